@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of heap allocations made by the process so far. Linking
+// alloc_counter.cpp replaces the global operator new to keep the count.
+uint64_t allocationCount();
@@ -0,0 +1,613 @@
+// Microbenchmarks for the client's hot paths.
+//
+// Fixtures are recorded API payloads: bench/fixtures/*.jsonl is a traffic capture
+// (ZerodhaTradingBot --record) and instruments.csv is the saved dump.
+//
+// Run and compare against the checked-in baseline:
+//   ZerodhaBench --benchmark_out=current.json --benchmark_out_format=json
+//   compare.py benchmarks bench/baseline.json current.json   (from Google Benchmark's tools/)
+#include "zerodha_client.h"
+#include "csv_parser.h"
+#include "traffic_capture.h"
+#include "alloc_counter.h"
+#include "indicators.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <streambuf>
+
+#ifndef ZERODHA_SOURCE_DIR
+#define ZERODHA_SOURCE_DIR "."
+#endif
+
+namespace {
+
+// Allocations made between construction and report(), as a per-iteration counter
+class AllocationCounter {
+public:
+    AllocationCounter() : start_(allocationCount()) {}
+
+    void report(benchmark::State& state) const {
+        double allocations = static_cast<double>(allocationCount() - start_);
+        state.counters["allocs"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    uint64_t start_;
+};
+
+// The client logs to stdout on most paths; keep that out of the reporter's output
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+class QuietStdout {
+public:
+    QuietStdout() : saved_(std::cout.rdbuf(&buffer_)) {}
+    ~QuietStdout() { std::cout.rdbuf(saved_); }
+
+private:
+    NullBuffer buffer_;
+    std::streambuf* saved_;
+};
+
+std::string fixturePath(const std::string& name) {
+    return std::string(ZERODHA_SOURCE_DIR) + "/" + name;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream out;
+    out << in.rdbuf();
+    return out.str();
+}
+
+// Recorded session, instrument dump and a client loaded with both
+struct Fixtures {
+    std::string historical_body;
+    std::vector<Price> ltps;
+    std::vector<CandleData> candles;
+    std::vector<double> closes;
+    std::vector<double> ema;
+    CandleSeries series;
+    std::string instruments_csv;
+    std::vector<std::string> symbols;
+    ZerodhaClient client;
+
+    Fixtures() {
+        std::ifstream in(fixturePath("bench/fixtures/abb_session.jsonl"));
+        std::string line;
+        TrafficEntry entry;
+        while (std::getline(in, line)) {
+            if (!TrafficReplayer::fromJsonLine(line, entry)) continue;
+            if (entry.url.find("/instruments/historical/") != std::string::npos) {
+                historical_body = entry.body;
+            } else if (entry.url.find("/quote/ltp") != std::string::npos) {
+                nlohmann::json json = nlohmann::json::parse(entry.body);
+                ltps.push_back(Price::fromDouble(json["data"].begin().value()["last_price"].get<double>()));
+            }
+        }
+
+        QuietStdout quiet;
+        client.loadTradeSettings(fixturePath("TradeSettings.csv"));
+        client.loadInstrumentsFromCSV(fixturePath("instruments.csv"));
+
+        cpr::Response response;
+        response.text = historical_body;
+        client.parseHistoricalDataResponse(response, candles);
+        for (const auto& candle : candles) {
+            closes.push_back(candle.close.toDouble());
+            series.push(CandleStore::parseTimestamp(candle.timestamp), candle.open, candle.high, candle.low,
+                        candle.close, candle.volume, candle.oi);
+        }
+        ema = client.calculateEMA(closes, 20);
+
+        instruments_csv = readFile(fixturePath("instruments.csv"));
+        const InstrumentStore& store = client.getInstrumentStore();
+        for (InstrumentStore::Row row = 0; row < store.size(); ++row) {
+            symbols.push_back(std::string(store.exchange(row)) + ":" + std::string(store.tradingsymbol(row)));
+        }
+    }
+};
+
+Fixtures& fixtures() {
+    static Fixtures instance;
+    return instance;
+}
+
+void BM_CalculateEMA(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    // Tile the recorded closes up to the requested length
+    std::vector<double> prices(static_cast<size_t>(state.range(0)));
+    for (size_t i = 0; i < prices.size(); ++i) {
+        prices[i] = f.closes[i % f.closes.size()];
+    }
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        std::vector<double> ema = f.client.calculateEMA(prices, 20);
+        benchmark::DoNotOptimize(ema.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CalculateEMA)->Arg(750)->Arg(10000);
+
+void BM_ParseHistoricalDataResponse(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    cpr::Response response;
+    response.text = f.historical_body;
+
+    AllocationCounter allocations;
+    size_t candles = 0;
+    for (auto _ : state) {
+        std::vector<CandleData> parsed;
+        f.client.parseHistoricalDataResponse(response, parsed);
+        candles = parsed.size();
+        benchmark::DoNotOptimize(parsed.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(candles));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(response.text.size()));
+}
+BENCHMARK(BM_ParseHistoricalDataResponse);
+
+void BM_ParseCSVStringInstruments(benchmark::State& state) {
+    Fixtures& f = fixtures();
+
+    AllocationCounter allocations;
+    size_t rows = 0;
+    for (auto _ : state) {
+        auto parsed = CSVParser::parseCSVString(f.instruments_csv);
+        rows = parsed.size();
+        benchmark::DoNotOptimize(parsed.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(rows));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(f.instruments_csv.size()));
+}
+BENCHMARK(BM_ParseCSVStringInstruments)->Unit(benchmark::kMillisecond);
+
+void BM_LoadInstrumentsFromCSV(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    ZerodhaClient client;
+    std::string path = fixturePath("instruments.csv");
+
+    QuietStdout quiet;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client.loadInstrumentsFromCSV(path));
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(f.symbols.size()));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(f.instruments_csv.size()));
+}
+BENCHMARK(BM_LoadInstrumentsFromCSV)->Unit(benchmark::kMillisecond);
+
+void BM_GetInstrumentToken(benchmark::State& state) {
+    Fixtures& f = fixtures();
+
+    AllocationCounter allocations;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(f.client.getInstrumentToken(f.symbols[i]));
+        if (++i == f.symbols.size()) i = 0;
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GetInstrumentToken);
+
+void BM_AnalyzeStrategy(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    // One decision per recorded bar, priced at the next bar's open
+    std::vector<LastThreeCandles> windows;
+    std::vector<Price> ltps;
+    for (size_t i = 2; i + 1 < f.candles.size(); ++i) {
+        LastThreeCandles data;
+        data.third_open = f.candles[i - 2].open;
+        data.third_high = f.candles[i - 2].high;
+        data.third_low = f.candles[i - 2].low;
+        data.third_close = f.candles[i - 2].close;
+        data.third_ema = f.ema[i - 2];
+        data.second_open = f.candles[i - 1].open;
+        data.second_high = f.candles[i - 1].high;
+        data.second_low = f.candles[i - 1].low;
+        data.second_close = f.candles[i - 1].close;
+        data.second_ema = f.ema[i - 1];
+        data.last_open = f.candles[i].open;
+        data.last_high = f.candles[i].high;
+        data.last_low = f.candles[i].low;
+        data.last_close = f.candles[i].close;
+        data.last_ema = f.ema[i];
+        windows.push_back(data);
+        ltps.push_back(f.candles[i + 1].open);
+    }
+
+    QuietStdout quiet;
+    AllocationCounter allocations;
+    size_t i = 0;
+    for (auto _ : state) {
+        TradeSignal signal = f.client.analyzeStrategy("ABB", windows[i], ltps[i]);
+        benchmark::DoNotOptimize(signal.action.data());
+        if (++i == windows.size()) i = 0;
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AnalyzeStrategy);
+
+// Each symbol holds the recorded bars ending at a different offset
+template <typename Strategy>
+void loadUniverse(Strategy& strategy, std::vector<SymbolId>& ids, size_t symbols) {
+    Fixtures& f = fixtures();
+    strategy.reset(symbols);
+    ids.resize(symbols);
+    for (size_t id = 0; id < symbols; ++id) {
+        ids[id] = static_cast<SymbolId>(id);
+        size_t i = 2 + id % (f.candles.size() - 3);
+        for (size_t bar = i - 2; bar <= i; ++bar) {
+            strategy.onBarClose(ids[id], f.candles[bar], f.ema[bar]);
+        }
+        strategy.onTick(ids[id], f.candles[i + 1].open);
+    }
+}
+
+template <typename Strategy>
+void evaluateUniverse(benchmark::State& state, Strategy& strategy) {
+    const size_t symbols = static_cast<size_t>(state.range(0));
+    std::vector<SymbolId> ids;
+    loadUniverse(strategy, ids, symbols);
+
+    std::vector<SignalDecision> decisions(symbols);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        size_t signals = strategy.evaluate(Span<const SymbolId>(ids), decisions.data());
+        benchmark::DoNotOptimize(signals);
+        benchmark::ClobberMemory();
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(symbols));
+}
+
+void BM_EvaluateUniverse(benchmark::State& state) {
+    EmaThreeCandleStrategy strategy;
+    evaluateUniverse(state, strategy);
+}
+BENCHMARK(BM_EvaluateUniverse)->Arg(50)->Arg(500);
+
+// The same rule compiled from strategy.rules
+void BM_EvaluateRules(benchmark::State& state) {
+    StrategyRules rules;
+    if (!rules.load(fixturePath("strategy.rules"))) {
+        state.SkipWithError("strategy.rules not found");
+        return;
+    }
+    RuleStrategy strategy(rules);
+    evaluateUniverse(state, strategy);
+}
+BENCHMARK(BM_EvaluateRules)->Arg(50)->Arg(500);
+
+// The six indicators, streamed
+struct IndicatorSet {
+    Ema ema;
+    Rsi rsi;
+    Atr atr;
+    Vwap vwap;
+    Bollinger bollinger;
+    SuperTrend supertrend;
+
+    IndicatorSet() : ema(20), rsi(14), atr(14), bollinger(20, 2.0), supertrend(10, 3.0) {}
+
+    void seed(const CandleSeries& series, size_t end) {
+        ema.seed(series, end);
+        rsi.seed(series, end);
+        atr.seed(series, end);
+        vwap.seed(series, end);
+        bollinger.seed(series, end);
+        supertrend.seed(series, end);
+    }
+};
+
+bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// Streams bars [split, end) after a batch seed of [0, split) and compares every
+// value with the batch columns; false on the first bit that differs
+bool indicatorsMatchBatch(const CandleSeries& series, size_t split) {
+    std::vector<double> ema, rsi, atr, vwap, middle, upper, lower, supertrend;
+    std::vector<int8_t> direction;
+    Ema::compute(series, 20, ema);
+    Rsi::compute(series, 14, rsi);
+    Atr::compute(series, 14, atr);
+    Vwap::compute(series, vwap);
+    Bollinger::compute(series, 20, 2.0, middle, upper, lower);
+    SuperTrend::compute(series, 10, 3.0, supertrend, direction);
+
+    IndicatorSet set;
+    set.seed(series, split);
+    for (size_t i = split; i < series.size(); ++i) {
+        Bollinger::Bands bands = set.bollinger.update(series.close[i]);
+        if (!sameBits(set.ema.update(series.close[i]), ema[i]) ||
+            !sameBits(set.rsi.update(series.close[i]), rsi[i]) ||
+            !sameBits(set.atr.update(series.high[i], series.low[i], series.close[i]), atr[i]) ||
+            !sameBits(set.vwap.update(series.timestamp[i], series.high[i], series.low[i], series.close[i], series.volume[i]), vwap[i]) ||
+            !sameBits(bands.middle, middle[i]) || !sameBits(bands.upper, upper[i]) || !sameBits(bands.lower, lower[i]) ||
+            !sameBits(set.supertrend.update(series.high[i], series.low[i], series.close[i]), supertrend[i]) ||
+            set.supertrend.direction() != direction[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Textbook definitions, written out over whole windows in rupees and sharing
+// nothing with indicators.cpp, to check the library's values against
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+std::vector<double> referenceRsi(const std::vector<double>& closes, size_t period) {
+    std::vector<double> out(closes.size(), kNaN);
+    if (closes.size() <= period) return out;
+    double average_gain = 0.0;
+    double average_loss = 0.0;
+    for (size_t i = 1; i < closes.size(); ++i) {
+        double change = closes[i] - closes[i - 1];
+        double gain = change > 0 ? change : 0.0;
+        double loss = change < 0 ? -change : 0.0;
+        if (i <= period) {
+            average_gain += gain / period;
+            average_loss += loss / period;
+            if (i < period) continue;
+        } else {
+            average_gain = (average_gain * (period - 1) + gain) / period;
+            average_loss = (average_loss * (period - 1) + loss) / period;
+        }
+        out[i] = average_loss == 0.0 ? 100.0 : 100.0 - 100.0 / (1.0 + average_gain / average_loss);
+    }
+    return out;
+}
+
+std::vector<double> referenceAtr(const std::vector<CandleData>& candles, size_t period) {
+    std::vector<double> out(candles.size(), kNaN);
+    double atr = 0.0;
+    for (size_t i = 0; i < candles.size(); ++i) {
+        double high = candles[i].high.toDouble();
+        double low = candles[i].low.toDouble();
+        double true_range = high - low;
+        if (i > 0) {
+            double previous_close = candles[i - 1].close.toDouble();
+            true_range = (std::max)({true_range, std::fabs(high - previous_close), std::fabs(low - previous_close)});
+        }
+        if (i < period) {
+            atr += true_range / period;
+            if (i + 1 < period) continue;
+        } else {
+            atr = (atr * (period - 1) + true_range) / period;
+        }
+        out[i] = atr;
+    }
+    return out;
+}
+
+// Session VWAP of the typical price, restarting at each IST date
+std::vector<double> referenceVwap(const std::vector<CandleData>& candles) {
+    std::vector<double> out(candles.size(), kNaN);
+    double price_volume = 0.0;
+    double volume = 0.0;
+    for (size_t i = 0; i < candles.size(); ++i) {
+        if (i == 0 || candles[i].timestamp.compare(0, 10, candles[i - 1].timestamp, 0, 10) != 0) {
+            price_volume = 0.0;
+            volume = 0.0;
+        }
+        double typical = (candles[i].high.toDouble() + candles[i].low.toDouble() + candles[i].close.toDouble()) / 3.0;
+        price_volume += typical * static_cast<double>(candles[i].volume);
+        volume += static_cast<double>(candles[i].volume);
+        if (volume > 0.0) out[i] = price_volume / volume;
+    }
+    return out;
+}
+
+// Mean and population deviation recomputed over each full window
+void referenceBollinger(const std::vector<double>& closes, size_t period, double width,
+                        std::vector<double>& middle, std::vector<double>& upper, std::vector<double>& lower) {
+    middle.assign(closes.size(), kNaN);
+    upper.assign(closes.size(), kNaN);
+    lower.assign(closes.size(), kNaN);
+    for (size_t i = period - 1; i < closes.size(); ++i) {
+        double mean = 0.0;
+        for (size_t k = i + 1 - period; k <= i; ++k) mean += closes[k];
+        mean /= period;
+        double variance = 0.0;
+        for (size_t k = i + 1 - period; k <= i; ++k) variance += (closes[k] - mean) * (closes[k] - mean);
+        double deviation = std::sqrt(variance / period);
+        middle[i] = mean;
+        upper[i] = mean + width * deviation;
+        lower[i] = mean - width * deviation;
+    }
+}
+
+// Final bands carried forward unless the previous close broke through; the
+// line flips to the other band when the close crosses it. The first value
+// starts on the lower band when the close is at or above the bar's midpoint.
+std::vector<double> referenceSuperTrend(const std::vector<CandleData>& candles, size_t period, double multiplier) {
+    std::vector<double> atr = referenceAtr(candles, period);
+    std::vector<double> out(candles.size(), kNaN);
+    double final_upper = 0.0;
+    double final_lower = 0.0;
+    for (size_t i = period - 1; i < candles.size(); ++i) {
+        double middle = (candles[i].high.toDouble() + candles[i].low.toDouble()) / 2.0;
+        double close = candles[i].close.toDouble();
+        double basic_upper = middle + multiplier * atr[i];
+        double basic_lower = middle - multiplier * atr[i];
+        if (i == period - 1) {
+            final_upper = basic_upper;
+            final_lower = basic_lower;
+            out[i] = close >= middle ? final_lower : final_upper;
+            continue;
+        }
+        double previous_close = candles[i - 1].close.toDouble();
+        bool was_upper = out[i - 1] == final_upper;
+        final_upper = basic_upper < final_upper || previous_close > final_upper ? basic_upper : final_upper;
+        final_lower = basic_lower > final_lower || previous_close < final_lower ? basic_lower : final_lower;
+        if (was_upper) {
+            out[i] = close > final_upper ? final_lower : final_upper;
+        } else {
+            out[i] = close < final_lower ? final_upper : final_lower;
+        }
+    }
+    return out;
+}
+
+// Relative tolerance: the library works in paise and keeps exact integer
+// window sums, so it rounds differently from the references above
+bool nearlyEqual(double value, double expected) {
+    if (std::isnan(value) || std::isnan(expected)) return std::isnan(value) && std::isnan(expected);
+    return std::fabs(value - expected) <= 1e-9 * (std::max)(1.0, std::fabs(expected));
+}
+
+bool matchesReference(const char* name, const std::vector<double>& values, const std::vector<double>& expected) {
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (i >= values.size() || !nearlyEqual(values[i], expected[i])) {
+            std::cerr << std::setprecision(17) << name << " differs from the reference at bar " << i << ": "
+                      << (i < values.size() ? values[i] : kNaN) << " vs " << expected[i] << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Batch columns against the references, then streaming against the batch
+// columns; main() refuses to benchmark indicators that fail either
+bool indicatorsCorrect() {
+    Fixtures& f = fixtures();
+    const CandleSeries& series = f.series;
+    std::vector<double> ema, rsi, atr, vwap, middle, upper, lower, supertrend;
+    std::vector<double> expected_middle, expected_upper, expected_lower;
+    std::vector<int8_t> direction;
+    Ema::compute(series, 20, ema);
+    Rsi::compute(series, 14, rsi);
+    Atr::compute(series, 14, atr);
+    Vwap::compute(series, vwap);
+    Bollinger::compute(series, 20, 2.0, middle, upper, lower);
+    SuperTrend::compute(series, 10, 3.0, supertrend, direction);
+    referenceBollinger(f.closes, 20, 2.0, expected_middle, expected_upper, expected_lower);
+
+    bool ok = matchesReference("Ema", ema, f.ema) &&
+              matchesReference("Rsi", rsi, referenceRsi(f.closes, 14)) &&
+              matchesReference("Atr", atr, referenceAtr(f.candles, 14)) &&
+              matchesReference("Vwap", vwap, referenceVwap(f.candles)) &&
+              matchesReference("Bollinger middle", middle, expected_middle) &&
+              matchesReference("Bollinger upper", upper, expected_upper) &&
+              matchesReference("Bollinger lower", lower, expected_lower) &&
+              matchesReference("SuperTrend", supertrend, referenceSuperTrend(f.candles, 10, 3.0));
+    for (size_t split : {size_t(0), size_t(1), series.size() / 2}) {
+        if (ok && !indicatorsMatchBatch(series, split)) {
+            std::cerr << "Streamed indicators differ from the batch columns after a seed of " << split << " bars" << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// One closed bar through all six indicators
+void BM_IndicatorsStream(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    const CandleSeries& series = f.series;
+
+    IndicatorSet set;
+    AllocationCounter allocations;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(set.ema.update(series.close[i]));
+        benchmark::DoNotOptimize(set.rsi.update(series.close[i]));
+        benchmark::DoNotOptimize(set.atr.update(series.high[i], series.low[i], series.close[i]));
+        benchmark::DoNotOptimize(set.vwap.update(series.timestamp[i], series.high[i], series.low[i], series.close[i], series.volume[i]));
+        benchmark::DoNotOptimize(set.bollinger.update(series.close[i]));
+        benchmark::DoNotOptimize(set.supertrend.update(series.high[i], series.low[i], series.close[i]));
+        if (++i == series.size()) i = 0;
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_IndicatorsStream);
+
+// Warming all six indicators up from the recorded history in batch
+void BM_IndicatorsSeed(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    IndicatorSet set;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        set.seed(f.series, f.series.size());
+        benchmark::DoNotOptimize(set.supertrend.value());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(f.series.size()));
+}
+BENCHMARK(BM_IndicatorsSeed);
+
+void BM_BuildOrderPayload(benchmark::State& state) {
+    Fixtures& f = fixtures();
+    Price stop_loss = f.ltps.front();
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        auto payload = f.client.buildOrderPayload("ABB", "SELL", "SL", 1, "TradingBot_SL", stop_loss, stop_loss);
+        benchmark::DoNotOptimize(payload.size());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BuildOrderPayload);
+
+void BM_LatencyHistogramRecord(benchmark::State& state) {
+    LatencyHistogram histogram;
+    uint64_t nanos = 1000;
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        histogram.record(nanos);
+        nanos = nanos * 7 % 100000007; // spread across buckets
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LatencyHistogramRecord);
+
+void BM_MetricCounterInc(benchmark::State& state) {
+    static MetricsRegistry registry;
+    MetricCounter& counter = registry.counter("bench_events_total", "Benchmark events.");
+
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        counter.inc();
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MetricCounterInc)->ThreadRange(1, 8);
+
+} // namespace
+
+// BENCHMARK_MAIN, preceded by the indicator correctness check so a wrong
+// result fails the run instead of being timed
+int main(int argc, char** argv) {
+    if (!indicatorsCorrect()) {
+        return 1;
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+class ZerodhaClient;
+
+// Spaces requests evenly so that no more than `rate` start per second
+// across all threads sharing the limiter.
+class RateLimiter {
+public:
+    explicit RateLimiter(double requests_per_second);
+
+    void acquire();
+
+private:
+    std::mutex mutex_;
+    std::chrono::steady_clock::duration interval_;
+    std::chrono::steady_clock::time_point next_slot_;
+};
+
+// Symbol/timeframe pair to backfill
+struct BackfillRequest {
+    std::string symbol;
+    std::string timeframe;
+};
+
+// Chunked, concurrent historical backfill into the local candle stores.
+//
+// The requested range is split into chunks no longer than Kite allows per
+// request for the interval. Worker threads fetch chunks under a shared rate
+// limit; results are appended to each symbol's CandleStore strictly in
+// chunk order, so the store's last timestamp is always the resume point
+// after an interruption and overlapping candles are de-duplicated there.
+// A range starting before the stored history is fetched as well and
+// prepended by rewriting the store once all of it has arrived.
+class HistoricalBackfill {
+public:
+    HistoricalBackfill(ZerodhaClient& client, double requests_per_second = 3.0, int workers = 3);
+
+    // Maximum days per historical request for a Kite interval
+    static int maxDaysPerRequest(const std::string& timeframe);
+    static std::vector<std::pair<int64_t, int64_t>> splitRange(int64_t from_ts, int64_t to_ts,
+                                                               const std::string& timeframe);
+
+    // Fills [from_ts, to_ts] (epoch seconds) for every request; returns false if any chunk failed.
+    // A candle whose interval has not closed yet is left for a later run.
+    bool run(const std::vector<BackfillRequest>& requests, int64_t from_ts, int64_t to_ts);
+
+    void setMaxRetries(int retries) { max_retries_ = retries; }
+
+private:
+    ZerodhaClient& client_;
+    RateLimiter limiter_;
+    int workers_;
+    int max_retries_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "candle_store.h"
+#include "strategy_rules.h"
+
+// One simulated round trip
+struct BacktestTrade {
+    int64_t entry_ts;
+    int64_t exit_ts;
+    SignalSide side;
+    Price entry_price;
+    Price exit_price;
+    Price stop_loss;
+    Price target;
+    int64_t pnl_paise;
+    bool target_hit;
+
+    BacktestTrade() : entry_ts(0), exit_ts(0), side(SignalSide::None), pnl_paise(0), target_hit(false) {}
+};
+
+// Aggregated outcome of one replay
+struct BacktestResult {
+    std::vector<BacktestTrade> trades; // only filled when trade recording is enabled
+    size_t candles;
+    int trade_count;
+    int wins;
+    int losses;
+    int64_t net_pnl_paise;
+    int64_t gross_profit_paise;
+    int64_t gross_loss_paise;
+    int64_t max_drawdown_paise;
+
+    BacktestResult() : candles(0), trade_count(0), wins(0), losses(0), net_pnl_paise(0),
+                       gross_profit_paise(0), gross_loss_paise(0), max_drawdown_paise(0) {}
+
+    double winRate() const { return trade_count ? static_cast<double>(wins) / trade_count : 0.0; }
+    void merge(const BacktestResult& other);
+};
+
+// Settings for a replay that are not strategy parameters
+struct BacktestOptions {
+    Price tick;
+    int quantity;
+    bool intraday_squareoff; // MIS positions are closed at the last bar of each session
+    bool record_trades;
+    const StrategyRules* rules; // entry conditions instead of the built-in rule; not owned
+
+    BacktestOptions() : tick(Price::fromPaise(5)), quantity(1), intraday_squareoff(true), record_trades(false),
+                        rules(nullptr) {}
+};
+
+// Bar-by-bar replay of the EMA three-candle strategy over stored candles.
+//
+// At the close of bar i the candles i-2, i-1 and i play the roles of the
+// third, second and last candle of the live loop, with close[i] as the LTP.
+// Entries fill at that close; from the next bar the stop loss is checked
+// before the target (pessimistic when both fall inside one bar), and a gap
+// through either level fills at the bar's open.
+class Backtester {
+public:
+    static BacktestResult run(const CandleSeries& series, const StrategyParams& params,
+                              const BacktestOptions& options = BacktestOptions());
+
+    // Same replay restricted to bars [begin, end) (used for walk-forward windows)
+    static BacktestResult runRange(const CandleSeries& series, size_t begin, size_t end,
+                                   const StrategyParams& params, const BacktestOptions& options);
+
+    // Replay with a precomputed EMA column (see computeEma) shared across parameter sets
+    static BacktestResult runRange(const CandleSeries& series, const std::vector<double>& ema, size_t begin, size_t end,
+                                   const StrategyParams& params, const BacktestOptions& options);
+
+    // EMA of the close column over the whole series, seeded like calculateEMA
+    static void computeEma(const CandleSeries& series, int period, std::vector<double>& out);
+
+    // Loads Timestamp,Open,High,Low,Close,Volume[,EMA] files written by saveInstrumentDataToCSV
+    static bool loadCSV(const std::string& filename, CandleSeries& out);
+
+private:
+    template <typename EmaAt>
+    static BacktestResult replay(const CandleSeries& series, size_t begin, size_t end,
+                                 const StrategyParams& params, const BacktestOptions& options, EmaAt ema_at);
+};
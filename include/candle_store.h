@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "market_data.h"
+#include "mapped_file.h"
+
+// Column-oriented candle series (one vector per field, timestamps in epoch seconds)
+struct CandleSeries {
+    std::vector<int64_t> timestamp;
+    std::vector<Price> open;
+    std::vector<Price> high;
+    std::vector<Price> low;
+    std::vector<Price> close;
+    std::vector<int64_t> volume;
+    std::vector<int64_t> oi;
+
+    size_t size() const { return timestamp.size(); }
+    bool empty() const { return timestamp.empty(); }
+    void clear();
+    void reserve(size_t count);
+    void push(int64_t ts, Price o, Price h, Price l, Price c, int64_t vol, int64_t open_interest);
+    CandleData candle(size_t i) const;
+};
+
+// Append-only, memory-mapped candle history for one symbol and timeframe.
+//
+// Two files live under the store directory:
+//   SYMBOL_timeframe.cdat  blocks of up to kBlockSize candles, each column
+//                          delta + zigzag varint encoded
+//   SYMBOL_timeframe.cidx  fixed 32-byte index records (first/last timestamp,
+//                          offset, size, count) - one per block
+// The data file is mapped read-only for random access; appends write a new
+// block followed by its index record. On open, index records past the end
+// of the data file and a torn trailing record are cut off, and the next
+// block overwrites any partly written data.
+class CandleStore {
+public:
+    static constexpr size_t kBlockSize = 1024;
+    static constexpr int kIstOffsetSeconds = 330 * 60;
+
+    explicit CandleStore(const std::string& directory = "candles");
+    ~CandleStore() { close(); }
+
+    bool open(const std::string& symbol, const std::string& timeframe);
+    void close();
+    bool isOpen() const { return !data_path_.empty(); }
+
+    // Appends candles newer than lastTimestamp(); older or duplicate candles are skipped
+    size_t append(const std::vector<CandleData>& candles);
+    size_t append(const CandleSeries& series);
+    // Appended candles are held in memory (and served by reads) until `candles`
+    // of them have collected, then written as full blocks; a few candles per
+    // append would otherwise each become a block with its own index record.
+    // 0, the default, writes every append through. close() flushes.
+    void setAppendBatch(size_t candles) { append_batch_ = candles; }
+    bool flush();
+    // Adds candles older than firstTimestamp() by rewriting the store; returns
+    // how many were added
+    size_t prepend(const std::vector<CandleData>& candles);
+    size_t prepend(const CandleSeries& series);
+
+    size_t size() const { return total_count_ + pending_.size(); }
+    bool empty() const { return size() == 0; }
+    int64_t firstTimestamp() const;
+    int64_t lastTimestamp() const;
+
+    // Range reads (timestamps inclusive, epoch seconds); readColumns replaces
+    // the contents of `out`, like Backtester::loadCSV
+    bool readColumns(int64_t from_ts, int64_t to_ts, CandleSeries& out) const;
+    std::vector<CandleData> read(int64_t from_ts, int64_t to_ts) const;
+    std::vector<CandleData> readLast(size_t count) const;
+
+    // Kite timestamp helpers ("2025-07-18T11:55:00+0530" <-> epoch seconds)
+    static int64_t parseTimestamp(const std::string& timestamp);
+    static std::string formatTimestamp(int64_t epoch_seconds);
+    static int timeframeSeconds(const std::string& timeframe);
+    static std::string sanitizeSymbol(const std::string& symbol);
+
+private:
+    struct IndexRecord {
+        int64_t first_ts;
+        int64_t last_ts;
+        uint64_t offset;
+        uint32_t byte_size;
+        uint32_t count;
+    };
+    static_assert(sizeof(IndexRecord) == 32, "index record layout must stay 32 bytes");
+
+    bool openFiles(const std::string& data_path, const std::string& index_path);
+    bool appendBlock(const CandleSeries& series, size_t begin, size_t end);
+    bool decodeBlock(const IndexRecord& record, CandleSeries& out, int64_t from_ts, int64_t to_ts) const;
+    bool remap() const;
+
+    std::string directory_;
+    std::string data_path_;
+    std::string index_path_;
+    std::vector<IndexRecord> index_;
+    size_t total_count_;     // candles on disk
+    CandleSeries pending_;   // appended, not yet written
+    size_t append_batch_;
+    mutable MappedFile mapped_;
+    mutable uint64_t mapped_end_; // data bytes covered by the current mapping
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Time source for the trading loop. Everything that used to read
+// system_clock::now() or sleep real time goes through a Clock, so a session
+// can be replayed in virtual time.
+class Clock {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+    using duration = std::chrono::system_clock::duration;
+
+    virtual ~Clock() = default;
+
+    virtual time_point now() const = 0;
+    virtual void sleepFor(duration d) = 0;
+    virtual bool isVirtual() const { return false; }
+
+    int64_t nowSeconds() const {
+        return std::chrono::duration_cast<std::chrono::seconds>(now().time_since_epoch()).count();
+    }
+};
+
+// Wall clock; sleeps really block
+class SystemClock : public Clock {
+public:
+    time_point now() const override { return std::chrono::system_clock::now(); }
+    void sleepFor(duration d) override { std::this_thread::sleep_for(d); }
+};
+
+// Manually driven clock: sleeping just moves time forward, so a full trading
+// session runs as fast as the work between the sleeps allows.
+class VirtualClock : public Clock {
+public:
+    explicit VirtualClock(time_point start) : ticks_(start.time_since_epoch().count()) {}
+
+    time_point now() const override { return time_point(duration(ticks_.load(std::memory_order_acquire))); }
+    void sleepFor(duration d) override { advance(d); }
+    bool isVirtual() const override { return true; }
+
+    void advance(duration d) { ticks_.fetch_add(d.count(), std::memory_order_acq_rel); }
+    void set(time_point t) { ticks_.store(t.time_since_epoch().count(), std::memory_order_release); }
+
+private:
+    std::atomic<duration::rep> ticks_;
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include "candle_store.h"
+#include "instrument_store.h"
+#include "http_server.h"
+
+// Order as tracked by the simulator (field names follow Kite's order book)
+struct SimOrder {
+    std::string order_id;
+    std::string symbol;
+    std::string exchange;
+    std::string transaction_type; // BUY / SELL
+    std::string order_type;       // MARKET / LIMIT / SL / SL-M
+    std::string product;
+    std::string validity;
+    std::string tag;
+    std::string status;           // OPEN / TRIGGER PENDING / COMPLETE / CANCELLED / REJECTED
+    std::string status_message;
+    int quantity;
+    int filled_quantity;
+    Price price;
+    Price trigger_price;
+    Price average_price;
+    bool triggered;
+    int64_t placed_ts;
+    int64_t updated_ts;
+
+    SimOrder() : quantity(0), filled_quantity(0), triggered(false), placed_ts(0), updated_ts(0) {}
+    bool isBuy() const { return transaction_type == "BUY"; }
+    bool isOpen() const { return status == "OPEN" || status == "TRIGGER PENDING"; }
+};
+
+// Net position per symbol and product
+struct SimPosition {
+    std::string symbol;
+    std::string exchange;
+    std::string product;
+    uint32_t token;
+    int64_t buy_quantity;
+    int64_t sell_quantity;
+    int64_t buy_value_paise;
+    int64_t sell_value_paise;
+
+    SimPosition() : token(0), buy_quantity(0), sell_quantity(0), buy_value_paise(0), sell_value_paise(0) {}
+    int64_t quantity() const { return buy_quantity - sell_quantity; }
+};
+
+// Deterministic paper-trading stand-in for the Kite REST API.
+//
+// Stored candles are replayed as ticks (open, then low/high in the order the
+// candle implies, then close). Endpoints mirror the shapes the client uses:
+//   POST /session/token, GET /instruments[/EXCH], GET /instruments/historical/TOKEN/INTERVAL,
+//   GET /quote/ltp, POST /orders/regular, DELETE /orders/regular/ID,
+//   GET /orders, GET /orders/ID, GET /portfolio/positions, GET /sim/stats
+//
+// The replay clock runs at `speed` x wall time from `start`, moves a symbol
+// forward one tick per LTP request for that symbol (step mode), or follows
+// the X-Sim-Time header sent by a client on a VirtualClock (client mode).
+// Step and client modes give the same prices and fills on every run.
+class ExchangeSimulator {
+public:
+    ExchangeSimulator();
+
+    // Instrument dump to serve; when absent one is synthesised from the loaded series
+    bool loadInstruments(const std::string& csv_file);
+    bool addSeries(const std::string& symbol, const std::string& timeframe, const CandleSeries& series);
+    size_t seriesCount() const { return books_.size(); }
+
+    void setApiSecret(const std::string& secret) { api_secret_ = secret; }
+    // Every clock starts with each symbol's history printed up to start_ts
+    void setRealtimeClock(int64_t start_ts, double speed);
+    void setStepClock(int64_t start_ts);
+    void setClientClock(int64_t start_ts);
+
+    HttpResponse handle(const HttpRequest& request);
+    void printSummary() const;
+
+private:
+    struct Tick {
+        int64_t ts;
+        Price price;
+    };
+
+    struct SymbolBook {
+        std::string symbol;
+        std::string exchange;
+        uint32_t token;
+        std::string timeframe;
+        int timeframe_seconds;
+        CandleSeries candles;
+        std::vector<Tick> ticks; // four per candle
+        size_t cursor;           // ticks already printed
+        std::vector<size_t> open_orders;
+
+        SymbolBook() : token(0), timeframe_seconds(60), cursor(0) {}
+        bool hasPrice() const { return cursor > 0; }
+        Price lastPrice() const { return ticks[cursor - 1].price; }
+    };
+
+    struct EndpointStats {
+        uint64_t requests;
+        uint64_t total_ns;
+        uint64_t max_ns;
+
+        EndpointStats() : requests(0), total_ns(0), max_ns(0) {}
+    };
+
+    HttpResponse route(const HttpRequest& request, std::string& endpoint);
+    HttpResponse sessionToken(const HttpRequest& request);
+    HttpResponse instruments(const std::string& exchange);
+    HttpResponse historical(const HttpRequest& request, const std::string& token, const std::string& interval);
+    HttpResponse quoteLtp(const HttpRequest& request);
+    HttpResponse placeOrder(const HttpRequest& request);
+    HttpResponse cancelOrder(const std::string& order_id);
+    HttpResponse orders(const std::string& order_id);
+    HttpResponse positions();
+    HttpResponse stats() const;
+
+    bool authorised(const HttpRequest& request) const;
+    SymbolBook* findBook(const std::string& key);
+    void positionCursors(int64_t start_ts);
+    void advanceTo(SymbolBook& book);
+    void emitTick(SymbolBook& book);
+    bool tryFill(SymbolBook& book, SimOrder& order, Price ltp, bool resting);
+    void fill(SymbolBook& book, SimOrder& order, Price price);
+    int64_t simNow() const;
+    int64_t bookNow(const SymbolBook& book) const;
+    std::string instrumentsCSV(const std::string& exchange) const;
+
+    static HttpResponse error(int status, const std::string& error_type, const std::string& message);
+
+    mutable std::mutex mutex_;
+    std::vector<SymbolBook> books_;
+    std::unordered_map<std::string, size_t> book_by_key_;   // "EXCH:SYM" and bare "SYM"
+    std::unordered_map<uint32_t, size_t> book_by_token_;
+    InstrumentStore instruments_;
+
+    std::vector<SimOrder> orders_;
+    std::unordered_map<std::string, size_t> order_index_;
+    std::map<std::string, SimPosition> positions_; // "EXCH:SYM:PRODUCT"
+    uint64_t next_order_id_;
+    uint64_t fills_;
+
+    std::string api_secret_;
+    std::map<std::string, std::string> sessions_; // access_token -> api_key
+
+    enum class ClockMode { Realtime, Step, Client };
+
+    ClockMode clock_mode_;
+    int64_t start_ts_;
+    int64_t client_now_;
+    double speed_;
+    std::chrono::steady_clock::time_point wall_start_;
+
+    std::map<std::string, EndpointStats> stats_;
+};
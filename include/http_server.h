@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// Parsed HTTP/1.1 request (query string and form body already decoded)
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> query;   // repeated keys keep the last value
+    std::multimap<std::string, std::string> query_all;
+    std::map<std::string, std::string> headers; // names lower-cased
+    std::map<std::string, std::string> form;    // application/x-www-form-urlencoded body
+    std::string body;
+
+    std::string header(const std::string& name) const;
+};
+
+struct HttpResponse {
+    int status;
+    std::string content_type;
+    std::string body;
+    std::map<std::string, std::string> headers;
+
+    HttpResponse() : status(200), content_type("application/json") {}
+    HttpResponse(int code, const std::string& text, const std::string& type = "application/json")
+        : status(code), content_type(type), body(text) {}
+};
+
+// Small blocking HTTP/1.1 server for local tools (simulator, metrics).
+//
+// One thread accepts connections and hands them to a fixed pool of
+// workers, which serve keep-alive requests until the peer closes. Plain
+// HTTP only; it is meant for loopback use, not for the internet.
+class HttpServer {
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+    HttpServer(const std::string& bind_address, int port, int workers = 8);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    void setHandler(Handler handler) { handler_ = std::move(handler); }
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running_; }
+    int port() const { return port_; } // actual port when 0 was requested
+
+    static std::string urlDecode(const std::string& text);
+    static void parseUrlEncoded(const std::string& text, std::map<std::string, std::string>& out,
+                                std::multimap<std::string, std::string>* all = nullptr);
+
+private:
+    void acceptLoop();
+    void workerLoop();
+    void serveConnection(intptr_t socket);
+
+    std::string bind_address_;
+    int port_;
+    int worker_count_;
+    Handler handler_;
+
+    intptr_t listen_socket_;
+    std::atomic<bool> running_;
+    std::thread accept_thread_;
+    std::vector<std::thread> workers_;
+
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<intptr_t> pending_;
+};
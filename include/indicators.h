@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "candle_store.h"
+#include "price.h"
+
+// Technical indicators with O(1) streaming state over candle columns.
+//
+// Each indicator has three entry points:
+//   update()   one closed bar, O(1); returns the new value, NaN until the
+//              indicator has seen enough bars
+//   seed()     brings the state up to bar `end` of a CandleSeries in one
+//              batch pass (element-wise work such as true ranges is done a
+//              block at a time in tight loops, then the recurrence runs)
+//   compute()  the batch pass over a whole series into output columns
+// The batch pass computes the element-wise terms the way update() does and
+// shares its recurrence, so both perform the same floating point operations
+// in the same order and agree bit for bit. Before benchmarking, ZerodhaBench
+// checks that on the fixture candles, and checks the batch values against
+// separate textbook implementations (calculateEMA for Ema); it exits with an
+// error if either check fails.
+// Prices come out in rupees.
+
+// Exponential moving average seeded with the first close (calculateEMA's recurrence)
+class Ema {
+public:
+    explicit Ema(int period = 20);
+
+    double update(Price close);
+    void seed(const CandleSeries& series, size_t end);
+    static void compute(const CandleSeries& series, int period, std::vector<double>& out);
+
+    bool ready() const { return count_ > 0; }
+    double value() const;
+
+private:
+    void run(const CandleSeries& series, size_t begin, size_t end, double* out);
+
+    double multiplier_;
+    double value_;
+    size_t count_;
+};
+
+// Wilder's relative strength index (0-100), first value after period + 1 closes
+class Rsi {
+public:
+    explicit Rsi(int period = 14);
+
+    double update(Price close);
+    void seed(const CandleSeries& series, size_t end);
+    static void compute(const CandleSeries& series, int period, std::vector<double>& out);
+
+    bool ready() const { return count_ > static_cast<size_t>(period_); }
+    double value() const;
+
+private:
+    void run(const CandleSeries& series, size_t begin, size_t end, double* out);
+    void step(double gain, double loss);
+
+    int period_;
+    int64_t previous_paise_;
+    double sum_gain_;
+    double sum_loss_;
+    double average_gain_;
+    double average_loss_;
+    size_t count_; // closes seen
+};
+
+// Wilder's average true range, first value after period bars
+class Atr {
+public:
+    explicit Atr(int period = 14);
+
+    double update(Price high, Price low, Price close);
+    void seed(const CandleSeries& series, size_t end);
+    static void compute(const CandleSeries& series, int period, std::vector<double>& out);
+
+    bool ready() const { return count_ >= static_cast<size_t>(period_); }
+    double value() const;
+
+private:
+    friend class SuperTrend;
+    void run(const CandleSeries& series, size_t begin, size_t end, double* out);
+    void step(double true_range);
+
+    int period_;
+    int64_t previous_close_paise_;
+    double sum_;
+    double atr_;
+    size_t count_; // bars seen
+};
+
+// Volume-weighted average of the typical price (H+L+C)/3, restarting every
+// IST session; NaN while the session has no volume
+class Vwap {
+public:
+    Vwap();
+
+    double update(int64_t timestamp, Price high, Price low, Price close, int64_t volume);
+    void seed(const CandleSeries& series, size_t end);
+    static void compute(const CandleSeries& series, std::vector<double>& out);
+
+    double value() const;
+
+private:
+    void run(const CandleSeries& series, size_t begin, size_t end, double* out);
+
+    int64_t session_day_;
+    double price_volume_; // sum of (H+L+C in paise) x volume
+    double volume_;
+};
+
+// Bollinger bands: simple moving average of the close +/- `width` population
+// standard deviations. The window sums are kept exactly in paise, so they
+// never drift however long the stream runs.
+class Bollinger {
+public:
+    struct Bands {
+        double middle;
+        double upper;
+        double lower;
+    };
+
+    explicit Bollinger(int period = 20, double width = 2.0);
+
+    Bands update(Price close);
+    void seed(const CandleSeries& series, size_t end);
+    static void compute(const CandleSeries& series, int period, double width,
+                        std::vector<double>& middle, std::vector<double>& upper, std::vector<double>& lower);
+
+    bool ready() const { return count_ >= window_.size(); }
+    Bands value() const;
+
+private:
+    void run(const CandleSeries& series, size_t begin, size_t end, Bands* out);
+    void push(int64_t close_paise);
+
+    double width_;
+    std::vector<int64_t> window_; // last `period` closes, oldest at next_
+    size_t next_;
+    int64_t sum_;
+    int64_t sum_squares_;
+    size_t count_;
+};
+
+// SuperTrend over Wilder's ATR. The first ready bar starts in the direction of
+// its close against the bar's midpoint; value() is the lower band while the
+// trend is up and the upper band while it is down.
+class SuperTrend {
+public:
+    explicit SuperTrend(int period = 10, double multiplier = 3.0);
+
+    double update(Price high, Price low, Price close);
+    void seed(const CandleSeries& series, size_t end);
+    // direction: 1 up, -1 down, 0 before the first value
+    static void compute(const CandleSeries& series, int period, double multiplier,
+                        std::vector<double>& out, std::vector<int8_t>& direction);
+
+    bool ready() const { return direction_ != 0; }
+    double value() const;
+    int direction() const { return direction_; }
+
+private:
+    void run(const CandleSeries& series, size_t begin, size_t end, double* out, int8_t* direction);
+    void step(double atr, int64_t high_paise, int64_t low_paise, int64_t close_paise);
+
+    Atr atr_;
+    double multiplier_;
+    double final_upper_;
+    double final_lower_;
+    double previous_close_;
+    int direction_;
+};
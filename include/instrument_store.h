@@ -0,0 +1,147 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <cstdint>
+#include "price.h"
+
+// Structure for instrument information
+struct Instrument {
+    std::string instrument_token;
+    std::string tradingsymbol;
+    std::string name;
+    std::string exchange;
+    std::string instrument_type;
+    std::string segment;
+    int expiry;        // yyyymmdd, 0 when the instrument does not expire
+    Price strike;
+    int lot_size;
+    Price tick_size;
+
+    Instrument() : expiry(0), lot_size(1), tick_size(Price::fromPaise(5)) {}
+};
+
+// Columnar store for the full Kite instrument dump (all exchanges and segments).
+// Rows are appended while parsing and indexes are built once at the end, so a
+// 100k row dump is parsed in a single pass without per-row maps.
+class InstrumentStore {
+public:
+    using Row = uint32_t;
+    static constexpr Row npos = UINT32_MAX;
+
+    // Contiguous range of rows returned by the indexed queries
+    struct RowRange {
+        const Row* first;
+        const Row* last;
+
+        const Row* begin() const { return first; }
+        const Row* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+    };
+
+    InstrumentStore();
+    // The symbol index holds views into the columns: copying would leave them
+    // pointing at the source, and a move re-keys them if the arena relocated
+    InstrumentStore(const InstrumentStore&) = delete;
+    InstrumentStore& operator=(const InstrumentStore&) = delete;
+    InstrumentStore(InstrumentStore&& other);
+    InstrumentStore& operator=(InstrumentStore&& other);
+
+    // Loading (Kite /instruments dump or a file written by saveToCSVFile)
+    bool loadFromCSVString(const std::string& csvText);
+    bool loadFromCSVFile(const std::string& filename);
+    bool saveToCSVFile(const std::string& filename) const;
+
+    void clear();
+    // Rows added with append() are not searchable until buildIndexes() is called
+    void append(const Instrument& inst);
+    void buildIndexes();
+
+    size_t size() const { return tokens_.size(); }
+    bool empty() const { return tokens_.empty(); }
+
+    // Symbol lookups
+    Row find(std::string_view exchange, std::string_view tradingsymbol) const;
+    Row findEquity(std::string_view tradingsymbol) const; // NSE first, then BSE
+    Row findAny(std::string_view symbol) const;           // "EXCH:SYMBOL" or bare symbol on any exchange
+
+    // Indexed queries
+    RowRange byExchange(std::string_view exchange) const;
+    RowRange bySegment(std::string_view segment) const;
+    RowRange byUnderlying(std::string_view name) const;                // sorted by expiry, strike
+    RowRange byUnderlyingExpiry(std::string_view name, int expiry) const;
+    std::vector<int> expiries(std::string_view name) const;
+    size_t countByExchange(std::string_view exchange) const { return byExchange(exchange).size(); }
+
+    // Column accessors
+    uint32_t instrumentToken(Row r) const { return tokens_[r]; }
+    std::string_view tradingsymbol(Row r) const;
+    std::string_view name(Row r) const { return names_.at(name_ids_[r]); }
+    std::string_view exchange(Row r) const { return exchanges_.at(exchange_ids_[r]); }
+    std::string_view segment(Row r) const { return segments_.at(segment_ids_[r]); }
+    std::string_view instrumentType(Row r) const { return types_.at(type_ids_[r]); }
+    int expiry(Row r) const { return expiry_[r]; }
+    Price strike(Row r) const { return strike_[r]; }
+    int lotSize(Row r) const { return lot_size_[r]; }
+    Price tickSize(Row r) const { return tick_size_[r]; }
+
+    Instrument instrument(Row r) const;
+
+    // Date helpers for the expiry column
+    static int parseExpiry(std::string_view text);        // "2025-07-31" -> 20250731
+    static std::string formatExpiry(int expiry);          // 20250731 -> "2025-07-31"
+
+private:
+    // Small string interning table for the low-cardinality columns
+    class Dictionary {
+    public:
+        Dictionary() = default;
+        Dictionary(const Dictionary&) = delete;            // ids_ views values_
+        Dictionary& operator=(const Dictionary&) = delete;
+        Dictionary(Dictionary&&) = default;                // deque moves keep element addresses
+        Dictionary& operator=(Dictionary&&) = default;
+
+        uint32_t intern(std::string_view value);
+        uint32_t lookup(std::string_view value) const; // npos when absent
+        std::string_view at(uint32_t id) const { return values_[id]; }
+        size_t size() const { return values_.size(); }
+        void clear() { values_.clear(); ids_.clear(); last_ = npos; }
+
+    private:
+        std::deque<std::string> values_; // deque keeps the views in ids_ stable
+        std::unordered_map<std::string_view, uint32_t> ids_;
+        uint32_t last_ = npos;           // the dump is grouped, so consecutive rows usually repeat
+    };
+
+    void indexSymbols();
+    RowRange rangeFor(const std::vector<std::vector<Row>>& index, uint32_t id) const;
+
+    // Columns
+    std::vector<uint32_t> tokens_;
+    std::vector<uint32_t> symbol_offsets_;
+    std::vector<uint16_t> symbol_lengths_;
+    std::vector<uint32_t> name_ids_;
+    std::vector<uint16_t> exchange_ids_;
+    std::vector<uint16_t> segment_ids_;
+    std::vector<uint16_t> type_ids_;
+    std::vector<int> expiry_;
+    std::vector<Price> strike_;
+    std::vector<int> lot_size_;
+    std::vector<Price> tick_size_;
+    std::string symbol_arena_;
+
+    Dictionary names_;
+    Dictionary exchanges_;
+    Dictionary segments_;
+    Dictionary types_;
+
+    // Indexes (rebuilt by buildIndexes)
+    std::vector<std::unordered_map<std::string_view, Row>> symbol_index_; // per exchange id
+    std::vector<std::vector<Row>> by_exchange_;
+    std::vector<std::vector<Row>> by_segment_;
+    std::vector<std::vector<Row>> by_underlying_;
+};
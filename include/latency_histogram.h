@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Lock-free log-linear histogram of nanosecond latencies (HDR-style).
+//
+// Values below 128 ns get their own bucket; above that every power of two is
+// split into 64 sub-buckets, so any recorded value is reported to within
+// about 1.6%. Recording is a handful of relaxed atomic adds, safe from any
+// thread; readers see a slightly stale but consistent-enough snapshot.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 6;
+    static constexpr uint64_t kLinearLimit = uint64_t(1) << (kSubBucketBits + 1); // 128 ns
+    static constexpr int kMaxShift = 36;                                           // up to 2^43 ns, about 146 minutes
+    static constexpr size_t kBucketCount = kLinearLimit + kMaxShift * (size_t(1) << kSubBucketBits);
+
+    LatencyHistogram();
+
+    void record(uint64_t nanos);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t maxValue() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    double mean() const;
+    // Value at quantile q in [0, 1], as the midpoint of its bucket
+    uint64_t percentile(double q) const;
+
+    static size_t bucketIndex(uint64_t nanos);
+    static uint64_t bucketLow(size_t index);
+    static uint64_t bucketHigh(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+// Stages of one pass over a symbol, from the quote request to the protective orders,
+// followed by the order lifecycle spans
+enum class LatencyStage {
+    Quote,          // LTP round trip
+    Candles,        // history from the store and/or API
+    Ema,            // closes extracted, EMA advanced
+    Signal,         // last three candles picked, strategy evaluated
+    OrderSend,      // entry order POST round trip
+    OrderParse,     // entry response parsed and logged
+    ProtectiveLegs, // SL and target orders acknowledged
+    TickToSignal,   // quote received -> signal, excluding rate-limit sleeps
+    TickToOrder,    // quote received -> entry order acknowledged
+    TickToLegs,     // quote received -> protective legs acknowledged
+    OrderFillSeen,  // order created -> fill seen by the reconciler poll (see OrderManager)
+    OrderCancel,    // cancel requested -> cancellation seen by the client
+    OrderModify,    // modify requested -> order seen live again
+    Count
+};
+
+class LatencyRecorder {
+public:
+    static constexpr size_t kStageCount = static_cast<size_t>(LatencyStage::Count);
+
+    void record(LatencyStage stage, uint64_t nanos) { histograms_[static_cast<size_t>(stage)].record(nanos); }
+    const LatencyHistogram& histogram(LatencyStage stage) const { return histograms_[static_cast<size_t>(stage)]; }
+    void reset();
+
+    // p50 / p99 / p99.9 / max per stage in microseconds; stages with no samples are skipped
+    void report(std::ostream& out) const;
+
+    static const char* stageName(LatencyStage stage);
+
+private:
+    std::array<LatencyHistogram, kStageCount> histograms_;
+};
+
+// Timestamps one pass through the stages. stamp() records the time since
+// the previous stamp; skip() drops a span (pacing sleeps) from the totals.
+class LatencyTrace {
+public:
+    using steady = std::chrono::steady_clock;
+
+    explicit LatencyTrace(LatencyRecorder& recorder)
+        : recorder_(recorder), last_(steady::now()), active_ns_(0) {}
+
+    void stamp(LatencyStage stage) {
+        steady::time_point now = steady::now();
+        uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+        recorder_.record(stage, nanos);
+        active_ns_ += nanos;
+        last_ = now;
+    }
+
+    void skip() { last_ = steady::now(); }
+
+    // Records the active time since the trace started under an end-to-end stage
+    void total(LatencyStage stage) { recorder_.record(stage, active_ns_); }
+
+private:
+    LatencyRecorder& recorder_;
+    steady::time_point last_;
+    uint64_t active_ns_;
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "price.h"
+
+// Structured, asynchronous, binary logging.
+//
+//   LOG_INFO("Order placed for {} at {}", symbol, price);
+//
+// Levels below ZERODHA_LOG_LEVEL (0 trace .. 4 error, default 2 = info) are
+// removed at compile time: the arguments are not even evaluated. Enabled
+// calls copy their raw arguments into a per-thread ring buffer (no
+// formatting, no locks, no syscalls); a background thread writes the bytes
+// to a binary file that ZerodhaLogDecode turns back into text, or formats
+// them to the console. Until Logger::start*() is called, messages are
+// formatted and printed synchronously so tools behave as before.
+#ifndef ZERODHA_LOG_LEVEL
+#define ZERODHA_LOG_LEVEL 2
+#endif
+
+enum class LogLevel : uint8_t { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+constexpr LogLevel kCompiledLogLevel = static_cast<LogLevel>(ZERODHA_LOG_LEVEL);
+
+constexpr bool logCompiledIn(LogLevel level) {
+    return static_cast<uint8_t>(level) >= static_cast<uint8_t>(kCompiledLogLevel);
+}
+
+const char* logLevelName(LogLevel level);
+
+// Binary layout (little-endian, as written by the host):
+//   file    := "ZLOG1\n\0\0" entry*
+//   entry   := u16 size, u8 kind, body            (size covers the whole entry)
+//   site    := kind 1: u32 id, u8 level, u32 line, str file, str format
+//   message := kind 2: u32 site, u32 thread, i64 epoch_ns, arg*
+//   arg     := u8 tag, payload                    (see LogArg)
+//   str     := u16 length, bytes
+namespace logfmt {
+
+constexpr char kMagic[8] = {'Z', 'L', 'O', 'G', '1', '\n', '\0', '\0'};
+constexpr uint8_t kSiteEntry = 1;
+constexpr uint8_t kMessageEntry = 2;
+constexpr size_t kMaxEntry = 4096;
+
+enum class LogArg : uint8_t { Int = 1, UInt = 2, Double = 3, Bool = 4, Price = 5, String = 6 };
+
+// Fixed-capacity entry under construction. Strings are clipped to fit; an
+// argument that still does not fit is dropped along with everything after it.
+class EntryWriter {
+public:
+    EntryWriter() : size_(3), full_(false) {}
+
+    template <typename T>
+    void raw(const T& value) {
+        if (size_ + sizeof(T) > kMaxEntry) {
+            full_ = true;
+            return;
+        }
+        std::memcpy(data_ + size_, &value, sizeof(T));
+        size_ += sizeof(T);
+    }
+
+    void str(std::string_view text) {
+        // Leave room for a few more scalar arguments after the string
+        size_t used = size_ + sizeof(uint16_t) + 64;
+        size_t room = kMaxEntry > used ? kMaxEntry - used : 0;
+        uint16_t length = static_cast<uint16_t>(text.size() < room ? text.size() : room);
+        raw(length);
+        if (full_) return;
+        std::memcpy(data_ + size_, text.data(), length);
+        size_ += length;
+    }
+
+    void arg(bool value) { add(LogArg::Bool, [&] { raw(static_cast<uint8_t>(value)); }); }
+    void arg(double value) { add(LogArg::Double, [&] { raw(value); }); }
+    void arg(float value) { arg(static_cast<double>(value)); }
+    void arg(Price value) { add(LogArg::Price, [&] { raw(value.paise()); }); }
+    void arg(const char* value) { add(LogArg::String, [&] { str(value ? value : "(null)"); }); }
+    void arg(const std::string& value) { add(LogArg::String, [&] { str(value); }); }
+    void arg(std::string_view value) { add(LogArg::String, [&] { str(value); }); }
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    void arg(T value) {
+        if (std::is_signed<T>::value) {
+            add(LogArg::Int, [&] { raw(static_cast<int64_t>(value)); });
+        } else {
+            add(LogArg::UInt, [&] { raw(static_cast<uint64_t>(value)); });
+        }
+    }
+
+    // Stamps the header; returns the finished entry
+    const char* finish(uint8_t kind, size_t& size) {
+        uint16_t total = static_cast<uint16_t>(size_);
+        std::memcpy(data_, &total, sizeof(total));
+        data_[2] = static_cast<char>(kind);
+        size = size_;
+        return data_;
+    }
+
+private:
+    template <typename F>
+    void add(LogArg type, F payload) {
+        if (full_) return;
+        size_t mark = size_;
+        raw(static_cast<uint8_t>(type));
+        payload();
+        if (full_) size_ = mark;
+    }
+
+    char data_[kMaxEntry];
+    size_t size_;
+    bool full_;
+};
+
+} // namespace logfmt
+
+// One LOG_* call site; registered with the logger the first time it fires
+struct LogSite {
+    LogLevel level;
+    const char* file;
+    int line;
+    const char* format;
+    std::atomic<uint32_t> id;
+
+    LogSite(LogLevel lvl, const char* f, int l, const char* fmt)
+        : level(lvl), file(f), line(l), format(fmt), id(0) {}
+};
+
+// Turns site and message entries back into text (used by the console sink and the decoder)
+class LogDecoder {
+public:
+    struct Site {
+        LogLevel level;
+        uint32_t line;
+        std::string file;
+        std::string format;
+    };
+
+    struct Message {
+        LogLevel level;
+        uint32_t thread;
+        int64_t epoch_ns;
+        std::string file;
+        uint32_t line;
+        std::string text;
+    };
+
+    // Consumes one entry; returns true and fills `message` for message entries
+    bool decode(const char* entry, size_t size, Message& message);
+    void defineSite(uint32_t id, const Site& site) { sites_[id] = site; }
+
+    // "yyyy-mm-dd hh:mm:ss.uuuuuu LEVEL [thread] file:line text"
+    static std::string formatLine(const Message& message);
+
+private:
+    std::unordered_map<uint32_t, Site> sites_;
+};
+
+class Logger {
+public:
+    static Logger& instance();
+
+    // Binary output to `path` (appended); decode with ZerodhaLogDecode
+    bool startBinary(const std::string& path);
+    // Formatted text on stdout (warnings and errors on stderr), off the calling thread
+    void startConsole();
+    // Drains everything queued so far and stops the writer thread
+    void stop();
+
+    void setLevel(LogLevel level) { level_.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const {
+        return static_cast<uint8_t>(level) >= level_.load(std::memory_order_relaxed);
+    }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // The format string is already on the site; it is taken here only so the
+    // macro can forward the call's arguments unchanged
+    template <typename... Args>
+    void write(LogSite& site, const char* /*format*/, const Args&... args) {
+        if (!enabled(site.level)) return;
+        uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0) id = registerSite(site);
+
+        logfmt::EntryWriter entry;
+        entry.raw(id);
+        entry.raw(threadId());
+        entry.raw(nowNanos());
+        (entry.arg(args), ...);
+
+        size_t size = 0;
+        const char* bytes = entry.finish(logfmt::kMessageEntry, size);
+        submit(bytes, size);
+    }
+
+    ~Logger();
+
+private:
+    // Single-producer (owning thread) / single-consumer (writer) byte ring.
+    // `busy` is set while the owner is pushing, so stop() can wait out a push
+    // that began before it switched to direct output; `retired` is set when
+    // the owning thread exits, and the writer frees the ring once it is empty.
+    struct Ring {
+        static constexpr size_t kCapacity = size_t(1) << 20;
+        std::unique_ptr<char[]> data;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<bool> busy;
+        std::atomic<bool> retired;
+
+        Ring() : data(new char[kCapacity]), head(0), tail(0), busy(false), retired(false) {}
+    };
+
+    enum class Mode { Direct, Binary, Console };
+
+    Logger();
+
+    uint32_t registerSite(LogSite& site);
+    void submit(const char* bytes, size_t size);
+    Ring& threadRing();
+    void writerLoop();
+    void drain();
+    void releaseRetiredRings();
+    void syncSites();
+    void emitText(const char* bytes, size_t size);
+
+    static uint32_t threadId();
+    static int64_t nowNanos();
+
+    std::atomic<uint8_t> level_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<Mode> mode_;
+
+    std::mutex sites_mutex_;
+    std::vector<LogSite*> sites_;
+    size_t sites_written_;
+
+    std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex writer_mutex_; // held while draining; also guards output_ and decoder_
+    std::condition_variable writer_cv_;
+    std::atomic<bool> running_;
+    std::thread writer_;
+    std::FILE* output_;
+    LogDecoder decoder_;
+    std::vector<char> scratch_;
+};
+
+#define ZLOG_FORMAT_(format, ...) format
+#define ZLOG_AT(level, ...)                                                         \
+    do {                                                                            \
+        if constexpr (logCompiledIn(level)) {                                       \
+            static LogSite zlog_site_(level, __FILE__, __LINE__,                    \
+                                      ZLOG_FORMAT_(__VA_ARGS__, ));                 \
+            Logger::instance().write(zlog_site_, __VA_ARGS__);                      \
+        }                                                                           \
+    } while (0)
+
+#define LOG_TRACE(...) ZLOG_AT(LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) ZLOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) ZLOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) ZLOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) ZLOG_AT(LogLevel::Error, __VA_ARGS__)
+
+// Guards work done only to produce log output (e.g. extra API calls for a debug dump)
+#define LOG_ENABLED(level) (logCompiledIn(level) && Logger::instance().enabled(level))
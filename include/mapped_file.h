@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file (POSIX mmap / Win32 file mapping).
+// An empty or missing file maps to an empty view.
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+#ifdef _WIN32
+    void* file_handle_;
+    void* mapping_handle_;
+#else
+    int fd_;
+#endif
+};
+
+// Replaces `to` with `from` in one step, so a crash leaves either file whole
+// (rename() plus a directory fsync on POSIX, MoveFileEx on Windows)
+bool replaceFile(const std::string& from, const std::string& to);
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include "price.h"
+
+// Structure for candle data
+struct CandleData {
+    std::string timestamp;
+    Price open;
+    Price high;
+    Price low;
+    Price close;
+    int volume;
+    int oi; // Open Interest (optional)
+    
+    CandleData() : volume(0), oi(0) {}
+};
+
+// Structure for trade settings
+struct TradeSetting {
+    std::string symbol;
+    int quantity;
+    std::string timeframe;
+    int ema_period;
+    double target_multiple; // optional column, 2:1 when blank
+    std::string stop_rule;  // optional column: "extreme" (default) or "second"
+    
+    TradeSetting() : quantity(0), ema_period(0), target_multiple(2.0) {}
+};
+
+// Structure for last 3 candle data
+struct LastThreeCandles {
+    // Last candle (most recent)
+    Price last_open, last_high, last_low, last_close;
+    double last_ema;
+    
+    // Second candle
+    Price second_open, second_high, second_low, second_close;
+    double second_ema;
+    
+    // Third candle (oldest)
+    Price third_open, third_high, third_low, third_close;
+    double third_ema;
+    
+    LastThreeCandles() : last_ema(0), second_ema(0), third_ema(0) {}
+};
+
+// Structure for trade signals
+struct TradeSignal {
+    std::string symbol;
+    std::string action; // "BUY", "SELL", "BUY_STOPLOSS", "BUY_TARGET", "SELL_STOPLOSS", "SELL_TARGET"
+    Price entry_price;
+    Price stop_loss;
+    Price target;
+    int quantity;
+    
+    TradeSignal() : quantity(0) {}
+};
+
+// Structure for active positions
+struct ActivePosition {
+    std::string symbol;
+    std::string entry_order_id;
+    std::string stop_loss_order_id;
+    std::string target_order_id;
+    std::string action; // "BUY" or "SELL"
+    Price entry_price;
+    Price stop_loss;
+    Price target;
+    int quantity;
+    bool stop_loss_placed;
+    bool target_placed;
+    
+    ActivePosition() : quantity(0), stop_loss_placed(false), target_placed(false) {}
+};
+
+// One order from the broker's order book (GET /orders)
+struct BrokerOrder {
+    std::string order_id;
+    std::string status; // "OPEN", "TRIGGER PENDING", "COMPLETE", "CANCELLED", "REJECTED"
+    std::string symbol;
+    std::string transaction_type;
+    std::string order_type;
+    std::string tag;
+    int quantity;
+    int filled_quantity;
+    Price average_price;
+    
+    BrokerOrder() : quantity(0), filled_quantity(0) {}
+};
+
+// One row of GET /portfolio/positions (the "net" list)
+struct BrokerPosition {
+    std::string symbol;
+    std::string exchange;
+    std::string product;
+    int quantity; // net: positive long, negative short
+    Price average_price;
+    
+    BrokerPosition() : quantity(0) {}
+};
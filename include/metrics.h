@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "latency_histogram.h"
+
+// Monotonic counter split into cache-line shards. Each thread always adds
+// to the same shard, so increments are uncontended relaxed adds; value()
+// sums the shards when the metrics are scraped.
+class MetricCounter {
+public:
+    static constexpr size_t kShards = 16;
+
+    MetricCounter() = default;
+    MetricCounter(const MetricCounter&) = delete;
+    MetricCounter& operator=(const MetricCounter&) = delete;
+
+    void inc(uint64_t n = 1) { shards_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static size_t shardIndex();
+
+    std::array<Shard, kShards> shards_;
+};
+
+// Last-written value (seconds, counts, bytes)
+class MetricGauge {
+public:
+    MetricGauge() : value_(0.0) {}
+    MetricGauge(const MetricGauge&) = delete;
+    MetricGauge& operator=(const MetricGauge&) = delete;
+
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_;
+};
+
+// Named counters and gauges rendered in the Prometheus text format.
+//
+// Registration takes a lock and returns a reference that stays valid for the
+// registry's lifetime; callers keep it and update it without any lookup.
+// Collectors run at scrape time, under the registry lock, for values that
+// are cheaper to read on demand (memory use, histograms); they may update
+// gauges they already hold but must not register new metrics.
+class MetricsRegistry {
+public:
+    using Collector = std::function<void(std::string& out)>;
+
+    // labels in Prometheus syntax without braces, e.g. endpoint="ltp"
+    MetricCounter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    MetricGauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    void addCollector(Collector collector);
+
+    std::string render() const;
+
+    // Summary with p50 / p99 / p99.9 quantiles plus _sum and _count, in seconds
+    static void appendSummary(std::string& out, const std::string& name, const std::string& help,
+                              const std::string& labels, const LatencyHistogram& histogram, bool with_header);
+    static void appendSample(std::string& out, const std::string& name, const std::string& labels, double value);
+
+    // Resident set size of this process, 0 when the platform doesn't say
+    static uint64_t residentMemoryBytes();
+
+private:
+    struct Family {
+        std::string help;
+        std::string type;
+        std::vector<std::pair<std::string, std::unique_ptr<MetricCounter>>> counters;
+        std::vector<std::pair<std::string, std::unique_ptr<MetricGauge>>> gauges;
+    };
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+    std::vector<Collector> collectors_;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "backtest.h"
+
+// One symbol's candles plus its trading constants; shared read-only by all runs
+struct OptimizerSeries {
+    std::string symbol;
+    CandleSeries candles;
+    Price tick;
+    int quantity;
+
+    OptimizerSeries() : tick(Price::fromPaise(5)), quantity(1) {}
+};
+
+// Parameter space to search: full grid, or random_samples draws from its bounds
+struct SweepSpace {
+    std::vector<int> ema_periods;
+    std::vector<double> target_multiples;
+    std::vector<StopRule> stop_rules;
+    size_t random_samples; // 0 = full grid
+    unsigned seed;
+
+    SweepSpace() : random_samples(0), seed(42) {}
+
+    std::vector<StrategyParams> combinations() const;
+};
+
+// Rolling walk-forward layout: each window trains on train_fraction of its
+// span and is scored on the bars that follow. windows == 0 scores the whole
+// series in-sample only.
+struct WalkForwardConfig {
+    int windows;
+    double train_fraction;
+
+    WalkForwardConfig() : windows(4), train_fraction(0.7) {}
+};
+
+// Bar ranges of one walk-forward window
+struct WalkForwardWindow {
+    size_t train_begin;
+    size_t train_end; // also the first test bar
+    size_t test_end;
+};
+
+// Aggregate score of one parameter set across every symbol and window
+struct ComboResult {
+    StrategyParams params;
+    BacktestResult in_sample;
+    BacktestResult out_of_sample;
+    int positive_windows; // symbol/window pairs with a profitable test period
+    int scored_windows;
+
+    ComboResult() : positive_windows(0), scored_windows(0) {}
+
+    // Ranking key: out-of-sample P&L when walk-forward is on, else in-sample
+    int64_t score() const;
+};
+
+// Parallel parameter sweep over shared candle columns.
+//
+// Work is split into (symbol, EMA period) tasks on a WorkStealingPool: each
+// task computes the EMA column once and replays every combination that uses
+// that period over all of the symbol's windows, so neither candles nor EMA
+// values are copied per run.
+class ParameterOptimizer {
+public:
+    ParameterOptimizer(const std::vector<OptimizerSeries>& series, int threads);
+
+    // Returns combinations sorted best first
+    std::vector<ComboResult> run(const std::vector<StrategyParams>& combinations, const WalkForwardConfig& walk_forward,
+                                 const BacktestOptions& options = BacktestOptions());
+
+    // Out-of-sample result of re-picking the best in-sample combination in every window
+    const BacktestResult& walkForwardResult() const { return walk_forward_result_; }
+
+    // Candles replayed by the last run (train and test passes counted separately)
+    uint64_t candlesReplayed() const { return candles_replayed_; }
+
+    static std::vector<WalkForwardWindow> windowsFor(size_t bars, const WalkForwardConfig& walk_forward);
+
+private:
+    const std::vector<OptimizerSeries>& series_;
+    int threads_;
+    BacktestResult walk_forward_result_;
+    uint64_t candles_replayed_;
+};
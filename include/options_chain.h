@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "instrument_store.h"
+
+enum class OptionType { CE, PE };
+
+// Options chain index over the instrument store:
+// underlying -> expiry -> strike -> CE/PE row.
+// Expiries and strikes are kept in sorted vectors so expiry and strike
+// selection are binary searches instead of scans over the instrument dump.
+class OptionsChain {
+public:
+    struct StrikeEntry {
+        Price strike;
+        InstrumentStore::Row ce;
+        InstrumentStore::Row pe;
+
+        StrikeEntry() : ce(InstrumentStore::npos), pe(InstrumentStore::npos) {}
+
+        InstrumentStore::Row row(OptionType type) const { return type == OptionType::CE ? ce : pe; }
+    };
+
+    struct ExpirySlice {
+        int expiry; // yyyymmdd
+        std::vector<StrikeEntry> strikes; // sorted by strike
+    };
+
+    OptionsChain();
+
+    // Builds the chain from the option segments of the store (NFO-OPT by default).
+    // as_of is the build date (yyyymmdd); expiries before it are dropped.
+    void build(const InstrumentStore& store, int as_of,
+               const std::vector<std::string>& segments = {"NFO-OPT"});
+    void clear();
+
+    bool empty() const { return chains_.empty(); }
+    int builtOn() const { return built_on_; }
+    size_t underlyingCount() const { return chains_.size(); }
+
+    // Lookups (all O(log n))
+    const std::vector<ExpirySlice>* expiries(std::string_view underlying) const;
+    const ExpirySlice* nearestExpiry(std::string_view underlying, int on_or_after) const;
+    const StrikeEntry* nearestStrike(const ExpirySlice& slice, Price price) const;
+    const StrikeEntry* atm(std::string_view underlying, Price ltp, int on_or_after) const;
+
+    // ATM strike shifted by strike_offset steps (positive = higher strikes) on the nearest expiry.
+    // Returns InstrumentStore::npos when the underlying, expiry or strike is not listed.
+    InstrumentStore::Row select(std::string_view underlying, Price ltp, OptionType type,
+                                int strike_offset, int on_or_after) const;
+
+private:
+    std::unordered_map<std::string, size_t> underlying_index_;
+    std::vector<std::vector<ExpirySlice>> chains_;
+    int built_on_;
+};
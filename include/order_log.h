@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+#include "price.h"
+
+// OrderLog.txt, one pipe-delimited line per event:
+//
+//   2025-07-18 12:44:05 | ENTRY | SELL | ABCAPITAL | Price: 265.35 | Qty: 1 | Order ID: 250718200687420
+//   2025-07-18 12:44:05 | STOPLOSS | BUY | ABCAPITAL | Price: 266.05 | Qty: 1 | Order ID: 250718200687425
+//   2025-07-18 13:02:41 | TARGET_HIT | BUY | ABCAPITAL | Price: 263.95 | Qty: 1 | Order ID: 250718200687430 | Entry ID: 250718200687420
+//
+// Exit lines (STOPLOSS_HIT / TARGET_HIT) name the leg that closed the trade
+// and the entry it belongs to. Older logs wrote them as "time | TARGET_HIT |
+// SYMBOL | Price: x"; those are still read and paired by symbol.
+enum class OrderLogEvent : uint8_t { Entry, StopLoss, Target, StopLossHit, TargetHit, Count };
+
+struct OrderLogRecord {
+    int64_t timestamp; // local wall-clock time as seconds since 1970-01-01 00:00:00 (no time zone)
+    OrderLogEvent event;
+    bool buy;          // side of this order; for exits, the side of the closing order
+    std::string symbol;
+    Price price;
+    int quantity;      // 0 when the line does not say
+    std::string order_id;
+    std::string entry_id;
+
+    OrderLogRecord() : timestamp(0), event(OrderLogEvent::Entry), buy(true), quantity(0) {}
+};
+
+const char* orderLogEventName(OrderLogEvent event);
+int64_t orderLogTimestamp(const std::tm& local_time);
+std::string formatOrderLogLine(const OrderLogRecord& record);
+// Parses one line (without the newline); false for anything that is not an order event
+bool parseOrderLogLine(const char* begin, const char* end, OrderLogRecord& record);
+bool appendOrderLog(const std::string& path, const OrderLogRecord& record);
+
+// Compact binary index over one or more order logs.
+//
+// Each log gets a "<log>.idx" next to it holding fixed 40-byte records and
+// the symbol table. The index remembers how many bytes of the log it covers
+// and a hash of the first 4 KB; as long as the log has only been appended
+// to, opening it parses just the new tail. Order ids are stored as 64-bit
+// keys (the numeric Kite id, or a hash for anything else).
+class OrderLogIndex {
+public:
+    struct Entry {
+        int64_t timestamp;
+        int64_t price_paise;
+        uint64_t order_key; // 0 when absent
+        uint64_t entry_key; // exits only; 0 when absent
+        int32_t quantity;
+        uint16_t symbol;    // into symbols()
+        uint8_t event;
+        uint8_t buy;
+    };
+    static_assert(sizeof(Entry) == 40, "index entries are 40 bytes");
+
+    OrderLogIndex() : parsed_lines_(0) {}
+
+    // Loads (or builds, or extends) the index for `log_path` and appends its entries
+    bool add(const std::string& log_path, bool rebuild = false);
+
+    const std::vector<Entry>& entries() const { return entries_; }
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    // Lines parsed from text by the last add() (0 when the index was current)
+    size_t parsedLines() const { return parsed_lines_; }
+
+    static uint64_t orderKey(const std::string& order_id);
+
+private:
+    uint16_t symbolId(const std::string& symbol);
+
+    std::vector<Entry> entries_;
+    std::vector<std::string> symbols_;
+    std::map<std::string, uint16_t> symbol_ids_;
+    size_t parsed_lines_;
+};
+
+// Closed-trade statistics for one group (a day, a symbol, or everything)
+struct TradeStats {
+    int64_t trades;
+    int64_t wins;
+    int64_t pnl_paise;
+    int64_t gross_profit_paise;
+    int64_t gross_loss_paise;
+    int64_t holding_seconds;
+
+    TradeStats() : trades(0), wins(0), pnl_paise(0), gross_profit_paise(0), gross_loss_paise(0), holding_seconds(0) {}
+
+    void add(int64_t pnl, int64_t held) {
+        ++trades;
+        wins += pnl > 0 ? 1 : 0;
+        pnl_paise += pnl;
+        (pnl > 0 ? gross_profit_paise : gross_loss_paise) += pnl;
+        holding_seconds += held;
+    }
+    double winRate() const { return trades ? static_cast<double>(wins) / trades : 0.0; }
+    double averageHoldingSeconds() const { return trades ? static_cast<double>(holding_seconds) / trades : 0.0; }
+};
+
+struct OrderLogReport {
+    TradeStats total;
+    std::map<int64_t, TradeStats> by_day;        // days since 1970-01-01 of the exit
+    std::map<std::string, TradeStats> by_symbol;
+    int64_t open_entries;    // entries with no exit in the logs
+    int64_t unmatched_exits; // exits whose entry is not in the logs
+
+    OrderLogReport() : open_entries(0), unmatched_exits(0) {}
+};
+
+// Pairs entries with exits (entry id, else the leg's order id, else the
+// symbol's latest open entry) in one pass; `from_day`/`to_day` bound exit days
+OrderLogReport analyzeOrderLog(const OrderLogIndex& index, int64_t from_day = INT64_MIN, int64_t to_day = INT64_MAX);
+std::string formatOrderLogDay(int64_t day);
+bool parseOrderLogDay(const std::string& text, int64_t& day);
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "latency_histogram.h"
+#include "price.h"
+
+enum class OrderState : uint8_t { Pending, Open, Partial, Filled, Cancelled, Rejected, Count };
+enum class OrderLeg : uint8_t { Entry, StopLoss, Target };
+
+// Point-in-time copy of one order, for logging and tests
+struct OrderView {
+    uint32_t id;
+    OrderState state;
+    OrderLeg leg;
+    bool buy;
+    bool cancel_requested;
+    bool modify_pending;
+    int quantity;
+    int filled_quantity;
+    Price price;
+    std::string symbol;
+    std::string broker_order_id;
+
+    OrderView() : id(0), state(OrderState::Pending), leg(OrderLeg::Entry), buy(true), cancel_requested(false),
+                  modify_pending(false), quantity(0), filled_quantity(0) {}
+};
+
+// Lifecycle of every order the bot sends during a session.
+//
+// Orders live in a fixed table indexed by a dense internal id handed out by
+// create(). Each slot's state, cumulative fill and request flags share one
+// 64-bit word that is only changed by compare-and-swap against a transition
+// table, so the network thread placing orders and the thread applying broker
+// updates never take a lock, and every transition is O(1). Broker order ids
+// map to internal ids through an insert-only open-addressing index.
+//
+//   PENDING -> OPEN -> PARTIAL -> FILLED
+//         \        \          \-> CANCELLED
+//          \        \-> CANCELLED / FILLED
+//           \-> REJECTED / CANCELLED / PARTIAL / FILLED (update raced the ack)
+//
+// Latencies go to the LatencyRecorder and end when a transition is applied,
+// not when the exchange made it. Broker statuses arrive only through the
+// reconciler's order book poll (every 30 s), so order_fill_seen is the time
+// from create() until a poll first saw the fill: it mostly measures the poll
+// phase and is no measure of exchange fill latency. Cancel and modify
+// latencies start at requestCancel() and requestModify(); the client does not
+// cancel or modify orders yet. Slots are not reused within a trading day;
+// reset() starts the next one.
+class OrderManager {
+public:
+    static constexpr uint32_t kNoOrder = UINT32_MAX;
+
+    explicit OrderManager(LatencyRecorder& latency, uint32_t capacity = 8192);
+
+    OrderManager(const OrderManager&) = delete;
+    OrderManager& operator=(const OrderManager&) = delete;
+
+    // Owning thread: allocates a PENDING order; kNoOrder when the table is full
+    uint32_t create(const std::string& symbol, OrderLeg leg, bool buy, int quantity, Price price);
+    // Owning thread, once per order: makes the order findable by the broker's id
+    bool bindBrokerId(uint32_t id, const std::string& broker_order_id);
+    // Owning thread, with no other thread using the table: forgets every order
+    void reset();
+
+    // Any thread. Each returns false when the transition is not allowed from
+    // the current state (late or duplicate updates are dropped, not applied).
+    bool acknowledge(uint32_t id);
+    bool reject(uint32_t id);
+    bool fill(uint32_t id, int filled_quantity); // cumulative quantity; PARTIAL until it reaches the order's
+    bool requestCancel(uint32_t id);
+    bool cancelled(uint32_t id);
+    bool requestModify(uint32_t id);
+    bool modified(uint32_t id);
+
+    // Applies one row of the broker's order book ("OPEN", "TRIGGER PENDING", "COMPLETE", ...)
+    bool applyBrokerStatus(const std::string& broker_order_id, const std::string& status, int filled_quantity);
+
+    uint32_t find(const std::string& broker_order_id) const;
+    OrderState state(uint32_t id) const;
+    int filledQuantity(uint32_t id) const;
+    bool view(uint32_t id, OrderView& out) const;
+
+    uint32_t size() const;
+    uint32_t capacity() const { return capacity_; }
+    // Orders not yet in a terminal state
+    uint32_t live() const { return live_.load(std::memory_order_relaxed); }
+
+    // Broker statuses of an order that can still execute, including the
+    // transient ones while a modification or cancellation is in flight
+    static bool isLiveStatus(const std::string& status);
+    static const char* stateName(OrderState state);
+    static bool canTransition(OrderState from, OrderState to);
+    static bool isTerminal(OrderState state) {
+        return state == OrderState::Filled || state == OrderState::Cancelled || state == OrderState::Rejected;
+    }
+
+private:
+    // Slot word: state (8 bits) | flags (8 bits) | cumulative fill (32 bits)
+    static constexpr uint64_t kCancelRequested = 1;
+    static constexpr uint64_t kModifyPending = 2;
+
+    static uint64_t pack(OrderState state, uint64_t flags, uint32_t filled) {
+        return static_cast<uint64_t>(state) | (flags << 8) | (static_cast<uint64_t>(filled) << 16);
+    }
+    static OrderState stateOf(uint64_t word) { return static_cast<OrderState>(word & 0xFF); }
+    static uint64_t flagsOf(uint64_t word) { return (word >> 8) & 0xFF; }
+    static uint32_t filledOf(uint64_t word) { return static_cast<uint32_t>(word >> 16); }
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> word;
+        int32_t quantity;
+        OrderLeg leg;
+        bool buy;
+        int64_t price_paise;
+        int64_t created_ns;
+        std::atomic<int64_t> cancel_requested_ns;
+        std::atomic<int64_t> modify_requested_ns;
+        char symbol[32];
+        char broker_order_id[32];
+    };
+
+    // Moves `id` to `to` (optionally with a new fill) when the table allows it;
+    // returns the word it replaced through `previous`
+    bool transition(uint32_t id, OrderState to, uint32_t filled, uint64_t& previous);
+    void finished(uint32_t id, OrderState from, OrderState to);
+    bool setFlag(uint32_t id, uint64_t flag, std::atomic<int64_t> Slot::*stamp);
+    static int64_t nowNanos();
+    static uint64_t hashId(const char* data, size_t size);
+
+    LatencyRecorder& latency_;
+    uint32_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint32_t> next_;
+    std::atomic<uint32_t> live_;
+
+    // Broker id -> internal id + 1 (0 = empty); twice the table size, power of two
+    uint64_t index_mask_;
+    std::unique_ptr<std::atomic<uint32_t>[]> index_;
+};
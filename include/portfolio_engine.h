@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "price.h"
+#include "seqlock.h"
+
+// Portfolio-wide figures, published as one consistent snapshot (all in paise)
+struct PortfolioTotals {
+    int64_t gross_exposure_paise; // sum of |quantity| x mark
+    int64_t net_exposure_paise;   // sum of signed quantity x mark
+    int64_t realized_pnl_paise;   // booked on reductions and closes this session
+    int64_t unrealized_pnl_paise; // open quantity x (mark - average entry)
+    int64_t open_positions;
+    int64_t updates;              // fills and marks applied so far
+
+    PortfolioTotals() : gross_exposure_paise(0), net_exposure_paise(0), realized_pnl_paise(0),
+                        unrealized_pnl_paise(0), open_positions(0), updates(0) {}
+
+    int64_t pnlPaise() const { return realized_pnl_paise + unrealized_pnl_paise; }
+};
+
+// Mark-to-market P&L and exposure per symbol, updated from fills and LTPs.
+//
+// Each position keeps its quantity, average entry and last mark. A fill or
+// mark removes that position's old share from the running totals and adds
+// the new one, so an update costs the same with one position or five hundred
+// and the totals are never recomputed by a scan. Updates come from the
+// trading loop thread; after each one (or each batch of marks) the totals are
+// published through a seqlock that the metrics endpoint, the risk gate or a
+// UI can read from any thread without ever holding up the loop.
+class PortfolioEngine {
+public:
+    static constexpr uint32_t kNoSlot = UINT32_MAX;
+
+    struct Position {
+        int64_t quantity;      // signed net quantity
+        int64_t average_paise; // average entry of the open quantity
+        int64_t mark_paise;    // last price seen
+        int64_t realized_paise;
+
+        Position() : quantity(0), average_paise(0), mark_paise(0), realized_paise(0) {}
+        int64_t unrealizedPaise() const { return quantity * (mark_paise - average_paise); }
+    };
+
+    PortfolioEngine();
+
+    // Slot for a symbol, created on first use (may allocate; keep it off the order path)
+    uint32_t registerSymbol(const std::string& symbol);
+    uint32_t find(const std::string& symbol) const;
+
+    // Writer thread. onFill returns the P&L this fill realized.
+    int64_t onFill(uint32_t slot, bool buy, int quantity, Price price);
+    void onMark(uint32_t slot, Price price);
+    // Marks between beginBatch() and endBatch() are published once, at the end
+    void beginBatch() { ++batch_depth_; }
+    void endBatch();
+
+    // Writer thread; a flat position for kNoSlot
+    Position position(uint32_t slot) const { return slot < positions_.size() ? positions_[slot] : Position(); }
+
+    // Any thread, never blocks the writer
+    PortfolioTotals snapshot() const { return published_.load(); }
+
+private:
+    // Adds (sign 1) or removes (sign -1) one position's share of the totals
+    void contribute(const Position& position, int64_t sign);
+    void publish();
+
+    std::vector<Position> positions_;
+    std::unordered_map<std::string, uint32_t> slots_;
+
+    PortfolioTotals totals_; // writer's running copy
+    int batch_depth_;
+    Seqlock<PortfolioTotals> published_;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "market_data.h"
+
+// Write-ahead journal of position state transitions (positions.journal).
+//
+// Every transition is one fixed-size, CRC-checked record appended with a
+// single write(); a background thread batches the fsyncs, so recording a
+// fill costs a syscall and never waits for the disk. After a process crash
+// everything written is in the page cache; after a power loss at most one
+// sync interval is lost. Replay folds the records into the positions map
+// and stops at the first torn or corrupt record, then the file is rewritten
+// to hold only the positions that are still open.
+class PositionJournal {
+public:
+    enum class Event : uint8_t { Opened = 1, StopLossPlaced = 2, TargetPlaced = 3, Closed = 4 };
+
+    // On-disk record, little-endian as written by the host
+    struct Record {
+        uint32_t crc;      // CRC-32 of the remaining 124 bytes
+        uint8_t event;
+        uint8_t side;      // 0 buy, 1 sell
+        uint16_t reserved;
+        uint64_t sequence;
+        int64_t timestamp_ms;
+        int64_t entry_paise;
+        int64_t stop_loss_paise;
+        int64_t target_paise;
+        int32_t quantity;
+        uint32_t reserved2;
+        char symbol[32];   // NUL-padded
+        char order_id[40]; // entry, SL or target order id depending on the event
+    };
+    static_assert(sizeof(Record) == 128, "journal records are 128 bytes");
+
+    explicit PositionJournal(std::chrono::milliseconds sync_interval = std::chrono::milliseconds(20));
+    ~PositionJournal();
+
+    PositionJournal(const PositionJournal&) = delete;
+    PositionJournal& operator=(const PositionJournal&) = delete;
+
+    // Replays `path` into `positions`, compacts it and opens it for appending
+    bool open(const std::string& path, std::map<std::string, ActivePosition>& positions);
+    void close();
+    bool isOpen() const;
+
+    void opened(const ActivePosition& position, int64_t timestamp_ms);
+    void stopLossPlaced(const std::string& symbol, const std::string& order_id, int64_t timestamp_ms);
+    void targetPlaced(const std::string& symbol, const std::string& order_id, int64_t timestamp_ms);
+    void closed(const std::string& symbol, int64_t timestamp_ms);
+
+    // Records replayed by the last open() and the bytes dropped after the last good one
+    size_t replayedRecords() const { return replayed_; }
+    size_t discardedBytes() const { return discarded_; }
+
+    // Folds a journal image into `positions`; returns the length of the valid prefix
+    static size_t replay(const uint8_t* data, size_t size, std::map<std::string, ActivePosition>& positions,
+                         size_t& records);
+    static uint32_t crc32(const void* data, size_t size);
+
+private:
+    void append(Record& record);
+    bool writeRecords(int fd, const std::map<std::string, ActivePosition>& positions);
+    void syncLoop();
+
+    std::chrono::milliseconds sync_interval_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    int fd_;
+    uint64_t sequence_;
+    bool dirty_;
+    bool stopping_;
+    std::thread sync_thread_;
+    size_t replayed_;
+    size_t discarded_;
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <charconv>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Tick rounding direction used when snapping a computed price onto the exchange tick grid
+enum class TickRounding { Nearest, Down, Up };
+
+// Fixed-point price in paise (1/100 rupee), stored as int64.
+// Candle OHLC, LTP, stop loss, target and order prices all use this type so
+// comparisons are integer compares and order payloads never carry binary
+// floating point noise. Doubles are only used for indicator math (EMA).
+class Price {
+public:
+    static constexpr int64_t kScale = 100;
+
+    constexpr Price() : paise_(0) {}
+
+    static constexpr Price fromPaise(int64_t paise) { return Price(paise); }
+
+    static Price fromDouble(double rupees) {
+        return Price(static_cast<int64_t>(std::llround(rupees * kScale)));
+    }
+
+    // Parses decimal text such as "265.35" or "-0.05" without going through double.
+    // Digits beyond the second decimal are rounded half away from zero.
+    static bool parse(std::string_view text, Price& out) {
+        size_t i = 0;
+        bool negative = false;
+        if (i < text.size() && (text[i] == '-' || text[i] == '+')) {
+            negative = text[i] == '-';
+            ++i;
+        }
+
+        int64_t whole = 0;
+        bool any_digit = false;
+        while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+            whole = whole * 10 + (text[i] - '0');
+            any_digit = true;
+            ++i;
+        }
+
+        int64_t fraction = 0;
+        int fraction_digits = 0;
+        bool round_up = false;
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                if (fraction_digits < 2) {
+                    fraction = fraction * 10 + (text[i] - '0');
+                    ++fraction_digits;
+                } else if (fraction_digits == 2) {
+                    round_up = text[i] >= '5';
+                    ++fraction_digits;
+                }
+                any_digit = true;
+                ++i;
+            }
+        }
+        if (!any_digit || i != text.size()) return false;
+
+        for (int d = fraction_digits; d < 2; ++d) fraction *= 10;
+        int64_t paise = whole * kScale + fraction + (round_up ? 1 : 0);
+        out = Price(negative ? -paise : paise);
+        return true;
+    }
+
+    static Price parseOr(std::string_view text, Price fallback) {
+        Price value;
+        return parse(text, value) ? value : fallback;
+    }
+
+    constexpr int64_t paise() const { return paise_; }
+    constexpr double toDouble() const { return static_cast<double>(paise_) / kScale; }
+    constexpr bool isZero() const { return paise_ == 0; }
+
+    // Snaps the price onto a multiple of tick (tick <= 0 leaves the price unchanged)
+    Price roundToTick(Price tick, TickRounding mode = TickRounding::Nearest) const {
+        int64_t t = tick.paise_;
+        if (t <= 0) return *this;
+
+        int64_t q = paise_ / t;
+        int64_t r = paise_ % t;
+        if (r < 0) {
+            r += t;
+            --q;
+        }
+        if (r == 0) return *this;
+
+        switch (mode) {
+            case TickRounding::Down: break;
+            case TickRounding::Up: ++q; break;
+            case TickRounding::Nearest: if (2 * r >= t) ++q; break;
+        }
+        return Price(q * t);
+    }
+
+    // Writes "1234.50" into buf (at least 24 bytes) and returns one past the last character
+    char* format(char* buf) const {
+        int64_t value = paise_;
+        char* p = buf;
+        if (value < 0) {
+            *p++ = '-';
+            value = -value;
+        }
+        p = std::to_chars(p, p + 20, value / kScale).ptr;
+        int64_t fraction = value % kScale;
+        *p++ = '.';
+        *p++ = static_cast<char>('0' + fraction / 10);
+        *p++ = static_cast<char>('0' + fraction % 10);
+        return p;
+    }
+
+    std::string toString() const {
+        char buf[24];
+        return std::string(buf, format(buf));
+    }
+
+    constexpr Price operator+(Price other) const { return Price(paise_ + other.paise_); }
+    constexpr Price operator-(Price other) const { return Price(paise_ - other.paise_); }
+    constexpr Price operator*(int64_t factor) const { return Price(paise_ * factor); }
+    constexpr Price operator-() const { return Price(-paise_); }
+    Price& operator+=(Price other) { paise_ += other.paise_; return *this; }
+    Price& operator-=(Price other) { paise_ -= other.paise_; return *this; }
+
+    constexpr bool operator==(Price other) const { return paise_ == other.paise_; }
+    constexpr bool operator!=(Price other) const { return paise_ != other.paise_; }
+    constexpr bool operator<(Price other) const { return paise_ < other.paise_; }
+    constexpr bool operator<=(Price other) const { return paise_ <= other.paise_; }
+    constexpr bool operator>(Price other) const { return paise_ > other.paise_; }
+    constexpr bool operator>=(Price other) const { return paise_ >= other.paise_; }
+
+private:
+    explicit constexpr Price(int64_t paise) : paise_(paise) {}
+
+    int64_t paise_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, Price price) {
+    char buf[24];
+    return os.write(buf, price.format(buf) - buf);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "market_data.h"
+
+// One difference between the broker's books and the bot's positions
+struct Discrepancy {
+    enum class Kind : uint8_t {
+        MissedFill,        // an exit leg filled (or the broker is flat) but the position is still open here
+        OrphanLeg,         // a live SL/target order with no position, or a second one for the same leg
+        UntrackedLeg,      // a leg the broker accepted although its POST was not recorded as placed
+        LostLeg,           // a leg recorded as placed that is not live at the broker
+        EntryNotFilled,    // the entry order is missing, rejected or cancelled
+        QuantityMismatch,  // the broker's net quantity differs from the position
+        UntrackedPosition, // a net MIS position the bot does not know about
+        Count
+    };
+    enum class Leg : uint8_t { None, Entry, StopLoss, Target };
+
+    Kind kind;
+    Leg leg;
+    std::string symbol;
+    std::string order_id;
+    int expected_quantity; // signed, as the bot sees it
+    int broker_quantity;   // signed net quantity at the broker
+
+    Discrepancy() : kind(Kind::MissedFill), leg(Leg::None), expected_quantity(0), broker_quantity(0) {}
+    Discrepancy(Kind kind, Leg leg, const std::string& symbol, const std::string& order_id)
+        : kind(kind), leg(leg), symbol(symbol), order_id(order_id), expected_quantity(0), broker_quantity(0) {}
+
+    static const char* kindName(Kind kind);
+    static const char* legName(Leg leg);
+};
+
+// Result of one reconciliation pass against a published view of the positions
+struct ReconcileReport {
+    uint64_t sequence;
+    uint64_t local_version; // version of the positions the diff was taken against
+    size_t orders;
+    size_t positions;
+    std::vector<Discrepancy> discrepancies;
+
+    ReconcileReport() : sequence(0), local_version(0), orders(0), positions(0) {}
+};
+
+// Periodically pulls the order book and net positions (one request each) and
+// diffs them against the positions the trading loop last published.
+//
+// The diff is a single pass over each list with hashed order ids and symbols.
+// It runs on its own thread at reduced OS priority, so it never competes with
+// signal evaluation. The trading loop publishes its positions by copy when
+// they change and picks up reports between passes; a report taken against an
+// older version than the loop's current one is stale and should be ignored.
+class Reconciler {
+public:
+    using Fetcher = std::function<bool(std::vector<BrokerOrder>& orders, std::vector<BrokerPosition>& positions)>;
+
+    explicit Reconciler(Fetcher fetcher, std::chrono::milliseconds interval = std::chrono::seconds(30));
+    ~Reconciler();
+
+    Reconciler(const Reconciler&) = delete;
+    Reconciler& operator=(const Reconciler&) = delete;
+
+    // Called by the trading loop whenever its positions change
+    void publishLocal(uint64_t version, std::vector<ActivePosition> positions);
+
+    bool start();
+    void stop();
+
+    std::shared_ptr<const ReconcileReport> latest() const { return std::atomic_load(&report_); }
+    // Sequence of the latest report; cheap to poll from the trading loop
+    uint64_t sequence() const { return sequence_.load(std::memory_order_acquire); }
+
+    // Positions are the bot's (MIS) positions; only MIS rows of `broker_positions` are considered
+    static std::vector<Discrepancy> diff(const std::vector<ActivePosition>& local,
+                                         const std::vector<BrokerOrder>& orders,
+                                         const std::vector<BrokerPosition>& broker_positions);
+
+private:
+    struct LocalPositions {
+        uint64_t version;
+        std::vector<ActivePosition> positions;
+
+        LocalPositions() : version(0) {}
+    };
+
+    void run();
+    void reconcileOnce();
+
+    Fetcher fetcher_;
+    std::chrono::milliseconds interval_;
+
+    std::shared_ptr<const LocalPositions> local_;    // accessed only through std::atomic_load/store
+    std::shared_ptr<const ReconcileReport> report_;  // accessed only through std::atomic_load/store
+    std::atomic<uint64_t> sequence_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+    std::thread thread_;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "portfolio_engine.h"
+#include "price.h"
+
+// Pre-trade limits; a zero limit is not enforced
+struct RiskLimits {
+    Price max_gross_exposure;  // sum of |quantity| x mark over all symbols
+    Price max_net_exposure;    // |sum of signed quantity x mark|
+    Price max_daily_loss;      // the day's realized + unrealized P&L may not fall below -max_daily_loss
+    int max_orders_per_second; // all orders sent, entries and protective legs alike
+    int max_symbol_quantity;   // |net quantity| per symbol
+
+    RiskLimits() : max_orders_per_second(10), max_symbol_quantity(0) {} // Kite allows 10 orders/s
+};
+
+enum class RiskVerdict : uint8_t {
+    Accept, GrossExposure, NetExposure, DailyLoss, OrderRate, SymbolQuantity, Count
+};
+
+// Pre-trade risk checks for the trading loop.
+//
+// Exposure and P&L come from the portfolio engine's published totals and the
+// symbol's position there, both maintained incrementally, so check() is a
+// few integer operations in paise with no scan, lock or allocation and can
+// sit inline before every order. Orders per second use a ring of the last N
+// send times. Orders that shrink a position are only subject to the rate
+// limit, so exits are never blocked.
+class RiskGate {
+public:
+    explicit RiskGate(const PortfolioEngine& portfolio, const RiskLimits& limits = RiskLimits());
+
+    void setLimits(const RiskLimits& limits);
+    const RiskLimits& limits() const { return limits_; }
+
+    // Would an order for `quantity` at `price` stay within the limits? `slot` is the
+    // portfolio slot; PortfolioEngine::kNoSlot is a flat symbol.
+    RiskVerdict check(uint32_t slot, bool buy, int quantity, Price price, int64_t now_ms) const;
+
+    void onOrderSent(int64_t now_ms);
+
+    // Starts a trading day: the daily loss limit counts P&L from the current
+    // portfolio total on, plus `booked_today_paise` realized earlier the same
+    // day (by a session before a restart)
+    void startDay(int64_t booked_today_paise = 0);
+    int64_t dayPnlPaise() const { return portfolio_.snapshot().pnlPaise() - day_start_pnl_paise_; }
+
+    static const char* verdictName(RiskVerdict verdict);
+
+private:
+    const PortfolioEngine& portfolio_;
+    RiskLimits limits_;
+    int64_t day_start_pnl_paise_; // portfolio P&L that belongs to earlier days
+
+    // Send times of the last max_orders_per_second orders; next_order_ is the oldest
+    std::vector<int64_t> order_times_;
+    size_t next_order_;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock around a small trivially copyable value.
+//
+// The writer bumps the sequence to odd, stores the value and bumps it back to
+// even; it never waits. A reader copies the value and retries if the
+// sequence was odd or changed meanwhile, so it never blocks the writer and
+// never sees a torn value. The value is held in relaxed atomic words, which
+// keeps the concurrent copy well defined.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock holds trivially copyable values");
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    Seqlock() : sequence_(0) {
+        for (auto& word : words_) word.store(0, std::memory_order_relaxed);
+    }
+
+    explicit Seqlock(const T& value) : Seqlock() { store(value); }
+
+    // Writer thread only
+    void store(const T& value) {
+        uint64_t buffer[kWords] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Any thread
+    T load() const {
+        uint64_t buffer[kWords];
+        for (;;) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // write in progress
+            }
+            for (size_t i = 0; i < kWords; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    // Number of completed writes
+    uint64_t version() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+private:
+    std::atomic<uint64_t> sequence_;
+    std::array<std::atomic<uint64_t>, kWords> words_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "market_data.h"
+
+// One parsed TradeSettings.csv; never modified once published
+struct SettingsSnapshot {
+    uint64_t version;
+    std::vector<TradeSetting> settings;
+
+    SettingsSnapshot() : version(0) {}
+};
+
+// Watches TradeSettings.csv and publishes every successful re-parse as a new
+// immutable snapshot (read-copy-update).
+//
+// Parsing happens on the watcher thread. Readers load the current snapshot
+// with one atomic shared_ptr copy and may keep it as long as they like; a
+// replaced snapshot is freed when its last reader lets go. A file is only
+// parsed once its size and modification time have held still for one poll,
+// so an editor's half-written save is not picked up, and a file that fails
+// to parse leaves the previous snapshot in place.
+class SettingsWatcher {
+public:
+    using Parser = std::function<bool(const std::string& path, std::vector<TradeSetting>& out)>;
+
+    SettingsWatcher(const std::string& path, Parser parser,
+                    std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    ~SettingsWatcher();
+
+    SettingsWatcher(const SettingsWatcher&) = delete;
+    SettingsWatcher& operator=(const SettingsWatcher&) = delete;
+
+    // Publishes settings that were already loaded, so startup does not parse twice
+    void publish(std::vector<TradeSetting> settings);
+
+    bool start();
+    void stop();
+
+    std::shared_ptr<const SettingsSnapshot> current() const { return std::atomic_load(&snapshot_); }
+    // Cheap change check for the trading loop: compare with the last version applied
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+    struct FileStamp {
+        int64_t mtime;
+        uint64_t size;
+
+        FileStamp() : mtime(0), size(0) {}
+        bool operator==(const FileStamp& other) const { return mtime == other.mtime && size == other.size; }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    };
+
+    bool readStamp(FileStamp& stamp) const;
+    void watchLoop(FileStamp applied);
+
+    std::string path_;
+    Parser parser_;
+    std::chrono::milliseconds interval_;
+
+    std::shared_ptr<const SettingsSnapshot> snapshot_; // accessed only through std::atomic_load/store
+    std::atomic<uint64_t> version_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+    std::thread thread_;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include "market_data.h"
+
+// Side of a strategy decision
+enum class SignalSide { None, Buy, Sell };
+
+// How the protective stop is placed for a new entry
+enum class StopRule {
+    TwoCandleExtreme, // lowest low / highest high of the second and third candles (live default)
+    SecondCandle      // low / high of the second candle only
+};
+
+// Tunable parameters of the EMA three-candle strategy
+struct StrategyParams {
+    int ema_period;
+    double target_multiple; // target distance as a multiple of the stop distance
+    StopRule stop_rule;
+
+    StrategyParams() : ema_period(20), target_multiple(2.0), stop_rule(StopRule::TwoCandleExtreme) {}
+};
+
+// Allocation-free result of one strategy evaluation
+struct SignalDecision {
+    SignalSide side;
+    Price entry_price;
+    Price stop_loss;
+    Price target;
+
+    SignalDecision() : side(SignalSide::None) {}
+};
+
+// EMA three-candle rule shared by the live client, the backtester and the optimizer.
+// Pure function: no I/O and no allocation, so it can be replayed over millions of bars.
+SignalDecision evaluateEmaStrategy(const LastThreeCandles& data, Price ltp, Price tick,
+                                   const StrategyParams& params = StrategyParams());
+
+// The same rule over any window exposing open/high/low/close/ema(age), where
+// age 0 is the latest bar and 2 the oldest. Lets column views of the candle
+// data be evaluated in place instead of being copied into LastThreeCandles.
+template <typename Window>
+SignalDecision evaluateEmaRule(const Window& w, Price ltp, Price tick, const StrategyParams& params);
+
+// EMA multiplier used by calculateEMA and the incremental replays
+inline double emaMultiplier(int period) {
+    return 2.0 / (period + 1.0);
+}
+
+// Stop rule names as written in TradeSettings.csv ("extreme" / "second")
+bool parseStopRule(const std::string& text, StopRule& out);
+const char* stopRuleName(StopRule rule);
+
+// Per-symbol parameters from a TradeSettings.csv row
+StrategyParams strategyParamsFor(const TradeSetting& setting);
+
+inline Price scaleStrategyRisk(Price risk, double multiple) {
+    return Price::fromPaise(static_cast<int64_t>(std::llround(static_cast<double>(risk.paise()) * multiple)));
+}
+
+// Entry at the LTP with the stop from params.stop_rule and the target at
+// params.target_multiple times the risk; shared by every entry rule
+template <typename Window>
+SignalDecision bracketEntry(SignalSide side, const Window& w, Price ltp, Price tick, const StrategyParams& params) {
+    SignalDecision decision;
+    decision.side = side;
+    decision.entry_price = ltp; // Use LTP instead of last candle close
+    if (side == SignalSide::Buy) {
+        Price stop = params.stop_rule == StopRule::SecondCandle
+            ? w.low(1)
+            : (std::min)(w.low(1), w.low(2));
+        decision.stop_loss = stop.roundToTick(tick);
+        // Target rounded towards the entry so it stays on the tick grid and reachable
+        decision.target = (ltp + scaleStrategyRisk(ltp - decision.stop_loss, params.target_multiple))
+                              .roundToTick(tick, TickRounding::Down);
+    } else {
+        Price stop = params.stop_rule == StopRule::SecondCandle
+            ? w.high(1)
+            : (std::max)(w.high(1), w.high(2));
+        decision.stop_loss = stop.roundToTick(tick);
+        decision.target = (ltp - scaleStrategyRisk(decision.stop_loss - ltp, params.target_multiple))
+                              .roundToTick(tick, TickRounding::Up);
+    }
+    return decision;
+}
+
+template <typename Window>
+SignalDecision evaluateEmaRule(const Window& w, Price ltp, Price tick, const StrategyParams& params) {
+    SignalDecision decision;
+
+    // EMA comparisons are done in rupees; price-to-price comparisons stay in paise
+    double ltp_value = ltp.toDouble();
+
+    // Buy Strategy
+    // thirdopen>thirdclose and secondopen>secondclose and secondclose>thirdclose and secondclose>secondema and thirdclose>thirdema and lastclose>lastema
+    if (w.open(2) < w.close(2) &&
+        w.open(1) < w.close(1) &&
+       // w.close(1) > w.close(2) &&
+        w.close(1).toDouble() > w.ema(1) &&
+        w.close(2).toDouble() > w.ema(2) &&
+        ltp_value > w.ema(0) &&
+        ltp > w.high(1)) {
+        decision = bracketEntry(SignalSide::Buy, w, ltp, tick, params);
+    }
+    // Sell Strategy
+    // thirdopen<thirdclose and secondopen<secondclose and secondclose<thirdclose and secondclose<secondema and thirdclose<thirdema and lastclose<lastema
+    else if (w.open(2) > w.close(2) &&
+             w.open(1) > w.close(1) &&
+            // w.close(1) < w.close(2) &&
+             w.close(1).toDouble() < w.ema(1) &&
+             w.close(2).toDouble() < w.ema(2) &&
+             ltp_value < w.ema(0) &&
+             ltp < w.low(1)) {
+        decision = bracketEntry(SignalSide::Sell, w, ltp, tick, params);
+    }
+
+    return decision;
+}
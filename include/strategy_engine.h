@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "market_data.h"
+#include "strategy.h"
+
+// Dense symbol index (SymbolContext::id in the live client)
+using SymbolId = uint32_t;
+
+// Non-owning view of contiguous elements (std::span is C++20)
+template <typename T>
+class Span {
+public:
+    Span() : data_(nullptr), size_(0) {}
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+    template <typename U>
+    Span(const std::vector<U>& values) : data_(values.data()), size_(values.size()) {}
+
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t i) const { return data_[i]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+private:
+    T* data_;
+    size_t size_;
+};
+
+// The last kDepth bars of every symbol, stored column-wise.
+//
+// Each field is one array laid out [age][symbol], so a strategy looking at
+// age 1 highs across the universe walks one contiguous column instead of
+// gathering fields from a struct per symbol. Bars arrive as bar-close events
+// (push) or as the tail of a candle window (assign).
+class BarColumns {
+public:
+    static constexpr size_t kDepth = 3; // age 0 is the latest bar
+
+    BarColumns() : symbols_(0) {}
+
+    // Sizes for `symbols` rows and forgets every bar
+    void reset(size_t symbols);
+    size_t symbols() const { return symbols_; }
+
+    // Shifts the symbol's bars one age back and stores `bar` as age 0
+    void push(SymbolId id, const CandleData& bar, double ema);
+    // Takes the last (up to kDepth) bars of a window and their EMA values
+    void assign(SymbolId id, const std::vector<CandleData>& candles, const std::vector<double>& ema);
+
+    bool ready(SymbolId id) const { return count_[id] == kDepth; }
+
+    // Column of one field at one age, indexed by SymbolId
+    const Price* open(size_t age) const { return &open_[age * symbols_]; }
+    const Price* high(size_t age) const { return &high_[age * symbols_]; }
+    const Price* low(size_t age) const { return &low_[age * symbols_]; }
+    const Price* close(size_t age) const { return &close_[age * symbols_]; }
+    const double* ema(size_t age) const { return &ema_[age * symbols_]; }
+
+    // One symbol's bars as a rule window (see evaluateEmaRule)
+    struct Row {
+        const BarColumns& bars;
+        SymbolId id;
+
+        Price open(size_t age) const { return bars.open(age)[id]; }
+        Price high(size_t age) const { return bars.high(age)[id]; }
+        Price low(size_t age) const { return bars.low(age)[id]; }
+        Price close(size_t age) const { return bars.close(age)[id]; }
+        double ema(size_t age) const { return bars.ema(age)[id]; }
+    };
+    Row row(SymbolId id) const { return Row{*this, id}; }
+
+private:
+    void store(size_t age, SymbolId id, const CandleData& bar, double ema);
+
+    size_t symbols_;
+    std::vector<Price> open_;
+    std::vector<Price> high_;
+    std::vector<Price> low_;
+    std::vector<Price> close_;
+    std::vector<double> ema_;
+    std::vector<uint8_t> count_;
+};
+
+// Event-driven strategy over a symbol universe.
+//
+// Bar-close and tick events update column state; evaluate() then decides
+// for a batch of symbols in one pass over that state. Strategies derive with
+// themselves as the template argument and provide
+//     SignalDecision decide(SymbolId id, Price ltp) const;
+// which evaluate() calls directly, so the rule inlines into the batch loop
+// with no virtual call or per-symbol copy. Optional hooks, found the same way:
+//     void resized(size_t symbols);  per-symbol state of the strategy's own
+//     void decideAll(Span<const SymbolId> ids, SignalDecision* out) const;
+//                                    the whole batch at once
+template <typename Derived>
+class StrategyEngine {
+public:
+    void reset(size_t symbols) {
+        bars_.reset(symbols);
+        ltp_.assign(symbols, Price());
+        static_cast<Derived&>(*this).resized(symbols);
+    }
+    size_t symbols() const { return bars_.symbols(); }
+
+    void onBarClose(SymbolId id, const CandleData& bar, double ema) { bars_.push(id, bar, ema); }
+    // A refreshed candle window (its newest bar may still be forming)
+    void onBars(SymbolId id, const std::vector<CandleData>& candles, const std::vector<double>& ema) {
+        bars_.assign(id, candles, ema);
+    }
+    void onTick(SymbolId id, Price ltp) { ltp_[id] = ltp; }
+
+    // Decides for each symbol at its last tick into out[0..ids.size()); symbols
+    // without a full window or a tick get no signal. Returns the signal count.
+    size_t evaluate(Span<const SymbolId> ids, SignalDecision* out) const {
+        static_cast<const Derived&>(*this).decideAll(ids, out);
+        size_t signals = 0;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            signals += out[i].side != SignalSide::None ? 1 : 0;
+        }
+        return signals;
+    }
+    SignalDecision evaluate(SymbolId id) const {
+        SignalDecision decision;
+        evaluate(Span<const SymbolId>(&id, 1), &decision);
+        return decision;
+    }
+
+    const BarColumns& bars() const { return bars_; }
+    Price ltp(SymbolId id) const { return ltp_[id]; }
+
+protected:
+    void resized(size_t) {}
+
+    // Symbol by symbol through decide(); a strategy that can do better over a
+    // whole batch (see RuleStrategy) provides its own
+    void decideAll(Span<const SymbolId> ids, SignalDecision* out) const {
+        const Derived& self = static_cast<const Derived&>(*this);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            SymbolId id = ids[i];
+            out[i] = bars_.ready(id) && ltp_[id] > Price() ? self.decide(id, ltp_[id]) : SignalDecision();
+        }
+    }
+
+    BarColumns bars_;
+    std::vector<Price> ltp_;
+};
+
+// The EMA three-candle rule (evaluateEmaRule) with per-symbol parameters and tick sizes
+class EmaThreeCandleStrategy : public StrategyEngine<EmaThreeCandleStrategy> {
+public:
+    void configure(SymbolId id, const StrategyParams& params, Price tick) {
+        params_[id] = params;
+        tick_[id] = tick;
+    }
+
+    SignalDecision decide(SymbolId id, Price ltp) const {
+        return evaluateEmaRule(bars_.row(id), ltp, tick_[id], params_[id]);
+    }
+
+private:
+    friend class StrategyEngine<EmaThreeCandleStrategy>;
+    void resized(size_t symbols) {
+        params_.assign(symbols, StrategyParams());
+        tick_.assign(symbols, Price::fromPaise(5));
+    }
+
+    std::vector<StrategyParams> params_;
+    std::vector<Price> tick_;
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "strategy_engine.h"
+
+// One entry condition compiled to stack bytecode.
+//
+// The text is a boolean expression over the last three bars and the quote:
+//
+//   open[2] < close[2] and close[1] > ema[1] and ltp > high[1]
+//
+// Operands are open/high/low/close/ema[age] (age 0 is the latest bar, 2 the
+// oldest; [0] may be left out), ltp, tick and decimal constants. Prices are
+// in rupees. Operators, loosest first: or, and, not, the comparisons
+// < <= > >= == !=, + -, * /, unary minus; parentheses group. `&&`, `||`
+// and `!` are accepted as well.
+//
+// run() executes the program over a batch of symbols at a time: each
+// instruction is one tight loop over up to kLanes symbols reading the bar
+// columns directly, and and/or/not are arithmetic on 0/1 lanes, so the cost
+// of decoding an instruction is shared by the whole batch and no lane ever
+// branches on its data.
+class RuleProgram {
+public:
+    static constexpr size_t kLanes = 64;
+    static constexpr size_t kMaxDepth = 16;
+
+    enum class Op : uint8_t {
+        Open, High, Low, Close, Ema, Ltp, Tick, Const,
+        Add, Sub, Mul, Div, Neg,
+        Lt, Le, Gt, Ge, Eq, Ne,
+        And, Or, Not
+    };
+
+    struct Instruction {
+        Op op;
+        uint8_t age;  // bar loads
+        double value; // Const
+    };
+
+    RuleProgram() : depth_(0) {}
+
+    // False with a message naming the offending column on a syntax or type error
+    bool compile(const std::string& text, std::string& error);
+
+    bool empty() const { return code_.empty(); }
+    const std::string& text() const { return text_; }
+    const std::vector<Instruction>& code() const { return code_; }
+
+    // mask[i] = 1 when the condition holds for ids[i]
+    void run(const BarColumns& bars, const Price* ltp, const Price* tick,
+             Span<const SymbolId> ids, uint8_t* mask) const;
+
+    // The condition over one rule window (see evaluateEmaRule)
+    template <typename Window>
+    bool test(const Window& w, Price ltp, Price tick) const;
+
+private:
+    std::string text_;
+    std::vector<Instruction> code_;
+    size_t depth_;
+};
+
+// Buy and sell conditions from a rules file.
+//
+//   # comments and blank lines are ignored
+//   buy  = open[2] < close[2] and open[1] < close[1]
+//          and close[1] > ema[1] and close[2] > ema[2]
+//          and ltp > ema and ltp > high[1]
+//   sell = ...
+//
+// A rule runs until the next "name =" line. The buy condition is tried
+// first; stops and targets still come from each symbol's StrategyParams.
+struct StrategyRules {
+    RuleProgram buy;
+    RuleProgram sell;
+
+    bool parse(const std::string& text, std::string& error);
+    bool load(const std::string& filename);
+
+    template <typename Window>
+    SignalDecision decide(const Window& w, Price ltp, Price tick, const StrategyParams& params) const {
+        if (!buy.empty() && buy.test(w, ltp, tick)) {
+            return bracketEntry(SignalSide::Buy, w, ltp, tick, params);
+        }
+        if (!sell.empty() && sell.test(w, ltp, tick)) {
+            return bracketEntry(SignalSide::Sell, w, ltp, tick, params);
+        }
+        return SignalDecision();
+    }
+};
+
+// Strategy engine driven by StrategyRules, evaluated a batch at a time
+class RuleStrategy : public StrategyEngine<RuleStrategy> {
+public:
+    explicit RuleStrategy(const StrategyRules& rules) : rules_(rules) {}
+
+    void configure(SymbolId id, const StrategyParams& params, Price tick) {
+        params_[id] = params;
+        tick_[id] = tick;
+    }
+    const StrategyRules& rules() const { return rules_; }
+
+    SignalDecision decide(SymbolId id, Price ltp) const {
+        return rules_.decide(bars_.row(id), ltp, tick_[id], params_[id]);
+    }
+
+private:
+    friend class StrategyEngine<RuleStrategy>;
+    void resized(size_t symbols) {
+        params_.assign(symbols, StrategyParams());
+        tick_.assign(symbols, Price::fromPaise(5));
+    }
+    void decideAll(Span<const SymbolId> ids, SignalDecision* out) const;
+
+    StrategyRules rules_;
+    std::vector<StrategyParams> params_;
+    std::vector<Price> tick_;
+};
+
+template <typename Window>
+bool RuleProgram::test(const Window& w, Price ltp, Price tick) const {
+    double stack[kMaxDepth];
+    size_t top = 0; // next free slot
+    for (const Instruction& in : code_) {
+        switch (in.op) {
+            case Op::Open: stack[top++] = w.open(in.age).toDouble(); break;
+            case Op::High: stack[top++] = w.high(in.age).toDouble(); break;
+            case Op::Low: stack[top++] = w.low(in.age).toDouble(); break;
+            case Op::Close: stack[top++] = w.close(in.age).toDouble(); break;
+            case Op::Ema: stack[top++] = w.ema(in.age); break;
+            case Op::Ltp: stack[top++] = ltp.toDouble(); break;
+            case Op::Tick: stack[top++] = tick.toDouble(); break;
+            case Op::Const: stack[top++] = in.value; break;
+            case Op::Neg: stack[top - 1] = -stack[top - 1]; break;
+            case Op::Not: stack[top - 1] = 1.0 - stack[top - 1]; break;
+            default: {
+                double b = stack[--top];
+                double& a = stack[top - 1];
+                switch (in.op) {
+                    case Op::Add: a = a + b; break;
+                    case Op::Sub: a = a - b; break;
+                    case Op::Mul: a = a * b; break;
+                    case Op::Div: a = a / b; break;
+                    case Op::Lt: a = a < b ? 1.0 : 0.0; break;
+                    case Op::Le: a = a <= b ? 1.0 : 0.0; break;
+                    case Op::Gt: a = a > b ? 1.0 : 0.0; break;
+                    case Op::Ge: a = a >= b ? 1.0 : 0.0; break;
+                    case Op::Eq: a = a == b ? 1.0 : 0.0; break;
+                    case Op::Ne: a = a != b ? 1.0 : 0.0; break;
+                    case Op::And: a = a * b; break;
+                    case Op::Or: a = a + b - a * b; break;
+                    default: break;
+                }
+            }
+        }
+    }
+    return top == 1 && stack[0] != 0.0;
+}
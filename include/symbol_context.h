@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "market_data.h"
+#include "strategy.h"
+
+// Everything the trading loop needs about one traded symbol, resolved once
+// after the instruments are loaded. Contexts sit in a vector and are indexed
+// by a dense id (their position in TradeSettings order), so the per-pass
+// lookups are array accesses instead of scans and string keys.
+struct SymbolContext {
+    uint32_t id;
+    TradeSetting setting;
+    StrategyParams params;
+    std::string quote_key;        // "EXCHANGE:SYMBOL" as the LTP endpoint expects
+    std::string instrument_token; // historical data URL segment
+    Price tick_size;
+
+    // Candle window from the last pass and the EMA over it; the EMA is only
+    // advanced over candles that changed since then
+    std::vector<CandleData> candles;
+    std::vector<double> ema_values;
+
+    // Entry in the client's active positions, null while flat
+    ActivePosition* position;
+
+    SymbolContext() : id(0), position(nullptr) {}
+
+    double ema() const { return ema_values.empty() ? 0.0 : ema_values.back(); }
+};
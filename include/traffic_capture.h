@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "clock.h"
+
+// One recorded API exchange. Headers (access token) and the login checksum
+// are not captured, but the session response is: treat captures as secrets.
+struct TrafficEntry {
+    int64_t ts_ms;            // client clock when the request was sent
+    std::string method;       // GET / POST
+    std::string url;
+    std::map<std::string, std::string> params; // query string or form body
+    long status;
+    double elapsed;           // seconds, as reported by the transport
+    std::string body;
+
+    TrafficEntry() : ts_ms(0), status(0), elapsed(0.0) {}
+};
+
+// Append-only JSONL capture of every request/response pair (one object per
+// line, flushed as it is written so a crash loses at most the last exchange).
+class TrafficRecorder {
+public:
+    TrafficRecorder() : entries_(0) {}
+
+    bool open(const std::string& path);
+    bool isOpen() const { return out_.is_open(); }
+    void record(const TrafficEntry& entry);
+    uint64_t entries() const { return entries_; }
+
+    static std::string toJsonLine(const TrafficEntry& entry);
+
+private:
+    std::mutex mutex_;
+    std::ofstream out_;
+    uint64_t entries_;
+};
+
+// Serves a recording back in place of the network.
+//
+// A request takes the next unserved entry with the same method, URL and
+// parameters, so repeated LTP polls see the recorded price sequence. When
+// nothing matches exactly (POSTs always, or a GET whose date parameters
+// moved) the next unserved entry for the same method and URL is used, so
+// orders and date-relative history replay in their recorded order.
+//
+// With a clock attached, each response moves it forward to the time its
+// request was recorded, so the client's waits and market-hours checks follow
+// the recording rather than the wall clock.
+class TrafficReplayer {
+public:
+    enum class Pacing {
+        Max,      // answer immediately
+        Recorded  // wait out each response's recorded latency
+    };
+
+    TrafficReplayer() : pacing_(Pacing::Max), served_count_(0), misses_(0) {}
+
+    bool load(const std::string& path);
+    void setPacing(Pacing pacing) { pacing_ = pacing; }
+    static bool parsePacing(const std::string& text, Pacing& pacing);
+    void setClock(std::shared_ptr<VirtualClock> clock) { clock_ = clock; }
+    // When the first recorded request was sent
+    Clock::time_point startTime() const;
+
+    // False when the recording has nothing left for this request
+    bool serve(const std::string& method, const std::string& url,
+               const std::map<std::string, std::string>& params, TrafficEntry& entry);
+
+    size_t size() const { return entries_.size(); }
+    size_t served() const;
+    size_t misses() const;
+    bool exhausted() const { return served() == entries_.size(); }
+    // True once every recorded request with this method and URL has been served
+    bool exhausted(const std::string& method, const std::string& url) const;
+
+    static bool fromJsonLine(const std::string& line, TrafficEntry& entry);
+
+private:
+    struct Queue {
+        std::vector<size_t> entries;
+        size_t cursor;
+
+        Queue() : cursor(0) {}
+    };
+
+    static std::string exactKey(const std::string& method, const std::string& url,
+                                const std::map<std::string, std::string>& params);
+    bool take(Queue& queue, size_t& index);
+
+    Pacing pacing_;
+    std::shared_ptr<VirtualClock> clock_;
+    mutable std::mutex mutex_;
+    std::vector<TrafficEntry> entries_;
+    std::vector<bool> served_;
+    std::unordered_map<std::string, Queue> by_exact_;  // "METHOD URL?k=v&..."
+    std::unordered_map<std::string, Queue> by_url_;    // "METHOD URL"
+    size_t served_count_;
+    size_t misses_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// LEB128 varints with zigzag mapping for signed deltas.
+// Used by the binary on-disk formats (candle store blocks).
+
+inline uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+inline void putSignedVarint(std::string& out, int64_t value) {
+    putVarint(out, zigzagEncode(value));
+}
+
+// Returns false when the input ends in the middle of a varint
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    int shift = 0;
+    while (p < end && shift < 64) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+        shift += 7;
+    }
+    return false;
+}
+
+inline bool getSignedVarint(const uint8_t*& p, const uint8_t* end, int64_t& value) {
+    uint64_t raw;
+    if (!getVarint(p, end, raw)) return false;
+    value = zigzagDecode(raw);
+    return true;
+}
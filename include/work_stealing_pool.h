@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fork/join pool for index-based batch work.
+//
+// parallelFor() hands every worker a contiguous slice of the index range.
+// A worker takes indices from the front of its own slice; once that is
+// empty it steals the back half of the largest remaining slice, so uneven
+// task costs (long vs short series, slow vs fast parameter sets) still
+// keep every core busy until the whole range is done.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threads);
+
+    int threads() const { return threads_; }
+
+    // Calls body(index) once for every index in [0, count); returns when all are done
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    struct Slice {
+        std::mutex mutex;
+        size_t begin;
+        size_t end;
+
+        Slice() : begin(0), end(0) {}
+    };
+
+    bool takeOwn(Slice& slice, size_t& index);
+    bool steal(size_t thief, size_t& index);
+
+    int threads_;
+    std::vector<std::unique_ptr<Slice>> slices_;
+};
@@ -4,93 +4,31 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <cpr/cpr.h>
 #include <openssl/sha.h>
 #include <openssl/hmac.h>
-
-// Structure for candle data
-struct CandleData {
-    std::string timestamp;
-    double open;
-    double high;
-    double low;
-    double close;
-    int volume;
-    int oi; // Open Interest (optional)
-    
-    CandleData() : open(0), high(0), low(0), close(0), volume(0), oi(0) {}
-};
-
-// Structure for trade settings
-struct TradeSetting {
-    std::string symbol;
-    int quantity;
-    std::string timeframe;
-    int ema_period;
-    
-    TradeSetting() : quantity(0), ema_period(0) {}
-};
-
-// Structure for instrument information
-struct Instrument {
-    std::string instrument_token;
-    std::string tradingsymbol;
-    std::string name;
-    std::string exchange;
-    std::string instrument_type;
-    
-    Instrument() {}
-};
-
-// Structure for last 3 candle data
-struct LastThreeCandles {
-    // Last candle (most recent)
-    double last_open, last_high, last_low, last_close;
-    double last_ema;
-    
-    // Second candle
-    double second_open, second_high, second_low, second_close;
-    double second_ema;
-    
-    // Third candle (oldest)
-    double third_open, third_high, third_low, third_close;
-    double third_ema;
-    
-    LastThreeCandles() : last_open(0), last_high(0), last_low(0), last_close(0), last_ema(0),
-                        second_open(0), second_high(0), second_low(0), second_close(0), second_ema(0),
-                        third_open(0), third_high(0), third_low(0), third_close(0), third_ema(0) {}
-};
-
-// Structure for trade signals
-struct TradeSignal {
-    std::string symbol;
-    std::string action; // "BUY", "SELL", "BUY_STOPLOSS", "BUY_TARGET", "SELL_STOPLOSS", "SELL_TARGET"
-    double entry_price;
-    double stop_loss;
-    double target;
-    int quantity;
-    
-    TradeSignal() : entry_price(0), stop_loss(0), target(0), quantity(0) {}
-};
-
-// Structure for active positions
-struct ActivePosition {
-    std::string symbol;
-    std::string entry_order_id;
-    std::string stop_loss_order_id;
-    std::string target_order_id;
-    std::string action; // "BUY" or "SELL"
-    double entry_price;
-    double stop_loss;
-    double target;
-    int quantity;
-    bool stop_loss_placed;
-    bool target_placed;
-    
-    ActivePosition() : entry_price(0), stop_loss(0), target(0), quantity(0), 
-                      stop_loss_placed(false), target_placed(false) {}
-};
+#include "market_data.h"
+#include "instrument_store.h"
+#include "options_chain.h"
+#include "candle_store.h"
+#include "clock.h"
+#include "traffic_capture.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "symbol_context.h"
+#include "settings_watcher.h"
+#include "position_journal.h"
+#include "reconciler.h"
+#include "order_manager.h"
+#include "portfolio_engine.h"
+#include "risk_gate.h"
+#include "order_log.h"
+#include "strategy_rules.h"
+#include <array>
+#include <unordered_map>
 
 class ZerodhaClient {
 public:
@@ -108,59 +46,165 @@ public:
     std::string getUserId() const { return user_id_; }
     bool isLoggedIn() const { return !access_token_.empty(); }
     
+    // REST endpoint root (default https://api.kite.trade)
+    void setBaseUrl(const std::string& url);
+    const std::string& getBaseUrl() const { return base_url_; }
+    std::string apiUrl(const std::string& path) const { return base_url_ + path; }
+    
     // Getter for trade settings
     const std::vector<TradeSetting>& getTradeSettings() const { return trade_settings_; }
     
     // Historical data methods
     bool loadTradeSettings(const std::string& filename);
+    static bool parseTradeSettings(const std::string& filename, std::vector<TradeSetting>& settings);
+    // Re-reads the file in the background when it changes; the trading loop applies a
+    // new version between passes, warming up only new symbols and changed EMA periods
+    bool watchTradeSettings(const std::string& filename,
+                            std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
     bool fetchInstruments();
     std::vector<CandleData> getHistoricalData(const std::string& symbol, 
                                              const std::string& timeframe,
                                              const std::string& from_date,
                                              const std::string& to_date,
                                              bool include_oi = false);
+    // Same as getHistoricalData but reports failure separately from an empty range
+    bool fetchHistoricalData(const std::string& symbol,
+                             const std::string& timeframe,
+                             const std::string& from_date,
+                             const std::string& to_date,
+                             std::vector<CandleData>& candles,
+                             bool include_oi = false);
     bool fetchHistoricalDataForAllSymbols(const std::string& from_date,
                                          const std::string& to_date);
+    bool parseHistoricalDataResponse(const cpr::Response& response, std::vector<CandleData>& candles);
+    
+    // Local candle history (memory-mapped store per symbol and timeframe); an empty directory disables it
+    void setCandleStoreDirectory(const std::string& directory) { candle_store_dir_ = directory; }
+    CandleStore* getCandleStore(const std::string& symbol, const std::string& timeframe);
+    // instrument_token skips the symbol lookup when the caller already resolved it
+    std::vector<CandleData> getCandlesWithHistory(const std::string& symbol,
+                                                 const std::string& timeframe,
+                                                 const std::chrono::system_clock::time_point& from,
+                                                 const std::chrono::system_clock::time_point& to,
+                                                 const std::string& instrument_token = std::string());
     
     // Market quote methods
-    double getLTP(const std::string& symbol);
+    Price getLTP(const std::string& symbol);
+    Price getLTP(const SymbolContext& context);
     
     // Instrument management methods
     bool saveInstrumentsToCSV(const std::string& filename);
     bool loadInstrumentsFromCSV(const std::string& filename);
     std::vector<std::string> getMatchedSymbols();
     
+    // One context per matched symbol, in TradeSettings order (see symbol_context.h).
+    // Built by the trading loop on first use, or explicitly once instruments are loaded.
+    size_t buildSymbolContexts();
+    std::vector<SymbolContext>& symbolContexts() { return symbol_contexts_; }
+    SymbolContext* findSymbolContext(const std::string& symbol);
+    const EmaThreeCandleStrategy& strategy() const { return strategy_; }
+    // Entry conditions from a rules file (see strategy_rules.h) instead of the built-in rule
+    bool loadStrategyRules(const std::string& filename);
+    // Replaces the context's candle window; updateEma() then extends the EMA over
+    // whatever changed, so the two can be timed separately
+    void refreshCandles(SymbolContext& context,
+                        const std::chrono::system_clock::time_point& from,
+                        const std::chrono::system_clock::time_point& to);
+    void updateEma(SymbolContext& context);
+    const InstrumentStore& getInstrumentStore() const { return instruments_; }
+    std::string getInstrumentToken(const std::string& symbol);
+    std::string getInstrumentExchange(const std::string& symbol) const;
+    Price getTickSize(const std::string& symbol) const;
+    
+    // Options chain methods (NFO underlyings)
+    bool refreshOptionsChain(bool force = false);
+    // Downloads the instrument dump again; the loaded one is kept if that fails
+    bool reloadInstruments();
+    const OptionsChain& getOptionsChain() const { return options_chain_; }
+    std::string selectOption(const std::string& underlying, Price ltp, OptionType type, int strike_offset = 0);
+    
     // Data processing methods
     std::vector<double> calculateEMA(const std::vector<double>& prices, int period);
     bool saveInstrumentDataToCSV(const std::string& symbol, const std::vector<CandleData>& candles, const std::vector<double>& ema_values);
     
     // Trading strategy methods
     LastThreeCandles getLastThreeCandles(const std::vector<CandleData>& candles, const std::vector<double>& ema_values);
-    TradeSignal analyzeStrategy(const std::string& symbol, const LastThreeCandles& data, double ltp);
-    bool placeOrder(const TradeSignal& signal);
+    TradeSignal analyzeStrategy(const std::string& symbol, const LastThreeCandles& data, Price ltp);
+    TradeSignal analyzeStrategy(const SymbolContext& context, const LastThreeCandles& data, Price ltp);
+    // With a trace, the send / parse / protective-leg stages are stamped on it
+    bool placeOrder(const TradeSignal& signal, LatencyTrace* trace = nullptr);
+    // Kite regular-order form fields (MIS, DAY); zero prices are left out
+    std::map<std::string, std::string> buildOrderPayload(const std::string& symbol,
+                                                         const std::string& transaction_type,
+                                                         const std::string& order_type,
+                                                         int quantity,
+                                                         const std::string& tag,
+                                                         Price price = Price(),
+                                                         Price trigger_price = Price()) const;
     
     // Position management methods
-    bool placeStopLossOrder(const std::string& symbol, const std::string& action, double stop_loss, int quantity);
-    bool placeTargetOrder(const std::string& symbol, const std::string& action, double target, int quantity);
+    bool placeStopLossOrder(const std::string& symbol, const std::string& action, Price stop_loss, int quantity);
+    bool placeTargetOrder(const std::string& symbol, const std::string& action, Price target, int quantity);
     void addActivePosition(const std::string& symbol, const std::string& entry_order_id, const TradeSignal& signal);
     bool hasActivePosition(const std::string& symbol);
-    void removeActivePosition(const std::string& symbol);
+    // The exit price books realized P&L in the portfolio; none means the entry never filled
+    void removeActivePosition(const std::string& symbol, Price exit_price = Price());
+    // Replays the journal into the active positions, then checks them against the
+    // order book in one request; every later transition is appended to it
+    bool openPositionJournal(const std::string& path);
+    // Today's orders (GET /orders) and net positions (GET /portfolio/positions)
+    bool fetchOrders(std::vector<BrokerOrder>& orders);
+    bool fetchPositions(std::vector<BrokerPosition>& positions);
+    // Diffs the broker's books against the active positions every `interval` on a
+    // low-priority thread (see reconciler.h); reports are applied between loop passes
+    bool startReconciler(std::chrono::milliseconds interval = std::chrono::seconds(30));
     
     // Order logging methods
     void logOrder(const std::string& symbol, const std::string& action, const std::string& order_id, 
-                  double price, int quantity, const std::string& order_type = "ENTRY");
-    void logStopLossHit(const std::string& symbol, double price);
-    void logTargetHit(const std::string& symbol, double price);
+                  Price price, int quantity, const std::string& order_type = "ENTRY");
+    void logStopLossHit(const std::string& symbol, Price price);
+    void logTargetHit(const std::string& symbol, Price price);
+    void logExit(const std::string& symbol, Price price, bool stop_loss);
+    void appendOrderLogRecord(OrderLogRecord& record);
     
     // Position monitoring methods
     void checkPositionStatus();
-    void checkPositionStatusWithLTP(const std::string& symbol, double ltp);
+    void checkPositionStatusWithLTP(const std::string& symbol, Price ltp);
     
     // Trading loop method
     void runTradingLoop();
+    void requestStop() { stop_requested_ = true; }
+    // The loop also returns once the clock reaches this time (used by session replay)
+    void setStopTime(const Clock::time_point& stop_at) { stop_at_ = stop_at; }
+    
+    // Time source (system clock by default; a VirtualClock replays a session)
+    void setClock(std::shared_ptr<Clock> clock) { clock_ = clock ? clock : std::make_shared<SystemClock>(); }
+    Clock& clock() { return *clock_; }
+    
+    // Capture every request/response to a JSONL file, or answer from one instead of the network
+    void setTrafficRecorder(std::shared_ptr<TrafficRecorder> recorder) { traffic_recorder_ = recorder; }
+    void setTrafficReplayer(std::shared_ptr<TrafficReplayer> replayer) { traffic_replayer_ = replayer; }
+    
+    // Per-stage latency of the trading loop; the report is printed at shutdown and
+    // on the next loop pass after requestLatencyReport() (safe from a signal handler)
+    LatencyRecorder& latency() { return latency_; }
+    void requestLatencyReport() { latency_report_requested_ = true; }
+    
+    // Pre-trade limits checked before every entry order (see risk_gate.h)
+    void setRiskLimits(const RiskLimits& limits) { risk_.setLimits(limits); }
+    const RiskGate& riskGate() const { return risk_; }
+    // Exposure and P&L; snapshot() is safe from any thread (see portfolio_engine.h)
+    const PortfolioEngine& portfolio() const { return portfolio_; }
+    
+    // Per-order states, fills and lifecycle latencies (see order_manager.h)
+    const OrderManager& orderManager() const { return order_manager_; }
+    
+    // Counters, gauges and stage latencies in the Prometheus text format (see metrics.h)
+    MetricsRegistry& metrics() { return metrics_; }
     
     // Helper methods
     std::string formatDate(const std::chrono::system_clock::time_point& time);
+    int currentDateYmd();
     
     // HTTP request methods
     cpr::Response makeRequest(const std::string& url, 
@@ -180,26 +224,143 @@ private:
     
     // Trade settings and instruments
     std::vector<TradeSetting> trade_settings_;
-    std::map<std::string, Instrument> instruments_cache_;
+    InstrumentStore instruments_;
+    OptionsChain options_chain_;
+    
+    // Candle history stores, keyed by "SYMBOL_timeframe"
+    std::string candle_store_dir_;
+    std::map<std::string, std::unique_ptr<CandleStore>> candle_stores_;
     
-    // Active positions tracking
+    // Active positions tracking (map nodes are stable, so contexts can point into it)
     std::map<std::string, ActivePosition> active_positions_;
     
+    // Hot-path view of the matched symbols; symbol_ids_ maps a symbol to its index
+    std::vector<SymbolContext> symbol_contexts_;
+    std::unordered_map<std::string, uint32_t> symbol_ids_;
+    // Bar and tick state of the contexts, indexed by context id
+    EmaThreeCandleStrategy strategy_;
+    std::unique_ptr<RuleStrategy> rule_strategy_; // set by loadStrategyRules
+    
     // API endpoints
     static constexpr const char* LOGIN_URL = "https://kite.zerodha.com/connect/login";
-    static constexpr const char* TOKEN_URL = "https://api.kite.trade/session/token";
-    static constexpr const char* BASE_URL = "https://api.kite.trade";
-    static constexpr const char* INSTRUMENTS_URL = "https://api.kite.trade/instruments/NSE";
-    static constexpr const char* HISTORICAL_URL = "https://api.kite.trade/instruments/historical";
+    static constexpr const char* DEFAULT_BASE_URL = "https://api.kite.trade";
+    static constexpr const char* TOKEN_PATH = "/session/token";
+    static constexpr const char* HISTORICAL_PATH = "/instruments/historical";
+    static constexpr const char* ORDERS_PATH = "/orders/regular";
+    static constexpr const char* LTP_PATH = "/quote/ltp";
+    static constexpr const char* ORDER_BOOK_PATH = "/orders";
+    static constexpr const char* POSITIONS_PATH = "/portfolio/positions";
+    
+    // REST API root; a local simulator can stand in for api.kite.trade
+    std::string base_url_;
+    
+    // Time source and loop control
+    std::shared_ptr<Clock> clock_;
+    std::atomic<bool> stop_requested_;
+    Clock::time_point stop_at_;
+    
+    std::shared_ptr<TrafficRecorder> traffic_recorder_;
+    std::shared_ptr<TrafficReplayer> traffic_replayer_;
+    
+    LatencyRecorder latency_;
+    std::atomic<bool> latency_report_requested_;
+    
+    // Hot-reloaded TradeSettings.csv and the snapshot version the contexts reflect
+    std::unique_ptr<SettingsWatcher> settings_watcher_;
+    uint64_t applied_settings_version_;
+    
+    // Write-ahead log of position transitions; null when not enabled
+    std::unique_ptr<PositionJournal> journal_;
+    
+    // Bumped on every position change; the reconciler diffs against a published copy
+    uint64_t positions_version_;
+    uint64_t published_positions_version_;
+    uint64_t applied_reconcile_sequence_;
+    
+    // Lifecycle of every order sent today, updated from the loop and the reconciler;
+    // the reconciler applies broker statuses under the mutex so the day change can reset it
+    OrderManager order_manager_;
+    std::mutex order_reset_mutex_;
+    
+    // Mark-to-market P&L and exposure, and the pre-trade checks that read them
+    PortfolioEngine portfolio_;
+    RiskGate risk_;
+    
+    // yyyymmdd the day-scoped state was last started for; 0 before the first pass
+    int trading_day_;
+    
+    // Metric handles are registered once in the constructor and updated lock-free
+    enum class ApiEndpoint { Session, Instruments, Historical, Quote, Orders, Other, Count };
+    static constexpr size_t kApiEndpoints = static_cast<size_t>(ApiEndpoint::Count);
+    MetricsRegistry metrics_;
+    std::array<MetricCounter*, kApiEndpoints> api_requests_;
+    std::array<MetricCounter*, kApiEndpoints> api_errors_;
+    MetricCounter* api_rate_limited_;
+    MetricCounter* rate_limit_waits_;
+    MetricCounter* rate_limit_wait_ms_;
+    MetricCounter* loop_passes_;
+    MetricGauge* loop_pass_seconds_;
+    MetricCounter* symbols_scanned_;
+    MetricGauge* active_positions_gauge_;
+    MetricCounter* signals_buy_;
+    MetricCounter* signals_sell_;
+    MetricCounter* orders_entry_;
+    MetricCounter* orders_stoploss_;
+    MetricCounter* orders_target_;
+    MetricCounter* settings_reloads_;
+    static constexpr size_t kDiscrepancyKinds = static_cast<size_t>(Discrepancy::Kind::Count);
+    MetricCounter* reconcile_passes_;
+    std::array<MetricCounter*, kDiscrepancyKinds> reconcile_discrepancies_;
+    MetricGauge* resident_memory_;
+    MetricGauge* live_orders_;
+    static constexpr size_t kRiskVerdicts = static_cast<size_t>(RiskVerdict::Count);
+    std::array<MetricCounter*, kRiskVerdicts> risk_rejections_;
+    MetricGauge* gross_exposure_;
+    MetricGauge* net_exposure_;
+    MetricGauge* realized_pnl_;
+    MetricGauge* unrealized_pnl_;
+    
+    // Declared last: its thread calls back into the client, so it must stop first
+    std::unique_ptr<Reconciler> reconciler_;
     
     // Helper methods
     std::string generateChecksum(const std::map<std::string, std::string>& params);
     std::string generateSHA256(const std::string& input);
     std::map<std::string, std::string> getDefaultHeaders();
     std::map<std::string, std::string> getAuthHeaders();
+    cpr::Response replayResponse(const std::string& method, const std::string& url,
+                                 const std::map<std::string, std::string>& params);
+    void recordTraffic(const std::string& method, const std::string& url,
+                       const std::map<std::string, std::string>& params, const cpr::Response& response,
+                       int64_t sent_ms);
+    void registerMetrics();
+    ApiEndpoint apiEndpointFor(const std::string& url) const;
+    void countResponse(const std::string& url, const cpr::Response& response);
+    void rateLimitWait(Clock::duration wait);
+    struct ContextChanges {
+        size_t added;
+        size_t removed;
+        size_t rewarmed;
+        
+        ContextChanges() : added(0), removed(0), rewarmed(0) {}
+    };
+    ContextChanges rebuildSymbolContexts(const std::vector<TradeSetting>& settings);
+    void applySettingsUpdate();
+    void orderAccepted(uint32_t ref, const std::string& order_id);
+    void recordLegPlaced(const std::string& symbol, bool stop_loss, const std::string& order_id);
+    void reconcileRecoveredPositions();
+    void publishPositions();
+    void applyReconcileReport();
+    void startTradingDay();
+    int64_t bookedTodayPaise();
+    Price fetchLTP(const std::string& symbol, const std::string& quote_key);
+    bool fetchHistoricalCandles(const std::string& symbol, const std::string& instrument_token,
+                                const std::string& timeframe, const std::string& from_date,
+                                const std::string& to_date, std::vector<CandleData>& candles, bool include_oi);
+    TradeSignal makeSignal(const std::string& symbol, const SignalDecision& decision) const;
+    void configureRuleStrategy();
     bool parseLoginResponse(const cpr::Response& response);
     bool parseTokenResponse(const cpr::Response& response);
     bool parseInstrumentsResponse(const cpr::Response& response);
     std::vector<CandleData> parseHistoricalDataResponse(const cpr::Response& response);
-    std::string getInstrumentToken(const std::string& symbol);
 }; 
\ No newline at end of file
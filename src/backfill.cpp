@@ -0,0 +1,254 @@
+#include "backfill.h"
+#include "zerodha_client.h"
+#include "candle_store.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// Kite expects "yyyy-mm-dd hh:mm:ss" in IST
+std::string kiteDate(int64_t ts) {
+    std::string text = CandleStore::formatTimestamp(ts).substr(0, 19);
+    text[10] = ' ';
+    return text;
+}
+
+// Drops trailing candles whose interval had not closed when the request went
+// out; a still-forming candle stored now would never be corrected later
+void dropOpenCandles(std::vector<CandleData>& candles, int timeframe_seconds, int64_t requested_at) {
+    if (timeframe_seconds <= 0) return;
+    while (!candles.empty() &&
+           CandleStore::parseTimestamp(candles.back().timestamp) + timeframe_seconds > requested_at) {
+        candles.pop_back();
+    }
+}
+
+struct Chunk {
+    size_t symbol;
+    size_t sequence;
+    std::string from_date;
+    std::string to_date;
+};
+
+struct SymbolState {
+    const BackfillRequest* request;
+    CandleStore* store;
+    std::mutex mutex;
+    size_t chunk_count;
+    size_t head_chunks;                // leading chunks older than the store, merged in at the end
+    std::vector<CandleData> head;
+    size_t next_to_append;
+    std::map<size_t, std::vector<CandleData>> pending; // completed out of order
+    bool failed;
+    size_t candles_written;
+
+    SymbolState() : request(nullptr), store(nullptr), chunk_count(0), head_chunks(0), next_to_append(0),
+                    failed(false), candles_written(0) {}
+};
+
+} // namespace
+
+RateLimiter::RateLimiter(double requests_per_second)
+    : interval_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / (requests_per_second > 0 ? requests_per_second : 1.0)))),
+      next_slot_(std::chrono::steady_clock::now()) {
+}
+
+void RateLimiter::acquire() {
+    std::chrono::steady_clock::time_point slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = std::chrono::steady_clock::now();
+        slot = (std::max)(now, next_slot_);
+        next_slot_ = slot + interval_;
+    }
+    std::this_thread::sleep_until(slot);
+}
+
+HistoricalBackfill::HistoricalBackfill(ZerodhaClient& client, double requests_per_second, int workers)
+    : client_(client), limiter_(requests_per_second), workers_((std::max)(1, workers)), max_retries_(3) {
+}
+
+int HistoricalBackfill::maxDaysPerRequest(const std::string& timeframe) {
+    if (timeframe == "minute") return 60;
+    if (timeframe == "3minute" || timeframe == "5minute" || timeframe == "10minute") return 100;
+    if (timeframe == "15minute" || timeframe == "30minute") return 200;
+    if (timeframe == "60minute") return 400;
+    if (timeframe == "day") return 2000;
+    return 60;
+}
+
+std::vector<std::pair<int64_t, int64_t>> HistoricalBackfill::splitRange(int64_t from_ts, int64_t to_ts,
+                                                                         const std::string& timeframe) {
+    std::vector<std::pair<int64_t, int64_t>> chunks;
+    const int64_t span = static_cast<int64_t>(maxDaysPerRequest(timeframe)) * 86400;
+
+    for (int64_t start = from_ts; start <= to_ts; start += span) {
+        // Kite treats both ends as inclusive, so chunks must not share a second
+        int64_t end = (std::min)(to_ts, start + span - 1);
+        chunks.emplace_back(start, end);
+    }
+    return chunks;
+}
+
+bool HistoricalBackfill::run(const std::vector<BackfillRequest>& requests, int64_t from_ts, int64_t to_ts) {
+    std::vector<std::unique_ptr<SymbolState>> states;
+    std::vector<std::vector<Chunk>> per_symbol;
+    bool all_ok = true;
+
+    // Stores are opened here, on the calling thread; workers only touch their own symbol's store
+    for (const auto& request : requests) {
+        CandleStore* store = client_.getCandleStore(request.symbol, request.timeframe);
+        if (!store) {
+            std::cerr << "Error: Could not open candle store for " << request.symbol << std::endl;
+            all_ok = false;
+            continue;
+        }
+
+        // The store only grows at the end, so the tail always resumes after the
+        // last stored candle, also when that leaves a gap before from_ts. History
+        // older than the store is fetched first and prepended once complete.
+        int64_t start = store->empty() ? from_ts : store->lastTimestamp() + 1;
+        int64_t head_end = !store->empty() && from_ts < store->firstTimestamp() ? store->firstTimestamp() - 1 : from_ts - 1;
+
+        auto state = std::make_unique<SymbolState>();
+        state->request = &request;
+        state->store = store;
+
+        std::vector<Chunk> chunks;
+        for (const auto& range : splitRange(from_ts, head_end, request.timeframe)) {
+            chunks.push_back(Chunk{states.size(), chunks.size(), kiteDate(range.first), kiteDate(range.second)});
+        }
+        state->head_chunks = chunks.size();
+        for (const auto& range : splitRange(start, to_ts, request.timeframe)) {
+            chunks.push_back(Chunk{states.size(), chunks.size(), kiteDate(range.first), kiteDate(range.second)});
+        }
+        state->chunk_count = chunks.size();
+
+        std::cout << request.symbol << " (" << request.timeframe << "): ";
+        if (chunks.empty()) {
+            std::cout << "up to date";
+        } else {
+            if (state->head_chunks > 0) {
+                std::cout << state->head_chunks << " chunk(s) before " << kiteDate(store->firstTimestamp());
+            }
+            if (chunks.size() > state->head_chunks) {
+                std::cout << (state->head_chunks > 0 ? ", " : "") << chunks.size() - state->head_chunks
+                          << " chunk(s) from " << kiteDate(start);
+            }
+        }
+        std::cout << std::endl;
+
+        states.push_back(std::move(state));
+        per_symbol.push_back(std::move(chunks));
+    }
+
+    // Interleave chunks across symbols so every symbol's in-order append keeps moving
+    std::vector<Chunk> work;
+    for (size_t sequence = 0;; ++sequence) {
+        bool any = false;
+        for (auto& chunks : per_symbol) {
+            if (sequence < chunks.size()) {
+                work.push_back(chunks[sequence]);
+                any = true;
+            }
+        }
+        if (!any) break;
+    }
+
+    std::cout << "Backfilling " << work.size() << " chunks for " << states.size()
+              << " symbols with " << workers_ << " workers..." << std::endl;
+
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> completed{0};
+
+    auto worker = [&]() {
+        std::vector<CandleData> candles;
+        while (true) {
+            size_t index = next_chunk.fetch_add(1);
+            if (index >= work.size()) break;
+
+            const Chunk& chunk = work[index];
+            SymbolState& state = *states[chunk.symbol];
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (state.failed) continue;
+            }
+
+            bool ok = false;
+            int64_t requested_at = 0;
+            for (int attempt = 0; attempt <= max_retries_ && !ok; ++attempt) {
+                if (attempt > 0) {
+                    std::this_thread::sleep_for(std::chrono::seconds(attempt));
+                }
+                limiter_.acquire();
+                requested_at = static_cast<int64_t>(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+                ok = client_.fetchHistoricalData(state.request->symbol, state.request->timeframe,
+                                                 chunk.from_date, chunk.to_date, candles);
+            }
+            if (ok) {
+                dropOpenCandles(candles, CandleStore::timeframeSeconds(state.request->timeframe), requested_at);
+            }
+
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!ok) {
+                // Later chunks are not appended, so the next run resumes from here
+                std::cerr << "Error: Backfill chunk " << chunk.from_date << " .. " << chunk.to_date
+                          << " failed for " << state.request->symbol << std::endl;
+                state.failed = true;
+                continue;
+            }
+
+            state.pending[chunk.sequence] = std::move(candles);
+            candles.clear();
+
+            auto it = state.pending.find(state.next_to_append);
+            while (it != state.pending.end()) {
+                if (state.next_to_append < state.head_chunks) {
+                    state.head.insert(state.head.end(), it->second.begin(), it->second.end());
+                } else {
+                    state.candles_written += state.store->append(it->second);
+                }
+                state.pending.erase(it);
+                ++state.next_to_append;
+                it = state.pending.find(state.next_to_append);
+            }
+
+            size_t done = completed.fetch_add(1) + 1;
+            std::cout << "[" << done << "/" << work.size() << "] " << state.request->symbol
+                      << " " << chunk.from_date << " .. " << chunk.to_date << std::endl;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < workers_; ++i) {
+        threads.emplace_back(worker);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Older history goes in only when every chunk of it arrived, otherwise the
+    // store would keep a hole that no later run looks for
+    for (const auto& state : states) {
+        if (state->head_chunks > 0 && state->next_to_append >= state->head_chunks) {
+            state->candles_written += state->store->prepend(state->head);
+        }
+        state->store->flush();
+    }
+
+    std::cout << "\n=== Backfill Summary ===" << std::endl;
+    for (const auto& state : states) {
+        std::cout << state->request->symbol << ": " << state->candles_written << " new candles, "
+                  << state->store->size() << " stored"
+                  << (state->failed ? " (incomplete - rerun to resume)" : "") << std::endl;
+        if (state->failed) all_ok = false;
+    }
+
+    return all_ok;
+}
@@ -0,0 +1,90 @@
+#include "zerodha_client.h"
+#include "backfill.h"
+#include "candle_store.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+// Usage: ZerodhaBackfill <from yyyy-mm-dd> [to yyyy-mm-dd] [--timeframe TF] [--workers N] [--rate R]
+// Fills the local candle store for every symbol in TradeSettings.csv; rerunning resumes.
+int main(int argc, char* argv[]) {
+    std::cout << "=== Zerodha Historical Backfill ===" << std::endl;
+
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <from yyyy-mm-dd> [to yyyy-mm-dd] [--timeframe TF] [--workers N] [--rate R]" << std::endl;
+        return 1;
+    }
+
+    std::string from_arg = argv[1];
+    std::string to_arg;
+    std::string timeframe_override;
+    int workers = 3;
+    double rate = 3.0; // Kite historical API limit (requests per second)
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--timeframe" && i + 1 < argc) {
+            timeframe_override = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "--rate" && i + 1 < argc) {
+            rate = std::atof(argv[++i]);
+        } else if (to_arg.empty()) {
+            to_arg = arg;
+        }
+    }
+
+    int64_t from_ts = CandleStore::parseTimestamp(from_arg + "T00:00:00");
+    int64_t to_ts = to_arg.empty()
+        ? static_cast<int64_t>(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()))
+        : CandleStore::parseTimestamp(to_arg + "T23:59:59");
+    if (from_ts == 0 || to_ts == 0 || from_ts > to_ts) {
+        std::cerr << "Invalid date range: " << from_arg << " .. " << (to_arg.empty() ? "now" : to_arg) << std::endl;
+        return 1;
+    }
+
+    ZerodhaClient client;
+
+    if (!client.loadCredentials("Credential.csv")) {
+        std::cerr << "Failed to load credentials. Exiting." << std::endl;
+        return 1;
+    }
+
+    if (!client.loadTradeSettings("TradeSettings.csv")) {
+        std::cerr << "Failed to load trade settings. Exiting." << std::endl;
+        return 1;
+    }
+
+    if (!client.login()) {
+        std::cerr << "Login failed. Exiting." << std::endl;
+        return 1;
+    }
+
+    // Prefer the saved instrument file; download only when it is missing
+    if (!client.loadInstrumentsFromCSV("instruments.csv")) {
+        if (!client.fetchInstruments() || !client.saveInstrumentsToCSV("instruments.csv")) {
+            std::cerr << "Failed to load instruments. Exiting." << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BackfillRequest> requests;
+    for (const auto& setting : client.getTradeSettings()) {
+        if (client.getInstrumentStore().findAny(setting.symbol) == InstrumentStore::npos) {
+            std::cout << "Skipping " << setting.symbol << " - not in instruments" << std::endl;
+            continue;
+        }
+        BackfillRequest request;
+        request.symbol = setting.symbol;
+        request.timeframe = timeframe_override.empty() ? setting.timeframe : timeframe_override;
+        requests.push_back(request);
+    }
+
+    HistoricalBackfill backfill(client, rate, workers);
+    bool ok = backfill.run(requests, from_ts, to_ts);
+
+    std::cout << (ok ? "Backfill complete." : "Backfill incomplete - rerun the same command to resume.") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,260 @@
+#include "backtest.h"
+#include "indicators.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// Enough bars for the EMA seed to decay below floating point noise
+constexpr size_t kEmaWarmupPeriods = 10;
+
+inline int64_t sessionDay(int64_t ts) {
+    return (ts + CandleStore::kIstOffsetSeconds) / 86400;
+}
+
+inline int64_t tradePnl(SignalSide side, Price entry, Price exit, int quantity) {
+    int64_t per_unit = side == SignalSide::Buy ? (exit - entry).paise() : (entry - exit).paise();
+    return per_unit * quantity;
+}
+
+// Splits one CSV line into at most max_fields views
+size_t splitFields(const std::string& line, std::string_view* fields, size_t max_fields) {
+    size_t count = 0;
+    size_t start = 0;
+    while (count < max_fields) {
+        size_t comma = line.find(',', start);
+        if (comma == std::string::npos) {
+            fields[count++] = std::string_view(line).substr(start);
+            break;
+        }
+        fields[count++] = std::string_view(line).substr(start, comma - start);
+        start = comma + 1;
+    }
+    return count;
+}
+
+// Bars i-2..i of the series columns as a rule window, read in place
+struct SeriesWindow {
+    const Price* opens;
+    const Price* highs;
+    const Price* lows;
+    const Price* closes;
+    size_t i;
+    const double* emas; // by age
+
+    Price open(size_t age) const { return opens[i - age]; }
+    Price high(size_t age) const { return highs[i - age]; }
+    Price low(size_t age) const { return lows[i - age]; }
+    Price close(size_t age) const { return closes[i - age]; }
+    double ema(size_t age) const { return emas[age]; }
+};
+
+} // namespace
+
+void BacktestResult::merge(const BacktestResult& other) {
+    trades.insert(trades.end(), other.trades.begin(), other.trades.end());
+    candles += other.candles;
+    trade_count += other.trade_count;
+    wins += other.wins;
+    losses += other.losses;
+    net_pnl_paise += other.net_pnl_paise;
+    gross_profit_paise += other.gross_profit_paise;
+    gross_loss_paise += other.gross_loss_paise;
+    // Drawdowns of independent symbols do not add up; keep the worst one
+    max_drawdown_paise = (std::max)(max_drawdown_paise, other.max_drawdown_paise);
+}
+
+template <typename EmaAt>
+BacktestResult Backtester::replay(const CandleSeries& series, size_t begin, size_t end,
+                                  const StrategyParams& params, const BacktestOptions& options, EmaAt ema_at) {
+    BacktestResult result;
+    result.candles = end - begin;
+
+    const int64_t* ts = series.timestamp.data();
+    const Price* open = series.open.data();
+    const Price* high = series.high.data();
+    const Price* low = series.low.data();
+    const Price* close = series.close.data();
+
+    double ema_third = 0.0;
+    double ema_second = 0.0;
+    size_t bars_seen = 0;
+
+    bool in_position = false;
+    BacktestTrade trade;
+    int64_t equity = 0;
+    int64_t peak = 0;
+
+    auto closeTrade = [&](int64_t exit_ts, Price exit_price, bool target_hit) {
+        trade.exit_ts = exit_ts;
+        trade.exit_price = exit_price;
+        trade.target_hit = target_hit;
+        trade.pnl_paise = tradePnl(trade.side, trade.entry_price, exit_price, options.quantity);
+
+        ++result.trade_count;
+        if (trade.pnl_paise > 0) {
+            ++result.wins;
+            result.gross_profit_paise += trade.pnl_paise;
+        } else {
+            ++result.losses;
+            result.gross_loss_paise -= trade.pnl_paise;
+        }
+
+        equity += trade.pnl_paise;
+        peak = (std::max)(peak, equity);
+        result.max_drawdown_paise = (std::max)(result.max_drawdown_paise, peak - equity);
+
+        if (options.record_trades) {
+            result.trades.push_back(trade);
+        }
+        in_position = false;
+    };
+
+    for (size_t i = begin; i < end; ++i) {
+        const double ema = ema_at(i);
+        bool last_of_session = (i + 1 == end) || sessionDay(ts[i + 1]) != sessionDay(ts[i]);
+
+        // Exits first: the position was opened at an earlier bar's close
+        if (in_position) {
+            const bool is_buy = trade.side == SignalSide::Buy;
+            const Price sl = trade.stop_loss;
+            const Price tgt = trade.target;
+
+            if (is_buy ? open[i] <= sl : open[i] >= sl) {
+                closeTrade(ts[i], open[i], false);        // gapped through the stop
+            } else if (is_buy ? open[i] >= tgt : open[i] <= tgt) {
+                closeTrade(ts[i], open[i], true);         // gapped through the target
+            } else if (is_buy ? low[i] <= sl : high[i] >= sl) {
+                closeTrade(ts[i], sl, false);             // stop before target when both are touched
+            } else if (is_buy ? high[i] >= tgt : low[i] <= tgt) {
+                closeTrade(ts[i], tgt, true);
+            } else if (last_of_session && options.intraday_squareoff) {
+                closeTrade(ts[i], close[i], false);       // MIS square-off
+            }
+        }
+
+        if (bars_seen >= 2 && !in_position && !(last_of_session && options.intraday_squareoff)) {
+            const double emas[3] = {ema, ema_second, ema_third};
+            SeriesWindow window{open, high, low, close, i, emas};
+            SignalDecision decision = options.rules ? options.rules->decide(window, close[i], options.tick, params)
+                                                    : evaluateEmaRule(window, close[i], options.tick, params);
+            if (decision.side != SignalSide::None) {
+                trade = BacktestTrade();
+                trade.entry_ts = ts[i];
+                trade.side = decision.side;
+                trade.entry_price = decision.entry_price;
+                trade.stop_loss = decision.stop_loss;
+                trade.target = decision.target;
+                in_position = true;
+            }
+        }
+
+        ema_third = ema_second;
+        ema_second = ema;
+        ++bars_seen;
+    }
+
+    // Anything still open at the end of the window is closed at the last close
+    if (in_position) {
+        closeTrade(ts[end - 1], close[end - 1], false);
+    }
+
+    result.net_pnl_paise = equity;
+    return result;
+}
+
+BacktestResult Backtester::run(const CandleSeries& series, const StrategyParams& params, const BacktestOptions& options) {
+    return runRange(series, 0, series.size(), params, options);
+}
+
+BacktestResult Backtester::runRange(const CandleSeries& series, size_t begin, size_t end,
+                                    const StrategyParams& params, const BacktestOptions& options) {
+    end = (std::min)(end, series.size());
+    if (begin >= end || params.ema_period <= 0) {
+        return BacktestResult();
+    }
+
+    // Same recurrence as calculateEMA, seeded a few periods before the window
+    const double multiplier = emaMultiplier(params.ema_period);
+    const size_t warmup = kEmaWarmupPeriods * static_cast<size_t>(params.ema_period);
+    const size_t seed = begin > warmup ? begin - warmup : 0;
+    const Price* close = series.close.data();
+
+    double ema = close[seed].toDouble();
+    for (size_t i = seed + 1; i < begin; ++i) {
+        ema = (close[i].toDouble() * multiplier) + (ema * (1 - multiplier));
+    }
+
+    return replay(series, begin, end, params, options, [&](size_t i) {
+        if (i > seed) {
+            ema = (close[i].toDouble() * multiplier) + (ema * (1 - multiplier));
+        }
+        return ema;
+    });
+}
+
+BacktestResult Backtester::runRange(const CandleSeries& series, const std::vector<double>& ema, size_t begin, size_t end,
+                                    const StrategyParams& params, const BacktestOptions& options) {
+    end = (std::min)((std::min)(end, series.size()), ema.size());
+    if (begin >= end) {
+        return BacktestResult();
+    }
+
+    const double* values = ema.data();
+    return replay(series, begin, end, params, options, [values](size_t i) { return values[i]; });
+}
+
+void Backtester::computeEma(const CandleSeries& series, int period, std::vector<double>& out) {
+    out.clear();
+    if (series.empty() || period <= 0) {
+        return;
+    }
+
+    Ema::compute(series, period, out);
+}
+
+bool Backtester::loadCSV(const std::string& filename, CandleSeries& out) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open candle file: " << filename << std::endl;
+        return false;
+    }
+
+    out.clear();
+
+    std::string line;
+    std::getline(file, line); // Skip header line
+
+    std::string_view fields[7];
+    size_t line_number = 1;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        if (splitFields(line, fields, 7) < 6) {
+            std::cerr << "Warning: Skipping malformed line " << line_number << " in " << filename << std::endl;
+            continue;
+        }
+
+        int64_t ts = CandleStore::parseTimestamp(std::string(fields[0]));
+        Price o, h, l, c;
+        int64_t volume = 0;
+        auto vol_result = std::from_chars(fields[5].data(), fields[5].data() + fields[5].size(), volume);
+        if (ts == 0 || !Price::parse(fields[1], o) || !Price::parse(fields[2], h) ||
+            !Price::parse(fields[3], l) || !Price::parse(fields[4], c) || vol_result.ec != std::errc()) {
+            std::cerr << "Warning: Skipping malformed line " << line_number << " in " << filename << std::endl;
+            continue;
+        }
+
+        // The replay assumes ascending time
+        if (!out.empty() && ts <= out.timestamp.back()) {
+            continue;
+        }
+        out.push(ts, o, h, l, c, volume, 0);
+    }
+
+    return true;
+}
@@ -0,0 +1,248 @@
+#include "zerodha_client.h"
+#include "backtest.h"
+#include "candle_store.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BacktestJob {
+    std::string symbol;
+    std::string csv_file;  // empty when the candle store is used
+    std::string timeframe;
+    int quantity;
+    StrategyParams params;
+    BacktestResult result;
+    bool ok;
+
+    BacktestJob() : quantity(1), ok(false) {}
+};
+
+std::string rupees(int64_t paise) {
+    return Price::fromPaise(paise).toString();
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--csv FILE]... [--symbol SYM]... [--all]\n"
+              << "       [--store-dir DIR] [--timeframe TF] [--from yyyy-mm-dd] [--to yyyy-mm-dd]\n"
+              << "       [--ema N] [--target-multiple X] [--stop-rule extreme|second]\n"
+              << "       [--quantity N] [--threads N] [--no-squareoff] [--trades] [--rules FILE]" << std::endl;
+}
+
+} // namespace
+
+// Replays local candles (CSV files or the candle store) through the live EMA strategy.
+// No network access: trade settings and tick sizes come from the local CSV files.
+int main(int argc, char* argv[]) {
+    std::cout << "=== Zerodha EMA Backtest ===" << std::endl;
+
+    std::vector<std::string> csv_files;
+    std::vector<std::string> symbols;
+    bool all_symbols = false;
+    std::string store_dir = "candles";
+    std::string timeframe_override;
+    std::string from_arg;
+    std::string to_arg;
+    int ema_override = 0;
+    double target_override = 0.0;
+    std::string stop_rule_override;
+    int quantity_override = 0;
+    int threads = static_cast<int>((std::max)(1u, std::thread::hardware_concurrency()));
+    bool print_trades = false;
+
+    BacktestOptions options;
+    StrategyRules rules;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--csv" && has_value) {
+            csv_files.push_back(argv[++i]);
+        } else if (arg == "--symbol" && has_value) {
+            symbols.push_back(argv[++i]);
+        } else if (arg == "--all") {
+            all_symbols = true;
+        } else if (arg == "--store-dir" && has_value) {
+            store_dir = argv[++i];
+        } else if (arg == "--timeframe" && has_value) {
+            timeframe_override = argv[++i];
+        } else if (arg == "--from" && has_value) {
+            from_arg = argv[++i];
+        } else if (arg == "--to" && has_value) {
+            to_arg = argv[++i];
+        } else if (arg == "--ema" && has_value) {
+            ema_override = std::atoi(argv[++i]);
+        } else if (arg == "--target-multiple" && has_value) {
+            target_override = std::atof(argv[++i]);
+        } else if (arg == "--stop-rule" && has_value) {
+            stop_rule_override = argv[++i];
+            StopRule parsed;
+            if (!parseStopRule(stop_rule_override, parsed)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--quantity" && has_value) {
+            quantity_override = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            threads = (std::max)(1, std::atoi(argv[++i]));
+        } else if (arg == "--no-squareoff") {
+            options.intraday_squareoff = false;
+        } else if (arg == "--trades") {
+            print_trades = true;
+        } else if (arg == "--rules" && has_value) {
+            if (!rules.load(argv[++i])) {
+                return 1;
+            }
+            options.rules = &rules;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (csv_files.empty() && symbols.empty() && !all_symbols) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    int64_t from_ts = from_arg.empty() ? 0 : CandleStore::parseTimestamp(from_arg + "T00:00:00");
+    int64_t to_ts = to_arg.empty() ? INT64_MAX : CandleStore::parseTimestamp(to_arg + "T23:59:59");
+
+    // Settings and instruments are optional; defaults apply when the files are absent
+    ZerodhaClient client;
+    client.loadTradeSettings("TradeSettings.csv");
+    client.loadInstrumentsFromCSV("instruments.csv");
+
+    auto settingFor = [&](const std::string& symbol) -> TradeSetting {
+        for (const auto& setting : client.getTradeSettings()) {
+            if (setting.symbol == symbol) return setting;
+        }
+        TradeSetting fallback;
+        fallback.symbol = symbol;
+        fallback.quantity = 1;
+        fallback.timeframe = "5minute";
+        return fallback;
+    };
+
+    if (all_symbols) {
+        for (const auto& setting : client.getTradeSettings()) {
+            symbols.push_back(setting.symbol);
+        }
+    }
+
+    std::vector<BacktestJob> jobs;
+    for (const auto& file : csv_files) {
+        BacktestJob job;
+        job.symbol = file;
+        job.csv_file = file;
+        jobs.push_back(job);
+    }
+    for (const auto& symbol : symbols) {
+        BacktestJob job;
+        job.symbol = symbol;
+        jobs.push_back(job);
+    }
+    for (auto& job : jobs) {
+        TradeSetting setting = settingFor(job.symbol);
+        job.timeframe = timeframe_override.empty() ? setting.timeframe : timeframe_override;
+        job.quantity = quantity_override > 0 ? quantity_override : (std::max)(1, setting.quantity);
+        if (ema_override > 0) setting.ema_period = ema_override;
+        if (target_override > 0) setting.target_multiple = target_override;
+        if (!stop_rule_override.empty()) setting.stop_rule = stop_rule_override;
+        job.params = strategyParamsFor(setting);
+    }
+
+    std::cout << "Backtesting " << jobs.size() << " series on " << threads << " thread(s)..." << std::endl;
+
+    // Symbols are independent, so each worker loads and replays whole series
+    std::atomic<size_t> next_job{0};
+    std::atomic<size_t> replay_nanos{0};
+    auto worker = [&]() {
+        CandleSeries series;
+        while (true) {
+            size_t index = next_job.fetch_add(1);
+            if (index >= jobs.size()) break;
+            BacktestJob& job = jobs[index];
+
+            if (!job.csv_file.empty()) {
+                if (!Backtester::loadCSV(job.csv_file, series)) continue;
+            } else {
+                CandleStore store(store_dir);
+                if (!store.open(job.symbol, job.timeframe) || !store.readColumns(from_ts, to_ts, series)) {
+                    std::cerr << "Error: No stored candles for " << job.symbol << " (" << job.timeframe << ")" << std::endl;
+                    continue;
+                }
+            }
+
+            BacktestOptions job_options = options;
+            job_options.quantity = job.quantity;
+            job_options.tick = client.getTickSize(job.symbol);
+            job_options.record_trades = print_trades;
+
+            auto start = std::chrono::steady_clock::now();
+            job.result = Backtester::run(series, job.params, job_options);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            replay_nanos += static_cast<size_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            job.ok = true;
+        }
+    };
+
+    auto wall_start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+    BacktestResult total;
+    std::cout << "\n=== Backtest Results ===" << std::endl;
+    std::cout << std::left << std::setw(24) << "Symbol" << std::right
+              << std::setw(10) << "Candles" << std::setw(8) << "Trades" << std::setw(8) << "Win%"
+              << std::setw(14) << "Net P&L" << std::setw(14) << "Max DD" << std::endl;
+
+    for (const auto& job : jobs) {
+        if (!job.ok) continue;
+        const BacktestResult& r = job.result;
+        std::cout << std::left << std::setw(24) << job.symbol << std::right
+                  << std::setw(10) << r.candles << std::setw(8) << r.trade_count
+                  << std::setw(8) << std::fixed << std::setprecision(1) << r.winRate() * 100.0
+                  << std::setw(14) << rupees(r.net_pnl_paise) << std::setw(14) << rupees(r.max_drawdown_paise) << std::endl;
+
+        if (print_trades) {
+            for (const auto& trade : r.trades) {
+                std::cout << "  " << (trade.side == SignalSide::Buy ? "BUY " : "SELL ")
+                          << CandleStore::formatTimestamp(trade.entry_ts) << " @ " << trade.entry_price
+                          << " SL:" << trade.stop_loss << " T:" << trade.target
+                          << " -> " << CandleStore::formatTimestamp(trade.exit_ts) << " @ " << trade.exit_price
+                          << (trade.target_hit ? " TARGET" : "") << " P&L:" << rupees(trade.pnl_paise) << std::endl;
+            }
+        }
+        total.merge(r);
+    }
+
+    double replay_seconds = static_cast<double>(replay_nanos.load()) / 1e9;
+    std::cout << "\nTotal: " << total.trade_count << " trades, " << total.wins << " wins, "
+              << total.losses << " losses (" << std::setprecision(1) << total.winRate() * 100.0 << "%)" << std::endl;
+    std::cout << "Net P&L: " << rupees(total.net_pnl_paise)
+              << " | Gross profit: " << rupees(total.gross_profit_paise)
+              << " | Gross loss: " << rupees(total.gross_loss_paise)
+              << " | Worst drawdown: " << rupees(total.max_drawdown_paise) << std::endl;
+    std::cout << "Replayed " << total.candles << " candles in " << std::setprecision(3) << wall_seconds << "s wall";
+    if (replay_seconds > 0) {
+        std::cout << " (" << std::setprecision(2) << total.candles / replay_seconds / 1e6 << "M candles/s per core)";
+    }
+    std::cout << std::endl;
+
+    return 0;
+}
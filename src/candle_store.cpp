@@ -0,0 +1,519 @@
+#include "candle_store.h"
+#include "civil_date.h"
+#include "varint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+const char kDataMagic[8] = {'Z', 'C', 'D', 'A', 'T', '0', '0', '1'};
+const char kIndexMagic[8] = {'Z', 'C', 'I', 'D', 'X', '0', '0', '1'};
+
+void encodeColumn(std::string& out, const int64_t* values, size_t count) {
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        putSignedVarint(out, values[i] - previous);
+        previous = values[i];
+    }
+}
+
+void encodePriceColumn(std::string& out, const Price* values, size_t count) {
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        putSignedVarint(out, values[i].paise() - previous);
+        previous = values[i].paise();
+    }
+}
+
+bool decodeColumn(const uint8_t*& p, const uint8_t* end, int64_t* values, size_t count) {
+    int64_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t delta;
+        if (!getSignedVarint(p, end, delta)) return false;
+        previous += delta;
+        values[i] = previous;
+    }
+    return true;
+}
+
+} // namespace
+
+void CandleSeries::clear() {
+    timestamp.clear();
+    open.clear();
+    high.clear();
+    low.clear();
+    close.clear();
+    volume.clear();
+    oi.clear();
+}
+
+void CandleSeries::reserve(size_t count) {
+    timestamp.reserve(count);
+    open.reserve(count);
+    high.reserve(count);
+    low.reserve(count);
+    close.reserve(count);
+    volume.reserve(count);
+    oi.reserve(count);
+}
+
+void CandleSeries::push(int64_t ts, Price o, Price h, Price l, Price c, int64_t vol, int64_t open_interest) {
+    timestamp.push_back(ts);
+    open.push_back(o);
+    high.push_back(h);
+    low.push_back(l);
+    close.push_back(c);
+    volume.push_back(vol);
+    oi.push_back(open_interest);
+}
+
+CandleData CandleSeries::candle(size_t i) const {
+    CandleData candle;
+    candle.timestamp = CandleStore::formatTimestamp(timestamp[i]);
+    candle.open = open[i];
+    candle.high = high[i];
+    candle.low = low[i];
+    candle.close = close[i];
+    candle.volume = static_cast<int>(volume[i]);
+    candle.oi = static_cast<int>(oi[i]);
+    return candle;
+}
+
+CandleStore::CandleStore(const std::string& directory)
+    : directory_(directory), total_count_(0), append_batch_(0), mapped_end_(0) {
+}
+
+std::string CandleStore::sanitizeSymbol(const std::string& symbol) {
+    std::string result = symbol;
+    for (char& c : result) {
+        if (c == ':' || c == '/' || c == '\\' || c == ' ' || c == '&') c = '_';
+    }
+    return result;
+}
+
+bool CandleStore::open(const std::string& symbol, const std::string& timeframe) {
+    close();
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+
+    std::string base = directory_ + "/" + sanitizeSymbol(symbol) + "_" + timeframe;
+    std::string data_path = base + ".cdat";
+    std::string index_path = base + ".cidx";
+
+    // Leftovers of an interrupted prepend(): with both temp files the rebuild
+    // never finished and the originals are intact; a lone temp index means the
+    // new data is already in place and only its index still has to move
+    std::string temp_data = data_path + ".tmp";
+    std::string temp_index = index_path + ".tmp";
+    if (std::filesystem::exists(temp_index, ec)) {
+        if (std::filesystem::exists(temp_data, ec)) {
+            std::remove(temp_data.c_str());
+            std::remove(temp_index.c_str());
+        } else if (!replaceFile(temp_index, index_path)) {
+            std::cerr << "Error: Could not finish replacing candle index: " << index_path << std::endl;
+            return false;
+        }
+    }
+
+    return openFiles(data_path, index_path);
+}
+
+bool CandleStore::openFiles(const std::string& data_path, const std::string& index_path) {
+    data_path_ = data_path;
+    index_path_ = index_path;
+
+    // Create both files with their magic headers on first use
+    if (!std::filesystem::exists(data_path_)) {
+        std::ofstream data(data_path_, std::ios::binary);
+        data.write(kDataMagic, sizeof(kDataMagic));
+    }
+    if (!std::filesystem::exists(index_path_)) {
+        std::ofstream index(index_path_, std::ios::binary);
+        index.write(kIndexMagic, sizeof(kIndexMagic));
+    }
+
+    std::error_code ec;
+    uint64_t data_size = std::filesystem::file_size(data_path_, ec);
+    if (ec) {
+        std::cerr << "Error: Could not open candle store: " << data_path_ << std::endl;
+        data_path_.clear();
+        return false;
+    }
+
+    std::ifstream index(index_path_, std::ios::binary);
+    char magic[8] = {};
+    index.read(magic, sizeof(magic));
+    if (std::memcmp(magic, kIndexMagic, sizeof(magic)) != 0) {
+        std::cerr << "Error: Corrupt candle index: " << index_path_ << std::endl;
+        data_path_.clear();
+        return false;
+    }
+
+    // Keep index records that point at fully written data; stop at the first torn one
+    IndexRecord record;
+    while (index.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.offset + record.byte_size > data_size) break;
+        index_.push_back(record);
+        total_count_ += record.count;
+    }
+    index.close();
+
+    // Cut off a torn record (or records past the data) so appends land on a record boundary
+    uint64_t index_size = sizeof(kIndexMagic) + index_.size() * sizeof(IndexRecord);
+    if (std::filesystem::file_size(index_path_, ec) > index_size && !ec) {
+        std::filesystem::resize_file(index_path_, index_size, ec);
+    }
+    if (ec) {
+        std::cerr << "Error: Could not truncate candle index: " << index_path_ << std::endl;
+        index_.clear();
+        total_count_ = 0;
+        data_path_.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void CandleStore::close() {
+    if (isOpen()) flush();
+    pending_.clear();
+    mapped_.close();
+    mapped_end_ = 0;
+    index_.clear();
+    total_count_ = 0;
+    data_path_.clear();
+    index_path_.clear();
+}
+
+int64_t CandleStore::firstTimestamp() const {
+    if (!index_.empty()) return index_.front().first_ts;
+    return pending_.empty() ? 0 : pending_.timestamp.front();
+}
+
+int64_t CandleStore::lastTimestamp() const {
+    if (!pending_.empty()) return pending_.timestamp.back();
+    return index_.empty() ? 0 : index_.back().last_ts;
+}
+
+size_t CandleStore::append(const std::vector<CandleData>& candles) {
+    CandleSeries series;
+    series.reserve(candles.size());
+    for (const auto& candle : candles) {
+        series.push(parseTimestamp(candle.timestamp), candle.open, candle.high, candle.low,
+                    candle.close, candle.volume, candle.oi);
+    }
+    return append(series);
+}
+
+size_t CandleStore::append(const CandleSeries& series) {
+    if (!isOpen()) return 0;
+
+    // Skip everything already stored (and anything out of order)
+    bool have_last = !empty();
+    int64_t last = lastTimestamp();
+    size_t appended = 0;
+    for (size_t i = 0; i < series.size(); ++i) {
+        if (have_last && series.timestamp[i] <= last) continue;
+        pending_.push(series.timestamp[i], series.open[i], series.high[i], series.low[i],
+                      series.close[i], series.volume[i], series.oi[i]);
+        last = series.timestamp[i];
+        have_last = true;
+        ++appended;
+    }
+
+    if (pending_.size() >= append_batch_) flush();
+    return appended;
+}
+
+bool CandleStore::flush() {
+    size_t begin = 0;
+    while (begin < pending_.size()) {
+        size_t end = std::min(pending_.size(), begin + kBlockSize);
+        if (!appendBlock(pending_, begin, end)) break;
+        begin = end;
+    }
+    if (begin == pending_.size()) {
+        pending_.clear();
+        return true;
+    }
+
+    // Keep what did not make it to disk for the next attempt
+    CandleSeries rest;
+    for (size_t i = begin; i < pending_.size(); ++i) {
+        rest.push(pending_.timestamp[i], pending_.open[i], pending_.high[i], pending_.low[i],
+                  pending_.close[i], pending_.volume[i], pending_.oi[i]);
+    }
+    pending_ = std::move(rest);
+    return false;
+}
+
+size_t CandleStore::prepend(const std::vector<CandleData>& candles) {
+    CandleSeries series;
+    series.reserve(candles.size());
+    for (const auto& candle : candles) {
+        series.push(parseTimestamp(candle.timestamp), candle.open, candle.high, candle.low,
+                    candle.close, candle.volume, candle.oi);
+    }
+    return prepend(series);
+}
+
+size_t CandleStore::prepend(const CandleSeries& series) {
+    if (!isOpen()) return 0;
+    if (empty()) return append(series);
+    if (!flush()) return 0;
+
+    // Only candles strictly before the stored range, in order
+    int64_t first = firstTimestamp();
+    CandleSeries combined;
+    for (size_t i = 0; i < series.size() && series.timestamp[i] < first; ++i) {
+        if (!combined.empty() && series.timestamp[i] <= combined.timestamp.back()) continue;
+        combined.push(series.timestamp[i], series.open[i], series.high[i], series.low[i],
+                      series.close[i], series.volume[i], series.oi[i]);
+    }
+    size_t added = combined.size();
+    if (added == 0) return 0;
+
+    CandleSeries stored;
+    if (!readColumns(first, lastTimestamp(), stored)) return 0;
+    combined.reserve(added + stored.size());
+    for (size_t i = 0; i < stored.size(); ++i) {
+        combined.push(stored.timestamp[i], stored.open[i], stored.high[i], stored.low[i],
+                      stored.close[i], stored.volume[i], stored.oi[i]);
+    }
+
+    // Write the whole store again beside the original
+    const std::string data_path = data_path_;
+    const std::string index_path = index_path_;
+    const std::string temp_data = data_path + ".tmp";
+    const std::string temp_index = index_path + ".tmp";
+    std::remove(temp_data.c_str());
+    std::remove(temp_index.c_str());
+    {
+        CandleStore rebuilt(directory_);
+        if (!rebuilt.openFiles(temp_data, temp_index) || rebuilt.append(combined) != combined.size()) {
+            std::cerr << "Error: Could not rebuild candle store: " << data_path << std::endl;
+            std::remove(temp_data.c_str());
+            std::remove(temp_index.c_str());
+            return 0;
+        }
+    }
+
+    // Swap the files in over the originals, data first and index last; open()
+    // finishes the swap if a crash lands between the two
+    close();
+    bool swapped = replaceFile(temp_data, data_path) && replaceFile(temp_index, index_path);
+    if (!swapped) {
+        std::cerr << "Error: Could not replace candle store: " << data_path << std::endl;
+    }
+    if (!openFiles(data_path, index_path) || !swapped) return 0;
+    return added;
+}
+
+bool CandleStore::appendBlock(const CandleSeries& series, size_t begin, size_t end) {
+    const size_t count = end - begin;
+    std::string block;
+    block.reserve(count * 12);
+
+    putVarint(block, count);
+    encodeColumn(block, series.timestamp.data() + begin, count);
+    encodePriceColumn(block, series.open.data() + begin, count);
+    encodePriceColumn(block, series.high.data() + begin, count);
+    encodePriceColumn(block, series.low.data() + begin, count);
+    encodePriceColumn(block, series.close.data() + begin, count);
+    encodeColumn(block, series.volume.data() + begin, count);
+    encodeColumn(block, series.oi.data() + begin, count);
+
+    IndexRecord record;
+    record.first_ts = series.timestamp[begin];
+    record.last_ts = series.timestamp[end - 1];
+    record.offset = index_.empty() ? sizeof(kDataMagic) : index_.back().offset + index_.back().byte_size;
+    record.byte_size = static_cast<uint32_t>(block.size());
+    record.count = static_cast<uint32_t>(count);
+
+    // Data first, then the index record that makes it visible
+    std::fstream data(data_path_, std::ios::binary | std::ios::in | std::ios::out);
+    if (!data.is_open()) {
+        std::cerr << "Error: Could not write candle store: " << data_path_ << std::endl;
+        return false;
+    }
+    data.seekp(static_cast<std::streamoff>(record.offset));
+    data.write(block.data(), static_cast<std::streamsize>(block.size()));
+    data.close();
+    if (!data) return false;
+
+    std::ofstream index(index_path_, std::ios::binary | std::ios::app);
+    index.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    if (!index) return false;
+
+    index_.push_back(record);
+    total_count_ += count;
+    return true;
+}
+
+bool CandleStore::remap() const {
+    if (index_.empty()) return false;
+    uint64_t needed = index_.back().offset + index_.back().byte_size;
+    if (mapped_.isOpen() && mapped_end_ >= needed) return true;
+
+    if (!mapped_.open(data_path_) || mapped_.size() < needed) {
+        mapped_.close();
+        return false;
+    }
+    mapped_end_ = mapped_.size();
+    return true;
+}
+
+bool CandleStore::decodeBlock(const IndexRecord& record, CandleSeries& out, int64_t from_ts, int64_t to_ts) const {
+    const uint8_t* p = mapped_.data() + record.offset;
+    const uint8_t* end = p + record.byte_size;
+
+    uint64_t count;
+    if (!getVarint(p, end, count) || count != record.count) return false;
+
+    // Decode straight into scratch columns, then copy the requested slice
+    thread_local std::vector<int64_t> columns;
+    columns.resize(count * 7);
+    int64_t* ts = columns.data();
+    for (size_t c = 0; c < 7; ++c) {
+        if (!decodeColumn(p, end, ts + c * count, count)) return false;
+    }
+
+    const int64_t* open = ts + count;
+    const int64_t* high = ts + 2 * count;
+    const int64_t* low = ts + 3 * count;
+    const int64_t* close = ts + 4 * count;
+    const int64_t* volume = ts + 5 * count;
+    const int64_t* oi = ts + 6 * count;
+
+    size_t first = static_cast<size_t>(std::lower_bound(ts, ts + count, from_ts) - ts);
+    size_t last = static_cast<size_t>(std::upper_bound(ts, ts + count, to_ts) - ts);
+    for (size_t i = first; i < last; ++i) {
+        out.push(ts[i], Price::fromPaise(open[i]), Price::fromPaise(high[i]), Price::fromPaise(low[i]),
+                 Price::fromPaise(close[i]), volume[i], oi[i]);
+    }
+    return true;
+}
+
+bool CandleStore::readColumns(int64_t from_ts, int64_t to_ts, CandleSeries& out) const {
+    out.clear();
+    if (from_ts > to_ts) return true;
+    if (!index_.empty() && index_.front().first_ts <= to_ts && index_.back().last_ts >= from_ts) {
+        if (!remap()) {
+            std::cerr << "Error: Could not map candle store: " << data_path_ << std::endl;
+            return false;
+        }
+
+        auto it = std::lower_bound(index_.begin(), index_.end(), from_ts,
+                                   [](const IndexRecord& record, int64_t value) { return record.last_ts < value; });
+        for (; it != index_.end() && it->first_ts <= to_ts; ++it) {
+            if (!decodeBlock(*it, out, from_ts, to_ts)) {
+                std::cerr << "Error: Corrupt candle block in " << data_path_ << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Candles not yet flushed follow the stored ones
+    size_t first = static_cast<size_t>(std::lower_bound(pending_.timestamp.begin(), pending_.timestamp.end(), from_ts) -
+                                       pending_.timestamp.begin());
+    for (size_t i = first; i < pending_.size() && pending_.timestamp[i] <= to_ts; ++i) {
+        out.push(pending_.timestamp[i], pending_.open[i], pending_.high[i], pending_.low[i],
+                 pending_.close[i], pending_.volume[i], pending_.oi[i]);
+    }
+    return true;
+}
+
+std::vector<CandleData> CandleStore::read(int64_t from_ts, int64_t to_ts) const {
+    CandleSeries series;
+    readColumns(from_ts, to_ts, series);
+
+    std::vector<CandleData> candles;
+    candles.reserve(series.size());
+    for (size_t i = 0; i < series.size(); ++i) {
+        candles.push_back(series.candle(i));
+    }
+    return candles;
+}
+
+std::vector<CandleData> CandleStore::readLast(size_t count) const {
+    if (empty() || count == 0) return {};
+
+    // Walk back over whole blocks until enough candles are covered
+    size_t covered = pending_.size();
+    size_t block = index_.size();
+    while (block > 0 && covered < count) {
+        --block;
+        covered += index_[block].count;
+    }
+
+    int64_t from_ts = block < index_.size() ? index_[block].first_ts : pending_.timestamp.front();
+    std::vector<CandleData> candles = read(from_ts, std::numeric_limits<int64_t>::max());
+    if (candles.size() > count) {
+        candles.erase(candles.begin(), candles.end() - static_cast<std::ptrdiff_t>(count));
+    }
+    return candles;
+}
+
+int64_t CandleStore::parseTimestamp(const std::string& timestamp) {
+    // yyyy-mm-ddThh:mm:ss[+hhmm]; a missing offset is taken as IST
+    if (timestamp.size() < 19) return 0;
+    const char* p = timestamp.data();
+    int year, month, day, hour, minute, second;
+    if (!digits(p, 4, year) || !digits(p + 5, 2, month) || !digits(p + 8, 2, day) ||
+        !digits(p + 11, 2, hour) || !digits(p + 14, 2, minute) || !digits(p + 17, 2, second) ||
+        month < 1 || day < 1) {
+        return 0;
+    }
+
+    int offset_seconds = kIstOffsetSeconds;
+    if (timestamp.size() >= 24 && (timestamp[19] == '+' || timestamp[19] == '-')) {
+        size_t minutes_at = timestamp[22] == ':' ? 23 : 22;
+        int hh, mm;
+        if (timestamp.size() >= minutes_at + 2 && digits(p + 20, 2, hh) && digits(p + minutes_at, 2, mm)) {
+            offset_seconds = (hh * 3600 + mm * 60) * (timestamp[19] == '-' ? -1 : 1);
+        }
+    }
+
+    int64_t days = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+    return days * 86400 + hour * 3600 + minute * 60 + second - offset_seconds;
+}
+
+std::string CandleStore::formatTimestamp(int64_t epoch_seconds) {
+    int64_t local = epoch_seconds + kIstOffsetSeconds;
+    int64_t days = local / 86400;
+    int64_t secs = local % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        --days;
+    }
+
+    int year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02uT%02d:%02d:%02d+0530", year, month, day,
+                  static_cast<int>(secs / 3600), static_cast<int>((secs / 60) % 60), static_cast<int>(secs % 60));
+    return buf;
+}
+
+int CandleStore::timeframeSeconds(const std::string& timeframe) {
+    if (timeframe == "day") return 86400;
+    if (timeframe == "minute") return 60;
+
+    // "<n>minute" intervals (3minute, 5minute, 60minute, ...)
+    size_t pos = timeframe.find("minute");
+    if (pos != std::string::npos && pos > 0) {
+        int minutes = std::atoi(timeframe.substr(0, pos).c_str());
+        return minutes > 0 ? minutes * 60 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,683 @@
+#include "exchange_simulator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <nlohmann/json.hpp>
+#include <openssl/sha.h>
+
+namespace {
+
+// Kite sends "yyyy-mm-dd hh:mm:ss" (IST) or a bare date
+int64_t parseKiteDate(std::string text) {
+    if (text.size() == 10) text += "T00:00:00";
+    if (text.size() > 10 && text[10] == ' ') text[10] = 'T';
+    return CandleStore::parseTimestamp(text);
+}
+
+std::string sha256Hex(const std::string& input) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(input.data()), input.size(), hash);
+
+    std::ostringstream out;
+    for (unsigned char byte : hash) {
+        out << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+    }
+    return out.str();
+}
+
+void appendPrice(std::string& out, Price price) {
+    char buffer[32];
+    out.append(buffer, price.format(buffer));
+}
+
+nlohmann::json orderJson(const SimOrder& order) {
+    nlohmann::json json;
+    json["order_id"] = order.order_id;
+    json["status"] = order.status;
+    json["status_message"] = order.status_message.empty() ? nlohmann::json() : nlohmann::json(order.status_message);
+    json["tradingsymbol"] = order.symbol;
+    json["exchange"] = order.exchange;
+    json["transaction_type"] = order.transaction_type;
+    json["order_type"] = order.order_type;
+    json["product"] = order.product;
+    json["validity"] = order.validity;
+    json["tag"] = order.tag;
+    json["quantity"] = order.quantity;
+    json["filled_quantity"] = order.filled_quantity;
+    json["pending_quantity"] = order.isOpen() ? order.quantity - order.filled_quantity : 0;
+    json["price"] = order.price.toDouble();
+    json["trigger_price"] = order.trigger_price.toDouble();
+    json["average_price"] = order.average_price.toDouble();
+    json["order_timestamp"] = CandleStore::formatTimestamp(order.placed_ts).substr(0, 19);
+    json["exchange_timestamp"] = CandleStore::formatTimestamp(order.updated_ts).substr(0, 19);
+    return json;
+}
+
+} // namespace
+
+ExchangeSimulator::ExchangeSimulator()
+    : next_order_id_(250000000000001ULL), fills_(0), clock_mode_(ClockMode::Realtime), start_ts_(0), client_now_(0), speed_(1.0),
+      wall_start_(std::chrono::steady_clock::now()) {
+}
+
+bool ExchangeSimulator::loadInstruments(const std::string& csv_file) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return instruments_.loadFromCSVFile(csv_file);
+}
+
+bool ExchangeSimulator::addSeries(const std::string& symbol, const std::string& timeframe, const CandleSeries& series) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (series.empty()) {
+        return false;
+    }
+
+    SymbolBook book;
+    book.symbol = symbol;
+    book.exchange = "NSE";
+    book.timeframe = timeframe;
+    book.timeframe_seconds = (std::max)(1, CandleStore::timeframeSeconds(timeframe));
+    book.candles = series;
+
+    InstrumentStore::Row row = instruments_.findAny(symbol);
+    if (row != InstrumentStore::npos) {
+        book.token = instruments_.instrumentToken(row);
+        book.exchange = std::string(instruments_.exchange(row));
+    } else {
+        // Not in the dump: add an NSE equity row so the client can resolve it
+        Instrument inst;
+        book.token = static_cast<uint32_t>(900000 + books_.size());
+        inst.instrument_token = std::to_string(book.token);
+        inst.tradingsymbol = symbol;
+        inst.name = symbol;
+        inst.exchange = "NSE";
+        inst.segment = "NSE";
+        inst.instrument_type = "EQ";
+        instruments_.append(inst);
+        instruments_.buildIndexes();
+    }
+
+    // Open, the nearer extreme, the far extreme, close - spread across the candle
+    const int64_t step = book.timeframe_seconds / 4;
+    book.ticks.reserve(series.size() * 4);
+    for (size_t i = 0; i < series.size(); ++i) {
+        int64_t ts = series.timestamp[i];
+        bool bullish = series.close[i] >= series.open[i];
+        book.ticks.push_back(Tick{ts, series.open[i]});
+        book.ticks.push_back(Tick{ts + step, bullish ? series.low[i] : series.high[i]});
+        book.ticks.push_back(Tick{ts + 2 * step, bullish ? series.high[i] : series.low[i]});
+        book.ticks.push_back(Tick{ts + book.timeframe_seconds - 1, series.close[i]});
+    }
+
+    size_t index = books_.size();
+    book_by_key_[book.exchange + ":" + symbol] = index;
+    book_by_key_.emplace(symbol, index);
+    book_by_token_[book.token] = index;
+    books_.push_back(std::move(book));
+    return true;
+}
+
+void ExchangeSimulator::setRealtimeClock(int64_t start_ts, double speed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clock_mode_ = ClockMode::Realtime;
+    start_ts_ = start_ts;
+    speed_ = speed > 0 ? speed : 1.0;
+    wall_start_ = std::chrono::steady_clock::now();
+    positionCursors(start_ts);
+}
+
+void ExchangeSimulator::setStepClock(int64_t start_ts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clock_mode_ = ClockMode::Step;
+    start_ts_ = start_ts;
+    positionCursors(start_ts);
+}
+
+void ExchangeSimulator::setClientClock(int64_t start_ts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clock_mode_ = ClockMode::Client;
+    start_ts_ = start_ts;
+    client_now_ = start_ts;
+    positionCursors(start_ts);
+}
+
+void ExchangeSimulator::positionCursors(int64_t start_ts) {
+    for (auto& book : books_) {
+        auto it = std::upper_bound(book.ticks.begin(), book.ticks.end(), start_ts,
+                                   [](int64_t ts, const Tick& tick) { return ts < tick.ts; });
+        book.cursor = static_cast<size_t>(it - book.ticks.begin());
+    }
+}
+
+int64_t ExchangeSimulator::simNow() const {
+    if (clock_mode_ == ClockMode::Client) {
+        return client_now_;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start_).count();
+    return start_ts_ + static_cast<int64_t>(elapsed * speed_);
+}
+
+int64_t ExchangeSimulator::bookNow(const SymbolBook& book) const {
+    if (clock_mode_ != ClockMode::Step) {
+        return simNow();
+    }
+    return book.hasPrice() ? book.ticks[book.cursor - 1].ts : start_ts_;
+}
+
+void ExchangeSimulator::advanceTo(SymbolBook& book) {
+    if (clock_mode_ == ClockMode::Step) {
+        return; // step mode only moves on LTP requests
+    }
+    int64_t now = simNow();
+    while (book.cursor < book.ticks.size() && book.ticks[book.cursor].ts <= now) {
+        emitTick(book);
+    }
+}
+
+void ExchangeSimulator::emitTick(SymbolBook& book) {
+    if (book.cursor >= book.ticks.size()) {
+        return; // replay finished; the last price stays
+    }
+    ++book.cursor;
+    Price ltp = book.lastPrice();
+
+    auto& open = book.open_orders;
+    open.erase(std::remove_if(open.begin(), open.end(), [&](size_t index) {
+        return tryFill(book, orders_[index], ltp, true);
+    }), open.end());
+}
+
+bool ExchangeSimulator::tryFill(SymbolBook& book, SimOrder& order, Price ltp, bool resting) {
+    if (!order.isOpen()) {
+        return true;
+    }
+
+    bool buy = order.isBuy();
+    bool stop_order = order.order_type == "SL" || order.order_type == "SL-M";
+    if (stop_order && !order.triggered) {
+        bool hit = buy ? ltp >= order.trigger_price : ltp <= order.trigger_price;
+        if (!hit) {
+            return false;
+        }
+        order.triggered = true;
+        order.status = "OPEN";
+        resting = false; // becomes marketable at the trigger
+    }
+
+    if (order.order_type == "MARKET" || order.order_type == "SL-M") {
+        fill(book, order, ltp);
+        return true;
+    }
+
+    // LIMIT, or SL after its trigger: fill at the limit once resting, or better on arrival
+    bool crosses = buy ? ltp <= order.price : ltp >= order.price;
+    if (!crosses) {
+        return false;
+    }
+    fill(book, order, resting ? order.price : ltp);
+    return true;
+}
+
+void ExchangeSimulator::fill(SymbolBook& book, SimOrder& order, Price price) {
+    order.status = "COMPLETE";
+    order.filled_quantity = order.quantity;
+    order.average_price = price;
+    order.updated_ts = bookNow(book);
+    ++fills_;
+
+    SimPosition& position = positions_[order.exchange + ":" + order.symbol + ":" + order.product];
+    position.symbol = order.symbol;
+    position.exchange = order.exchange;
+    position.product = order.product;
+    position.token = book.token;
+    if (order.isBuy()) {
+        position.buy_quantity += order.quantity;
+        position.buy_value_paise += price.paise() * order.quantity;
+    } else {
+        position.sell_quantity += order.quantity;
+        position.sell_value_paise += price.paise() * order.quantity;
+    }
+}
+
+ExchangeSimulator::SymbolBook* ExchangeSimulator::findBook(const std::string& key) {
+    auto it = book_by_key_.find(key);
+    return it != book_by_key_.end() ? &books_[it->second] : nullptr;
+}
+
+HttpResponse ExchangeSimulator::error(int status, const std::string& error_type, const std::string& message) {
+    nlohmann::json json;
+    json["status"] = "error";
+    json["message"] = message;
+    json["data"] = nullptr;
+    json["error_type"] = error_type;
+    return HttpResponse(status, json.dump());
+}
+
+bool ExchangeSimulator::authorised(const HttpRequest& request) const {
+    // "token api_key:access_token"
+    std::string value = request.header("Authorization");
+    if (value.compare(0, 6, "token ") != 0) return false;
+    size_t colon = value.find(':', 6);
+    if (colon == std::string::npos) return false;
+    auto it = sessions_.find(value.substr(colon + 1));
+    return it != sessions_.end() && it->second == value.substr(6, colon - 6);
+}
+
+HttpResponse ExchangeSimulator::handle(const HttpRequest& request) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (clock_mode_ == ClockMode::Client) {
+        // Time only moves forward, whatever order concurrent requests arrive in
+        std::string sim_time = request.header("X-Sim-Time");
+        if (!sim_time.empty()) {
+            client_now_ = (std::max)(client_now_, static_cast<int64_t>(std::strtoll(sim_time.c_str(), nullptr, 10)));
+        }
+    }
+    std::string endpoint = "other";
+    HttpResponse response = route(request, endpoint);
+
+    uint64_t elapsed = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    EndpointStats& stat = stats_[endpoint];
+    ++stat.requests;
+    stat.total_ns += elapsed;
+    stat.max_ns = (std::max)(stat.max_ns, elapsed);
+    return response;
+}
+
+HttpResponse ExchangeSimulator::route(const HttpRequest& request, std::string& endpoint) {
+    const std::string& path = request.path;
+    const std::string& method = request.method;
+
+    if (path == "/session/token" && method == "POST") {
+        endpoint = "session";
+        return sessionToken(request);
+    }
+    if (path == "/sim/stats") {
+        endpoint = "stats";
+        return stats();
+    }
+    if (!authorised(request)) {
+        return error(403, "TokenException", "Incorrect `api_key` or `access_token`.");
+    }
+
+    if (path == "/quote/ltp" && method == "GET") {
+        endpoint = "ltp";
+        return quoteLtp(request);
+    }
+    if (path == "/orders/regular" && method == "POST") {
+        endpoint = "place_order";
+        return placeOrder(request);
+    }
+    if (path.compare(0, 16, "/orders/regular/") == 0 && method == "DELETE") {
+        endpoint = "cancel_order";
+        return cancelOrder(path.substr(16));
+    }
+    if ((path == "/orders" || path.compare(0, 8, "/orders/") == 0) && method == "GET") {
+        endpoint = "orders";
+        return orders(path.size() > 8 ? path.substr(8) : std::string());
+    }
+    if (path == "/portfolio/positions" && method == "GET") {
+        endpoint = "positions";
+        return positions();
+    }
+    if (path.compare(0, 24, "/instruments/historical/") == 0 && method == "GET") {
+        endpoint = "historical";
+        std::string rest = path.substr(24);
+        size_t slash = rest.find('/');
+        if (slash == std::string::npos) {
+            return error(400, "InputException", "Invalid interval.");
+        }
+        return historical(request, rest.substr(0, slash), rest.substr(slash + 1));
+    }
+    if ((path == "/instruments" || path.compare(0, 13, "/instruments/") == 0) && method == "GET") {
+        endpoint = "instruments";
+        return instruments(path.size() > 13 ? path.substr(13) : std::string());
+    }
+
+    return error(404, "GeneralException", "Route not found");
+}
+
+HttpResponse ExchangeSimulator::sessionToken(const HttpRequest& request) {
+    auto field = [&](const char* name) {
+        auto it = request.form.find(name);
+        return it != request.form.end() ? it->second : std::string();
+    };
+    std::string api_key = field("api_key");
+    std::string request_token = field("request_token");
+    if (api_key.empty() || request_token.empty()) {
+        return error(400, "InputException", "Missing api_key or request_token");
+    }
+    if (!api_secret_.empty() && field("checksum") != sha256Hex(api_key + request_token + api_secret_)) {
+        return error(403, "TokenException", "Invalid `checksum`.");
+    }
+
+    std::string access_token = sha256Hex(api_key + request_token + std::to_string(sessions_.size())).substr(0, 32);
+    sessions_[access_token] = api_key;
+
+    nlohmann::json json;
+    json["status"] = "success";
+    json["data"]["user_id"] = "SIM001";
+    json["data"]["user_name"] = "Simulator";
+    json["data"]["api_key"] = api_key;
+    json["data"]["access_token"] = access_token;
+    json["data"]["login_time"] = CandleStore::formatTimestamp(simNow()).substr(0, 19);
+    return HttpResponse(200, json.dump());
+}
+
+std::string ExchangeSimulator::instrumentsCSV(const std::string& exchange) const {
+    std::string out = "instrument_token,tradingsymbol,name,exchange,instrument_type,segment,lot_size,tick_size,expiry,strike\n";
+    auto writeRow = [&](InstrumentStore::Row r) {
+        out += std::to_string(instruments_.instrumentToken(r));
+        out += ',';
+        out += instruments_.tradingsymbol(r);
+        out += ",\"";
+        out += instruments_.name(r);
+        out += "\",";
+        out += instruments_.exchange(r);
+        out += ',';
+        out += instruments_.instrumentType(r);
+        out += ',';
+        out += instruments_.segment(r);
+        out += ',';
+        out += std::to_string(instruments_.lotSize(r));
+        out += ',';
+        appendPrice(out, instruments_.tickSize(r));
+        out += ',';
+        out += InstrumentStore::formatExpiry(instruments_.expiry(r));
+        out += ',';
+        appendPrice(out, instruments_.strike(r));
+        out += '\n';
+    };
+
+    if (exchange.empty()) {
+        for (InstrumentStore::Row r = 0; r < instruments_.size(); ++r) writeRow(r);
+    } else {
+        for (InstrumentStore::Row r : instruments_.byExchange(exchange)) writeRow(r);
+    }
+    return out;
+}
+
+HttpResponse ExchangeSimulator::instruments(const std::string& exchange) {
+    return HttpResponse(200, instrumentsCSV(exchange), "text/csv");
+}
+
+HttpResponse ExchangeSimulator::historical(const HttpRequest& request, const std::string& token, const std::string& interval) {
+    auto it = book_by_token_.find(static_cast<uint32_t>(std::strtoul(token.c_str(), nullptr, 10)));
+    if (it == book_by_token_.end()) {
+        return error(400, "InputException", "invalid token");
+    }
+    SymbolBook& book = books_[it->second];
+    if (interval != book.timeframe) {
+        return error(400, "InputException", "Interval " + interval + " not loaded in the simulator");
+    }
+    advanceTo(book);
+
+    auto param = [&](const char* name) {
+        auto found = request.query.find(name);
+        return found != request.query.end() ? found->second : std::string();
+    };
+    int64_t from_ts = parseKiteDate(param("from"));
+    int64_t to_ts = parseKiteDate(param("to"));
+    if (from_ts == 0 || to_ts == 0 || from_ts > to_ts) {
+        return error(400, "InputException", "Invalid from/to dates");
+    }
+
+    // A client on wall-clock time asks for "now"; keep the window length but end it at replay time
+    int64_t now = bookNow(book);
+    if (to_ts > now) {
+        from_ts -= to_ts - now;
+        to_ts = now;
+    }
+    bool with_oi = param("oi") == "1";
+
+    const CandleSeries& series = book.candles;
+    size_t first = static_cast<size_t>(std::lower_bound(series.timestamp.begin(), series.timestamp.end(), from_ts) -
+                                       series.timestamp.begin());
+
+    std::string out = "{\"status\":\"success\",\"data\":{\"candles\":[";
+    bool any = false;
+    for (size_t k = first; k < series.size() && series.timestamp[k] <= to_ts; ++k) {
+        size_t first_tick = k * 4;
+        if (first_tick >= book.cursor) break; // not printed yet
+
+        Price open = series.open[k], high = series.high[k], low = series.low[k], close = series.close[k];
+        int64_t volume = series.volume[k];
+        if (first_tick + 4 > book.cursor) {
+            // Forming candle: only the ticks printed so far
+            size_t printed = book.cursor - first_tick;
+            open = high = low = close = book.ticks[first_tick].price;
+            for (size_t t = first_tick + 1; t < book.cursor; ++t) {
+                high = (std::max)(high, book.ticks[t].price);
+                low = (std::min)(low, book.ticks[t].price);
+                close = book.ticks[t].price;
+            }
+            volume = volume * static_cast<int64_t>(printed) / 4;
+        }
+
+        if (any) out += ',';
+        any = true;
+        out += "[\"";
+        out += CandleStore::formatTimestamp(series.timestamp[k]);
+        out += "\",";
+        appendPrice(out, open);
+        out += ',';
+        appendPrice(out, high);
+        out += ',';
+        appendPrice(out, low);
+        out += ',';
+        appendPrice(out, close);
+        out += ',';
+        out += std::to_string(volume);
+        if (with_oi) {
+            out += ',';
+            out += std::to_string(series.oi[k]);
+        }
+        out += ']';
+    }
+    out += "]}}";
+    return HttpResponse(200, out);
+}
+
+HttpResponse ExchangeSimulator::quoteLtp(const HttpRequest& request) {
+    std::string out = "{\"status\":\"success\",\"data\":{";
+    bool any = false;
+
+    auto range = request.query_all.equal_range("i");
+    for (auto it = range.first; it != range.second; ++it) {
+        SymbolBook* book = findBook(it->second);
+        if (!book) continue; // Kite silently omits unknown instruments
+
+        if (clock_mode_ == ClockMode::Step) {
+            emitTick(*book);
+        } else {
+            advanceTo(*book);
+        }
+        if (!book->hasPrice()) continue;
+
+        if (any) out += ',';
+        any = true;
+        out += "\"" + it->second + "\":{\"instrument_token\":" + std::to_string(book->token) + ",\"last_price\":";
+        appendPrice(out, book->lastPrice());
+        out += '}';
+    }
+    out += "}}";
+    return HttpResponse(200, out);
+}
+
+HttpResponse ExchangeSimulator::placeOrder(const HttpRequest& request) {
+    auto field = [&](const char* name) {
+        auto it = request.form.find(name);
+        return it != request.form.end() ? it->second : std::string();
+    };
+
+    SimOrder order;
+    order.symbol = field("tradingsymbol");
+    order.exchange = field("exchange");
+    order.transaction_type = field("transaction_type");
+    order.order_type = field("order_type");
+    order.product = field("product");
+    order.validity = field("validity").empty() ? "DAY" : field("validity");
+    order.tag = field("tag");
+    order.quantity = std::atoi(field("quantity").c_str());
+    Price::parse(field("price"), order.price);
+    Price::parse(field("trigger_price"), order.trigger_price);
+
+    SymbolBook* book = findBook(order.exchange + ":" + order.symbol);
+    if (!book) {
+        return error(400, "InputException", "Invalid `tradingsymbol` or `exchange`.");
+    }
+    if (order.transaction_type != "BUY" && order.transaction_type != "SELL") {
+        return error(400, "InputException", "Invalid `transaction_type`.");
+    }
+    if (order.quantity <= 0) {
+        return error(400, "InputException", "Invalid `quantity`.");
+    }
+    bool needs_price = order.order_type == "LIMIT" || order.order_type == "SL";
+    bool needs_trigger = order.order_type == "SL" || order.order_type == "SL-M";
+    if (order.order_type != "MARKET" && !needs_price && !needs_trigger) {
+        return error(400, "InputException", "Invalid `order_type`.");
+    }
+    if ((needs_price && order.price <= Price()) || (needs_trigger && order.trigger_price <= Price())) {
+        return error(400, "InputException", "Missing `price` or `trigger_price`.");
+    }
+
+    advanceTo(*book);
+
+    order.order_id = std::to_string(next_order_id_++);
+    order.status = needs_trigger ? "TRIGGER PENDING" : "OPEN";
+    order.placed_ts = order.updated_ts = bookNow(*book);
+
+    size_t index = orders_.size();
+    orders_.push_back(order);
+    order_index_[order.order_id] = index;
+
+    if (!book->hasPrice() || !tryFill(*book, orders_[index], book->lastPrice(), false)) {
+        book->open_orders.push_back(index);
+    }
+
+    nlohmann::json json;
+    json["status"] = "success";
+    json["data"]["order_id"] = order.order_id;
+    return HttpResponse(200, json.dump());
+}
+
+HttpResponse ExchangeSimulator::cancelOrder(const std::string& order_id) {
+    auto it = order_index_.find(order_id);
+    if (it == order_index_.end()) {
+        return error(400, "InputException", "Invalid `order_id`.");
+    }
+    SimOrder& order = orders_[it->second];
+    if (!order.isOpen()) {
+        return error(400, "InputException", "Order cannot be cancelled as it is being processed or already " + order.status);
+    }
+
+    SymbolBook* book = findBook(order.exchange + ":" + order.symbol);
+    order.status = "CANCELLED";
+    order.status_message = "Cancelled by user";
+    if (book) {
+        order.updated_ts = bookNow(*book);
+        auto& open = book->open_orders;
+        open.erase(std::remove(open.begin(), open.end(), it->second), open.end());
+    }
+
+    nlohmann::json json;
+    json["status"] = "success";
+    json["data"]["order_id"] = order_id;
+    return HttpResponse(200, json.dump());
+}
+
+HttpResponse ExchangeSimulator::orders(const std::string& order_id) {
+    // Bring resting orders up to date before reporting them
+    for (auto& book : books_) {
+        if (!book.open_orders.empty()) advanceTo(book);
+    }
+
+    nlohmann::json json;
+    json["status"] = "success";
+    json["data"] = nlohmann::json::array();
+    if (order_id.empty()) {
+        for (const auto& order : orders_) {
+            json["data"].push_back(orderJson(order));
+        }
+    } else {
+        auto it = order_index_.find(order_id);
+        if (it == order_index_.end()) {
+            return error(400, "InputException", "Invalid `order_id`.");
+        }
+        json["data"].push_back(orderJson(orders_[it->second])); // history of one state
+    }
+    return HttpResponse(200, json.dump());
+}
+
+HttpResponse ExchangeSimulator::positions() {
+    nlohmann::json net = nlohmann::json::array();
+    for (const auto& entry : positions_) {
+        const SimPosition& position = entry.second;
+        SymbolBook* book = findBook(position.exchange + ":" + position.symbol);
+        if (book) advanceTo(*book);
+        Price ltp = book && book->hasPrice() ? book->lastPrice() : Price();
+
+        int64_t quantity = position.quantity();
+        int64_t pnl_paise = position.sell_value_paise - position.buy_value_paise + quantity * ltp.paise();
+        double buy_price = position.buy_quantity ? position.buy_value_paise / 100.0 / position.buy_quantity : 0.0;
+        double sell_price = position.sell_quantity ? position.sell_value_paise / 100.0 / position.sell_quantity : 0.0;
+
+        nlohmann::json json;
+        json["tradingsymbol"] = position.symbol;
+        json["exchange"] = position.exchange;
+        json["instrument_token"] = position.token;
+        json["product"] = position.product;
+        json["quantity"] = quantity;
+        json["average_price"] = quantity > 0 ? buy_price : (quantity < 0 ? sell_price : 0.0);
+        json["last_price"] = ltp.toDouble();
+        json["pnl"] = pnl_paise / 100.0;
+        json["m2m"] = pnl_paise / 100.0;
+        json["buy_quantity"] = position.buy_quantity;
+        json["buy_price"] = buy_price;
+        json["buy_value"] = position.buy_value_paise / 100.0;
+        json["sell_quantity"] = position.sell_quantity;
+        json["sell_price"] = sell_price;
+        json["sell_value"] = position.sell_value_paise / 100.0;
+        net.push_back(json);
+    }
+
+    nlohmann::json json;
+    json["status"] = "success";
+    json["data"]["net"] = net;
+    json["data"]["day"] = net; // every simulated position is opened today
+    return HttpResponse(200, json.dump());
+}
+
+HttpResponse ExchangeSimulator::stats() const {
+    nlohmann::json json;
+    json["status"] = "success";
+    json["data"]["symbols"] = books_.size();
+    json["data"]["orders"] = orders_.size();
+    json["data"]["fills"] = fills_;
+    json["data"]["sim_time"] = CandleStore::formatTimestamp(clock_mode_ == ClockMode::Step ? start_ts_ : simNow());
+    for (const auto& entry : stats_) {
+        const EndpointStats& stat = entry.second;
+        json["data"]["endpoints"][entry.first] = {
+            {"requests", stat.requests},
+            {"avg_us", stat.requests ? stat.total_ns / stat.requests / 1000.0 : 0.0},
+            {"max_us", stat.max_ns / 1000.0}
+        };
+    }
+    return HttpResponse(200, json.dump());
+}
+
+void ExchangeSimulator::printSummary() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "\n=== Simulator Summary ===" << std::endl;
+    std::cout << "Symbols: " << books_.size() << " | Orders: " << orders_.size() << " | Fills: " << fills_ << std::endl;
+    for (const auto& entry : stats_) {
+        const EndpointStats& stat = entry.second;
+        std::cout << std::left << std::setw(14) << entry.first << std::right
+                  << std::setw(10) << stat.requests << " requests, avg "
+                  << std::fixed << std::setprecision(1) << (stat.requests ? stat.total_ns / stat.requests / 1000.0 : 0.0)
+                  << " us, max " << stat.max_ns / 1000.0 << " us" << std::endl;
+    }
+}
@@ -0,0 +1,341 @@
+#include "http_server.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using socket_t = SOCKET;
+#define CLOSE_SOCKET closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using socket_t = int;
+#define INVALID_SOCKET (-1)
+#define CLOSE_SOCKET ::close
+#endif
+
+namespace {
+
+constexpr size_t kMaxHeaderBytes = 64 * 1024;
+constexpr size_t kMaxBodyBytes = 16 * 1024 * 1024;
+
+const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+bool sendAll(socket_t socket, const char* data, size_t size) {
+    while (size > 0) {
+        int sent = ::send(socket, data, static_cast<int>((std::min)(size, static_cast<size_t>(1 << 30))), 0);
+        if (sent <= 0) return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+#ifdef _WIN32
+struct WinsockInit {
+    WinsockInit() {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+    }
+    ~WinsockInit() { WSACleanup(); }
+};
+#endif
+
+} // namespace
+
+std::string HttpRequest::header(const std::string& name) const {
+    auto it = headers.find(toLower(name));
+    return it != headers.end() ? it->second : std::string();
+}
+
+HttpServer::HttpServer(const std::string& bind_address, int port, int workers)
+    : bind_address_(bind_address), port_(port), worker_count_((std::max)(1, workers)),
+      listen_socket_(static_cast<intptr_t>(INVALID_SOCKET)), running_(false) {
+#ifdef _WIN32
+    static WinsockInit winsock;
+#endif
+}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+std::string HttpServer::urlDecode(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '+') {
+            out.push_back(' ');
+        } else if (c == '%' && i + 2 < text.size() &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            out.push_back(static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16)));
+            i += 2;
+        } else {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+void HttpServer::parseUrlEncoded(const std::string& text, std::map<std::string, std::string>& out,
+                                 std::multimap<std::string, std::string>* all) {
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t amp = text.find('&', start);
+        if (amp == std::string::npos) amp = text.size();
+        std::string pair = text.substr(start, amp - start);
+        if (!pair.empty()) {
+            size_t eq = pair.find('=');
+            std::string key = urlDecode(pair.substr(0, eq));
+            std::string value = eq == std::string::npos ? std::string() : urlDecode(pair.substr(eq + 1));
+            out[key] = value;
+            if (all) all->emplace(key, value);
+        }
+        start = amp + 1;
+    }
+}
+
+bool HttpServer::start() {
+    if (running_) return true;
+
+    socket_t listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_SOCKET) {
+        std::cerr << "Error: Could not create listening socket" << std::endl;
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<unsigned short>(port_));
+    if (inet_pton(AF_INET, bind_address_.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "Error: Invalid bind address: " << bind_address_ << std::endl;
+        CLOSE_SOCKET(listener);
+        return false;
+    }
+
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 512) != 0) {
+        std::cerr << "Error: Could not listen on " << bind_address_ << ":" << port_ << std::endl;
+        CLOSE_SOCKET(listener);
+        return false;
+    }
+
+    socklen_t length = sizeof(address);
+    if (getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+        port_ = ntohs(address.sin_port);
+    }
+
+    listen_socket_ = static_cast<intptr_t>(listener);
+    running_ = true;
+    for (int i = 0; i < worker_count_; ++i) {
+        workers_.emplace_back(&HttpServer::workerLoop, this);
+    }
+    accept_thread_ = std::thread(&HttpServer::acceptLoop, this);
+    return true;
+}
+
+void HttpServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    socket_t listener = static_cast<socket_t>(listen_socket_);
+#ifdef _WIN32
+    CLOSE_SOCKET(listener);
+#else
+    ::shutdown(listener, SHUT_RDWR);
+    CLOSE_SOCKET(listener);
+#endif
+    listen_socket_ = static_cast<intptr_t>(INVALID_SOCKET);
+
+    queue_cv_.notify_all();
+    if (accept_thread_.joinable()) accept_thread_.join();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (intptr_t socket : pending_) {
+        CLOSE_SOCKET(static_cast<socket_t>(socket));
+    }
+    pending_.clear();
+}
+
+void HttpServer::acceptLoop() {
+    socket_t listener = static_cast<socket_t>(listen_socket_);
+    while (running_) {
+        socket_t client = ::accept(listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            if (!running_) break;
+            continue;
+        }
+
+        int no_delay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&no_delay), sizeof(no_delay));
+
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            pending_.push_back(static_cast<intptr_t>(client));
+        }
+        queue_cv_.notify_one();
+    }
+}
+
+void HttpServer::workerLoop() {
+    while (true) {
+        intptr_t socket;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return !pending_.empty() || !running_; });
+            if (!running_) return;
+            socket = pending_.front();
+            pending_.pop_front();
+        }
+        serveConnection(socket);
+    }
+}
+
+void HttpServer::serveConnection(intptr_t handle) {
+    socket_t socket = static_cast<socket_t>(handle);
+
+#ifdef _WIN32
+    DWORD timeout_ms = 1000;
+#else
+    timeval timeout_ms{1, 0};
+#endif
+    // Short receive timeout so idle keep-alive connections notice shutdown
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+
+    std::string buffer;
+    char chunk[16 * 1024];
+    bool keep_alive = true;
+    int idle_timeouts = 0;
+
+    while (keep_alive && running_) {
+        // Read until the end of the headers
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (buffer.size() > kMaxHeaderBytes) {
+                keep_alive = false;
+                break;
+            }
+            int received = ::recv(socket, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                // Timeouts keep an idle connection open for up to 30 seconds
+                if (received < 0 && buffer.empty() && running_ && ++idle_timeouts < 30) continue;
+                keep_alive = false;
+                break;
+            }
+            idle_timeouts = 0;
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+        if (!keep_alive) break;
+
+        HttpRequest request;
+        std::string head = buffer.substr(0, header_end);
+        buffer.erase(0, header_end + 4);
+
+        size_t line_end = head.find("\r\n");
+        std::string request_line = head.substr(0, line_end);
+        size_t first_space = request_line.find(' ');
+        size_t second_space = request_line.find(' ', first_space + 1);
+        if (first_space == std::string::npos || second_space == std::string::npos) {
+            break;
+        }
+        request.method = request_line.substr(0, first_space);
+        std::string target = request_line.substr(first_space + 1, second_space - first_space - 1);
+        bool http10 = request_line.compare(second_space + 1, std::string::npos, "HTTP/1.0") == 0;
+
+        size_t question = target.find('?');
+        request.path = urlDecode(target.substr(0, question));
+        if (question != std::string::npos) {
+            parseUrlEncoded(target.substr(question + 1), request.query, &request.query_all);
+        }
+
+        size_t position = line_end == std::string::npos ? head.size() : line_end + 2;
+        while (position < head.size()) {
+            size_t next = head.find("\r\n", position);
+            if (next == std::string::npos) next = head.size();
+            std::string line = head.substr(position, next - position);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                std::string value = line.substr(colon + 1);
+                value.erase(0, value.find_first_not_of(" \t"));
+                request.headers[toLower(line.substr(0, colon))] = value;
+            }
+            position = next + 2;
+        }
+
+        size_t content_length = static_cast<size_t>(std::strtoull(request.header("Content-Length").c_str(), nullptr, 10));
+        if (content_length > kMaxBodyBytes) break;
+        while (buffer.size() < content_length) {
+            int received = ::recv(socket, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                keep_alive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+        if (!keep_alive) break;
+        request.body = buffer.substr(0, content_length);
+        buffer.erase(0, content_length);
+
+        if (request.header("Content-Type").find("application/x-www-form-urlencoded") != std::string::npos) {
+            parseUrlEncoded(request.body, request.form);
+        }
+
+        std::string connection = toLower(request.header("Connection"));
+        keep_alive = http10 ? connection == "keep-alive" : connection != "close";
+
+        HttpResponse response;
+        try {
+            response = handler_ ? handler_(request) : HttpResponse(404, "{\"status\":\"error\",\"message\":\"No handler\"}");
+        } catch (const std::exception& e) {
+            response = HttpResponse(500, std::string("{\"status\":\"error\",\"message\":\"") + e.what() + "\"}");
+        }
+
+        std::string out;
+        out.reserve(response.body.size() + 256);
+        out += "HTTP/1.1 " + std::to_string(response.status) + " " + statusText(response.status) + "\r\n";
+        out += "Content-Type: " + response.content_type + "\r\n";
+        out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+        for (const auto& header : response.headers) {
+            out += header.first + ": " + header.second + "\r\n";
+        }
+        out += keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        out += response.body;
+
+        if (!sendAll(socket, out.data(), out.size())) break;
+    }
+
+    CLOSE_SOCKET(socket);
+}
@@ -0,0 +1,406 @@
+#include "indicators.h"
+#include "strategy.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Bars per block of element-wise work in the batch passes
+constexpr size_t kBlock = 256;
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+int64_t trueRangePaise(int64_t high, int64_t low, int64_t previous_close, bool has_previous) {
+    int64_t range = high - low;
+    if (!has_previous) {
+        return range;
+    }
+    int64_t up = high > previous_close ? high - previous_close : previous_close - high;
+    int64_t down = low > previous_close ? low - previous_close : previous_close - low;
+    return (std::max)(range, (std::max)(up, down));
+}
+
+int64_t sessionDay(int64_t timestamp) {
+    int64_t shifted = timestamp + CandleStore::kIstOffsetSeconds;
+    return shifted >= 0 ? shifted / 86400 : (shifted - 86399) / 86400;
+}
+
+} // namespace
+
+// --- Ema ---
+
+Ema::Ema(int period) : multiplier_(emaMultiplier(period)), value_(0.0), count_(0) {}
+
+double Ema::value() const {
+    return count_ > 0 ? value_ : kNaN;
+}
+
+double Ema::update(Price close) {
+    double price = close.toDouble();
+    value_ = count_ == 0 ? price : (price * multiplier_) + (value_ * (1 - multiplier_));
+    ++count_;
+    return value_;
+}
+
+void Ema::run(const CandleSeries& series, size_t begin, size_t end, double* out) {
+    double prices[kBlock];
+    for (size_t i = begin; i < end; i += kBlock) {
+        const size_t n = (std::min)(kBlock, end - i);
+        for (size_t k = 0; k < n; ++k) {
+            prices[k] = series.close[i + k].toDouble();
+        }
+        for (size_t k = 0; k < n; ++k) {
+            value_ = count_ == 0 ? prices[k] : (prices[k] * multiplier_) + (value_ * (1 - multiplier_));
+            ++count_;
+            if (out) out[i + k - begin] = value_;
+        }
+    }
+}
+
+void Ema::seed(const CandleSeries& series, size_t end) {
+    value_ = 0.0;
+    count_ = 0;
+    run(series, 0, (std::min)(end, series.size()), nullptr);
+}
+
+void Ema::compute(const CandleSeries& series, int period, std::vector<double>& out) {
+    out.resize(series.size());
+    Ema ema(period);
+    ema.run(series, 0, series.size(), out.data());
+}
+
+// --- Rsi ---
+
+Rsi::Rsi(int period)
+    : period_((std::max)(1, period)), previous_paise_(0), sum_gain_(0.0), sum_loss_(0.0),
+      average_gain_(0.0), average_loss_(0.0), count_(0) {}
+
+double Rsi::value() const {
+    if (!ready()) {
+        return kNaN;
+    }
+    if (average_loss_ == 0.0) {
+        return 100.0;
+    }
+    return 100.0 - 100.0 / (1.0 + average_gain_ / average_loss_);
+}
+
+void Rsi::step(double gain, double loss) {
+    ++count_;
+    if (count_ <= static_cast<size_t>(period_) + 1) {
+        // Simple average of the first `period` changes
+        sum_gain_ += gain;
+        sum_loss_ += loss;
+        if (count_ == static_cast<size_t>(period_) + 1) {
+            average_gain_ = sum_gain_ / period_;
+            average_loss_ = sum_loss_ / period_;
+        }
+    } else {
+        average_gain_ = (average_gain_ * (period_ - 1) + gain) / period_;
+        average_loss_ = (average_loss_ * (period_ - 1) + loss) / period_;
+    }
+}
+
+double Rsi::update(Price close) {
+    int64_t paise = close.paise();
+    if (count_ == 0) {
+        previous_paise_ = paise;
+        count_ = 1;
+        return kNaN;
+    }
+    int64_t change = paise - previous_paise_;
+    previous_paise_ = paise;
+    step(change > 0 ? static_cast<double>(change) : 0.0, change < 0 ? static_cast<double>(-change) : 0.0);
+    return value();
+}
+
+void Rsi::run(const CandleSeries& series, size_t begin, size_t end, double* out) {
+    const Price* close = series.close.data();
+    size_t i = begin;
+    if (i < end && count_ == 0) {
+        previous_paise_ = close[i].paise();
+        count_ = 1;
+        if (out) out[0] = kNaN;
+        ++i;
+    }
+    double gains[kBlock];
+    double losses[kBlock];
+    for (; i < end; i += kBlock) {
+        const size_t n = (std::min)(kBlock, end - i);
+        // Changes are independent of the averages, so they are done a block at a time
+        for (size_t k = 0; k < n; ++k) {
+            int64_t previous = k == 0 ? previous_paise_ : close[i + k - 1].paise();
+            int64_t change = close[i + k].paise() - previous;
+            gains[k] = change > 0 ? static_cast<double>(change) : 0.0;
+            losses[k] = change < 0 ? static_cast<double>(-change) : 0.0;
+        }
+        for (size_t k = 0; k < n; ++k) {
+            step(gains[k], losses[k]);
+            if (out) out[i + k - begin] = value();
+        }
+        previous_paise_ = close[i + n - 1].paise();
+    }
+}
+
+void Rsi::seed(const CandleSeries& series, size_t end) {
+    *this = Rsi(period_);
+    run(series, 0, (std::min)(end, series.size()), nullptr);
+}
+
+void Rsi::compute(const CandleSeries& series, int period, std::vector<double>& out) {
+    out.resize(series.size());
+    Rsi rsi(period);
+    rsi.run(series, 0, series.size(), out.data());
+}
+
+// --- Atr ---
+
+Atr::Atr(int period)
+    : period_((std::max)(1, period)), previous_close_paise_(0), sum_(0.0), atr_(0.0), count_(0) {}
+
+double Atr::value() const {
+    return ready() ? atr_ : kNaN;
+}
+
+void Atr::step(double true_range) {
+    ++count_;
+    if (count_ <= static_cast<size_t>(period_)) {
+        sum_ += true_range;
+        if (count_ == static_cast<size_t>(period_)) {
+            atr_ = sum_ / period_;
+        }
+    } else {
+        atr_ = (atr_ * (period_ - 1) + true_range) / period_;
+    }
+}
+
+double Atr::update(Price high, Price low, Price close) {
+    int64_t range = trueRangePaise(high.paise(), low.paise(), previous_close_paise_, count_ > 0);
+    previous_close_paise_ = close.paise();
+    step(Price::fromPaise(range).toDouble());
+    return value();
+}
+
+void Atr::run(const CandleSeries& series, size_t begin, size_t end, double* out) {
+    const Price* high = series.high.data();
+    const Price* low = series.low.data();
+    const Price* close = series.close.data();
+    double ranges[kBlock];
+    for (size_t i = begin; i < end; i += kBlock) {
+        const size_t n = (std::min)(kBlock, end - i);
+        for (size_t k = 0; k < n; ++k) {
+            bool has_previous = k > 0 || count_ > 0;
+            int64_t previous = k == 0 ? previous_close_paise_ : close[i + k - 1].paise();
+            ranges[k] = Price::fromPaise(trueRangePaise(high[i + k].paise(), low[i + k].paise(), previous, has_previous)).toDouble();
+        }
+        for (size_t k = 0; k < n; ++k) {
+            step(ranges[k]);
+            if (out) out[i + k - begin] = value();
+        }
+        previous_close_paise_ = close[i + n - 1].paise();
+    }
+}
+
+void Atr::seed(const CandleSeries& series, size_t end) {
+    *this = Atr(period_);
+    run(series, 0, (std::min)(end, series.size()), nullptr);
+}
+
+void Atr::compute(const CandleSeries& series, int period, std::vector<double>& out) {
+    out.resize(series.size());
+    Atr atr(period);
+    atr.run(series, 0, series.size(), out.data());
+}
+
+// --- Vwap ---
+
+Vwap::Vwap() : session_day_(INT64_MIN), price_volume_(0.0), volume_(0.0) {}
+
+double Vwap::value() const {
+    return volume_ > 0.0 ? price_volume_ / volume_ / 300.0 : kNaN;
+}
+
+double Vwap::update(int64_t timestamp, Price high, Price low, Price close, int64_t volume) {
+    int64_t day = sessionDay(timestamp);
+    if (day != session_day_) {
+        session_day_ = day;
+        price_volume_ = 0.0;
+        volume_ = 0.0;
+    }
+    price_volume_ += static_cast<double>((high + low + close).paise()) * static_cast<double>(volume);
+    volume_ += static_cast<double>(volume);
+    return value();
+}
+
+void Vwap::run(const CandleSeries& series, size_t begin, size_t end, double* out) {
+    double price_volumes[kBlock];
+    double volumes[kBlock];
+    int64_t days[kBlock];
+    for (size_t i = begin; i < end; i += kBlock) {
+        const size_t n = (std::min)(kBlock, end - i);
+        for (size_t k = 0; k < n; ++k) {
+            price_volumes[k] = static_cast<double>((series.high[i + k] + series.low[i + k] + series.close[i + k]).paise()) *
+                               static_cast<double>(series.volume[i + k]);
+            volumes[k] = static_cast<double>(series.volume[i + k]);
+            days[k] = sessionDay(series.timestamp[i + k]);
+        }
+        for (size_t k = 0; k < n; ++k) {
+            if (days[k] != session_day_) {
+                session_day_ = days[k];
+                price_volume_ = 0.0;
+                volume_ = 0.0;
+            }
+            price_volume_ += price_volumes[k];
+            volume_ += volumes[k];
+            if (out) out[i + k - begin] = value();
+        }
+    }
+}
+
+void Vwap::seed(const CandleSeries& series, size_t end) {
+    *this = Vwap();
+    run(series, 0, (std::min)(end, series.size()), nullptr);
+}
+
+void Vwap::compute(const CandleSeries& series, std::vector<double>& out) {
+    out.resize(series.size());
+    Vwap vwap;
+    vwap.run(series, 0, series.size(), out.data());
+}
+
+// --- Bollinger ---
+
+Bollinger::Bollinger(int period, double width)
+    : width_(width), window_(static_cast<size_t>((std::max)(1, period)), 0), next_(0), sum_(0), sum_squares_(0), count_(0) {}
+
+Bollinger::Bands Bollinger::value() const {
+    if (!ready()) {
+        return Bands{kNaN, kNaN, kNaN};
+    }
+    const double period = static_cast<double>(window_.size());
+    double mean = static_cast<double>(sum_) / period;
+    double variance = static_cast<double>(sum_squares_) / period - mean * mean;
+    double deviation = std::sqrt(variance > 0.0 ? variance : 0.0);
+    return Bands{mean / 100.0, (mean + width_ * deviation) / 100.0, (mean - width_ * deviation) / 100.0};
+}
+
+void Bollinger::push(int64_t close_paise) {
+    int64_t oldest = window_[next_];
+    if (count_ >= window_.size()) {
+        sum_ -= oldest;
+        sum_squares_ -= oldest * oldest;
+    }
+    window_[next_] = close_paise;
+    next_ = next_ + 1 == window_.size() ? 0 : next_ + 1;
+    sum_ += close_paise;
+    sum_squares_ += close_paise * close_paise;
+    ++count_;
+}
+
+Bollinger::Bands Bollinger::update(Price close) {
+    push(close.paise());
+    return value();
+}
+
+void Bollinger::run(const CandleSeries& series, size_t begin, size_t end, Bands* out) {
+    // The sums are exact integers, so only the bars that are still in the
+    // window at `end` need to go through the ring when nothing is written out
+    if (!out && count_ == 0 && end - begin > window_.size()) {
+        size_t skipped = end - begin - window_.size();
+        count_ = skipped;
+        begin += skipped;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        push(series.close[i].paise());
+        if (out) out[i - begin] = value();
+    }
+}
+
+void Bollinger::seed(const CandleSeries& series, size_t end) {
+    *this = Bollinger(static_cast<int>(window_.size()), width_);
+    run(series, 0, (std::min)(end, series.size()), nullptr);
+}
+
+void Bollinger::compute(const CandleSeries& series, int period, double width,
+                        std::vector<double>& middle, std::vector<double>& upper, std::vector<double>& lower) {
+    Bollinger bollinger(period, width);
+    std::vector<Bands> bands(series.size());
+    bollinger.run(series, 0, series.size(), bands.data());
+    middle.resize(bands.size());
+    upper.resize(bands.size());
+    lower.resize(bands.size());
+    for (size_t i = 0; i < bands.size(); ++i) {
+        middle[i] = bands[i].middle;
+        upper[i] = bands[i].upper;
+        lower[i] = bands[i].lower;
+    }
+}
+
+// --- SuperTrend ---
+
+SuperTrend::SuperTrend(int period, double multiplier)
+    : atr_(period), multiplier_(multiplier), final_upper_(0.0), final_lower_(0.0), previous_close_(0.0), direction_(0) {}
+
+double SuperTrend::value() const {
+    return direction_ > 0 ? final_lower_ : direction_ < 0 ? final_upper_ : kNaN;
+}
+
+void SuperTrend::step(double atr, int64_t high_paise, int64_t low_paise, int64_t close_paise) {
+    double close = static_cast<double>(close_paise) / 100.0;
+    if (std::isnan(atr)) {
+        previous_close_ = close;
+        return;
+    }
+    double middle = static_cast<double>(high_paise + low_paise) / 200.0;
+    double band = multiplier_ * atr;
+    double upper = middle + band;
+    double lower = middle - band;
+    if (direction_ == 0) {
+        final_upper_ = upper;
+        final_lower_ = lower;
+        direction_ = close >= middle ? 1 : -1;
+    } else {
+        // Bands only tighten unless the previous close broke through them
+        final_upper_ = (upper < final_upper_ || previous_close_ > final_upper_) ? upper : final_upper_;
+        final_lower_ = (lower > final_lower_ || previous_close_ < final_lower_) ? lower : final_lower_;
+        if (direction_ > 0 && close < final_lower_) {
+            direction_ = -1;
+        } else if (direction_ < 0 && close > final_upper_) {
+            direction_ = 1;
+        }
+    }
+    previous_close_ = close;
+}
+
+double SuperTrend::update(Price high, Price low, Price close) {
+    double atr = atr_.update(high, low, close);
+    step(atr, high.paise(), low.paise(), close.paise());
+    return value();
+}
+
+void SuperTrend::run(const CandleSeries& series, size_t begin, size_t end, double* out, int8_t* direction) {
+    double atrs[kBlock];
+    for (size_t i = begin; i < end; i += kBlock) {
+        const size_t n = (std::min)(kBlock, end - i);
+        atr_.run(series, i, i + n, atrs);
+        for (size_t k = 0; k < n; ++k) {
+            step(atrs[k], series.high[i + k].paise(), series.low[i + k].paise(), series.close[i + k].paise());
+            if (out) out[i + k - begin] = value();
+            if (direction) direction[i + k - begin] = static_cast<int8_t>(direction_);
+        }
+    }
+}
+
+void SuperTrend::seed(const CandleSeries& series, size_t end) {
+    *this = SuperTrend(atr_.period_, multiplier_);
+    run(series, 0, (std::min)(end, series.size()), nullptr, nullptr);
+}
+
+void SuperTrend::compute(const CandleSeries& series, int period, double multiplier,
+                         std::vector<double>& out, std::vector<int8_t>& direction) {
+    out.resize(series.size());
+    direction.resize(series.size());
+    SuperTrend supertrend(period, multiplier);
+    supertrend.run(series, 0, series.size(), out.data(), direction.data());
+}
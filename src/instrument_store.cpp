@@ -0,0 +1,420 @@
+#include "instrument_store.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+// Columns understood by the loader. Both the Kite dump header
+// (instrument_token,exchange_token,tradingsymbol,name,last_price,expiry,strike,tick_size,lot_size,instrument_type,segment,exchange)
+// and the shorter instruments.csv header are mapped through this table.
+enum Column {
+    COL_TOKEN, COL_SYMBOL, COL_NAME, COL_EXCHANGE, COL_TYPE, COL_SEGMENT,
+    COL_LOT_SIZE, COL_TICK_SIZE, COL_EXPIRY, COL_STRIKE, COL_COUNT
+};
+
+int columnFor(std::string_view header) {
+    if (header == "instrument_token") return COL_TOKEN;
+    if (header == "tradingsymbol") return COL_SYMBOL;
+    if (header == "name") return COL_NAME;
+    if (header == "exchange") return COL_EXCHANGE;
+    if (header == "instrument_type") return COL_TYPE;
+    if (header == "segment") return COL_SEGMENT;
+    if (header == "lot_size") return COL_LOT_SIZE;
+    if (header == "tick_size") return COL_TICK_SIZE;
+    if (header == "expiry") return COL_EXPIRY;
+    if (header == "strike") return COL_STRIKE;
+    return -1;
+}
+
+std::string_view trimView(std::string_view s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos) return {};
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+// Splits one CSV line into views without allocating. Quoted fields have their
+// quotes stripped; embedded commas inside quotes are honoured.
+size_t splitFields(std::string_view line, std::vector<std::string_view>& fields) {
+    fields.clear();
+    size_t i = 0;
+    while (i <= line.size()) {
+        if (i < line.size() && line[i] == '"') {
+            size_t close = line.find('"', i + 1);
+            if (close == std::string_view::npos) close = line.size();
+            fields.push_back(line.substr(i + 1, close - i - 1));
+            size_t comma = line.find(',', close);
+            if (comma == std::string_view::npos) break;
+            i = comma + 1;
+        } else {
+            size_t comma = line.find(',', i);
+            if (comma == std::string_view::npos) {
+                fields.push_back(trimView(line.substr(i)));
+                break;
+            }
+            fields.push_back(trimView(line.substr(i, comma - i)));
+            i = comma + 1;
+        }
+    }
+    return fields.size();
+}
+
+template <typename T>
+T parseInt(std::string_view s, T fallback) {
+    T value = fallback;
+    std::from_chars(s.data(), s.data() + s.size(), value);
+    return value;
+}
+
+// Tick sizes finer than one paisa (currency segment) are clamped to one paisa
+Price parseTickSize(std::string_view s) {
+    Price tick = Price::parseOr(s, Price::fromPaise(5));
+    return tick.paise() > 0 ? tick : Price::fromPaise(1);
+}
+
+} // namespace
+
+InstrumentStore::InstrumentStore() {
+}
+
+InstrumentStore::InstrumentStore(InstrumentStore&& other) {
+    *this = std::move(other);
+}
+
+InstrumentStore& InstrumentStore::operator=(InstrumentStore&& other) {
+    if (this == &other) return *this;
+    const char* arena = other.symbol_arena_.data();
+    tokens_ = std::move(other.tokens_);
+    symbol_offsets_ = std::move(other.symbol_offsets_);
+    symbol_lengths_ = std::move(other.symbol_lengths_);
+    name_ids_ = std::move(other.name_ids_);
+    exchange_ids_ = std::move(other.exchange_ids_);
+    segment_ids_ = std::move(other.segment_ids_);
+    type_ids_ = std::move(other.type_ids_);
+    expiry_ = std::move(other.expiry_);
+    strike_ = std::move(other.strike_);
+    lot_size_ = std::move(other.lot_size_);
+    tick_size_ = std::move(other.tick_size_);
+    symbol_arena_ = std::move(other.symbol_arena_);
+    names_ = std::move(other.names_);
+    exchanges_ = std::move(other.exchanges_);
+    segments_ = std::move(other.segments_);
+    types_ = std::move(other.types_);
+    symbol_index_ = std::move(other.symbol_index_);
+    by_exchange_ = std::move(other.by_exchange_);
+    by_segment_ = std::move(other.by_segment_);
+    by_underlying_ = std::move(other.by_underlying_);
+    // Only a short (SSO) arena is copied by the move; its views must be re-keyed
+    if (symbol_arena_.data() != arena && !symbol_index_.empty()) indexSymbols();
+    other.clear();
+    return *this;
+}
+
+uint32_t InstrumentStore::Dictionary::intern(std::string_view value) {
+    if (last_ != npos && values_[last_] == value) return last_;
+    auto it = ids_.find(value);
+    if (it != ids_.end()) {
+        last_ = it->second;
+        return last_;
+    }
+    uint32_t id = static_cast<uint32_t>(values_.size());
+    values_.emplace_back(value);
+    ids_.emplace(values_.back(), id);
+    last_ = id;
+    return id;
+}
+
+uint32_t InstrumentStore::Dictionary::lookup(std::string_view value) const {
+    auto it = ids_.find(value);
+    return it != ids_.end() ? it->second : npos;
+}
+
+void InstrumentStore::clear() {
+    tokens_.clear();
+    symbol_offsets_.clear();
+    symbol_lengths_.clear();
+    name_ids_.clear();
+    exchange_ids_.clear();
+    segment_ids_.clear();
+    type_ids_.clear();
+    expiry_.clear();
+    strike_.clear();
+    lot_size_.clear();
+    tick_size_.clear();
+    symbol_arena_.clear();
+    names_.clear();
+    exchanges_.clear();
+    segments_.clear();
+    types_.clear();
+    symbol_index_.clear();
+    by_exchange_.clear();
+    by_segment_.clear();
+    by_underlying_.clear();
+}
+
+void InstrumentStore::append(const Instrument& inst) {
+    tokens_.push_back(parseInt<uint32_t>(inst.instrument_token, 0));
+    symbol_offsets_.push_back(static_cast<uint32_t>(symbol_arena_.size()));
+    symbol_lengths_.push_back(static_cast<uint16_t>(inst.tradingsymbol.size()));
+    symbol_arena_ += inst.tradingsymbol;
+    name_ids_.push_back(names_.intern(inst.name));
+    exchange_ids_.push_back(static_cast<uint16_t>(exchanges_.intern(inst.exchange)));
+    segment_ids_.push_back(static_cast<uint16_t>(segments_.intern(inst.segment.empty() ? inst.exchange : inst.segment)));
+    type_ids_.push_back(static_cast<uint16_t>(types_.intern(inst.instrument_type)));
+    expiry_.push_back(inst.expiry);
+    strike_.push_back(inst.strike);
+    lot_size_.push_back(inst.lot_size);
+    tick_size_.push_back(inst.tick_size);
+}
+
+bool InstrumentStore::loadFromCSVString(const std::string& csvText) {
+    clear();
+
+    std::string_view text(csvText);
+    std::vector<std::string_view> fields;
+    fields.reserve(16);
+
+    int column_index[COL_COUNT];
+    std::fill(std::begin(column_index), std::end(column_index), -1);
+
+    // Rough row estimate so the columns do not reallocate while parsing
+    size_t estimated_rows = static_cast<size_t>(std::count(csvText.begin(), csvText.end(), '\n'));
+    tokens_.reserve(estimated_rows);
+    symbol_offsets_.reserve(estimated_rows);
+    symbol_lengths_.reserve(estimated_rows);
+    name_ids_.reserve(estimated_rows);
+    exchange_ids_.reserve(estimated_rows);
+    segment_ids_.reserve(estimated_rows);
+    type_ids_.reserve(estimated_rows);
+    expiry_.reserve(estimated_rows);
+    strike_.reserve(estimated_rows);
+    lot_size_.reserve(estimated_rows);
+    tick_size_.reserve(estimated_rows);
+    symbol_arena_.reserve(estimated_rows * 16);
+
+    bool header_seen = false;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) eol = text.size();
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+
+        splitFields(line, fields);
+
+        if (!header_seen) {
+            for (size_t i = 0; i < fields.size(); ++i) {
+                int col = columnFor(fields[i]);
+                if (col >= 0) column_index[col] = static_cast<int>(i);
+            }
+            header_seen = true;
+            if (column_index[COL_TOKEN] < 0 || column_index[COL_SYMBOL] < 0) {
+                std::cerr << "Instrument CSV is missing instrument_token/tradingsymbol columns" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        auto field = [&](int col) -> std::string_view {
+            int idx = column_index[col];
+            return (idx >= 0 && static_cast<size_t>(idx) < fields.size()) ? fields[idx] : std::string_view();
+        };
+
+        std::string_view symbol = field(COL_SYMBOL);
+        std::string_view exchange = field(COL_EXCHANGE);
+        std::string_view segment = field(COL_SEGMENT);
+
+        tokens_.push_back(parseInt<uint32_t>(field(COL_TOKEN), 0));
+        symbol_offsets_.push_back(static_cast<uint32_t>(symbol_arena_.size()));
+        symbol_lengths_.push_back(static_cast<uint16_t>(symbol.size()));
+        symbol_arena_.append(symbol.data(), symbol.size());
+        name_ids_.push_back(names_.intern(field(COL_NAME)));
+        exchange_ids_.push_back(static_cast<uint16_t>(exchanges_.intern(exchange)));
+        segment_ids_.push_back(static_cast<uint16_t>(segments_.intern(segment.empty() ? exchange : segment)));
+        type_ids_.push_back(static_cast<uint16_t>(types_.intern(field(COL_TYPE))));
+        expiry_.push_back(parseExpiry(field(COL_EXPIRY)));
+        strike_.push_back(Price::parseOr(field(COL_STRIKE), Price()));
+        lot_size_.push_back(parseInt<int>(field(COL_LOT_SIZE), 1));
+        tick_size_.push_back(parseTickSize(field(COL_TICK_SIZE)));
+    }
+
+    buildIndexes();
+    return !empty();
+}
+
+bool InstrumentStore::loadFromCSVFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open instruments file: " << filename << std::endl;
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    return loadFromCSVString(buffer.str());
+}
+
+bool InstrumentStore::saveToCSVFile(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not create file: " << filename << std::endl;
+        return false;
+    }
+
+    file << "instrument_token,tradingsymbol,name,exchange,instrument_type,segment,lot_size,tick_size,expiry,strike\n";
+
+    for (Row r = 0; r < size(); ++r) {
+        file << tokens_[r] << ","
+             << tradingsymbol(r) << ","
+             << "\"" << name(r) << "\","
+             << exchange(r) << ","
+             << instrumentType(r) << ","
+             << segment(r) << ","
+             << lot_size_[r] << ","
+             << tick_size_[r] << ","
+             << formatExpiry(expiry_[r]) << ","
+             << strike_[r] << "\n";
+    }
+
+    return true;
+}
+
+void InstrumentStore::buildIndexes() {
+    const size_t rows = size();
+
+    indexSymbols();
+    by_exchange_.assign(exchanges_.size(), {});
+    by_segment_.assign(segments_.size(), {});
+    by_underlying_.assign(names_.size(), {});
+
+    for (Row r = 0; r < rows; ++r) {
+        by_exchange_[exchange_ids_[r]].push_back(r);
+        by_segment_[segment_ids_[r]].push_back(r);
+        by_underlying_[name_ids_[r]].push_back(r);
+    }
+
+    // Underlying rows are kept ordered by (expiry, strike) so expiry slices are contiguous
+    for (auto& rows_for_name : by_underlying_) {
+        std::sort(rows_for_name.begin(), rows_for_name.end(), [this](Row a, Row b) {
+            if (expiry_[a] != expiry_[b]) return expiry_[a] < expiry_[b];
+            return strike_[a] < strike_[b];
+        });
+    }
+}
+
+std::string_view InstrumentStore::tradingsymbol(Row r) const {
+    return std::string_view(symbol_arena_).substr(symbol_offsets_[r], symbol_lengths_[r]);
+}
+
+void InstrumentStore::indexSymbols() {
+    symbol_index_.assign(exchanges_.size(), {});
+    for (Row r = 0; r < size(); ++r) {
+        symbol_index_[exchange_ids_[r]][tradingsymbol(r)] = r;
+    }
+}
+
+InstrumentStore::Row InstrumentStore::find(std::string_view exchange, std::string_view tradingsymbol) const {
+    uint32_t ex = exchanges_.lookup(exchange);
+    if (ex == npos || ex >= symbol_index_.size()) return npos;
+    auto it = symbol_index_[ex].find(tradingsymbol);
+    return it != symbol_index_[ex].end() ? it->second : npos;
+}
+
+InstrumentStore::Row InstrumentStore::findEquity(std::string_view tradingsymbol) const {
+    Row r = find("NSE", tradingsymbol);
+    if (r != npos) return r;
+    return find("BSE", tradingsymbol);
+}
+
+InstrumentStore::Row InstrumentStore::findAny(std::string_view symbol) const {
+    size_t colon = symbol.find(':');
+    if (colon != std::string_view::npos) {
+        return find(symbol.substr(0, colon), symbol.substr(colon + 1));
+    }
+
+    Row r = findEquity(symbol);
+    if (r != npos) return r;
+
+    for (const auto& index : symbol_index_) {
+        auto it = index.find(symbol);
+        if (it != index.end()) return it->second;
+    }
+    return npos;
+}
+
+InstrumentStore::RowRange InstrumentStore::rangeFor(const std::vector<std::vector<Row>>& index, uint32_t id) const {
+    if (id == npos || id >= index.size() || index[id].empty()) return RowRange{nullptr, nullptr};
+    const auto& rows = index[id];
+    return RowRange{rows.data(), rows.data() + rows.size()};
+}
+
+InstrumentStore::RowRange InstrumentStore::byExchange(std::string_view exchange) const {
+    return rangeFor(by_exchange_, exchanges_.lookup(exchange));
+}
+
+InstrumentStore::RowRange InstrumentStore::bySegment(std::string_view segment) const {
+    return rangeFor(by_segment_, segments_.lookup(segment));
+}
+
+InstrumentStore::RowRange InstrumentStore::byUnderlying(std::string_view name) const {
+    return rangeFor(by_underlying_, names_.lookup(name));
+}
+
+InstrumentStore::RowRange InstrumentStore::byUnderlyingExpiry(std::string_view name, int expiry) const {
+    RowRange all = byUnderlying(name);
+    auto lower = std::lower_bound(all.begin(), all.end(), expiry,
+                                  [this](Row r, int value) { return expiry_[r] < value; });
+    auto upper = std::upper_bound(lower, all.end(), expiry,
+                                  [this](int value, Row r) { return value < expiry_[r]; });
+    return RowRange{lower, upper};
+}
+
+std::vector<int> InstrumentStore::expiries(std::string_view name) const {
+    std::vector<int> result;
+    for (Row r : byUnderlying(name)) {
+        if (expiry_[r] != 0 && (result.empty() || result.back() != expiry_[r])) {
+            result.push_back(expiry_[r]);
+        }
+    }
+    return result;
+}
+
+Instrument InstrumentStore::instrument(Row r) const {
+    Instrument inst;
+    inst.instrument_token = std::to_string(tokens_[r]);
+    inst.tradingsymbol = std::string(tradingsymbol(r));
+    inst.name = std::string(name(r));
+    inst.exchange = std::string(exchange(r));
+    inst.instrument_type = std::string(instrumentType(r));
+    inst.segment = std::string(segment(r));
+    inst.expiry = expiry_[r];
+    inst.strike = strike_[r];
+    inst.lot_size = lot_size_[r];
+    inst.tick_size = tick_size_[r];
+    return inst;
+}
+
+int InstrumentStore::parseExpiry(std::string_view text) {
+    // Expected format yyyy-mm-dd; anything else means "no expiry"
+    if (text.size() < 10 || text[4] != '-' || text[7] != '-') return 0;
+    int year = parseInt<int>(text.substr(0, 4), 0);
+    int month = parseInt<int>(text.substr(5, 2), 0);
+    int day = parseInt<int>(text.substr(8, 2), 0);
+    return year * 10000 + month * 100 + day;
+}
+
+std::string InstrumentStore::formatExpiry(int expiry) {
+    if (expiry == 0) return "";
+    std::ostringstream oss;
+    oss << std::setfill('0') << std::setw(4) << expiry / 10000 << "-"
+        << std::setw(2) << (expiry / 100) % 100 << "-"
+        << std::setw(2) << expiry % 100;
+    return oss.str();
+}
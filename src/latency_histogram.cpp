@@ -0,0 +1,149 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+int highestBit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t nanos) {
+    if (nanos < kLinearLimit) {
+        return static_cast<size_t>(nanos);
+    }
+    int shift = highestBit(nanos) - kSubBucketBits;
+    if (shift > kMaxShift) {
+        return kBucketCount - 1;
+    }
+    size_t top = static_cast<size_t>(nanos >> shift); // 64..127
+    return kLinearLimit + static_cast<size_t>(shift - 1) * (size_t(1) << kSubBucketBits) +
+           (top - (size_t(1) << kSubBucketBits));
+}
+
+uint64_t LatencyHistogram::bucketLow(size_t index) {
+    if (index < kLinearLimit) {
+        return index;
+    }
+    size_t offset = index - kLinearLimit;
+    int shift = static_cast<int>(offset >> kSubBucketBits) + 1;
+    uint64_t top = (offset & ((size_t(1) << kSubBucketBits) - 1)) + (uint64_t(1) << kSubBucketBits);
+    return top << shift;
+}
+
+uint64_t LatencyHistogram::bucketHigh(size_t index) {
+    if (index < kLinearLimit) {
+        return index;
+    }
+    int shift = static_cast<int>((index - kLinearLimit) >> kSubBucketBits) + 1;
+    return bucketLow(index) + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    buckets_[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanos, std::memory_order_relaxed);
+
+    uint64_t current = max_.load(std::memory_order_relaxed);
+    while (nanos > current && !max_.compare_exchange_weak(current, nanos, std::memory_order_relaxed)) {
+    }
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    // Total from the buckets themselves so the walk is consistent with what it reads
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    q = (std::min)(1.0, (std::max)(0.0, q));
+    uint64_t rank = (std::max)(uint64_t(1), static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t mid = bucketLow(i) + (bucketHigh(i) - bucketLow(i)) / 2;
+            return (std::min)(mid, maxValue());
+        }
+    }
+    return maxValue();
+}
+
+void LatencyRecorder::reset() {
+    for (auto& histogram : histograms_) {
+        histogram.reset();
+    }
+}
+
+const char* LatencyRecorder::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Quote: return "quote";
+        case LatencyStage::Candles: return "candles";
+        case LatencyStage::Ema: return "ema";
+        case LatencyStage::Signal: return "signal";
+        case LatencyStage::OrderSend: return "order_send";
+        case LatencyStage::OrderParse: return "order_parse";
+        case LatencyStage::ProtectiveLegs: return "protective_legs";
+        case LatencyStage::TickToSignal: return "tick_to_signal";
+        case LatencyStage::TickToOrder: return "tick_to_order";
+        case LatencyStage::TickToLegs: return "tick_to_legs";
+        case LatencyStage::OrderFillSeen: return "order_fill_seen";
+        case LatencyStage::OrderCancel: return "order_cancel";
+        case LatencyStage::OrderModify: return "order_modify";
+        default: return "unknown";
+    }
+}
+
+void LatencyRecorder::report(std::ostream& out) const {
+    auto micros = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+
+    out << "=== Stage Latency (us) ===" << std::endl;
+    out << std::left << std::setw(18) << "stage" << std::right
+        << std::setw(10) << "count" << std::setw(12) << "p50" << std::setw(12) << "p99"
+        << std::setw(12) << "p99.9" << std::setw(12) << "max" << std::endl;
+
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    for (size_t i = 0; i < kStageCount; ++i) {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        const LatencyHistogram& h = histogram(stage);
+        if (h.count() == 0) {
+            continue;
+        }
+        out << std::left << std::setw(18) << stageName(stage) << std::right
+            << std::setw(10) << h.count()
+            << std::setw(12) << micros(h.percentile(0.50))
+            << std::setw(12) << micros(h.percentile(0.99))
+            << std::setw(12) << micros(h.percentile(0.999))
+            << std::setw(12) << micros(h.maxValue()) << std::endl;
+    }
+    out.flags(flags);
+}
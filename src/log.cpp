@@ -0,0 +1,405 @@
+#include "log.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+// Sequential reader over one entry's body; reads past the end yield zeros
+class EntryReader {
+public:
+    EntryReader(const char* data, size_t size) : data_(data), size_(size), offset_(3) {}
+
+    template <typename T>
+    T raw() {
+        T value{};
+        if (offset_ + sizeof(T) <= size_) {
+            std::memcpy(&value, data_ + offset_, sizeof(T));
+        }
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    std::string str() {
+        uint16_t length = raw<uint16_t>();
+        if (offset_ + length > size_) {
+            offset_ = size_;
+            return std::string();
+        }
+        std::string text(data_ + offset_, length);
+        offset_ += length;
+        return text;
+    }
+
+    bool atEnd() const { return offset_ >= size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t offset_;
+};
+
+std::string formatArg(EntryReader& reader, logfmt::LogArg type) {
+    char buffer[32];
+    switch (type) {
+        case logfmt::LogArg::Int:
+            std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(reader.raw<int64_t>()));
+            return buffer;
+        case logfmt::LogArg::UInt:
+            std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(reader.raw<uint64_t>()));
+            return buffer;
+        case logfmt::LogArg::Double:
+            // Same as the default ostream precision the old std::cout output used
+            std::snprintf(buffer, sizeof(buffer), "%g", reader.raw<double>());
+            return buffer;
+        case logfmt::LogArg::Bool:
+            return reader.raw<uint8_t>() ? "true" : "false";
+        case logfmt::LogArg::Price:
+            Price::fromPaise(reader.raw<int64_t>()).format(buffer);
+            return buffer;
+        case logfmt::LogArg::String:
+            return reader.str();
+        default:
+            return "?";
+    }
+}
+
+} // namespace
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+bool LogDecoder::decode(const char* entry, size_t size, Message& message) {
+    if (size < 3) {
+        return false;
+    }
+    EntryReader reader(entry, size);
+    uint8_t kind = static_cast<uint8_t>(entry[2]);
+
+    if (kind == logfmt::kSiteEntry) {
+        uint32_t id = reader.raw<uint32_t>();
+        Site site;
+        site.level = static_cast<LogLevel>(reader.raw<uint8_t>());
+        site.line = reader.raw<uint32_t>();
+        site.file = reader.str();
+        site.format = reader.str();
+        defineSite(id, site);
+        return false;
+    }
+    if (kind != logfmt::kMessageEntry) {
+        return false;
+    }
+
+    uint32_t id = reader.raw<uint32_t>();
+    message.thread = reader.raw<uint32_t>();
+    message.epoch_ns = reader.raw<int64_t>();
+
+    auto it = sites_.find(id);
+    if (it == sites_.end()) {
+        message.level = LogLevel::Info;
+        message.file = "?";
+        message.line = 0;
+        message.text = "<unknown log site " + std::to_string(id) + ">";
+        return true;
+    }
+    const Site& site = it->second;
+    message.level = site.level;
+    message.file = site.file;
+    message.line = site.line;
+
+    // Substitute "{}" placeholders in order; surplus arguments are appended
+    message.text.clear();
+    const std::string& format = site.format;
+    size_t pos = 0;
+    while (pos < format.size()) {
+        size_t brace = format.find("{}", pos);
+        if (brace == std::string::npos) {
+            message.text.append(format, pos, std::string::npos);
+            break;
+        }
+        message.text.append(format, pos, brace - pos);
+        if (reader.atEnd()) {
+            message.text += "{}";
+        } else {
+            message.text += formatArg(reader, static_cast<logfmt::LogArg>(reader.raw<uint8_t>()));
+        }
+        pos = brace + 2;
+    }
+    while (!reader.atEnd()) {
+        message.text += ' ';
+        message.text += formatArg(reader, static_cast<logfmt::LogArg>(reader.raw<uint8_t>()));
+    }
+    return true;
+}
+
+std::string LogDecoder::formatLine(const Message& message) {
+    std::time_t seconds = static_cast<std::time_t>(message.epoch_ns / 1000000000);
+    long micros = static_cast<long>((message.epoch_ns % 1000000000) / 1000);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+
+    size_t slash = message.file.find_last_of("/\\");
+    const char* file = message.file.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+
+    char prefix[160];
+    std::snprintf(prefix, sizeof(prefix), "%s.%06ld %-5s [%u] %s:%u ", stamp, micros, logLevelName(message.level),
+                  message.thread, file, message.line);
+    return prefix + message.text;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : level_(static_cast<uint8_t>(LogLevel::Trace)), dropped_(0), mode_(Mode::Direct), sites_written_(0),
+      running_(false), output_(nullptr) {}
+
+Logger::~Logger() {
+    stop();
+}
+
+uint32_t Logger::registerSite(LogSite& site) {
+    std::lock_guard<std::mutex> lock(sites_mutex_);
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if (id == 0) {
+        sites_.push_back(&site);
+        id = static_cast<uint32_t>(sites_.size());
+        site.id.store(id, std::memory_order_release);
+    }
+    return id;
+}
+
+uint32_t Logger::threadId() {
+    static std::atomic<uint32_t> next{0};
+    thread_local uint32_t id = ++next;
+    return id;
+}
+
+int64_t Logger::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+Logger::Ring& Logger::threadRing() {
+    // Marks the ring retired when the thread exits; the writer frees it once drained
+    struct Holder {
+        std::shared_ptr<Ring> ring;
+        ~Holder() {
+            if (ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+    thread_local Holder holder;
+    if (!holder.ring) {
+        holder.ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(holder.ring);
+    }
+    return *holder.ring;
+}
+
+void Logger::submit(const char* bytes, size_t size) {
+    if (mode_.load(std::memory_order_acquire) != Mode::Direct) {
+        // busy and mode pair up with stop(), which stores mode and then reads busy:
+        // either this sees Direct, or stop() sees the push in flight and waits for it
+        Ring& ring = threadRing();
+        ring.busy.store(true, std::memory_order_seq_cst);
+        if (mode_.load(std::memory_order_seq_cst) != Mode::Direct) {
+            uint64_t head = ring.head.load(std::memory_order_relaxed);
+            uint64_t tail = ring.tail.load(std::memory_order_acquire);
+            if (Ring::kCapacity - (head - tail) < size) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                size_t offset = static_cast<size_t>(head % Ring::kCapacity);
+                size_t first = (std::min)(size, Ring::kCapacity - offset);
+                std::memcpy(ring.data.get() + offset, bytes, first);
+                std::memcpy(ring.data.get(), bytes + first, size - first);
+                ring.head.store(head + size, std::memory_order_release);
+            }
+            ring.busy.store(false, std::memory_order_release);
+            return;
+        }
+        ring.busy.store(false, std::memory_order_release);
+    }
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    syncSites();
+    emitText(bytes, size);
+}
+
+void Logger::syncSites() {
+    std::lock_guard<std::mutex> lock(sites_mutex_);
+    for (; sites_written_ < sites_.size(); ++sites_written_) {
+        const LogSite& site = *sites_[sites_written_];
+        uint32_t id = static_cast<uint32_t>(sites_written_ + 1);
+
+        logfmt::EntryWriter entry;
+        entry.raw(id);
+        entry.raw(static_cast<uint8_t>(site.level));
+        entry.raw(static_cast<uint32_t>(site.line));
+        entry.str(site.file);
+        entry.str(site.format);
+        size_t size = 0;
+        const char* bytes = entry.finish(logfmt::kSiteEntry, size);
+
+        LogDecoder::Message unused;
+        decoder_.decode(bytes, size, unused);
+        if (output_) {
+            std::fwrite(bytes, 1, size, output_);
+        }
+    }
+}
+
+void Logger::emitText(const char* bytes, size_t size) {
+    LogDecoder::Message message;
+    if (!decoder_.decode(bytes, size, message)) {
+        return;
+    }
+    std::FILE* stream = message.level >= LogLevel::Warn ? stderr : stdout;
+    std::fwrite(message.text.data(), 1, message.text.size(), stream);
+    std::fputc('\n', stream);
+}
+
+void Logger::drain() {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    // Snapshot the heads before syncing sites: every message up to a head was
+    // written after its site registered, so its site entry goes out first
+    std::vector<uint64_t> heads(rings.size());
+    for (size_t i = 0; i < rings.size(); ++i) {
+        heads[i] = rings[i]->head.load(std::memory_order_acquire);
+    }
+    syncSites();
+
+    for (size_t i = 0; i < rings.size(); ++i) {
+        Ring& ring = *rings[i];
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        size_t pending = static_cast<size_t>(heads[i] - tail);
+        if (pending == 0) {
+            continue;
+        }
+
+        scratch_.resize(pending);
+        size_t offset = static_cast<size_t>(tail % Ring::kCapacity);
+        size_t first = (std::min)(pending, Ring::kCapacity - offset);
+        std::memcpy(scratch_.data(), ring.data.get() + offset, first);
+        std::memcpy(scratch_.data() + first, ring.data.get(), pending - first);
+        ring.tail.store(heads[i], std::memory_order_release);
+
+        if (output_) {
+            std::fwrite(scratch_.data(), 1, pending, output_);
+            continue;
+        }
+        for (size_t pos = 0; pos + 3 <= pending;) {
+            uint16_t size = 0;
+            std::memcpy(&size, scratch_.data() + pos, sizeof(size));
+            if (size < 3) {
+                break;
+            }
+            emitText(scratch_.data() + pos, size);
+            pos += size;
+        }
+    }
+
+    std::fflush(output_ ? output_ : stdout);
+    releaseRetiredRings();
+}
+
+void Logger::releaseRetiredRings() {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [](const std::shared_ptr<Ring>& ring) {
+                                    // retired is stored after the thread's last push
+                                    return ring->retired.load(std::memory_order_acquire) &&
+                                           ring->tail.load(std::memory_order_relaxed) ==
+                                               ring->head.load(std::memory_order_acquire);
+                                }),
+                 rings_.end());
+}
+
+void Logger::writerLoop() {
+    std::unique_lock<std::mutex> lock(writer_mutex_);
+    while (running_.load(std::memory_order_acquire)) {
+        writer_cv_.wait_for(lock, std::chrono::milliseconds(5));
+        drain();
+    }
+}
+
+bool Logger::startBinary(const std::string& path) {
+    stop();
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    output_ = std::fopen(path.c_str(), "ab");
+    if (!output_) {
+        std::cerr << "Error: Could not open log file " << path << std::endl;
+        return false;
+    }
+    // Every run starts with the magic; ids restart, so the decoder resets its sites there
+    std::fwrite(logfmt::kMagic, 1, sizeof(logfmt::kMagic), output_);
+    sites_written_ = 0;
+
+    mode_.store(Mode::Binary, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    writer_ = std::thread(&Logger::writerLoop, this);
+    return true;
+}
+
+void Logger::startConsole() {
+    stop();
+
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    mode_.store(Mode::Console, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    writer_ = std::thread(&Logger::writerLoop, this);
+}
+
+void Logger::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    writer_cv_.notify_all();
+    writer_.join();
+
+    // Late messages go straight out (and wait for the writer lock) rather than
+    // into a ring; pushes that began before the switch finish before the last drain
+    mode_.store(Mode::Direct, std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            while (ring->busy.load(std::memory_order_seq_cst)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    drain();
+    if (output_) {
+        std::fclose(output_);
+        output_ = nullptr;
+    }
+
+    uint64_t lost = dropped_.exchange(0);
+    if (lost > 0) {
+        std::cerr << "Warning: " << lost << " log messages dropped (ring buffer full)" << std::endl;
+    }
+}
@@ -0,0 +1,108 @@
+#include "log.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool parseLevel(const std::string& name, LogLevel& level) {
+    static const std::pair<const char*, LogLevel> levels[] = {
+        {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug}, {"info", LogLevel::Info},
+        {"warn", LogLevel::Warn}, {"error", LogLevel::Error}};
+    for (const auto& entry : levels) {
+        if (name == entry.first) {
+            level = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+// Usage: ZerodhaLogDecode <log file> [--level trace|debug|info|warn|error] [--sort]
+// Turns a binary log written with --log-file back into text. Each thread's
+// messages arrive in order but threads are interleaved in chunks; --sort
+// orders every message of a run by timestamp.
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <log file> [--level trace|debug|info|warn|error] [--sort]" << std::endl;
+        return 1;
+    }
+
+    std::string path = argv[1];
+    LogLevel min_level = LogLevel::Trace;
+    bool sort = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--level" && i + 1 < argc) {
+            if (!parseLevel(argv[++i], min_level)) {
+                std::cerr << "Unknown level: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--sort") {
+            sort = true;
+        }
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return 1;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const size_t magic_size = sizeof(logfmt::kMagic);
+    if (data.size() < magic_size || std::memcmp(data.data(), logfmt::kMagic, magic_size) != 0) {
+        std::cerr << "Error: " << path << " is not a binary log" << std::endl;
+        return 1;
+    }
+
+    // Site ids restart with every run, marked by another magic header
+    LogDecoder decoder;
+    std::vector<LogDecoder::Message> run;
+    auto flush = [&]() {
+        if (sort) {
+            std::stable_sort(run.begin(), run.end(), [](const LogDecoder::Message& a, const LogDecoder::Message& b) {
+                return a.epoch_ns < b.epoch_ns;
+            });
+        }
+        for (const auto& message : run) {
+            std::cout << LogDecoder::formatLine(message) << '\n';
+        }
+        run.clear();
+    };
+
+    size_t pos = 0;
+    size_t messages = 0;
+    while (pos + 3 <= data.size()) {
+        if (pos + magic_size <= data.size() && std::memcmp(data.data() + pos, logfmt::kMagic, magic_size) == 0) {
+            flush();
+            decoder = LogDecoder();
+            pos += magic_size;
+            continue;
+        }
+
+        uint16_t size = 0;
+        std::memcpy(&size, data.data() + pos, sizeof(size));
+        if (size < 3 || pos + size > data.size()) {
+            std::cerr << "Warning: truncated entry at offset " << pos << std::endl;
+            break;
+        }
+
+        LogDecoder::Message message;
+        if (decoder.decode(data.data() + pos, size, message) && message.level >= min_level) {
+            run.push_back(std::move(message));
+            ++messages;
+        }
+        pos += size;
+    }
+    flush();
+
+    std::cerr << messages << " messages decoded" << std::endl;
+    return 0;
+}
@@ -1,9 +1,16 @@
 #include "zerodha_client.h"
+#include "clock.h"
+#include "http_server.h"
+#include "log.h"
 #include <iostream>
 #include <string>
 #include <algorithm>
 #include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
 #include <iomanip>
+#include <memory>
 
 #include <sstream>
 #include <thread> // Added for std::this_thread::sleep_for
@@ -18,16 +25,194 @@ std::string formatDate(const std::chrono::system_clock::time_point& time) {
     return oss.str();
 }
 
-int main() {
+// Signal handlers only flip the client's atomic flags
+ZerodhaClient* g_client = nullptr;
+
+void onInterrupt(int) {
+    if (g_client) g_client->requestStop();
+    std::signal(SIGINT, SIG_DFL); // a second Ctrl+C quits immediately
+}
+
+#ifdef SIGUSR1
+void onLatencyReport(int) {
+    if (g_client) g_client->requestLatencyReport();
+}
+#endif
+
+// Local time on a yyyy-mm-dd date; the trading loop checks market hours in local time too
+bool localTimeOn(const std::string& date, int hour, int minute, std::chrono::system_clock::time_point& out) {
+    std::tm tm = {};
+    std::istringstream iss(date);
+    iss >> std::get_time(&tm, "%Y-%m-%d");
+    if (iss.fail()) {
+        return false;
+    }
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    out = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    return true;
+}
+
+int main(int argc, char* argv[]) {
     std::cout << "=== Zerodha Trading Bot ===" << std::endl;
     
+    // Optional overrides: --base-url URL (e.g. a local simulator), --request-token TOKEN (skip the prompt),
+    // --replay yyyy-mm-dd (run that session on a virtual clock against a simulator started with --client-clock),
+    // --record FILE (append all API traffic as JSONL), --replay-traffic FILE [--replay-speed max|recorded],
+    // --metrics-port N (serve Prometheus metrics on 127.0.0.1:N/metrics),
+    // --log-file FILE (binary trading loop log, read with ZerodhaLogDecode), --log-level debug|info|warn|error,
+    // --journal FILE (position journal, positions.journal by default; off for --replay unless given),
+    // --reconcile-seconds N (broker books vs. positions check, every 30 s by default; 0 turns it off),
+    // --rules FILE (entry conditions from a rules file such as strategy.rules instead of the built-in rule),
+    // risk limits checked before each entry (0 = no limit): --max-gross-exposure RUPEES,
+    // --max-net-exposure RUPEES, --max-daily-loss RUPEES, --max-symbol-quantity N, --max-orders-per-second N (10)
+    std::string base_url;
+    std::string request_token;
+    std::string replay_date;
+    std::string record_file;
+    std::string traffic_file;
+    std::string replay_speed = "max";
+    int metrics_port = 0;
+    std::string log_file;
+    std::string log_level;
+    std::string journal_file;
+    int reconcile_seconds = 30;
+    std::string rules_file;
+    RiskLimits risk_limits;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--base-url") {
+            base_url = argv[i + 1];
+        } else if (arg == "--request-token") {
+            request_token = argv[i + 1];
+        } else if (arg == "--replay") {
+            replay_date = argv[i + 1];
+        } else if (arg == "--record") {
+            record_file = argv[i + 1];
+        } else if (arg == "--replay-traffic") {
+            traffic_file = argv[i + 1];
+        } else if (arg == "--replay-speed") {
+            replay_speed = argv[i + 1];
+        } else if (arg == "--metrics-port") {
+            metrics_port = std::atoi(argv[i + 1]);
+        } else if (arg == "--log-file") {
+            log_file = argv[i + 1];
+        } else if (arg == "--log-level") {
+            log_level = argv[i + 1];
+        } else if (arg == "--journal") {
+            journal_file = argv[i + 1];
+        } else if (arg == "--reconcile-seconds") {
+            reconcile_seconds = std::atoi(argv[i + 1]);
+        } else if (arg == "--rules") {
+            rules_file = argv[i + 1];
+        } else if (arg == "--max-gross-exposure") {
+            risk_limits.max_gross_exposure = Price::fromDouble(std::atof(argv[i + 1]));
+        } else if (arg == "--max-net-exposure") {
+            risk_limits.max_net_exposure = Price::fromDouble(std::atof(argv[i + 1]));
+        } else if (arg == "--max-daily-loss") {
+            risk_limits.max_daily_loss = Price::fromDouble(std::atof(argv[i + 1]));
+        } else if (arg == "--max-symbol-quantity") {
+            risk_limits.max_symbol_quantity = std::atoi(argv[i + 1]);
+        } else if (arg == "--max-orders-per-second") {
+            risk_limits.max_orders_per_second = std::atoi(argv[i + 1]);
+        }
+    }
+    
+    if (!log_level.empty()) {
+        // Only levels compiled in (ZERODHA_LOG_LEVEL) can be turned on here
+        static const std::pair<const char*, LogLevel> levels[] = {
+            {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug}, {"info", LogLevel::Info},
+            {"warn", LogLevel::Warn}, {"error", LogLevel::Error}};
+        auto it = std::find_if(std::begin(levels), std::end(levels),
+                               [&](const std::pair<const char*, LogLevel>& level) { return log_level == level.first; });
+        if (it == std::end(levels)) {
+            std::cerr << "Invalid --log-level (expected trace, debug, info, warn or error): " << log_level << std::endl;
+            return 1;
+        }
+        Logger::instance().setLevel(it->second);
+    }
+    
     ZerodhaClient client;
+    client.setRiskLimits(risk_limits);
+    if (!rules_file.empty() && !client.loadStrategyRules(rules_file)) {
+        return 1;
+    }
+    
+    std::chrono::system_clock::time_point session_open, session_close;
+    std::shared_ptr<VirtualClock> virtual_clock;
+    if (!replay_date.empty()) {
+        if (!localTimeOn(replay_date, 9, 15, session_open) || !localTimeOn(replay_date, 15, 30, session_close)) {
+            std::cerr << "Invalid --replay date (expected yyyy-mm-dd): " << replay_date << std::endl;
+            return 1;
+        }
+        // Sleeps advance the clock instead of blocking; the loop ends at the close
+        virtual_clock = std::make_shared<VirtualClock>(session_open);
+        client.setClock(virtual_clock);
+        client.setStopTime(session_close);
+        // The local store may hold candles past the replayed session
+        client.setCandleStoreDirectory("");
+        std::cout << "Replaying session " << replay_date << " on a virtual clock" << std::endl;
+    }
+    
+    // Declared after the client so it stops before the client goes away
+    std::unique_ptr<HttpServer> metrics_server;
+    if (metrics_port > 0) {
+        metrics_server.reset(new HttpServer("127.0.0.1", metrics_port, 2));
+        metrics_server->setHandler([&client](const HttpRequest& request) {
+            if (request.path != "/metrics") {
+                return HttpResponse(404, "not found\n", "text/plain");
+            }
+            return HttpResponse(200, client.metrics().render(), "text/plain; version=0.0.4");
+        });
+        if (!metrics_server->start()) {
+            return 1;
+        }
+        std::cout << "Metrics on http://127.0.0.1:" << metrics_server->port() << "/metrics" << std::endl;
+    }
+    
+    std::shared_ptr<TrafficRecorder> recorder;
+    std::shared_ptr<TrafficReplayer> replayer;
+    if (!traffic_file.empty()) {
+        replayer = std::make_shared<TrafficReplayer>();
+        TrafficReplayer::Pacing pacing;
+        if (!TrafficReplayer::parsePacing(replay_speed, pacing)) {
+            std::cerr << "Invalid --replay-speed (expected max or recorded): " << replay_speed << std::endl;
+            return 1;
+        }
+        replayer->setPacing(pacing);
+        if (!replayer->load(traffic_file)) {
+            std::cerr << "No traffic to replay in " << traffic_file << ". Exiting." << std::endl;
+            return 1;
+        }
+        // Waits and the market-hours check run on the recording's timestamps
+        if (!virtual_clock) {
+            virtual_clock = std::make_shared<VirtualClock>(replayer->startTime());
+            client.setClock(virtual_clock);
+        }
+        replayer->setClock(virtual_clock);
+        client.setTrafficReplayer(replayer);
+        // History comes from the recording rather than the local store
+        client.setCandleStoreDirectory("");
+        std::cout << "Serving " << replayer->size() << " recorded responses from " << traffic_file << std::endl;
+    } else if (!record_file.empty()) {
+        recorder = std::make_shared<TrafficRecorder>();
+        if (!recorder->open(record_file)) {
+            return 1;
+        }
+        client.setTrafficRecorder(recorder);
+        std::cout << "Recording API traffic to " << record_file << std::endl;
+    }
     
     // Load credentials
     if (!client.loadCredentials("Credential.csv")) {
         std::cerr << "Failed to load credentials. Exiting." << std::endl;
         return 1;
     }
+    if (!base_url.empty()) {
+        client.setBaseUrl(base_url);
+    }
     
     // Load trade settings
     if (!client.loadTradeSettings("TradeSettings.csv")) {
@@ -38,7 +223,8 @@ int main() {
     std::cout << "\nStarting login process..." << std::endl;
     
     // Login to Zerodha
-    if (!client.login()) {
+    bool logged_in = request_token.empty() ? client.login() : client.generateSessionToken(request_token);
+    if (!logged_in) {
         std::cerr << "Login failed. Exiting." << std::endl;
         return 1;
     }
@@ -69,9 +255,11 @@ int main() {
     
     // Step 4: Match symbols from trade settings with instruments
     std::cout << "\nMatching symbols from trade settings with instruments..." << std::endl;
-    std::vector<std::string> matched_symbols = client.getMatchedSymbols();
+    size_t matched_count = client.buildSymbolContexts();
+    std::cout << "Found " << matched_count << " symbols in instruments out of "
+              << client.getTradeSettings().size() << " trade settings" << std::endl;
     
-    if (matched_symbols.empty()) {
+    if (matched_count == 0) {
         std::cerr << "No symbols matched. Exiting." << std::endl;
         return 1;
     }
@@ -80,7 +268,7 @@ int main() {
     std::cout << "\n=== Fetching Historical Data for Matched Symbols ===" << std::endl;
     
     // Calculate dynamic dates
-    auto now = std::chrono::system_clock::now();
+    auto now = client.clock().now();
     auto ten_days_ago = now - std::chrono::hours(24 * 10); // 10 days ago
     
     // Format dates
@@ -92,46 +280,31 @@ int main() {
     tm.tm_hour = 15;
     tm.tm_min = 15;
     tm.tm_sec = 0;
-    std::string to_date = formatDate(std::chrono::system_clock::from_time_t(std::mktime(&tm)));
+    auto to_time = std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    std::string to_date = formatDate(to_time);
     
     std::cout << "Date range: " << from_date << " to " << to_date << std::endl;
-    std::cout << "Fetching historical data for " << matched_symbols.size() << " matched symbols..." << std::endl;
+    std::cout << "Fetching historical data for " << matched_count << " matched symbols..." << std::endl;
     
     int success_count = 0;
     int total_count = 0;
     
-    for (const auto& symbol : matched_symbols) {
+    // Also warms each context's candle window and EMA for the first loop pass
+    for (SymbolContext& context : client.symbolContexts()) {
         total_count++;
-        std::cout << "[" << total_count << "/" << matched_symbols.size() << "] Processing " << symbol << "... ";
+        std::cout << "[" << total_count << "/" << matched_count << "] Processing " << context.setting.symbol << "... ";
         
-        // Get timeframe and EMA period from trade settings
-        std::string timeframe = "5minute"; // Default
-        int ema_period = 20; // Default
-        for (const auto& setting : client.getTradeSettings()) {
-            if (setting.symbol == symbol) {
-                timeframe = setting.timeframe;
-                ema_period = setting.ema_period;
-                break;
-            }
-        }
+        // Served from the local candle store; only missing candles are downloaded
+        client.refreshCandles(context, ten_days_ago, to_time);
         
-        std::vector<CandleData> candles = client.getHistoricalData(symbol, timeframe, from_date, to_date);
-        
-        if (!candles.empty()) {
-            std::cout << "✓ " << candles.size() << " candles";
-            
-            // Extract close prices for EMA calculation
-            std::vector<double> close_prices;
-            for (const auto& candle : candles) {
-                close_prices.push_back(candle.close);
-            }
+        if (!context.candles.empty()) {
+            std::cout << "✓ " << context.candles.size() << " candles";
             
-            // Calculate EMA
-            std::vector<double> ema_values = client.calculateEMA(close_prices, ema_period);
-            std::cout << ", EMA(" << ema_period << ") calculated";
+            client.updateEma(context);
+            std::cout << ", EMA(" << context.setting.ema_period << ") calculated";
             
             // Save to CSV just comment it for not saving data to csv
-            // if (client.saveInstrumentDataToCSV(symbol, candles, ema_values)) {
+            // if (client.saveInstrumentDataToCSV(context.setting.symbol, context.candles, context.ema_values)) {
             //     std::cout << ", saved to CSV";
             // }
             
@@ -142,7 +315,7 @@ int main() {
         }
         
         // Add a small delay to avoid rate limiting
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        client.clock().sleepFor(std::chrono::milliseconds(100));
     }
     
     std::cout << "\n=== Historical Data Fetch Complete ===" << std::endl;
@@ -152,7 +325,58 @@ int main() {
     std::cout << "\n=== Starting Trading Loop ===" << std::endl;
     std::cout << "Press Ctrl+C to stop the trading loop" << std::endl;
     
+    // Positions left open by a previous run are recovered before the first pass
+    if (journal_file.empty() && replay_date.empty()) {
+        journal_file = "positions.journal";
+    }
+    if (!journal_file.empty() && !client.openPositionJournal(journal_file)) {
+        std::cerr << "Failed to open position journal " << journal_file << ". Exiting." << std::endl;
+        return 1;
+    }
+    if (reconcile_seconds > 0) {
+        client.startReconciler(std::chrono::seconds(reconcile_seconds));
+    }
+    
+    // Edits to TradeSettings.csv are picked up between loop passes without a restart
+    if (!client.watchTradeSettings("TradeSettings.csv")) {
+        std::cerr << "Warning: TradeSettings.csv changes will need a restart" << std::endl;
+    }
+    
+    g_client = &client;
+    std::signal(SIGINT, onInterrupt);
+#ifdef SIGUSR1
+    // kill -USR1 <pid> prints the stage latency table on the next pass
+    std::signal(SIGUSR1, onLatencyReport);
+#endif
+    
+    // From here on log calls only queue raw bytes; a background thread does the I/O
+    if (!log_file.empty()) {
+        if (!Logger::instance().startBinary(log_file)) {
+            return 1;
+        }
+        std::cout << "Logging to " << log_file << " (decode with ZerodhaLogDecode)" << std::endl;
+    } else {
+        Logger::instance().startConsole();
+    }
+    
+    auto wall_start = std::chrono::steady_clock::now();
     client.runTradingLoop();
+    Logger::instance().stop();
+    
+    if (!replay_date.empty()) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        std::cout << "Replayed " << replay_date << " in " << std::fixed << std::setprecision(1)
+                  << seconds << "s wall time" << std::endl;
+    }
+    if (replayer) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+        std::cout << "Traffic replay: " << replayer->served() << "/" << replayer->size() << " responses served, "
+                  << replayer->misses() << " unmatched requests, trading loop " << std::fixed
+                  << std::setprecision(2) << seconds << "s" << std::endl;
+    }
+    if (recorder) {
+        std::cout << "Recorded " << recorder->entries() << " API exchanges to " << record_file << std::endl;
+    }
     
     return 0;
 } 
\ No newline at end of file
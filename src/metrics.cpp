@@ -0,0 +1,150 @@
+#include "metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef PSAPI_VERSION
+#define PSAPI_VERSION 2 // K32GetProcessMemoryInfo lives in kernel32
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::atomic<size_t> g_next_shard{0};
+
+// Exact for counters and sums up to 2^53; otherwise the shortest of 15 or 17
+// significant digits that reads back as the same double
+void appendNumber(std::string& out, double value) {
+    char buffer[32];
+    int length;
+    if (value == std::floor(value) && std::fabs(value) < 9007199254740992.0) {
+        length = std::snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else {
+        length = std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+        if (std::strtod(buffer, nullptr) != value) {
+            length = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        }
+    }
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+void appendHeader(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+} // namespace
+
+size_t MetricCounter::shardIndex() {
+    // Threads take shards round robin the first time they count anything
+    thread_local size_t index = g_next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+}
+
+uint64_t MetricCounter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family& family = families_[name];
+    family.help = help;
+    family.type = "counter";
+    for (auto& entry : family.counters) {
+        if (entry.first == labels) return *entry.second;
+    }
+    family.counters.emplace_back(labels, std::unique_ptr<MetricCounter>(new MetricCounter()));
+    return *family.counters.back().second;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Family& family = families_[name];
+    family.help = help;
+    family.type = "gauge";
+    for (auto& entry : family.gauges) {
+        if (entry.first == labels) return *entry.second;
+    }
+    family.gauges.emplace_back(labels, std::unique_ptr<MetricGauge>(new MetricGauge()));
+    return *family.gauges.back().second;
+}
+
+void MetricsRegistry::addCollector(Collector collector) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    collectors_.push_back(std::move(collector));
+}
+
+void MetricsRegistry::appendSample(std::string& out, const std::string& name, const std::string& labels, double value) {
+    out += name;
+    if (!labels.empty()) {
+        out += "{" + labels + "}";
+    }
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+void MetricsRegistry::appendSummary(std::string& out, const std::string& name, const std::string& help,
+                                    const std::string& labels, const LatencyHistogram& histogram, bool with_header) {
+    if (with_header) {
+        appendHeader(out, name, help, "summary");
+    }
+    const std::string prefix = labels.empty() ? std::string() : labels + ",";
+    static const std::pair<double, const char*> quantiles[] = {{0.5, "0.5"}, {0.99, "0.99"}, {0.999, "0.999"}};
+    for (const auto& quantile : quantiles) {
+        appendSample(out, name, prefix + "quantile=\"" + quantile.second + "\"",
+                     static_cast<double>(histogram.percentile(quantile.first)) / 1e9);
+    }
+    appendSample(out, name + "_sum", labels, static_cast<double>(histogram.sum()) / 1e9);
+    appendSample(out, name + "_count", labels, static_cast<double>(histogram.count()));
+}
+
+std::string MetricsRegistry::render() const {
+    std::string out;
+    out.reserve(8192);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& collector : collectors_) {
+        collector(out);
+    }
+    for (const auto& entry : families_) {
+        const Family& family = entry.second;
+        appendHeader(out, entry.first, family.help, family.type.c_str());
+        for (const auto& counter : family.counters) {
+            appendSample(out, entry.first, counter.first, static_cast<double>(counter.second->value()));
+        }
+        for (const auto& gauge : family.gauges) {
+            appendSample(out, entry.first, gauge.first, gauge.second->value());
+        }
+    }
+    return out;
+}
+
+uint64_t MetricsRegistry::residentMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<uint64_t>(counters.WorkingSetSize);
+    }
+    return 0;
+#else
+    // statm: total and resident sizes in pages (Linux)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t total_pages = 0;
+    uint64_t resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
@@ -0,0 +1,240 @@
+#include "zerodha_client.h"
+#include "optimizer.h"
+#include "work_stealing_pool.h"
+#include "candle_store.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string rupees(int64_t paise) {
+    return Price::fromPaise(paise).toString();
+}
+
+// "10:50:5" (start:end:step) or "10,20,30"
+template <typename T>
+bool parseAxis(const std::string& text, std::vector<T>& out) {
+    out.clear();
+    std::vector<double> parts;
+    std::stringstream ss(text);
+    std::string item;
+    char separator = text.find(':') != std::string::npos ? ':' : ',';
+    while (std::getline(ss, item, separator)) {
+        if (item.empty()) return false;
+        parts.push_back(std::atof(item.c_str()));
+    }
+
+    if (separator == ':') {
+        if (parts.size() != 3 || parts[2] <= 0 || parts[1] < parts[0]) return false;
+        // Half a step of slack so 1.0:3.0:0.25 includes 3.0
+        for (double value = parts[0]; value <= parts[1] + parts[2] / 2; value += parts[2]) {
+            out.push_back(static_cast<T>(value));
+        }
+    } else {
+        for (double value : parts) out.push_back(static_cast<T>(value));
+    }
+    return !out.empty();
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--csv FILE]... [--symbol SYM]... [--all]\n"
+              << "       [--store-dir DIR] [--timeframe TF] [--from yyyy-mm-dd] [--to yyyy-mm-dd]\n"
+              << "       [--ema 10:50:5] [--target 1.0:3.0:0.25] [--stop-rule extreme,second]\n"
+              << "       [--random N] [--seed S] [--windows N] [--train-fraction F]\n"
+              << "       [--threads N] [--top N] [--no-squareoff]" << std::endl;
+}
+
+} // namespace
+
+// Sweeps EMA period, target multiple and stop rule over local candles and ranks
+// the combinations by walk-forward (out-of-sample) P&L. No network access.
+int main(int argc, char* argv[]) {
+    std::cout << "=== Zerodha EMA Parameter Optimizer ===" << std::endl;
+
+    std::vector<std::string> csv_files;
+    std::vector<std::string> symbols;
+    bool all_symbols = false;
+    std::string store_dir = "candles";
+    std::string timeframe_override;
+    std::string from_arg;
+    std::string to_arg;
+    int threads = static_cast<int>((std::max)(1u, std::thread::hardware_concurrency()));
+    size_t top = 20;
+
+    SweepSpace space;
+    space.ema_periods = {10, 15, 20, 25, 30, 40, 50};
+    space.target_multiples = {1.0, 1.5, 2.0, 2.5, 3.0};
+    space.stop_rules = {StopRule::TwoCandleExtreme, StopRule::SecondCandle};
+    WalkForwardConfig walk_forward;
+    BacktestOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (arg == "--csv" && has_value) {
+            csv_files.push_back(argv[++i]);
+        } else if (arg == "--symbol" && has_value) {
+            symbols.push_back(argv[++i]);
+        } else if (arg == "--all") {
+            all_symbols = true;
+        } else if (arg == "--store-dir" && has_value) {
+            store_dir = argv[++i];
+        } else if (arg == "--timeframe" && has_value) {
+            timeframe_override = argv[++i];
+        } else if (arg == "--from" && has_value) {
+            from_arg = argv[++i];
+        } else if (arg == "--to" && has_value) {
+            to_arg = argv[++i];
+        } else if (arg == "--ema" && has_value) {
+            ok = parseAxis(argv[++i], space.ema_periods);
+        } else if (arg == "--target" && has_value) {
+            ok = parseAxis(argv[++i], space.target_multiples);
+        } else if (arg == "--stop-rule" && has_value) {
+            space.stop_rules.clear();
+            std::stringstream ss(argv[++i]);
+            std::string item;
+            while (ok && std::getline(ss, item, ',')) {
+                StopRule rule;
+                ok = parseStopRule(item, rule);
+                space.stop_rules.push_back(rule);
+            }
+        } else if (arg == "--random" && has_value) {
+            space.random_samples = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--seed" && has_value) {
+            space.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--windows" && has_value) {
+            walk_forward.windows = std::atoi(argv[++i]);
+        } else if (arg == "--train-fraction" && has_value) {
+            walk_forward.train_fraction = std::atof(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            threads = (std::max)(1, std::atoi(argv[++i]));
+        } else if (arg == "--top" && has_value) {
+            top = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (arg == "--no-squareoff") {
+            options.intraday_squareoff = false;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (csv_files.empty() && symbols.empty() && !all_symbols) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    int64_t from_ts = from_arg.empty() ? 0 : CandleStore::parseTimestamp(from_arg + "T00:00:00");
+    int64_t to_ts = to_arg.empty() ? INT64_MAX : CandleStore::parseTimestamp(to_arg + "T23:59:59");
+
+    // Settings and instruments are optional; defaults apply when the files are absent
+    ZerodhaClient client;
+    client.loadTradeSettings("TradeSettings.csv");
+    client.loadInstrumentsFromCSV("instruments.csv");
+
+    if (all_symbols) {
+        for (const auto& setting : client.getTradeSettings()) {
+            symbols.push_back(setting.symbol);
+        }
+    }
+
+    std::vector<OptimizerSeries> series(csv_files.size() + symbols.size());
+    for (size_t i = 0; i < series.size(); ++i) {
+        series[i].symbol = i < csv_files.size() ? csv_files[i] : symbols[i - csv_files.size()];
+        series[i].tick = client.getTickSize(series[i].symbol);
+        for (const auto& setting : client.getTradeSettings()) {
+            if (setting.symbol == series[i].symbol) {
+                series[i].quantity = (std::max)(1, setting.quantity);
+                break;
+            }
+        }
+    }
+
+    // Columns are loaded once and then shared read-only by every run
+    WorkStealingPool pool(threads);
+    pool.parallelFor(series.size(), [&](size_t i) {
+        OptimizerSeries& entry = series[i];
+        if (i < csv_files.size()) {
+            Backtester::loadCSV(entry.symbol, entry.candles);
+            return;
+        }
+
+        std::string timeframe = timeframe_override.empty() ? "5minute" : timeframe_override;
+        if (timeframe_override.empty()) {
+            for (const auto& setting : client.getTradeSettings()) {
+                if (setting.symbol == entry.symbol) timeframe = setting.timeframe;
+            }
+        }
+        CandleStore store(store_dir);
+        if (!store.open(entry.symbol, timeframe) || !store.readColumns(from_ts, to_ts, entry.candles)) {
+            std::cerr << "Error: No stored candles for " << entry.symbol << " (" << timeframe << ")" << std::endl;
+        }
+    });
+
+    size_t total_bars = 0;
+    for (const auto& entry : series) total_bars += entry.candles.size();
+
+    std::vector<StrategyParams> combinations = space.combinations();
+    std::cout << "Sweeping " << combinations.size() << " combinations over " << series.size() << " series ("
+              << total_bars << " candles), " << walk_forward.windows << " walk-forward window(s), "
+              << threads << " thread(s)..." << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    ParameterOptimizer optimizer(series, threads);
+    std::vector<ComboResult> ranked = optimizer.run(combinations, walk_forward, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    bool oos = !ranked.empty() && ranked.front().scored_windows > 0;
+    std::cout << "\n=== Ranked by " << (oos ? "out-of-sample" : "in-sample") << " P&L ===" << std::endl;
+    std::cout << std::right << std::setw(5) << "Rank" << std::setw(6) << "EMA" << std::setw(8) << "Target"
+              << std::setw(9) << "Stop" << std::setw(14) << "IS P&L" << std::setw(14) << "OOS P&L"
+              << std::setw(9) << "Trades" << std::setw(7) << "Win%" << std::setw(10) << "+Windows"
+              << std::setw(14) << "Max DD" << std::endl;
+
+    for (size_t i = 0; i < ranked.size() && i < top; ++i) {
+        const ComboResult& r = ranked[i];
+        const BacktestResult& scored = oos ? r.out_of_sample : r.in_sample;
+        std::cout << std::setw(5) << (i + 1) << std::setw(6) << r.params.ema_period
+                  << std::setw(8) << std::fixed << std::setprecision(2) << r.params.target_multiple
+                  << std::setw(9) << stopRuleName(r.params.stop_rule)
+                  << std::setw(14) << rupees(r.in_sample.net_pnl_paise)
+                  << std::setw(14) << (oos ? rupees(r.out_of_sample.net_pnl_paise) : std::string("-"))
+                  << std::setw(9) << scored.trade_count
+                  << std::setw(7) << std::setprecision(1) << scored.winRate() * 100.0
+                  << std::setw(10) << (std::to_string(r.positive_windows) + "/" + std::to_string(r.scored_windows))
+                  << std::setw(14) << rupees(scored.max_drawdown_paise) << std::endl;
+    }
+
+    if (oos) {
+        const BacktestResult& wf = optimizer.walkForwardResult();
+        std::cout << "\nWalk-forward (best in-sample set re-picked per window): OOS P&L " << rupees(wf.net_pnl_paise)
+                  << ", " << wf.trade_count << " trades, " << std::setprecision(1) << wf.winRate() * 100.0 << "% wins"
+                  << std::endl;
+    }
+
+    if (!ranked.empty()) {
+        const StrategyParams& best = ranked.front().params;
+        std::cout << "Best TradeSettings.csv columns: EMA_Period=" << best.ema_period
+                  << ", Target_Multiple=" << std::setprecision(2) << best.target_multiple
+                  << ", Stop_Rule=" << stopRuleName(best.stop_rule) << std::endl;
+    }
+
+    std::cout << "Replayed " << optimizer.candlesReplayed() << " candles in " << std::setprecision(2) << seconds << "s";
+    if (seconds > 0) {
+        std::cout << " (" << std::setprecision(1) << optimizer.candlesReplayed() / seconds / 1e6 << "M candles/s)";
+    }
+    std::cout << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+#include "optimizer.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <random>
+
+namespace {
+
+constexpr size_t kComboLockStripes = 64;
+
+// Best in-sample candidate seen so far for one symbol/window
+struct WindowPick {
+    bool set;
+    int64_t train_pnl;
+    size_t combo;
+    BacktestResult test;
+
+    WindowPick() : set(false), train_pnl(0), combo(0) {}
+};
+
+} // namespace
+
+std::vector<StrategyParams> SweepSpace::combinations() const {
+    std::vector<StrategyParams> result;
+
+    std::vector<int> periods = ema_periods.empty() ? std::vector<int>{StrategyParams().ema_period} : ema_periods;
+    std::vector<double> multiples = target_multiples.empty() ? std::vector<double>{StrategyParams().target_multiple} : target_multiples;
+    std::vector<StopRule> rules = stop_rules.empty() ? std::vector<StopRule>{StrategyParams().stop_rule} : stop_rules;
+
+    if (random_samples == 0) {
+        result.reserve(periods.size() * multiples.size() * rules.size());
+        for (int period : periods) {
+            for (double multiple : multiples) {
+                for (StopRule rule : rules) {
+                    StrategyParams params;
+                    params.ema_period = period;
+                    params.target_multiple = multiple;
+                    params.stop_rule = rule;
+                    result.push_back(params);
+                }
+            }
+        }
+        return result;
+    }
+
+    // Random search draws from the bounds of each axis; multiples snap to 0.05
+    std::mt19937 rng(seed);
+    auto period_bounds = std::minmax_element(periods.begin(), periods.end());
+    auto multiple_bounds = std::minmax_element(multiples.begin(), multiples.end());
+    std::uniform_int_distribution<int> period_dist(*period_bounds.first, *period_bounds.second);
+    std::uniform_real_distribution<double> multiple_dist(*multiple_bounds.first, *multiple_bounds.second);
+    std::uniform_int_distribution<size_t> rule_dist(0, rules.size() - 1);
+
+    result.reserve(random_samples);
+    for (size_t i = 0; i < random_samples; ++i) {
+        StrategyParams params;
+        params.ema_period = period_dist(rng);
+        params.target_multiple = std::round(multiple_dist(rng) * 20.0) / 20.0;
+        params.stop_rule = rules[rule_dist(rng)];
+        result.push_back(params);
+    }
+    return result;
+}
+
+int64_t ComboResult::score() const {
+    return scored_windows > 0 ? out_of_sample.net_pnl_paise : in_sample.net_pnl_paise;
+}
+
+ParameterOptimizer::ParameterOptimizer(const std::vector<OptimizerSeries>& series, int threads)
+    : series_(series), threads_((std::max)(1, threads)), candles_replayed_(0) {
+}
+
+std::vector<WalkForwardWindow> ParameterOptimizer::windowsFor(size_t bars, const WalkForwardConfig& walk_forward) {
+    std::vector<WalkForwardWindow> windows;
+    if (walk_forward.windows <= 0 || walk_forward.train_fraction <= 0.0 || walk_forward.train_fraction >= 1.0) {
+        return windows;
+    }
+
+    // bars = train + windows * test, with train / (train + test) == train_fraction
+    double ratio = walk_forward.train_fraction / (1.0 - walk_forward.train_fraction);
+    size_t test = static_cast<size_t>(bars / (walk_forward.windows + ratio));
+    size_t train = static_cast<size_t>(test * ratio);
+    if (test < 3 || train < 3) {
+        return windows;
+    }
+
+    for (int k = 0; k < walk_forward.windows; ++k) {
+        WalkForwardWindow window;
+        window.train_begin = k * test;
+        window.train_end = window.train_begin + train;
+        window.test_end = (k + 1 == walk_forward.windows) ? bars : (std::min)(bars, window.train_end + test);
+        windows.push_back(window);
+    }
+    return windows;
+}
+
+std::vector<ComboResult> ParameterOptimizer::run(const std::vector<StrategyParams>& combinations,
+                                                 const WalkForwardConfig& walk_forward,
+                                                 const BacktestOptions& options) {
+    std::vector<ComboResult> results(combinations.size());
+    for (size_t i = 0; i < combinations.size(); ++i) {
+        results[i].params = combinations[i];
+    }
+
+    // Group combinations by EMA period so each (symbol, period) task shares one EMA column
+    std::map<int, std::vector<size_t>> by_period;
+    for (size_t i = 0; i < combinations.size(); ++i) {
+        by_period[combinations[i].ema_period].push_back(i);
+    }
+    std::vector<std::pair<int, const std::vector<size_t>*>> periods;
+    for (const auto& entry : by_period) {
+        periods.emplace_back(entry.first, &entry.second);
+    }
+
+    std::vector<std::vector<WalkForwardWindow>> layouts(series_.size());
+    std::vector<std::vector<WindowPick>> picks(series_.size());
+    for (size_t s = 0; s < series_.size(); ++s) {
+        layouts[s] = windowsFor(series_[s].candles.size(), walk_forward);
+        picks[s].resize(layouts[s].size());
+    }
+
+    std::vector<std::mutex> combo_locks(kComboLockStripes);
+    std::vector<std::mutex> series_locks(series_.size());
+    std::atomic<uint64_t> replayed{0};
+
+    WorkStealingPool pool(threads_);
+    pool.parallelFor(series_.size() * periods.size(), [&](size_t task) {
+        size_t s = task / periods.size();
+        const OptimizerSeries& input = series_[s];
+        const std::vector<WalkForwardWindow>& windows = layouts[s];
+        int period = periods[task % periods.size()].first;
+        const std::vector<size_t>& combos = *periods[task % periods.size()].second;
+        if (input.candles.size() < 3) {
+            return;
+        }
+
+        thread_local std::vector<double> ema;
+        Backtester::computeEma(input.candles, period, ema);
+
+        BacktestOptions run_options = options;
+        run_options.tick = input.tick;
+        run_options.quantity = input.quantity;
+        run_options.record_trades = false;
+
+        uint64_t local_replayed = 0;
+        for (size_t combo : combos) {
+            const StrategyParams& params = combinations[combo];
+            BacktestResult train_total;
+            BacktestResult test_total;
+            int positive = 0;
+
+            if (windows.empty()) {
+                train_total = Backtester::runRange(input.candles, ema, 0, input.candles.size(), params, run_options);
+                local_replayed += input.candles.size();
+            }
+
+            for (size_t w = 0; w < windows.size(); ++w) {
+                const WalkForwardWindow& window = windows[w];
+                BacktestResult train = Backtester::runRange(input.candles, ema, window.train_begin, window.train_end, params, run_options);
+                BacktestResult test = Backtester::runRange(input.candles, ema, window.train_end, window.test_end, params, run_options);
+                local_replayed += window.test_end - window.train_begin;
+                if (test.net_pnl_paise > 0) ++positive;
+
+                {
+                    std::lock_guard<std::mutex> lock(series_locks[s]);
+                    WindowPick& pick = picks[s][w];
+                    if (!pick.set || train.net_pnl_paise > pick.train_pnl ||
+                        (train.net_pnl_paise == pick.train_pnl && combo < pick.combo)) {
+                        pick.set = true;
+                        pick.train_pnl = train.net_pnl_paise;
+                        pick.combo = combo;
+                        pick.test = test;
+                    }
+                }
+
+                train_total.merge(train);
+                test_total.merge(test);
+            }
+
+            std::lock_guard<std::mutex> lock(combo_locks[combo % kComboLockStripes]);
+            ComboResult& result = results[combo];
+            result.in_sample.merge(train_total);
+            result.out_of_sample.merge(test_total);
+            result.positive_windows += positive;
+            result.scored_windows += static_cast<int>(windows.size());
+        }
+        replayed += local_replayed;
+    });
+
+    walk_forward_result_ = BacktestResult();
+    for (const auto& series_picks : picks) {
+        for (const auto& pick : series_picks) {
+            if (pick.set) walk_forward_result_.merge(pick.test);
+        }
+    }
+    candles_replayed_ = replayed.load();
+
+    std::stable_sort(results.begin(), results.end(), [](const ComboResult& a, const ComboResult& b) {
+        return a.score() > b.score();
+    });
+    return results;
+}
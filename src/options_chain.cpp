@@ -0,0 +1,107 @@
+#include "options_chain.h"
+#include <algorithm>
+#include <map>
+
+OptionsChain::OptionsChain() : built_on_(0) {
+}
+
+void OptionsChain::clear() {
+    underlying_index_.clear();
+    chains_.clear();
+    built_on_ = 0;
+}
+
+void OptionsChain::build(const InstrumentStore& store, int as_of, const std::vector<std::string>& segments) {
+    clear();
+
+    // Group rows per underlying with ordered maps, then flatten into sorted vectors
+    std::vector<std::map<int, std::map<int64_t, StrikeEntry>>> staging;
+
+    for (const auto& segment : segments) {
+        for (InstrumentStore::Row row : store.bySegment(segment)) {
+            int expiry = store.expiry(row);
+            if (expiry == 0 || expiry < as_of) continue;
+
+            std::string_view type = store.instrumentType(row);
+            if (type != "CE" && type != "PE") continue;
+
+            std::string underlying(store.name(row));
+            auto it = underlying_index_.find(underlying);
+            if (it == underlying_index_.end()) {
+                it = underlying_index_.emplace(underlying, staging.size()).first;
+                staging.emplace_back();
+            }
+
+            StrikeEntry& entry = staging[it->second][expiry][store.strike(row).paise()];
+            entry.strike = store.strike(row);
+            if (type == "CE") {
+                entry.ce = row;
+            } else {
+                entry.pe = row;
+            }
+        }
+    }
+
+    chains_.resize(staging.size());
+    for (size_t i = 0; i < staging.size(); ++i) {
+        chains_[i].reserve(staging[i].size());
+        for (auto& expiry_pair : staging[i]) {
+            ExpirySlice slice;
+            slice.expiry = expiry_pair.first;
+            slice.strikes.reserve(expiry_pair.second.size());
+            for (auto& strike_pair : expiry_pair.second) {
+                slice.strikes.push_back(strike_pair.second);
+            }
+            chains_[i].push_back(std::move(slice));
+        }
+    }
+
+    built_on_ = as_of;
+}
+
+const std::vector<OptionsChain::ExpirySlice>* OptionsChain::expiries(std::string_view underlying) const {
+    auto it = underlying_index_.find(std::string(underlying));
+    return it != underlying_index_.end() ? &chains_[it->second] : nullptr;
+}
+
+const OptionsChain::ExpirySlice* OptionsChain::nearestExpiry(std::string_view underlying, int on_or_after) const {
+    const auto* slices = expiries(underlying);
+    if (!slices) return nullptr;
+
+    auto it = std::lower_bound(slices->begin(), slices->end(), on_or_after,
+                               [](const ExpirySlice& slice, int value) { return slice.expiry < value; });
+    return it != slices->end() ? &*it : nullptr;
+}
+
+const OptionsChain::StrikeEntry* OptionsChain::nearestStrike(const ExpirySlice& slice, Price price) const {
+    const auto& strikes = slice.strikes;
+    if (strikes.empty()) return nullptr;
+
+    auto it = std::lower_bound(strikes.begin(), strikes.end(), price,
+                               [](const StrikeEntry& entry, Price value) { return entry.strike < value; });
+    if (it == strikes.end()) return &strikes.back();
+    if (it == strikes.begin()) return &*it;
+
+    // Pick the closer of the two neighbours; ties go to the lower strike
+    auto below = it - 1;
+    return (price - below->strike) <= (it->strike - price) ? &*below : &*it;
+}
+
+const OptionsChain::StrikeEntry* OptionsChain::atm(std::string_view underlying, Price ltp, int on_or_after) const {
+    const ExpirySlice* slice = nearestExpiry(underlying, on_or_after);
+    return slice ? nearestStrike(*slice, ltp) : nullptr;
+}
+
+InstrumentStore::Row OptionsChain::select(std::string_view underlying, Price ltp, OptionType type,
+                                          int strike_offset, int on_or_after) const {
+    const ExpirySlice* slice = nearestExpiry(underlying, on_or_after);
+    if (!slice) return InstrumentStore::npos;
+
+    const StrikeEntry* atm_entry = nearestStrike(*slice, ltp);
+    if (!atm_entry) return InstrumentStore::npos;
+
+    long index = static_cast<long>(atm_entry - slice->strikes.data()) + strike_offset;
+    if (index < 0 || index >= static_cast<long>(slice->strikes.size())) return InstrumentStore::npos;
+
+    return slice->strikes[index].row(type);
+}
@@ -0,0 +1,400 @@
+#include "order_log.h"
+#include "civil_date.h"
+#include "mapped_file.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+const char kIndexMagic[8] = {'Z', 'O', 'L', 'I', 'D', 'X', '0', '1'};
+const size_t kHeadBytes = 4096;
+
+struct IndexHeader {
+    char magic[8];
+    uint64_t source_bytes; // prefix of the log covered by the index
+    uint64_t head_bytes;   // hashed prefix, min(kHeadBytes, source_bytes)
+    uint64_t head_hash;
+    uint64_t entry_count;
+    uint64_t symbol_bytes; // NUL-terminated names after the entries
+    uint64_t reserved[2];
+};
+static_assert(sizeof(IndexHeader) == 64, "index header is 64 bytes");
+
+const char* const kEventNames[] = {"ENTRY", "STOPLOSS", "TARGET", "STOPLOSS_HIT", "TARGET_HIT"};
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+// "yyyy-mm-dd hh:mm:ss"
+bool parseTimestamp(const char* p, size_t size, int64_t& timestamp) {
+    int year, month, day, hour, minute, second;
+    if (size != 19 || p[4] != '-' || p[7] != '-' || p[10] != ' ' || p[13] != ':' || p[16] != ':' ||
+        !digits(p, 4, year) || !digits(p + 5, 2, month) || !digits(p + 8, 2, day) ||
+        !digits(p + 11, 2, hour) || !digits(p + 14, 2, minute) || !digits(p + 17, 2, second)) {
+        return false;
+    }
+    timestamp = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day)) * 86400 +
+                hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+// Text after "Label: " when the field starts with it
+bool labelled(const char* begin, const char* end, const char* label, std::string_view& value) {
+    size_t length = std::strlen(label);
+    if (static_cast<size_t>(end - begin) < length || std::memcmp(begin, label, length) != 0) {
+        return false;
+    }
+    value = std::string_view(begin + length, static_cast<size_t>(end - begin) - length);
+    return true;
+}
+
+uint64_t fnv1a(const uint8_t* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+const char* orderLogEventName(OrderLogEvent event) {
+    return event < OrderLogEvent::Count ? kEventNames[static_cast<size_t>(event)] : "UNKNOWN";
+}
+
+int64_t orderLogTimestamp(const std::tm& local_time) {
+    return daysFromCivil(local_time.tm_year + 1900, static_cast<unsigned>(local_time.tm_mon + 1),
+                         static_cast<unsigned>(local_time.tm_mday)) * 86400 +
+           local_time.tm_hour * 3600 + local_time.tm_min * 60 + local_time.tm_sec;
+}
+
+std::string formatOrderLogDay(int64_t day) {
+    int year;
+    unsigned month, dom;
+    civilFromDays(day, year, month, dom);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u", year, month, dom);
+    return buf;
+}
+
+bool parseOrderLogDay(const std::string& text, int64_t& day) {
+    int year, month, dom;
+    if (text.size() != 10 || text[4] != '-' || text[7] != '-' || !digits(text.data(), 4, year) ||
+        !digits(text.data() + 5, 2, month) || !digits(text.data() + 8, 2, dom)) {
+        return false;
+    }
+    day = daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(dom));
+    return true;
+}
+
+std::string formatOrderLogLine(const OrderLogRecord& record) {
+    int64_t seconds = floorDiv(record.timestamp, 86400);
+    int64_t time_of_day = record.timestamp - seconds * 86400;
+    char time_buf[32];
+    std::snprintf(time_buf, sizeof(time_buf), " %02d:%02d:%02d", static_cast<int>(time_of_day / 3600),
+                  static_cast<int>(time_of_day / 60 % 60), static_cast<int>(time_of_day % 60));
+
+    std::string line = formatOrderLogDay(seconds) + time_buf;
+    line += " | ";
+    line += orderLogEventName(record.event);
+    line += record.buy ? " | BUY | " : " | SELL | ";
+    line += record.symbol;
+    line += " | Price: " + record.price.toString();
+    line += " | Qty: " + std::to_string(record.quantity);
+    line += " | Order ID: " + record.order_id;
+    if (!record.entry_id.empty()) {
+        line += " | Entry ID: " + record.entry_id;
+    }
+    return line;
+}
+
+bool parseOrderLogLine(const char* begin, const char* end, OrderLogRecord& record) {
+    if (end > begin && end[-1] == '\r') --end;
+
+    // Split on " | " (at most 8 fields)
+    const char* fields[8][2];
+    size_t count = 0;
+    const char* start = begin;
+    for (const char* p = begin; p + 3 <= end && count < 7; ++p) {
+        if (p[0] == ' ' && p[1] == '|' && p[2] == ' ') {
+            fields[count][0] = start;
+            fields[count][1] = p;
+            ++count;
+            start = p + 3;
+            p += 2;
+        }
+    }
+    fields[count][0] = start;
+    fields[count][1] = end;
+    ++count;
+    if (count < 4 || !parseTimestamp(fields[0][0], static_cast<size_t>(fields[0][1] - fields[0][0]), record.timestamp)) {
+        return false;
+    }
+
+    std::string_view event(fields[1][0], static_cast<size_t>(fields[1][1] - fields[1][0]));
+    size_t index = 0;
+    while (index < static_cast<size_t>(OrderLogEvent::Count) && event != kEventNames[index]) ++index;
+    if (index == static_cast<size_t>(OrderLogEvent::Count)) {
+        return false;
+    }
+    record.event = static_cast<OrderLogEvent>(index);
+    record.quantity = 0;
+    record.order_id.clear();
+    record.entry_id.clear();
+
+    std::string_view value;
+    if (count == 4) {
+        // Older exit line: time | EVENT | SYMBOL | Price: x
+        record.buy = true;
+        record.symbol.assign(fields[2][0], fields[2][1]);
+        return labelled(fields[3][0], fields[3][1], "Price: ", value) && Price::parse(value, record.price);
+    }
+
+    std::string_view side(fields[2][0], static_cast<size_t>(fields[2][1] - fields[2][0]));
+    record.buy = side == "BUY";
+    record.symbol.assign(fields[3][0], fields[3][1]);
+    if (!labelled(fields[4][0], fields[4][1], "Price: ", value) || !Price::parse(value, record.price)) {
+        return false;
+    }
+    for (size_t i = 5; i < count; ++i) {
+        if (labelled(fields[i][0], fields[i][1], "Qty: ", value)) {
+            std::from_chars(value.data(), value.data() + value.size(), record.quantity);
+        } else if (labelled(fields[i][0], fields[i][1], "Order ID: ", value)) {
+            record.order_id.assign(value.data(), value.size());
+        } else if (labelled(fields[i][0], fields[i][1], "Entry ID: ", value)) {
+            record.entry_id.assign(value.data(), value.size());
+        }
+    }
+    return true;
+}
+
+bool appendOrderLog(const std::string& path, const OrderLogRecord& record) {
+    std::ofstream file(path, std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << formatOrderLogLine(record) << '\n';
+    return static_cast<bool>(file);
+}
+
+uint64_t OrderLogIndex::orderKey(const std::string& order_id) {
+    if (order_id.empty()) {
+        return 0;
+    }
+    uint64_t key = 0;
+    auto result = std::from_chars(order_id.data(), order_id.data() + order_id.size(), key);
+    if (result.ec == std::errc() && result.ptr == order_id.data() + order_id.size() && key != 0) {
+        return key;
+    }
+    // Not a Kite numeric id; the top bit keeps hashes apart from real ids
+    return fnv1a(reinterpret_cast<const uint8_t*>(order_id.data()), order_id.size()) | (uint64_t(1) << 63);
+}
+
+uint16_t OrderLogIndex::symbolId(const std::string& symbol) {
+    auto it = symbol_ids_.find(symbol);
+    if (it != symbol_ids_.end()) {
+        return it->second;
+    }
+    uint16_t id = static_cast<uint16_t>(symbols_.size());
+    symbols_.push_back(symbol);
+    symbol_ids_.emplace(symbol, id);
+    return id;
+}
+
+bool OrderLogIndex::add(const std::string& log_path, bool rebuild) {
+    parsed_lines_ = 0;
+    MappedFile log;
+    if (!log.open(log_path)) {
+        std::cerr << "Error: Could not open " << log_path << std::endl;
+        return false;
+    }
+    const uint8_t* data = log.data();
+    size_t size = log.size();
+
+    // Entries and symbols of this log, with symbol ids local to it
+    std::vector<Entry> entries;
+    std::vector<std::string> symbols;
+    std::map<std::string, uint16_t> symbol_ids;
+    size_t covered = 0;
+
+    std::string index_path = log_path + ".idx";
+    if (!rebuild) {
+        MappedFile index;
+        IndexHeader header;
+        if (index.open(index_path) && index.size() >= sizeof(header)) {
+            std::memcpy(&header, index.data(), sizeof(header));
+            bool valid = std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) == 0 &&
+                         header.source_bytes <= size && header.head_bytes <= header.source_bytes &&
+                         sizeof(header) + header.entry_count * sizeof(Entry) + header.symbol_bytes == index.size() &&
+                         fnv1a(data, header.head_bytes) == header.head_hash;
+            if (valid) {
+                entries.resize(header.entry_count);
+                std::memcpy(entries.data(), index.data() + sizeof(header), header.entry_count * sizeof(Entry));
+                const char* names = reinterpret_cast<const char*>(index.data() + sizeof(header) + header.entry_count * sizeof(Entry));
+                const char* names_end = names + header.symbol_bytes;
+                while (names < names_end) {
+                    size_t length = strnlen(names, static_cast<size_t>(names_end - names));
+                    symbol_ids.emplace(std::string(names, length), static_cast<uint16_t>(symbols.size()));
+                    symbols.emplace_back(names, length);
+                    names += length + 1;
+                }
+                covered = header.source_bytes;
+            }
+        }
+    }
+
+    // Parse whatever the index does not cover yet, up to the last complete line
+    size_t parse_end = size;
+    while (parse_end > covered && data[parse_end - 1] != '\n') --parse_end;
+    if (parse_end > covered) {
+        OrderLogRecord record;
+        const char* p = reinterpret_cast<const char*>(data) + covered;
+        const char* end = reinterpret_cast<const char*>(data) + parse_end;
+        while (p < end) {
+            const char* line_end = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!line_end) line_end = end;
+            ++parsed_lines_;
+            if (parseOrderLogLine(p, line_end, record)) {
+                auto it = symbol_ids.find(record.symbol);
+                if (it == symbol_ids.end()) {
+                    it = symbol_ids.emplace(record.symbol, static_cast<uint16_t>(symbols.size())).first;
+                    symbols.push_back(record.symbol);
+                }
+                Entry entry;
+                std::memset(&entry, 0, sizeof(entry));
+                entry.timestamp = record.timestamp;
+                entry.price_paise = record.price.paise();
+                entry.order_key = orderKey(record.order_id);
+                entry.entry_key = orderKey(record.entry_id);
+                entry.quantity = record.quantity;
+                entry.symbol = it->second;
+                entry.event = static_cast<uint8_t>(record.event);
+                entry.buy = record.buy ? 1 : 0;
+                entries.push_back(entry);
+            }
+            p = line_end + 1;
+        }
+
+        // Rewrite the index next to the log; failing to is not fatal
+        IndexHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+        header.source_bytes = parse_end;
+        header.head_bytes = parse_end < kHeadBytes ? parse_end : kHeadBytes;
+        header.head_hash = fnv1a(data, header.head_bytes);
+        header.entry_count = entries.size();
+        std::string names;
+        for (const auto& symbol : symbols) {
+            names.append(symbol).push_back('\0');
+        }
+        header.symbol_bytes = names.size();
+
+        std::string temp_path = index_path + ".tmp";
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+        out.write(names.data(), static_cast<std::streamsize>(names.size()));
+        out.close();
+        if (out) {
+            std::remove(index_path.c_str());
+            if (std::rename(temp_path.c_str(), index_path.c_str()) != 0) {
+                std::cerr << "Warning: Could not write " << index_path << std::endl;
+            }
+        } else {
+            std::remove(temp_path.c_str());
+            std::cerr << "Warning: Could not write " << index_path << std::endl;
+        }
+    }
+
+    // Merge into the combined index with global symbol ids
+    std::vector<uint16_t> remap(symbols.size());
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        remap[i] = symbolId(symbols[i]);
+    }
+    entries_.reserve(entries_.size() + entries.size());
+    for (Entry entry : entries) {
+        entry.symbol = entry.symbol < remap.size() ? remap[entry.symbol] : 0;
+        entries_.push_back(entry);
+    }
+    return true;
+}
+
+OrderLogReport analyzeOrderLog(const OrderLogIndex& index, int64_t from_day, int64_t to_day) {
+    struct Open {
+        int64_t timestamp;
+        int64_t price_paise;
+        int32_t quantity;
+        uint16_t symbol;
+        bool buy;
+    };
+
+    OrderLogReport report;
+    const std::vector<OrderLogIndex::Entry>& entries = index.entries();
+    std::unordered_map<uint64_t, Open> open;
+    std::unordered_map<uint64_t, uint64_t> leg_entry; // SL/target order -> entry
+    std::vector<uint64_t> latest(index.symbols().size(), 0);
+    std::vector<TradeStats> by_symbol(index.symbols().size());
+    open.reserve(1024);
+    uint64_t synthetic = 0;
+
+    for (const auto& entry : entries) {
+        switch (static_cast<OrderLogEvent>(entry.event)) {
+            case OrderLogEvent::Entry: {
+                // Entries without an id still pair by symbol
+                uint64_t key = entry.order_key ? entry.order_key : (++synthetic | (uint64_t(1) << 62));
+                open[key] = Open{entry.timestamp, entry.price_paise, entry.quantity, entry.symbol, entry.buy != 0};
+                latest[entry.symbol] = key;
+                break;
+            }
+            case OrderLogEvent::StopLoss:
+            case OrderLogEvent::Target:
+                // Legs are logged right after their entry
+                if (entry.order_key && latest[entry.symbol]) {
+                    leg_entry[entry.order_key] = latest[entry.symbol];
+                }
+                break;
+            case OrderLogEvent::StopLossHit:
+            case OrderLogEvent::TargetHit: {
+                uint64_t key = entry.entry_key;
+                if (!key || !open.count(key)) {
+                    auto leg = entry.order_key ? leg_entry.find(entry.order_key) : leg_entry.end();
+                    key = leg != leg_entry.end() ? leg->second : latest[entry.symbol];
+                }
+                auto it = key ? open.find(key) : open.end();
+                if (it == open.end()) {
+                    ++report.unmatched_exits;
+                    break;
+                }
+                const Open& trade = it->second;
+                int64_t pnl = (entry.price_paise - trade.price_paise) * trade.quantity * (trade.buy ? 1 : -1);
+                int64_t held = entry.timestamp - trade.timestamp;
+                int64_t day = floorDiv(entry.timestamp, 86400);
+                if (day >= from_day && day <= to_day) {
+                    report.total.add(pnl, held);
+                    report.by_day[day].add(pnl, held);
+                    by_symbol[trade.symbol].add(pnl, held);
+                }
+                if (latest[trade.symbol] == key) latest[trade.symbol] = 0;
+                open.erase(it);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    report.open_entries = static_cast<int64_t>(open.size());
+    for (size_t i = 0; i < by_symbol.size(); ++i) {
+        if (by_symbol[i].trades > 0) {
+            report.by_symbol.emplace(index.symbols()[i], by_symbol[i]);
+        }
+    }
+    return report;
+}
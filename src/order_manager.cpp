@@ -0,0 +1,339 @@
+#include "order_manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t bit(OrderState state) { return static_cast<uint8_t>(1u << static_cast<uint8_t>(state)); }
+
+// kAllowed[from] has a bit set for every state `from` may move to
+constexpr uint8_t kAllowed[static_cast<size_t>(OrderState::Count)] = {
+    /* Pending   */ bit(OrderState::Open) | bit(OrderState::Partial) | bit(OrderState::Filled) |
+                        bit(OrderState::Cancelled) | bit(OrderState::Rejected),
+    /* Open      */ bit(OrderState::Partial) | bit(OrderState::Filled) | bit(OrderState::Cancelled),
+    /* Partial   */ bit(OrderState::Partial) | bit(OrderState::Filled) | bit(OrderState::Cancelled),
+    /* Filled    */ 0,
+    /* Cancelled */ 0,
+    /* Rejected  */ 0,
+};
+
+// Still live, but waiting on a modification or cancellation
+bool isTransientStatus(const std::string& status) {
+    return status == "MODIFY PENDING" || status == "MODIFY VALIDATION PENDING" || status == "CANCEL PENDING";
+}
+
+uint32_t roundUpPowerOfTwo(uint64_t value) {
+    uint32_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+} // namespace
+
+OrderManager::OrderManager(LatencyRecorder& latency, uint32_t capacity)
+    : latency_(latency), capacity_(capacity), slots_(new Slot[capacity]), next_(0), live_(0) {
+    uint32_t buckets = roundUpPowerOfTwo(static_cast<uint64_t>(capacity) * 2);
+    index_mask_ = buckets - 1;
+    index_.reset(new std::atomic<uint32_t>[buckets]);
+    reset();
+}
+
+void OrderManager::reset() {
+    for (uint64_t i = 0; i <= index_mask_; ++i) {
+        index_[i].store(0, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < capacity_; ++i) {
+        slots_[i].word.store(pack(OrderState::Pending, 0, 0), std::memory_order_relaxed);
+        slots_[i].cancel_requested_ns.store(0, std::memory_order_relaxed);
+        slots_[i].modify_requested_ns.store(0, std::memory_order_relaxed);
+        slots_[i].broker_order_id[0] = '\0';
+    }
+    live_.store(0, std::memory_order_relaxed);
+    next_.store(0, std::memory_order_release);
+}
+
+int64_t OrderManager::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t OrderManager::hashId(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool OrderManager::isLiveStatus(const std::string& status) {
+    return status == "OPEN" || status == "TRIGGER PENDING" || status == "OPEN PENDING" ||
+           status == "VALIDATION PENDING" || status == "PUT ORDER REQ RECEIVED" || status == "AMO REQ RECEIVED" ||
+           status == "MODIFIED" || isTransientStatus(status);
+}
+
+const char* OrderManager::stateName(OrderState state) {
+    switch (state) {
+        case OrderState::Pending: return "PENDING";
+        case OrderState::Open: return "OPEN";
+        case OrderState::Partial: return "PARTIAL";
+        case OrderState::Filled: return "FILLED";
+        case OrderState::Cancelled: return "CANCELLED";
+        case OrderState::Rejected: return "REJECTED";
+        default: return "UNKNOWN";
+    }
+}
+
+bool OrderManager::canTransition(OrderState from, OrderState to) {
+    if (from >= OrderState::Count || to >= OrderState::Count) return false;
+    return (kAllowed[static_cast<size_t>(from)] & bit(to)) != 0;
+}
+
+uint32_t OrderManager::create(const std::string& symbol, OrderLeg leg, bool buy, int quantity, Price price) {
+    uint32_t id = next_.fetch_add(1, std::memory_order_relaxed);
+    if (id >= capacity_) {
+        next_.store(capacity_, std::memory_order_relaxed);
+        return kNoOrder;
+    }
+    Slot& slot = slots_[id];
+    slot.quantity = quantity;
+    slot.leg = leg;
+    slot.buy = buy;
+    slot.price_paise = price.paise();
+    slot.created_ns = nowNanos();
+    std::memset(slot.symbol, 0, sizeof(slot.symbol));
+    std::memcpy(slot.symbol, symbol.data(), std::min(symbol.size(), sizeof(slot.symbol) - 1));
+    std::memset(slot.broker_order_id, 0, sizeof(slot.broker_order_id));
+    live_.fetch_add(1, std::memory_order_relaxed);
+    // Release so a thread that is handed the id sees the fields above
+    slot.word.store(pack(OrderState::Pending, 0, 0), std::memory_order_release);
+    return id;
+}
+
+bool OrderManager::bindBrokerId(uint32_t id, const std::string& broker_order_id) {
+    if (id >= size() || broker_order_id.empty() || broker_order_id.size() >= sizeof(Slot::broker_order_id) ||
+        slots_[id].broker_order_id[0] != '\0') {
+        return false;
+    }
+    Slot& slot = slots_[id];
+    std::memcpy(slot.broker_order_id, broker_order_id.data(), broker_order_id.size());
+
+    uint64_t bucket = hashId(broker_order_id.data(), broker_order_id.size()) & index_mask_;
+    for (;;) {
+        uint32_t expected = 0;
+        if (index_[bucket].compare_exchange_strong(expected, id + 1, std::memory_order_release,
+                                                   std::memory_order_acquire)) {
+            return true;
+        }
+        if (std::strcmp(slots_[expected - 1].broker_order_id, slot.broker_order_id) == 0) {
+            return false; // already bound to another order
+        }
+        bucket = (bucket + 1) & index_mask_;
+    }
+}
+
+uint32_t OrderManager::find(const std::string& broker_order_id) const {
+    uint64_t bucket = hashId(broker_order_id.data(), broker_order_id.size()) & index_mask_;
+    for (;;) {
+        uint32_t entry = index_[bucket].load(std::memory_order_acquire);
+        if (entry == 0) {
+            return kNoOrder;
+        }
+        const char* bound = slots_[entry - 1].broker_order_id;
+        if (std::strncmp(bound, broker_order_id.c_str(), sizeof(Slot::broker_order_id)) == 0) {
+            return entry - 1;
+        }
+        bucket = (bucket + 1) & index_mask_;
+    }
+}
+
+uint32_t OrderManager::size() const {
+    uint32_t next = next_.load(std::memory_order_acquire);
+    return next < capacity_ ? next : capacity_;
+}
+
+bool OrderManager::transition(uint32_t id, OrderState to, uint32_t filled, uint64_t& previous) {
+    if (id >= size()) {
+        return false;
+    }
+    std::atomic<uint64_t>& word = slots_[id].word;
+    uint64_t current = word.load(std::memory_order_acquire);
+    for (;;) {
+        OrderState from = stateOf(current);
+        if (!canTransition(from, to)) {
+            return false;
+        }
+        bool fill = to == OrderState::Partial || to == OrderState::Filled;
+        if (fill && filled <= filledOf(current)) {
+            return false; // stale or duplicate fill report
+        }
+        uint64_t flags = isTerminal(to) ? 0 : flagsOf(current);
+        uint64_t next = pack(to, flags, fill ? filled : filledOf(current));
+        if (word.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            previous = current;
+            return true;
+        }
+    }
+}
+
+void OrderManager::finished(uint32_t id, OrderState from, OrderState to) {
+    if (!isTerminal(to) || isTerminal(from)) {
+        return;
+    }
+    live_.fetch_sub(1, std::memory_order_relaxed);
+
+    Slot& slot = slots_[id];
+    int64_t now = nowNanos();
+    if (to == OrderState::Filled) {
+        latency_.record(LatencyStage::OrderFillSeen, static_cast<uint64_t>(now - slot.created_ns));
+    } else if (to == OrderState::Cancelled) {
+        int64_t requested = slot.cancel_requested_ns.load(std::memory_order_relaxed);
+        if (requested != 0) {
+            latency_.record(LatencyStage::OrderCancel, static_cast<uint64_t>(now - requested));
+        }
+    }
+}
+
+bool OrderManager::acknowledge(uint32_t id) {
+    uint64_t previous;
+    return transition(id, OrderState::Open, 0, previous);
+}
+
+bool OrderManager::reject(uint32_t id) {
+    uint64_t previous;
+    if (!transition(id, OrderState::Rejected, 0, previous)) {
+        return false;
+    }
+    finished(id, stateOf(previous), OrderState::Rejected);
+    return true;
+}
+
+bool OrderManager::fill(uint32_t id, int filled_quantity) {
+    if (id >= size() || filled_quantity <= 0) {
+        return false;
+    }
+    uint32_t filled = static_cast<uint32_t>(filled_quantity);
+    OrderState to = filled_quantity >= slots_[id].quantity ? OrderState::Filled : OrderState::Partial;
+    uint64_t previous;
+    if (!transition(id, to, filled, previous)) {
+        return false;
+    }
+    finished(id, stateOf(previous), to);
+    return true;
+}
+
+bool OrderManager::setFlag(uint32_t id, uint64_t flag, std::atomic<int64_t> Slot::*stamp) {
+    if (id >= size()) {
+        return false;
+    }
+    Slot& slot = slots_[id];
+    // Stamped first; a response that beats the flag still finds the request time
+    (slot.*stamp).store(nowNanos(), std::memory_order_relaxed);
+    uint64_t current = slot.word.load(std::memory_order_acquire);
+    for (;;) {
+        if (isTerminal(stateOf(current)) || (flagsOf(current) & flag)) {
+            return false;
+        }
+        uint64_t next = pack(stateOf(current), flagsOf(current) | flag, filledOf(current));
+        if (slot.word.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return true;
+        }
+    }
+}
+
+bool OrderManager::requestCancel(uint32_t id) {
+    return setFlag(id, kCancelRequested, &Slot::cancel_requested_ns);
+}
+
+bool OrderManager::requestModify(uint32_t id) {
+    return setFlag(id, kModifyPending, &Slot::modify_requested_ns);
+}
+
+bool OrderManager::cancelled(uint32_t id) {
+    uint64_t previous;
+    if (!transition(id, OrderState::Cancelled, 0, previous)) {
+        return false;
+    }
+    finished(id, stateOf(previous), OrderState::Cancelled);
+    return true;
+}
+
+bool OrderManager::modified(uint32_t id) {
+    if (id >= size()) {
+        return false;
+    }
+    Slot& slot = slots_[id];
+    uint64_t current = slot.word.load(std::memory_order_acquire);
+    for (;;) {
+        if (!(flagsOf(current) & kModifyPending)) {
+            return false;
+        }
+        uint64_t next = pack(stateOf(current), flagsOf(current) & ~kModifyPending, filledOf(current));
+        if (slot.word.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    int64_t requested = slot.modify_requested_ns.load(std::memory_order_relaxed);
+    latency_.record(LatencyStage::OrderModify, static_cast<uint64_t>(nowNanos() - requested));
+    return true;
+}
+
+bool OrderManager::applyBrokerStatus(const std::string& broker_order_id, const std::string& status,
+                                     int filled_quantity) {
+    uint32_t id = find(broker_order_id);
+    if (id == kNoOrder) {
+        return false;
+    }
+    if (status == "COMPLETE") {
+        return fill(id, filled_quantity > 0 ? filled_quantity : slots_[id].quantity);
+    }
+    if (status == "REJECTED") {
+        return reject(id);
+    }
+    if (status == "CANCELLED") {
+        if (filled_quantity > 0) {
+            fill(id, filled_quantity);
+        }
+        return cancelled(id);
+    }
+    if (isTransientStatus(status)) {
+        return false; // the outcome arrives as a later status
+    }
+    if (isLiveStatus(status)) {
+        bool changed = filled_quantity > 0 ? fill(id, filled_quantity) : acknowledge(id);
+        // Back to a plain live status means a pending modification went through
+        if (flagsOf(slots_[id].word.load(std::memory_order_acquire)) & kModifyPending) {
+            changed = modified(id) || changed;
+        }
+        return changed;
+    }
+    return false;
+}
+
+OrderState OrderManager::state(uint32_t id) const {
+    return id < size() ? stateOf(slots_[id].word.load(std::memory_order_acquire)) : OrderState::Count;
+}
+
+int OrderManager::filledQuantity(uint32_t id) const {
+    return id < size() ? static_cast<int>(filledOf(slots_[id].word.load(std::memory_order_acquire))) : 0;
+}
+
+bool OrderManager::view(uint32_t id, OrderView& out) const {
+    if (id >= size()) {
+        return false;
+    }
+    const Slot& slot = slots_[id];
+    uint64_t word = slot.word.load(std::memory_order_acquire);
+    out.id = id;
+    out.state = stateOf(word);
+    out.cancel_requested = (flagsOf(word) & kCancelRequested) != 0;
+    out.modify_pending = (flagsOf(word) & kModifyPending) != 0;
+    out.filled_quantity = static_cast<int>(filledOf(word));
+    out.leg = slot.leg;
+    out.buy = slot.buy;
+    out.quantity = slot.quantity;
+    out.price = Price::fromPaise(slot.price_paise);
+    out.symbol = slot.symbol;
+    out.broker_order_id = std::string(slot.broker_order_id, strnlen(slot.broker_order_id, sizeof(slot.broker_order_id)));
+    return true;
+}
@@ -0,0 +1,104 @@
+#include "order_log.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printHeader(const char* label) {
+    std::cout << std::left << std::setw(14) << label << std::right
+              << std::setw(8) << "Trades" << std::setw(8) << "Win%"
+              << std::setw(14) << "P&L" << std::setw(14) << "Profit" << std::setw(14) << "Loss"
+              << std::setw(10) << "Avg hold" << '\n';
+}
+
+void printRow(const std::string& label, const TradeStats& stats) {
+    int64_t hold = static_cast<int64_t>(stats.averageHoldingSeconds() + 0.5);
+    char hold_buf[32];
+    std::snprintf(hold_buf, sizeof(hold_buf), "%lld:%02lld:%02lld", static_cast<long long>(hold / 3600),
+                  static_cast<long long>(hold / 60 % 60), static_cast<long long>(hold % 60));
+    std::cout << std::left << std::setw(14) << label << std::right
+              << std::setw(8) << stats.trades
+              << std::setw(8) << std::fixed << std::setprecision(1) << stats.winRate() * 100.0
+              << std::setw(14) << Price::fromPaise(stats.pnl_paise).toString()
+              << std::setw(14) << Price::fromPaise(stats.gross_profit_paise).toString()
+              << std::setw(14) << Price::fromPaise(stats.gross_loss_paise).toString()
+              << std::setw(10) << hold_buf << '\n';
+}
+
+} // namespace
+
+// Usage: ZerodhaOrderStats <OrderLog.txt>... [--from yyyy-mm-dd] [--to yyyy-mm-dd] [--rebuild]
+// Pairs each entry in the order logs with its stop-loss or target exit and
+// prints P&L, win rate and average holding time per day and per symbol.
+// Each log is indexed into "<log>.idx" on first use; later runs only parse
+// lines appended since (--rebuild re-parses everything).
+int main(int argc, char* argv[]) {
+    std::vector<std::string> paths;
+    int64_t from_day = INT64_MIN;
+    int64_t to_day = INT64_MAX;
+    bool rebuild = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            if (!parseOrderLogDay(argv[++i], arg == "--from" ? from_day : to_day)) {
+                std::cerr << "Invalid date (expected yyyy-mm-dd): " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--rebuild") {
+            rebuild = true;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <OrderLog.txt>... [--from yyyy-mm-dd] [--to yyyy-mm-dd] [--rebuild]" << std::endl;
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    OrderLogIndex index;
+    size_t parsed_lines = 0;
+    for (const auto& path : paths) {
+        if (!index.add(path, rebuild)) {
+            return 1;
+        }
+        parsed_lines += index.parsedLines();
+    }
+    auto indexed = std::chrono::steady_clock::now();
+    OrderLogReport report = analyzeOrderLog(index, from_day, to_day);
+    auto analyzed = std::chrono::steady_clock::now();
+
+    std::cout << "By day\n";
+    printHeader("Day");
+    for (const auto& day : report.by_day) {
+        printRow(formatOrderLogDay(day.first), day.second);
+    }
+    std::cout << "\nBy symbol\n";
+    printHeader("Symbol");
+    for (const auto& symbol : report.by_symbol) {
+        printRow(symbol.first, symbol.second);
+    }
+    std::cout << '\n';
+    printRow("Total", report.total);
+
+    double index_seconds = std::chrono::duration<double>(indexed - started).count();
+    double analyze_seconds = std::chrono::duration<double>(analyzed - indexed).count();
+    size_t records = index.entries().size();
+    std::cout << "\n" << records << " records (" << parsed_lines << " lines parsed) in "
+              << std::setprecision(3) << index_seconds * 1000.0 << " ms, analyzed in "
+              << analyze_seconds * 1000.0 << " ms";
+    if (analyze_seconds > 0.0) {
+        std::cout << " (" << std::setprecision(1) << records / analyze_seconds / 1e6 << "M records/s)";
+    }
+    std::cout << '\n';
+    if (report.open_entries > 0 || report.unmatched_exits > 0) {
+        std::cout << report.open_entries << " entries still open, "
+                  << report.unmatched_exits << " exits without a matching entry\n";
+    }
+    return 0;
+}
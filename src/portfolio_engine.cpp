@@ -0,0 +1,93 @@
+#include "portfolio_engine.h"
+#include <algorithm>
+#include <cstdlib>
+
+PortfolioEngine::PortfolioEngine() : batch_depth_(0) {}
+
+uint32_t PortfolioEngine::registerSymbol(const std::string& symbol) {
+    auto it = slots_.find(symbol);
+    if (it != slots_.end()) {
+        return it->second;
+    }
+    uint32_t slot = static_cast<uint32_t>(positions_.size());
+    positions_.emplace_back();
+    slots_.emplace(symbol, slot);
+    return slot;
+}
+
+uint32_t PortfolioEngine::find(const std::string& symbol) const {
+    auto it = slots_.find(symbol);
+    return it == slots_.end() ? kNoSlot : it->second;
+}
+
+void PortfolioEngine::contribute(const Position& position, int64_t sign) {
+    int64_t net = position.quantity * position.mark_paise;
+    totals_.gross_exposure_paise += sign * std::llabs(net);
+    totals_.net_exposure_paise += sign * net;
+    totals_.unrealized_pnl_paise += sign * position.unrealizedPaise();
+    totals_.open_positions += sign * (position.quantity != 0 ? 1 : 0);
+}
+
+void PortfolioEngine::publish() {
+    ++totals_.updates;
+    if (batch_depth_ == 0) {
+        published_.store(totals_);
+    }
+}
+
+void PortfolioEngine::endBatch() {
+    if (batch_depth_ > 0 && --batch_depth_ == 0) {
+        published_.store(totals_);
+    }
+}
+
+int64_t PortfolioEngine::onFill(uint32_t slot, bool buy, int quantity, Price price) {
+    if (slot >= positions_.size() || quantity <= 0) {
+        return 0;
+    }
+    Position& position = positions_[slot];
+    contribute(position, -1);
+
+    int64_t realized = 0;
+    int64_t signed_quantity = buy ? quantity : -quantity;
+    int64_t paise = price.paise();
+    if (position.quantity == 0 || (position.quantity > 0) == buy) {
+        // Opening or adding: volume-weighted average entry
+        int64_t held = std::llabs(position.quantity);
+        position.average_paise = (held * position.average_paise + quantity * paise) / (held + quantity);
+        position.quantity += signed_quantity;
+    } else {
+        // Reducing: the closed part is realized at this price
+        int64_t closed = std::min<int64_t>(std::llabs(position.quantity), quantity);
+        int64_t direction = position.quantity > 0 ? 1 : -1;
+        realized = closed * (paise - position.average_paise) * direction;
+        position.quantity += signed_quantity;
+        if (position.quantity == 0) {
+            position.average_paise = 0;
+        } else if ((position.quantity > 0) != (direction > 0)) {
+            position.average_paise = paise; // flipped: the remainder opened here
+        }
+    }
+    position.mark_paise = paise;
+    position.realized_paise += realized;
+    totals_.realized_pnl_paise += realized;
+
+    contribute(position, 1);
+    publish();
+    return realized;
+}
+
+void PortfolioEngine::onMark(uint32_t slot, Price price) {
+    if (slot >= positions_.size() || price <= Price()) {
+        return;
+    }
+    Position& position = positions_[slot];
+    if (position.quantity == 0) {
+        position.mark_paise = price.paise(); // flat positions add nothing
+        return;
+    }
+    contribute(position, -1);
+    position.mark_paise = price.paise();
+    contribute(position, 1);
+    publish();
+}
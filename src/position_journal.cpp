@@ -0,0 +1,316 @@
+#include "position_journal.h"
+#include "mapped_file.h"
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+int openFile(const std::string& path, bool truncate) {
+    int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND);
+    return _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+}
+bool writeAll(int fd, const void* data, size_t size) {
+    return _write(fd, data, static_cast<unsigned int>(size)) == static_cast<int>(size);
+}
+void syncFile(int fd) { _commit(fd); }
+void closeFile(int fd) { _close(fd); }
+#else
+int openFile(const std::string& path, bool truncate) {
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND);
+    return ::open(path.c_str(), flags, 0644);
+}
+bool writeAll(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+void syncFile(int fd) {
+#ifdef __linux__
+    fdatasync(fd);
+#else
+    fsync(fd);
+#endif
+}
+void closeFile(int fd) { ::close(fd); }
+#endif
+
+void copyField(char* field, size_t capacity, const std::string& value) {
+    std::memset(field, 0, capacity);
+    std::memcpy(field, value.data(), value.size() < capacity ? value.size() : capacity - 1);
+}
+
+std::string readField(const char* field, size_t capacity) {
+    return std::string(field, strnlen(field, capacity));
+}
+
+PositionJournal::Record makeRecord(PositionJournal::Event event, const std::string& symbol,
+                                   const std::string& order_id, int64_t timestamp_ms) {
+    PositionJournal::Record record;
+    std::memset(&record, 0, sizeof(record));
+    record.event = static_cast<uint8_t>(event);
+    record.timestamp_ms = timestamp_ms;
+    copyField(record.symbol, sizeof(record.symbol), symbol);
+    copyField(record.order_id, sizeof(record.order_id), order_id);
+    return record;
+}
+
+PositionJournal::Record openedRecord(const ActivePosition& position, int64_t timestamp_ms) {
+    PositionJournal::Record record =
+        makeRecord(PositionJournal::Event::Opened, position.symbol, position.entry_order_id, timestamp_ms);
+    record.side = position.action == "SELL" ? 1 : 0;
+    record.entry_paise = position.entry_price.paise();
+    record.stop_loss_paise = position.stop_loss.paise();
+    record.target_paise = position.target.paise();
+    record.quantity = position.quantity;
+    return record;
+}
+
+void seal(PositionJournal::Record& record) {
+    record.crc = PositionJournal::crc32(reinterpret_cast<const char*>(&record) + sizeof(record.crc),
+                                        sizeof(record) - sizeof(record.crc));
+}
+
+} // namespace
+
+uint32_t PositionJournal::crc32(const void* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> entries{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+PositionJournal::PositionJournal(std::chrono::milliseconds sync_interval)
+    : sync_interval_(sync_interval), fd_(-1), sequence_(0), dirty_(false), stopping_(false),
+      replayed_(0), discarded_(0) {}
+
+PositionJournal::~PositionJournal() {
+    close();
+}
+
+size_t PositionJournal::replay(const uint8_t* data, size_t size, std::map<std::string, ActivePosition>& positions,
+                               size_t& records) {
+    records = 0;
+    size_t offset = 0;
+    for (; offset + sizeof(Record) <= size; offset += sizeof(Record)) {
+        Record record;
+        std::memcpy(&record, data + offset, sizeof(record));
+        uint32_t crc = crc32(data + offset + sizeof(record.crc), sizeof(record) - sizeof(record.crc));
+        if (crc != record.crc || record.event < static_cast<uint8_t>(Event::Opened) ||
+            record.event > static_cast<uint8_t>(Event::Closed)) {
+            break; // torn write at the tail, or garbage: everything after it is untrusted
+        }
+        ++records;
+
+        std::string symbol = readField(record.symbol, sizeof(record.symbol));
+        std::string order_id = readField(record.order_id, sizeof(record.order_id));
+        switch (static_cast<Event>(record.event)) {
+            case Event::Opened: {
+                ActivePosition position;
+                position.symbol = symbol;
+                position.entry_order_id = order_id;
+                position.action = record.side ? "SELL" : "BUY";
+                position.entry_price = Price::fromPaise(record.entry_paise);
+                position.stop_loss = Price::fromPaise(record.stop_loss_paise);
+                position.target = Price::fromPaise(record.target_paise);
+                position.quantity = record.quantity;
+                positions[symbol] = position;
+                break;
+            }
+            case Event::StopLossPlaced: {
+                auto it = positions.find(symbol);
+                if (it != positions.end()) {
+                    it->second.stop_loss_placed = true;
+                    it->second.stop_loss_order_id = order_id;
+                }
+                break;
+            }
+            case Event::TargetPlaced: {
+                auto it = positions.find(symbol);
+                if (it != positions.end()) {
+                    it->second.target_placed = true;
+                    it->second.target_order_id = order_id;
+                }
+                break;
+            }
+            case Event::Closed:
+                positions.erase(symbol);
+                break;
+        }
+    }
+    return offset;
+}
+
+bool PositionJournal::writeRecords(int fd, const std::map<std::string, ActivePosition>& positions) {
+    for (const auto& entry : positions) {
+        const ActivePosition& position = entry.second;
+        Record record = openedRecord(position, 0);
+        record.sequence = ++sequence_;
+        seal(record);
+        if (!writeAll(fd, &record, sizeof(record))) return false;
+
+        if (position.stop_loss_placed) {
+            record = makeRecord(Event::StopLossPlaced, position.symbol, position.stop_loss_order_id, 0);
+            record.sequence = ++sequence_;
+            seal(record);
+            if (!writeAll(fd, &record, sizeof(record))) return false;
+        }
+        if (position.target_placed) {
+            record = makeRecord(Event::TargetPlaced, position.symbol, position.target_order_id, 0);
+            record.sequence = ++sequence_;
+            seal(record);
+            if (!writeAll(fd, &record, sizeof(record))) return false;
+        }
+    }
+    return true;
+}
+
+bool PositionJournal::open(const std::string& path, std::map<std::string, ActivePosition>& positions) {
+    close();
+
+    // Recovery is one sequential pass over a mapped file of 128-byte records
+    replayed_ = 0;
+    discarded_ = 0;
+    {
+        MappedFile file;
+        if (file.open(path)) {
+            size_t valid = replay(file.data(), file.size(), positions, replayed_);
+            discarded_ = file.size() - valid;
+        }
+    }
+    if (discarded_ > 0) {
+        std::cerr << "Warning: " << path << ": ignored " << discarded_ << " bytes after the last valid record" << std::endl;
+    }
+
+    // Compact: rewrite only the open positions, then swap the new file in
+    std::string temp_path = path + ".tmp";
+    int temp = openFile(temp_path, true);
+    if (temp < 0) {
+        std::cerr << "Error: Could not create " << temp_path << std::endl;
+        return false;
+    }
+    sequence_ = 0;
+    bool written = writeRecords(temp, positions);
+    syncFile(temp);
+    closeFile(temp);
+    if (!written || !replaceFile(temp_path, path)) {
+        std::cerr << "Error: Could not rewrite position journal " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    int fd = openFile(path, false);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open position journal " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    fd_ = fd;
+    dirty_ = false;
+    stopping_ = false;
+    sync_thread_ = std::thread(&PositionJournal::syncLoop, this);
+    return true;
+}
+
+void PositionJournal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (sync_thread_.joinable()) {
+        sync_thread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        syncFile(fd_);
+        closeFile(fd_);
+        fd_ = -1;
+    }
+}
+
+bool PositionJournal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ >= 0;
+}
+
+void PositionJournal::append(Record& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return;
+    }
+    record.sequence = ++sequence_;
+    seal(record);
+    if (!writeAll(fd_, &record, sizeof(record))) {
+        std::cerr << "Error: Position journal write failed" << std::endl;
+        return;
+    }
+    dirty_ = true;
+}
+
+void PositionJournal::syncLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        cv_.wait_for(lock, sync_interval_);
+        if (dirty_ && fd_ >= 0) {
+            // Writers keep appending while the disk flush runs
+            int fd = fd_;
+            dirty_ = false;
+            lock.unlock();
+            syncFile(fd);
+            lock.lock();
+        }
+    }
+}
+
+void PositionJournal::opened(const ActivePosition& position, int64_t timestamp_ms) {
+    Record record = openedRecord(position, timestamp_ms);
+    append(record);
+}
+
+void PositionJournal::stopLossPlaced(const std::string& symbol, const std::string& order_id, int64_t timestamp_ms) {
+    Record record = makeRecord(Event::StopLossPlaced, symbol, order_id, timestamp_ms);
+    append(record);
+}
+
+void PositionJournal::targetPlaced(const std::string& symbol, const std::string& order_id, int64_t timestamp_ms) {
+    Record record = makeRecord(Event::TargetPlaced, symbol, order_id, timestamp_ms);
+    append(record);
+}
+
+void PositionJournal::closed(const std::string& symbol, int64_t timestamp_ms) {
+    Record record = makeRecord(Event::Closed, symbol, std::string(), timestamp_ms);
+    append(record);
+}
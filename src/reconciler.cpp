@@ -0,0 +1,235 @@
+#include "reconciler.h"
+#include "log.h"
+#include "order_manager.h"
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace {
+
+const char* kStopLossTag = "TradingBot_SL";
+const char* kTargetTag = "TradingBot_TARGET";
+
+bool isDead(const std::string& status) {
+    return status == "REJECTED" || status == "CANCELLED";
+}
+
+Discrepancy::Leg legForTag(const std::string& tag) {
+    if (tag == kStopLossTag) return Discrepancy::Leg::StopLoss;
+    if (tag == kTargetTag) return Discrepancy::Leg::Target;
+    return Discrepancy::Leg::None;
+}
+
+// Below-normal scheduling for the calling thread; best effort
+void lowerThreadPriority() {
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    // Linux applies nice values per thread
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+}
+
+} // namespace
+
+const char* Discrepancy::kindName(Kind kind) {
+    switch (kind) {
+        case Kind::MissedFill: return "missed_fill";
+        case Kind::OrphanLeg: return "orphan_leg";
+        case Kind::UntrackedLeg: return "untracked_leg";
+        case Kind::LostLeg: return "lost_leg";
+        case Kind::EntryNotFilled: return "entry_not_filled";
+        case Kind::QuantityMismatch: return "quantity_mismatch";
+        case Kind::UntrackedPosition: return "untracked_position";
+        default: return "unknown";
+    }
+}
+
+const char* Discrepancy::legName(Leg leg) {
+    switch (leg) {
+        case Leg::Entry: return "entry";
+        case Leg::StopLoss: return "stoploss";
+        case Leg::Target: return "target";
+        default: return "none";
+    }
+}
+
+std::vector<Discrepancy> Reconciler::diff(const std::vector<ActivePosition>& local,
+                                          const std::vector<BrokerOrder>& orders,
+                                          const std::vector<BrokerPosition>& broker_positions) {
+    std::vector<Discrepancy> found;
+
+    std::unordered_map<std::string, const ActivePosition*> local_by_symbol;
+    std::unordered_set<std::string> known_ids;
+    local_by_symbol.reserve(local.size());
+    known_ids.reserve(local.size() * 3);
+    for (const auto& position : local) {
+        local_by_symbol[position.symbol] = &position;
+        known_ids.insert(position.entry_order_id);
+        if (position.stop_loss_placed) known_ids.insert(position.stop_loss_order_id);
+        if (position.target_placed) known_ids.insert(position.target_order_id);
+    }
+
+    // Order book: index by id, and classify live exit legs the bot did not record
+    std::unordered_map<std::string, const BrokerOrder*> by_id;
+    by_id.reserve(orders.size());
+    for (const auto& order : orders) {
+        by_id[order.order_id] = &order;
+
+        Discrepancy::Leg leg = legForTag(order.tag);
+        if (leg == Discrepancy::Leg::None || !OrderManager::isLiveStatus(order.status) || known_ids.count(order.order_id)) {
+            continue;
+        }
+        auto it = local_by_symbol.find(order.symbol);
+        bool recorded = it != local_by_symbol.end() &&
+                        (leg == Discrepancy::Leg::StopLoss ? it->second->stop_loss_placed : it->second->target_placed);
+        Discrepancy::Kind kind = it == local_by_symbol.end() || recorded ? Discrepancy::Kind::OrphanLeg
+                                                                        : Discrepancy::Kind::UntrackedLeg;
+        found.emplace_back(kind, leg, order.symbol, order.order_id);
+    }
+
+    std::unordered_map<std::string, int> broker_quantity;
+    broker_quantity.reserve(broker_positions.size());
+    for (const auto& position : broker_positions) {
+        if (position.product == "MIS") {
+            broker_quantity[position.symbol] += position.quantity;
+        }
+    }
+
+    auto status = [&by_id](const std::string& order_id) -> const std::string* {
+        auto it = by_id.find(order_id);
+        return it == by_id.end() ? nullptr : &it->second->status;
+    };
+
+    for (const auto& position : local) {
+        const std::string* entry = status(position.entry_order_id);
+        if (!entry || isDead(*entry)) {
+            found.emplace_back(Discrepancy::Kind::EntryNotFilled, Discrepancy::Leg::Entry, position.symbol,
+                               position.entry_order_id);
+            continue;
+        }
+        if (*entry != "COMPLETE") {
+            continue; // entry still working; nothing to compare yet
+        }
+
+        bool exited = false;
+        const std::pair<bool, Discrepancy::Leg> legs[] = {{position.stop_loss_placed, Discrepancy::Leg::StopLoss},
+                                                          {position.target_placed, Discrepancy::Leg::Target}};
+        for (const auto& leg : legs) {
+            if (!leg.first) continue;
+            const std::string& order_id =
+                leg.second == Discrepancy::Leg::StopLoss ? position.stop_loss_order_id : position.target_order_id;
+            const std::string* leg_status = status(order_id);
+            if (leg_status && *leg_status == "COMPLETE") {
+                found.emplace_back(Discrepancy::Kind::MissedFill, leg.second, position.symbol, order_id);
+                exited = true;
+            } else if (!leg_status || isDead(*leg_status)) {
+                found.emplace_back(Discrepancy::Kind::LostLeg, leg.second, position.symbol, order_id);
+            }
+        }
+        if (exited) {
+            continue;
+        }
+
+        int expected = position.action == "SELL" ? -position.quantity : position.quantity;
+        auto held = broker_quantity.find(position.symbol);
+        int actual = held == broker_quantity.end() ? 0 : held->second;
+        if (actual != expected) {
+            Discrepancy discrepancy(actual == 0 ? Discrepancy::Kind::MissedFill : Discrepancy::Kind::QuantityMismatch,
+                                    Discrepancy::Leg::None, position.symbol, std::string());
+            discrepancy.expected_quantity = expected;
+            discrepancy.broker_quantity = actual;
+            found.push_back(discrepancy);
+        }
+    }
+
+    for (const auto& held : broker_quantity) {
+        if (held.second != 0 && !local_by_symbol.count(held.first)) {
+            Discrepancy discrepancy(Discrepancy::Kind::UntrackedPosition, Discrepancy::Leg::None, held.first,
+                                    std::string());
+            discrepancy.broker_quantity = held.second;
+            found.push_back(discrepancy);
+        }
+    }
+    return found;
+}
+
+Reconciler::Reconciler(Fetcher fetcher, std::chrono::milliseconds interval)
+    : fetcher_(std::move(fetcher)), interval_(interval), sequence_(0), stopping_(false) {}
+
+Reconciler::~Reconciler() {
+    stop();
+}
+
+void Reconciler::publishLocal(uint64_t version, std::vector<ActivePosition> positions) {
+    auto local = std::make_shared<LocalPositions>();
+    local->version = version;
+    local->positions = std::move(positions);
+    std::atomic_store(&local_, std::shared_ptr<const LocalPositions>(std::move(local)));
+}
+
+bool Reconciler::start() {
+    if (thread_.joinable()) {
+        return true;
+    }
+    stopping_ = false;
+    thread_ = std::thread(&Reconciler::run, this);
+    return true;
+}
+
+void Reconciler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void Reconciler::run() {
+    lowerThreadPriority();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval_, [this] { return stopping_; })) {
+        lock.unlock();
+        reconcileOnce();
+        lock.lock();
+    }
+}
+
+void Reconciler::reconcileOnce() {
+    // Taken before the fetch, so every order the view knows about is already in the book
+    std::shared_ptr<const LocalPositions> local = std::atomic_load(&local_);
+    if (!local) {
+        return; // nothing published yet
+    }
+
+    std::vector<BrokerOrder> orders;
+    std::vector<BrokerPosition> positions;
+    if (!fetcher_(orders, positions)) {
+        LOG_WARN("Reconciliation skipped: broker books unavailable");
+        return;
+    }
+
+    auto report = std::make_shared<ReconcileReport>();
+    report->sequence = sequence_.load(std::memory_order_relaxed) + 1;
+    report->local_version = local->version;
+    report->orders = orders.size();
+    report->positions = positions.size();
+    report->discrepancies = diff(local->positions, orders, positions);
+
+    uint64_t sequence = report->sequence;
+    std::atomic_store(&report_, std::shared_ptr<const ReconcileReport>(std::move(report)));
+    sequence_.store(sequence, std::memory_order_release);
+}
@@ -0,0 +1,74 @@
+#include "risk_gate.h"
+#include <cstdlib>
+
+RiskGate::RiskGate(const PortfolioEngine& portfolio, const RiskLimits& limits)
+    : portfolio_(portfolio), day_start_pnl_paise_(0), next_order_(0) {
+    setLimits(limits);
+}
+
+void RiskGate::setLimits(const RiskLimits& limits) {
+    limits_ = limits;
+    order_times_.assign(limits.max_orders_per_second > 0 ? static_cast<size_t>(limits.max_orders_per_second) : 0, 0);
+    next_order_ = 0;
+}
+
+const char* RiskGate::verdictName(RiskVerdict verdict) {
+    switch (verdict) {
+        case RiskVerdict::Accept: return "accept";
+        case RiskVerdict::GrossExposure: return "gross_exposure";
+        case RiskVerdict::NetExposure: return "net_exposure";
+        case RiskVerdict::DailyLoss: return "daily_loss";
+        case RiskVerdict::OrderRate: return "order_rate";
+        case RiskVerdict::SymbolQuantity: return "symbol_quantity";
+        default: return "unknown";
+    }
+}
+
+RiskVerdict RiskGate::check(uint32_t slot, bool buy, int quantity, Price price, int64_t now_ms) const {
+    if (!order_times_.empty()) {
+        int64_t oldest = order_times_[next_order_];
+        if (oldest != 0 && now_ms - oldest < 1000) {
+            return RiskVerdict::OrderRate;
+        }
+    }
+
+    PortfolioEngine::Position current = portfolio_.position(slot);
+    int64_t after = current.quantity + (buy ? quantity : -quantity);
+    if (std::llabs(after) <= std::llabs(current.quantity)) {
+        return RiskVerdict::Accept; // reduces or flips no further than the current size
+    }
+
+    if (limits_.max_symbol_quantity > 0 && std::llabs(after) > limits_.max_symbol_quantity) {
+        return RiskVerdict::SymbolQuantity;
+    }
+    PortfolioTotals totals = portfolio_.snapshot();
+    if (limits_.max_daily_loss > Price() &&
+        totals.pnlPaise() - day_start_pnl_paise_ <= -limits_.max_daily_loss.paise()) {
+        return RiskVerdict::DailyLoss;
+    }
+
+    // The symbol's share re-marked at the order price
+    int64_t old_net = current.quantity * current.mark_paise;
+    int64_t new_net = after * price.paise();
+    if (limits_.max_gross_exposure > Price() &&
+        totals.gross_exposure_paise - std::llabs(old_net) + std::llabs(new_net) > limits_.max_gross_exposure.paise()) {
+        return RiskVerdict::GrossExposure;
+    }
+    if (limits_.max_net_exposure > Price() &&
+        std::llabs(totals.net_exposure_paise - old_net + new_net) > limits_.max_net_exposure.paise()) {
+        return RiskVerdict::NetExposure;
+    }
+    return RiskVerdict::Accept;
+}
+
+void RiskGate::startDay(int64_t booked_today_paise) {
+    day_start_pnl_paise_ = portfolio_.snapshot().pnlPaise() - booked_today_paise;
+}
+
+void RiskGate::onOrderSent(int64_t now_ms) {
+    if (order_times_.empty()) {
+        return;
+    }
+    order_times_[next_order_] = now_ms;
+    next_order_ = next_order_ + 1 == order_times_.size() ? 0 : next_order_ + 1;
+}
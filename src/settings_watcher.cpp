@@ -0,0 +1,93 @@
+#include "settings_watcher.h"
+#include "log.h"
+#include <filesystem>
+#include <iostream>
+
+SettingsWatcher::SettingsWatcher(const std::string& path, Parser parser, std::chrono::milliseconds interval)
+    : path_(path), parser_(std::move(parser)), interval_(interval),
+      snapshot_(std::make_shared<SettingsSnapshot>()), version_(0), stopping_(false) {}
+
+SettingsWatcher::~SettingsWatcher() {
+    stop();
+}
+
+void SettingsWatcher::publish(std::vector<TradeSetting> settings) {
+    auto snapshot = std::make_shared<SettingsSnapshot>();
+    snapshot->version = version_.load(std::memory_order_relaxed) + 1;
+    snapshot->settings = std::move(settings);
+
+    // Snapshot first, then the version readers poll, so a new version always has its data
+    uint64_t version = snapshot->version;
+    std::atomic_store(&snapshot_, std::shared_ptr<const SettingsSnapshot>(std::move(snapshot)));
+    version_.store(version, std::memory_order_release);
+}
+
+bool SettingsWatcher::readStamp(FileStamp& stamp) const {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path_, ec);
+    if (ec) return false;
+    uint64_t size = std::filesystem::file_size(path_, ec);
+    if (ec) return false;
+
+    stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    stamp.size = size;
+    return true;
+}
+
+bool SettingsWatcher::start() {
+    if (thread_.joinable()) {
+        return true;
+    }
+    // Baseline taken here so an edit made right after start() is not mistaken for it
+    FileStamp baseline;
+    if (!readStamp(baseline)) {
+        std::cerr << "Error: Cannot watch trade settings file: " << path_ << std::endl;
+        return false;
+    }
+    stopping_ = false;
+    thread_ = std::thread(&SettingsWatcher::watchLoop, this, baseline);
+    return true;
+}
+
+void SettingsWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SettingsWatcher::watchLoop(FileStamp applied) {
+    FileStamp pending = applied;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval_, [this] { return stopping_; })) {
+        FileStamp stamp;
+        if (!readStamp(stamp) || stamp == applied) {
+            pending = applied;
+            continue;
+        }
+        // Wait for the file to settle before parsing it
+        if (stamp != pending) {
+            pending = stamp;
+            continue;
+        }
+
+        lock.unlock();
+        std::vector<TradeSetting> settings;
+        bool parsed = parser_(path_, settings);
+        lock.lock();
+
+        applied = stamp;
+        if (!parsed || settings.empty()) {
+            LOG_WARN("Ignoring unreadable {}; keeping the current settings", path_);
+            continue;
+        }
+        size_t count = settings.size();
+        publish(std::move(settings));
+        LOG_INFO("Reloaded {} ({} settings, version {})", path_, count, version());
+    }
+}
@@ -0,0 +1,166 @@
+#include "zerodha_client.h"
+#include "exchange_simulator.h"
+#include "http_server.h"
+#include "candle_store.h"
+#include "backtest.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> g_stop{false};
+
+void onSignal(int) {
+    g_stop = true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--port N] [--bind ADDR] [--workers N]\n"
+              << "       [--store-dir DIR] [--timeframe TF] [--symbol SYM]... [--csv SYM=FILE]...\n"
+              << "       [--instruments FILE] [--api-secret S]\n"
+              << "       [--start yyyy-mm-ddThh:mm:ss] [--speed X | --step | --client-clock]" << std::endl;
+}
+
+} // namespace
+
+// Local Kite stand-in: point the bot at it with BASE_URL in Credential.csv
+// (or --base-url) and any request token.
+int main(int argc, char* argv[]) {
+    std::cout << "=== Zerodha Exchange Simulator ===" << std::endl;
+
+    std::string bind_address = "127.0.0.1";
+    int port = 8765;
+    int workers = 16;
+    std::string store_dir = "candles";
+    std::string timeframe = "5minute";
+    std::string instruments_file = "instruments.csv";
+    std::string api_secret;
+    std::string start_arg;
+    double speed = 1.0;
+    bool step = false;
+    bool client_clock = false;
+    std::vector<std::string> symbols;
+    std::vector<std::pair<std::string, std::string>> csv_files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--port" && has_value) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--bind" && has_value) {
+            bind_address = argv[++i];
+        } else if (arg == "--workers" && has_value) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "--store-dir" && has_value) {
+            store_dir = argv[++i];
+        } else if (arg == "--timeframe" && has_value) {
+            timeframe = argv[++i];
+        } else if (arg == "--symbol" && has_value) {
+            symbols.push_back(argv[++i]);
+        } else if (arg == "--csv" && has_value) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq == std::string::npos) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            csv_files.emplace_back(spec.substr(0, eq), spec.substr(eq + 1));
+        } else if (arg == "--instruments" && has_value) {
+            instruments_file = argv[++i];
+        } else if (arg == "--api-secret" && has_value) {
+            api_secret = argv[++i];
+        } else if (arg == "--start" && has_value) {
+            start_arg = argv[++i];
+        } else if (arg == "--speed" && has_value) {
+            speed = std::atof(argv[++i]);
+        } else if (arg == "--step") {
+            step = true;
+        } else if (arg == "--client-clock") {
+            client_clock = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    ExchangeSimulator simulator;
+    simulator.setApiSecret(api_secret);
+    if (!simulator.loadInstruments(instruments_file)) {
+        std::cout << "No instrument dump; serving NSE equity rows for the replayed symbols only" << std::endl;
+    }
+
+    // Default universe: every symbol in TradeSettings.csv that has stored candles
+    if (symbols.empty() && csv_files.empty()) {
+        ZerodhaClient settings;
+        if (settings.loadTradeSettings("TradeSettings.csv")) {
+            for (const auto& setting : settings.getTradeSettings()) {
+                symbols.push_back(setting.symbol);
+            }
+        }
+    }
+
+    // A fresh series per symbol: addSeries copies it, and nothing may carry over
+    int64_t earliest = INT64_MAX;
+    for (const auto& entry : csv_files) {
+        CandleSeries series;
+        if (Backtester::loadCSV(entry.second, series) && simulator.addSeries(entry.first, timeframe, series)) {
+            earliest = (std::min)(earliest, series.timestamp.front());
+        }
+    }
+    for (const auto& symbol : symbols) {
+        CandleStore store(store_dir);
+        CandleSeries series;
+        if (!store.open(symbol, timeframe) || store.empty() ||
+            !store.readColumns(store.firstTimestamp(), store.lastTimestamp(), series)) {
+            continue;
+        }
+        if (simulator.addSeries(symbol, timeframe, series)) {
+            earliest = (std::min)(earliest, series.timestamp.front());
+        }
+    }
+
+    if (simulator.seriesCount() == 0) {
+        std::cerr << "No candles to replay. Run ZerodhaBackfill first or pass --csv SYM=FILE." << std::endl;
+        return 1;
+    }
+
+    // By default leave ten days of history behind the replay start for the bot's EMA warm-up
+    int64_t start_ts = start_arg.empty() ? earliest + 10 * 86400 : CandleStore::parseTimestamp(start_arg);
+    if (client_clock) {
+        simulator.setClientClock(start_ts);
+    } else if (step) {
+        simulator.setStepClock(start_ts);
+    } else {
+        simulator.setRealtimeClock(start_ts, speed);
+    }
+
+    HttpServer server(bind_address, port, workers);
+    server.setHandler([&simulator](const HttpRequest& request) { return simulator.handle(request); });
+    if (!server.start()) {
+        return 1;
+    }
+
+    std::cout << "Replaying " << simulator.seriesCount() << " symbols (" << timeframe << ") from "
+              << CandleStore::formatTimestamp(start_ts)
+              << (client_clock ? " following the client's X-Sim-Time"
+                               : step ? " one tick per LTP request" : " at " + std::to_string(speed) + "x")
+              << std::endl;
+    std::cout << "Listening on http://" << bind_address << ":" << server.port() << " - Ctrl+C to stop" << std::endl;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    server.stop();
+    simulator.printSummary();
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "strategy.h"
+
+namespace {
+
+// LastThreeCandles as a rule window
+struct SnapshotWindow {
+    const LastThreeCandles& data;
+
+    Price open(size_t age) const { return age == 0 ? data.last_open : age == 1 ? data.second_open : data.third_open; }
+    Price high(size_t age) const { return age == 0 ? data.last_high : age == 1 ? data.second_high : data.third_high; }
+    Price low(size_t age) const { return age == 0 ? data.last_low : age == 1 ? data.second_low : data.third_low; }
+    Price close(size_t age) const { return age == 0 ? data.last_close : age == 1 ? data.second_close : data.third_close; }
+    double ema(size_t age) const { return age == 0 ? data.last_ema : age == 1 ? data.second_ema : data.third_ema; }
+};
+
+} // namespace
+
+SignalDecision evaluateEmaStrategy(const LastThreeCandles& data, Price ltp, Price tick, const StrategyParams& params) {
+    return evaluateEmaRule(SnapshotWindow{data}, ltp, tick, params);
+}
+
+bool parseStopRule(const std::string& text, StopRule& out) {
+    if (text.empty() || text == "extreme") {
+        out = StopRule::TwoCandleExtreme;
+        return true;
+    }
+    if (text == "second") {
+        out = StopRule::SecondCandle;
+        return true;
+    }
+    return false;
+}
+
+const char* stopRuleName(StopRule rule) {
+    return rule == StopRule::SecondCandle ? "second" : "extreme";
+}
+
+StrategyParams strategyParamsFor(const TradeSetting& setting) {
+    StrategyParams params;
+    if (setting.ema_period > 0) {
+        params.ema_period = setting.ema_period;
+    }
+    if (setting.target_multiple > 0) {
+        params.target_multiple = setting.target_multiple;
+    }
+    parseStopRule(setting.stop_rule, params.stop_rule);
+    return params;
+}
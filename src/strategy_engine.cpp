@@ -0,0 +1,53 @@
+#include "strategy_engine.h"
+
+void BarColumns::reset(size_t symbols) {
+    symbols_ = symbols;
+    open_.assign(kDepth * symbols, Price());
+    high_.assign(kDepth * symbols, Price());
+    low_.assign(kDepth * symbols, Price());
+    close_.assign(kDepth * symbols, Price());
+    ema_.assign(kDepth * symbols, 0.0);
+    count_.assign(symbols, 0);
+}
+
+void BarColumns::store(size_t age, SymbolId id, const CandleData& bar, double ema) {
+    size_t i = age * symbols_ + id;
+    open_[i] = bar.open;
+    high_[i] = bar.high;
+    low_[i] = bar.low;
+    close_[i] = bar.close;
+    ema_[i] = ema;
+}
+
+void BarColumns::push(SymbolId id, const CandleData& bar, double ema) {
+    if (id >= symbols_) {
+        return;
+    }
+    for (size_t age = kDepth - 1; age > 0; --age) {
+        size_t to = age * symbols_ + id;
+        size_t from = to - symbols_;
+        open_[to] = open_[from];
+        high_[to] = high_[from];
+        low_[to] = low_[from];
+        close_[to] = close_[from];
+        ema_[to] = ema_[from];
+    }
+    store(0, id, bar, ema);
+    if (count_[id] < kDepth) {
+        ++count_[id];
+    }
+}
+
+void BarColumns::assign(SymbolId id, const std::vector<CandleData>& candles, const std::vector<double>& ema) {
+    if (id >= symbols_) {
+        return;
+    }
+    // Bars without an EMA value yet are left out
+    size_t usable = candles.size() < ema.size() ? candles.size() : ema.size();
+    size_t count = usable < kDepth ? usable : kDepth;
+    for (size_t age = 0; age < count; ++age) {
+        size_t i = usable - 1 - age;
+        store(age, id, candles[i], ema[i]);
+    }
+    count_[id] = static_cast<uint8_t>(count);
+}
@@ -0,0 +1,454 @@
+#include "strategy_rules.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+using Op = RuleProgram::Op;
+
+enum class ValueType { Number, Bool };
+
+// Recursive descent straight to postfix code, type-checking as it goes
+class RuleParser {
+public:
+    RuleParser(const std::string& text, std::vector<RuleProgram::Instruction>& code)
+        : text_(text), code_(code), pos_(0), depth_(0), max_depth_(0) {}
+
+    bool parse(std::string& error, size_t& depth) {
+        ValueType type;
+        bool ok = parseOr(type);
+        skipSpace();
+        if (ok && pos_ < text_.size()) {
+            ok = fail("unexpected text");
+        }
+        if (ok && type != ValueType::Bool) {
+            ok = fail("a rule must be a condition, not a number");
+        }
+        if (ok && max_depth_ > RuleProgram::kMaxDepth) {
+            ok = fail("expression nests too deeply");
+        }
+        error = error_;
+        depth = max_depth_;
+        return ok;
+    }
+
+private:
+    bool fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = "column " + std::to_string(pos_ + 1) + ": " + message;
+            if (pos_ < text_.size()) {
+                error_ += " near \"" + text_.substr(pos_, 16) + "\"";
+            }
+        }
+        return false;
+    }
+
+    void emit(Op op, uint8_t age = 0, double value = 0.0) {
+        code_.push_back(RuleProgram::Instruction{op, age, value});
+        if (op <= Op::Const) {
+            max_depth_ = (std::max)(max_depth_, ++depth_);
+        } else if (op != Op::Neg && op != Op::Not) {
+            --depth_;
+        }
+    }
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+    }
+
+    // A symbol such as "<=" (a "<" does not match the start of "<=")
+    bool match(const char* token) {
+        skipSpace();
+        size_t length = std::strlen(token);
+        if (text_.compare(pos_, length, token) != 0) {
+            return false;
+        }
+        char next = pos_ + length < text_.size() ? text_[pos_ + length] : '\0';
+        if ((token[0] == '<' || token[0] == '>' || token[0] == '!') && length == 1 && next == '=') {
+            return false;
+        }
+        pos_ += length;
+        return true;
+    }
+
+    bool matchWord(const char* word) {
+        skipSpace();
+        size_t length = std::strlen(word);
+        if (text_.compare(pos_, length, word) != 0) {
+            return false;
+        }
+        char next = pos_ + length < text_.size() ? text_[pos_ + length] : '\0';
+        if (std::isalnum(static_cast<unsigned char>(next)) || next == '_') {
+            return false;
+        }
+        pos_ += length;
+        return true;
+    }
+
+    bool expect(ValueType actual, ValueType wanted, const char* message) {
+        return actual == wanted || fail(message);
+    }
+
+    bool parseOr(ValueType& type) {
+        if (!parseAnd(type)) return false;
+        while (matchWord("or") || match("||")) {
+            ValueType right;
+            if (!expect(type, ValueType::Bool, "'or' needs conditions on both sides") ||
+                !parseAnd(right) || !expect(right, ValueType::Bool, "'or' needs conditions on both sides")) {
+                return false;
+            }
+            emit(Op::Or);
+        }
+        return true;
+    }
+
+    bool parseAnd(ValueType& type) {
+        if (!parseNot(type)) return false;
+        while (matchWord("and") || match("&&")) {
+            ValueType right;
+            if (!expect(type, ValueType::Bool, "'and' needs conditions on both sides") ||
+                !parseNot(right) || !expect(right, ValueType::Bool, "'and' needs conditions on both sides")) {
+                return false;
+            }
+            emit(Op::And);
+        }
+        return true;
+    }
+
+    bool parseNot(ValueType& type) {
+        if (matchWord("not") || match("!")) {
+            if (!parseNot(type) || !expect(type, ValueType::Bool, "'not' needs a condition")) {
+                return false;
+            }
+            emit(Op::Not);
+            return true;
+        }
+        return parseComparison(type);
+    }
+
+    bool parseComparison(ValueType& type) {
+        if (!parseSum(type)) return false;
+        static const std::pair<const char*, Op> comparisons[] = {
+            {"<=", Op::Le}, {">=", Op::Ge}, {"==", Op::Eq}, {"!=", Op::Ne}, {"<", Op::Lt}, {">", Op::Gt}};
+        for (const auto& comparison : comparisons) {
+            if (match(comparison.first)) {
+                ValueType right;
+                if (!expect(type, ValueType::Number, "comparisons need numbers on both sides") ||
+                    !parseSum(right) || !expect(right, ValueType::Number, "comparisons need numbers on both sides")) {
+                    return false;
+                }
+                emit(comparison.second);
+                type = ValueType::Bool;
+                return true;
+            }
+        }
+        return true;
+    }
+
+    bool parseSum(ValueType& type) {
+        if (!parseProduct(type)) return false;
+        for (;;) {
+            Op op;
+            if (match("+")) {
+                op = Op::Add;
+            } else if (match("-")) {
+                op = Op::Sub;
+            } else {
+                return true;
+            }
+            ValueType right;
+            if (!expect(type, ValueType::Number, "arithmetic needs numbers") ||
+                !parseProduct(right) || !expect(right, ValueType::Number, "arithmetic needs numbers")) {
+                return false;
+            }
+            emit(op);
+        }
+    }
+
+    bool parseProduct(ValueType& type) {
+        if (!parseUnary(type)) return false;
+        for (;;) {
+            Op op;
+            if (match("*")) {
+                op = Op::Mul;
+            } else if (match("/")) {
+                op = Op::Div;
+            } else {
+                return true;
+            }
+            ValueType right;
+            if (!expect(type, ValueType::Number, "arithmetic needs numbers") ||
+                !parseUnary(right) || !expect(right, ValueType::Number, "arithmetic needs numbers")) {
+                return false;
+            }
+            emit(op);
+        }
+    }
+
+    bool parseUnary(ValueType& type) {
+        if (match("-")) {
+            if (!parseUnary(type) || !expect(type, ValueType::Number, "'-' needs a number")) {
+                return false;
+            }
+            emit(Op::Neg);
+            return true;
+        }
+        return parsePrimary(type);
+    }
+
+    bool parsePrimary(ValueType& type) {
+        skipSpace();
+        if (match("(")) {
+            return parseOr(type) && (match(")") || fail("expected ')'"));
+        }
+        if (pos_ < text_.size() && (std::isdigit(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '.')) {
+            const char* begin = text_.c_str() + pos_;
+            char* end = nullptr;
+            double value = std::strtod(begin, &end);
+            if (end == begin) {
+                return fail("expected a number");
+            }
+            pos_ += static_cast<size_t>(end - begin);
+            emit(Op::Const, 0, value);
+            type = ValueType::Number;
+            return true;
+        }
+
+        static const std::pair<const char*, Op> fields[] = {
+            {"open", Op::Open}, {"high", Op::High}, {"low", Op::Low}, {"close", Op::Close}, {"ema", Op::Ema}};
+        for (const auto& field : fields) {
+            if (matchWord(field.first)) {
+                uint8_t age = 0;
+                if (match("[")) {
+                    skipSpace();
+                    if (pos_ >= text_.size() || text_[pos_] < '0' || text_[pos_] >= '0' + static_cast<int>(BarColumns::kDepth)) {
+                        return fail("bar age must be 0, 1 or 2");
+                    }
+                    age = static_cast<uint8_t>(text_[pos_++] - '0');
+                    if (!match("]")) {
+                        return fail("expected ']'");
+                    }
+                }
+                emit(field.second, age);
+                type = ValueType::Number;
+                return true;
+            }
+        }
+        if (matchWord("ltp")) {
+            emit(Op::Ltp);
+            type = ValueType::Number;
+            return true;
+        }
+        if (matchWord("tick")) {
+            emit(Op::Tick);
+            type = ValueType::Number;
+            return true;
+        }
+        return fail("expected a value (open/high/low/close/ema[age], ltp, tick or a number)");
+    }
+
+    const std::string& text_;
+    std::vector<RuleProgram::Instruction>& code_;
+    size_t pos_;
+    size_t depth_;
+    size_t max_depth_;
+    std::string error_;
+};
+
+void loadPrices(double* lane, const Price* column, const SymbolId* ids, size_t lanes) {
+    for (size_t l = 0; l < lanes; ++l) {
+        lane[l] = column[ids[l]].toDouble();
+    }
+}
+
+template <typename F>
+void lanewise(double* a, const double* b, size_t lanes, F f) {
+    for (size_t l = 0; l < lanes; ++l) {
+        a[l] = f(a[l], b[l]);
+    }
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+bool RuleProgram::compile(const std::string& text, std::string& error) {
+    std::vector<Instruction> code;
+    size_t depth = 0;
+    RuleParser parser(text, code);
+    if (!parser.parse(error, depth)) {
+        return false;
+    }
+    text_ = text;
+    code_.swap(code);
+    depth_ = depth;
+    return true;
+}
+
+void RuleProgram::run(const BarColumns& bars, const Price* ltp, const Price* tick,
+                      Span<const SymbolId> ids, uint8_t* mask) const {
+    double stack[kMaxDepth][kLanes];
+    for (size_t base = 0; base < ids.size(); base += kLanes) {
+        const size_t lanes = (std::min)(kLanes, ids.size() - base);
+        const SymbolId* lane_ids = ids.begin() + base;
+        size_t top = 0; // next free slot
+
+        // One dispatch per instruction, then a branch-free loop over the lanes
+        for (const Instruction& in : code_) {
+            switch (in.op) {
+                case Op::Open: loadPrices(stack[top++], bars.open(in.age), lane_ids, lanes); break;
+                case Op::High: loadPrices(stack[top++], bars.high(in.age), lane_ids, lanes); break;
+                case Op::Low: loadPrices(stack[top++], bars.low(in.age), lane_ids, lanes); break;
+                case Op::Close: loadPrices(stack[top++], bars.close(in.age), lane_ids, lanes); break;
+                case Op::Ltp: loadPrices(stack[top++], ltp, lane_ids, lanes); break;
+                case Op::Tick: loadPrices(stack[top++], tick, lane_ids, lanes); break;
+                case Op::Ema: {
+                    const double* column = bars.ema(in.age);
+                    double* lane = stack[top++];
+                    for (size_t l = 0; l < lanes; ++l) lane[l] = column[lane_ids[l]];
+                    break;
+                }
+                case Op::Const: std::fill(stack[top], stack[top] + lanes, in.value); ++top; break;
+                case Op::Neg: {
+                    double* lane = stack[top - 1];
+                    for (size_t l = 0; l < lanes; ++l) lane[l] = -lane[l];
+                    break;
+                }
+                case Op::Not: {
+                    double* lane = stack[top - 1];
+                    for (size_t l = 0; l < lanes; ++l) lane[l] = 1.0 - lane[l];
+                    break;
+                }
+                default: {
+                    const double* b = stack[--top];
+                    double* a = stack[top - 1];
+                    switch (in.op) {
+                        case Op::Add: lanewise(a, b, lanes, [](double x, double y) { return x + y; }); break;
+                        case Op::Sub: lanewise(a, b, lanes, [](double x, double y) { return x - y; }); break;
+                        case Op::Mul: lanewise(a, b, lanes, [](double x, double y) { return x * y; }); break;
+                        case Op::Div: lanewise(a, b, lanes, [](double x, double y) { return x / y; }); break;
+                        case Op::Lt: lanewise(a, b, lanes, [](double x, double y) { return x < y ? 1.0 : 0.0; }); break;
+                        case Op::Le: lanewise(a, b, lanes, [](double x, double y) { return x <= y ? 1.0 : 0.0; }); break;
+                        case Op::Gt: lanewise(a, b, lanes, [](double x, double y) { return x > y ? 1.0 : 0.0; }); break;
+                        case Op::Ge: lanewise(a, b, lanes, [](double x, double y) { return x >= y ? 1.0 : 0.0; }); break;
+                        case Op::Eq: lanewise(a, b, lanes, [](double x, double y) { return x == y ? 1.0 : 0.0; }); break;
+                        case Op::Ne: lanewise(a, b, lanes, [](double x, double y) { return x != y ? 1.0 : 0.0; }); break;
+                        case Op::And: lanewise(a, b, lanes, [](double x, double y) { return x * y; }); break;
+                        case Op::Or: lanewise(a, b, lanes, [](double x, double y) { return x + y - x * y; }); break;
+                        default: break;
+                    }
+                }
+            }
+        }
+
+        for (size_t l = 0; l < lanes; ++l) {
+            mask[base + l] = top == 1 && stack[0][l] != 0.0 ? 1 : 0;
+        }
+    }
+}
+
+bool StrategyRules::parse(const std::string& text, std::string& error) {
+    std::string rule_text[2];
+    std::string* current = nullptr;
+    std::istringstream in(text);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        size_t equals = line.find('=');
+        std::string name = equals == std::string::npos ? "" : trim(line.substr(0, equals));
+        // "==" inside a continuation line is a comparison, not a new rule
+        bool starts_rule = (name == "buy" || name == "sell") && line.compare(equals, 2, "==") != 0;
+        if (starts_rule) {
+            current = &rule_text[name == "buy" ? 0 : 1];
+            if (!current->empty()) {
+                error = "line " + std::to_string(line_number) + ": " + name + " is defined twice";
+                return false;
+            }
+            line = trim(line.substr(equals + 1));
+        } else if (!current) {
+            error = "line " + std::to_string(line_number) + ": expected \"buy =\" or \"sell =\"";
+            return false;
+        }
+        if (!current->empty()) {
+            current->push_back(' ');
+        }
+        *current += line;
+    }
+
+    StrategyRules rules;
+    RuleProgram* programs[2] = {&rules.buy, &rules.sell};
+    const char* names[2] = {"buy", "sell"};
+    for (size_t i = 0; i < 2; ++i) {
+        if (!rule_text[i].empty() && !programs[i]->compile(rule_text[i], error)) {
+            error = std::string(names[i]) + " rule, " + error;
+            return false;
+        }
+    }
+    if (rules.buy.empty() && rules.sell.empty()) {
+        error = "no buy or sell rule";
+        return false;
+    }
+    *this = rules;
+    return true;
+}
+
+bool StrategyRules::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string error;
+    if (!parse(buffer.str(), error)) {
+        std::cerr << "Error: " << filename << ": " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void RuleStrategy::decideAll(Span<const SymbolId> ids, SignalDecision* out) const {
+    uint8_t buy[RuleProgram::kLanes];
+    uint8_t sell[RuleProgram::kLanes];
+    for (size_t base = 0; base < ids.size(); base += RuleProgram::kLanes) {
+        const size_t lanes = (std::min)(RuleProgram::kLanes, ids.size() - base);
+        Span<const SymbolId> chunk(ids.begin() + base, lanes);
+        std::fill(buy, buy + lanes, 0);
+        std::fill(sell, sell + lanes, 0);
+        if (!rules_.buy.empty()) {
+            rules_.buy.run(bars_, ltp_.data(), tick_.data(), chunk, buy);
+        }
+        if (!rules_.sell.empty()) {
+            rules_.sell.run(bars_, ltp_.data(), tick_.data(), chunk, sell);
+        }
+
+        // Brackets only for the lanes that signalled
+        for (size_t l = 0; l < lanes; ++l) {
+            SymbolId id = chunk[l];
+            SignalDecision& decision = out[base + l];
+            decision = SignalDecision();
+            if (!bars_.ready(id) || !(ltp_[id] > Price()) || !(buy[l] | sell[l])) {
+                continue;
+            }
+            decision = bracketEntry(buy[l] ? SignalSide::Buy : SignalSide::Sell, bars_.row(id), ltp_[id], tick_[id], params_[id]);
+        }
+    }
+}
@@ -0,0 +1,196 @@
+#include "traffic_capture.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+bool TrafficRecorder::open(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.open(path, std::ios::out | std::ios::app | std::ios::binary);
+    if (!out_.is_open()) {
+        std::cerr << "Error: Could not open traffic capture file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string TrafficRecorder::toJsonLine(const TrafficEntry& entry) {
+    nlohmann::json json;
+    json["ts"] = entry.ts_ms;
+    json["method"] = entry.method;
+    json["url"] = entry.url;
+    json["params"] = entry.params;
+    json["status"] = entry.status;
+    json["elapsed"] = entry.elapsed;
+    json["body"] = entry.body;
+    // Bodies are exchange payloads; never let a stray byte abort the capture
+    return json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+void TrafficRecorder::record(const TrafficEntry& entry) {
+    std::string line = toJsonLine(entry);
+    line.push_back('\n');
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!out_.is_open()) {
+        return;
+    }
+    out_.write(line.data(), static_cast<std::streamsize>(line.size()));
+    out_.flush();
+    ++entries_;
+}
+
+bool TrafficReplayer::fromJsonLine(const std::string& line, TrafficEntry& entry) {
+    try {
+        nlohmann::json json = nlohmann::json::parse(line);
+        entry.ts_ms = json.value("ts", static_cast<int64_t>(0));
+        entry.method = json.at("method").get<std::string>();
+        entry.url = json.at("url").get<std::string>();
+        entry.params = json.value("params", std::map<std::string, std::string>());
+        entry.status = json.value("status", 0L);
+        entry.elapsed = json.value("elapsed", 0.0);
+        entry.body = json.value("body", std::string());
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool TrafficReplayer::parsePacing(const std::string& text, Pacing& pacing) {
+    if (text == "max") {
+        pacing = Pacing::Max;
+    } else if (text == "recorded") {
+        pacing = Pacing::Recorded;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string TrafficReplayer::exactKey(const std::string& method, const std::string& url,
+                                      const std::map<std::string, std::string>& params) {
+    std::string key = method + " " + url + "?";
+    for (const auto& param : params) {
+        key += param.first;
+        key += '=';
+        key += param.second;
+        key += '&';
+    }
+    return key;
+}
+
+bool TrafficReplayer::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Error: Could not open traffic recording: " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string line;
+    size_t line_number = 0;
+    size_t skipped = 0;
+    while (std::getline(in, line)) {
+        ++line_number;
+        if (line.empty()) {
+            continue;
+        }
+        TrafficEntry entry;
+        if (!fromJsonLine(line, entry)) {
+            ++skipped; // usually a torn last line from an interrupted capture
+            continue;
+        }
+        size_t index = entries_.size();
+        by_exact_[exactKey(entry.method, entry.url, entry.params)].entries.push_back(index);
+        by_url_[entry.method + " " + entry.url].entries.push_back(index);
+        entries_.push_back(std::move(entry));
+    }
+    served_.assign(entries_.size(), false);
+
+    if (skipped > 0) {
+        std::cerr << "Warning: Skipped " << skipped << " unreadable lines of " << line_number
+                  << " in " << path << std::endl;
+    }
+    return !entries_.empty();
+}
+
+bool TrafficReplayer::take(Queue& queue, size_t& index) {
+    // Entries taken through the other index are skipped here
+    while (queue.cursor < queue.entries.size() && served_[queue.entries[queue.cursor]]) {
+        ++queue.cursor;
+    }
+    if (queue.cursor == queue.entries.size()) {
+        return false;
+    }
+    index = queue.entries[queue.cursor++];
+    served_[index] = true;
+    ++served_count_;
+    return true;
+}
+
+bool TrafficReplayer::serve(const std::string& method, const std::string& url,
+                            const std::map<std::string, std::string>& params, TrafficEntry& entry) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t index = 0;
+        bool found = false;
+        if (method != "POST") {
+            auto exact = by_exact_.find(exactKey(method, url, params));
+            found = exact != by_exact_.end() && take(exact->second, index);
+        }
+        if (!found) {
+            auto loose = by_url_.find(method + " " + url);
+            found = loose != by_url_.end() && take(loose->second, index);
+        }
+        if (!found) {
+            ++misses_;
+            return false;
+        }
+        entry = entries_[index];
+    }
+
+    // Never backwards: the client's own sleeps may already have passed this point
+    if (clock_) {
+        Clock::time_point sent{std::chrono::milliseconds(entry.ts_ms)};
+        if (sent > clock_->now()) {
+            clock_->set(sent);
+        }
+    }
+
+    if (pacing_ == Pacing::Recorded && entry.elapsed > 0.0) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(entry.elapsed));
+    }
+    return true;
+}
+
+Clock::time_point TrafficReplayer::startTime() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t first = entries_.empty() ? 0 : entries_.front().ts_ms;
+    for (const auto& entry : entries_) {
+        first = (std::min)(first, entry.ts_ms);
+    }
+    return Clock::time_point(std::chrono::milliseconds(first));
+}
+
+bool TrafficReplayer::exhausted(const std::string& method, const std::string& url) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = by_url_.find(method + " " + url);
+    if (it == by_url_.end()) {
+        return false; // never recorded, so running out says nothing about the recording
+    }
+    for (size_t index : it->second.entries) {
+        if (!served_[index]) return false;
+    }
+    return true;
+}
+
+size_t TrafficReplayer::served() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return served_count_;
+}
+
+size_t TrafficReplayer::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
@@ -0,0 +1,85 @@
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int threads) : threads_((std::max)(1, threads)) {
+}
+
+bool WorkStealingPool::takeOwn(Slice& slice, size_t& index) {
+    std::lock_guard<std::mutex> lock(slice.mutex);
+    if (slice.begin >= slice.end) {
+        return false;
+    }
+    index = slice.begin++;
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, size_t& index) {
+    while (true) {
+        // Pick the victim with the most work left; the sizes are only a hint
+        size_t victim = slices_.size();
+        size_t best = 0;
+        for (size_t i = 0; i < slices_.size(); ++i) {
+            if (i == thief) continue;
+            std::lock_guard<std::mutex> lock(slices_[i]->mutex);
+            size_t remaining = slices_[i]->end - slices_[i]->begin;
+            if (remaining > best) {
+                best = remaining;
+                victim = i;
+            }
+        }
+        if (victim == slices_.size()) {
+            return false;
+        }
+
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(slices_[victim]->mutex);
+            Slice& target = *slices_[victim];
+            if (target.begin >= target.end) {
+                continue; // drained while we were looking
+            }
+            size_t mid = target.begin + (target.end - target.begin) / 2;
+            begin = mid;
+            end = target.end;
+            target.end = mid;
+        }
+
+        index = begin;
+        std::lock_guard<std::mutex> lock(slices_[thief]->mutex);
+        slices_[thief]->begin = begin + 1;
+        slices_[thief]->end = end;
+        return true;
+    }
+}
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t workers = (std::min)(static_cast<size_t>(threads_), count);
+    slices_.clear();
+    for (size_t i = 0; i < workers; ++i) {
+        auto slice = std::make_unique<Slice>();
+        slice->begin = count * i / workers;
+        slice->end = count * (i + 1) / workers;
+        slices_.push_back(std::move(slice));
+    }
+
+    auto worker = [&](size_t self) {
+        size_t index;
+        while (takeOwn(*slices_[self], index) || steal(self, index)) {
+            body(index);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < workers; ++i) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0); // the calling thread works too
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
@@ -1,5 +1,7 @@
 #include "zerodha_client.h"
 #include "csv_parser.h"
+#include "strategy.h"
+#include "log.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -9,8 +11,143 @@
 #include <cmath>
 #include <chrono>
 #include <thread>
+#include <limits>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
 
-ZerodhaClient::ZerodhaClient() : api_key_(""), api_secret_(""), access_token_(""), user_id_("") {
+namespace {
+
+// Bar and tick events for one symbol, then its decision
+template <typename Strategy>
+SignalDecision decideWith(Strategy& strategy, const SymbolContext& context, Price ltp) {
+    strategy.onBars(context.id, context.candles, context.ema_values);
+    strategy.onTick(context.id, ltp);
+    return strategy.evaluate(context.id);
+}
+
+int64_t clockMillis(const Clock& clock) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clock.now().time_since_epoch()).count();
+}
+
+// "2025-07-18T11:58:12+0530" -> "2025-07-18 11:55" (start of the 5-minute candle)
+std::string formatFiveMinute(const std::string& timestamp) {
+    if (timestamp.length() >= 16) {
+        std::string date_part = timestamp.substr(0, 10);
+        std::string time_part = timestamp.substr(11, 5);
+        int hour = std::stoi(time_part.substr(0, 2));
+        int minute = std::stoi(time_part.substr(3, 2));
+        int rounded_minute = (minute / 5) * 5;
+
+        std::ostringstream oss;
+        oss << date_part << " " << std::setfill('0') << std::setw(2) << hour
+            << ":" << std::setfill('0') << std::setw(2) << rounded_minute;
+        return oss.str();
+    }
+    return timestamp;
+}
+
+} // namespace
+
+ZerodhaClient::ZerodhaClient() : api_key_(""), api_secret_(""), access_token_(""), user_id_(""),
+                                 candle_store_dir_("candles"), base_url_(DEFAULT_BASE_URL),
+                                 clock_(std::make_shared<SystemClock>()), stop_requested_(false),
+                                 stop_at_(Clock::time_point::max()), latency_report_requested_(false),
+                                 applied_settings_version_(0), positions_version_(0),
+                                 published_positions_version_(UINT64_MAX), applied_reconcile_sequence_(0),
+                                 order_manager_(latency_), risk_(portfolio_), trading_day_(0) {
+    registerMetrics();
+}
+
+void ZerodhaClient::registerMetrics() {
+    static const char* endpoint_names[kApiEndpoints] = {"session", "instruments", "historical", "quote", "orders", "other"};
+    for (size_t i = 0; i < kApiEndpoints; ++i) {
+        std::string labels = std::string("endpoint=\"") + endpoint_names[i] + "\"";
+        api_requests_[i] = &metrics_.counter("zerodha_api_requests_total", "Kite API requests sent.", labels);
+        api_errors_[i] = &metrics_.counter("zerodha_api_errors_total", "Kite API responses other than HTTP 200.", labels);
+    }
+    api_rate_limited_ = &metrics_.counter("zerodha_api_rate_limited_total", "Kite API responses with HTTP 429.");
+    rate_limit_waits_ = &metrics_.counter("zerodha_rate_limit_waits_total", "Pacing sleeps taken to stay under the API rate limits.");
+    rate_limit_wait_ms_ = &metrics_.counter("zerodha_rate_limit_wait_milliseconds_total", "Time spent in pacing sleeps.");
+    loop_passes_ = &metrics_.counter("zerodha_loop_passes_total", "Completed trading loop passes over all symbols.");
+    loop_pass_seconds_ = &metrics_.gauge("zerodha_loop_pass_seconds", "Wall time of the last trading loop pass.");
+    symbols_scanned_ = &metrics_.counter("zerodha_symbols_scanned_total", "Symbols analysed by the trading loop.");
+    active_positions_gauge_ = &metrics_.gauge("zerodha_active_positions", "Positions waiting for their stop loss or target.");
+    signals_buy_ = &metrics_.counter("zerodha_signals_total", "Strategy signals produced.", "side=\"buy\"");
+    signals_sell_ = &metrics_.counter("zerodha_signals_total", "Strategy signals produced.", "side=\"sell\"");
+    orders_entry_ = &metrics_.counter("zerodha_orders_placed_total", "Orders accepted by the exchange.", "leg=\"entry\"");
+    orders_stoploss_ = &metrics_.counter("zerodha_orders_placed_total", "Orders accepted by the exchange.", "leg=\"stoploss\"");
+    orders_target_ = &metrics_.counter("zerodha_orders_placed_total", "Orders accepted by the exchange.", "leg=\"target\"");
+    settings_reloads_ = &metrics_.counter("zerodha_settings_reloads_total", "TradeSettings.csv changes applied without a restart.");
+    reconcile_passes_ = &metrics_.counter("zerodha_reconcile_passes_total", "Broker reconciliation reports applied.");
+    for (size_t i = 0; i < kDiscrepancyKinds; ++i) {
+        std::string labels = std::string("kind=\"") + Discrepancy::kindName(static_cast<Discrepancy::Kind>(i)) + "\"";
+        reconcile_discrepancies_[i] = &metrics_.counter("zerodha_reconcile_discrepancies_total",
+                                                        "Differences found between the broker's books and the bot.", labels);
+    }
+    resident_memory_ = &metrics_.gauge("zerodha_resident_memory_bytes", "Resident set size of the process.");
+    for (size_t i = 1; i < kRiskVerdicts; ++i) {
+        std::string labels = std::string("reason=\"") + RiskGate::verdictName(static_cast<RiskVerdict>(i)) + "\"";
+        risk_rejections_[i] = &metrics_.counter("zerodha_risk_rejections_total", "Entry orders blocked by the risk gate.", labels);
+    }
+    risk_rejections_[0] = nullptr;
+    gross_exposure_ = &metrics_.gauge("zerodha_gross_exposure_rupees", "Sum of |quantity| x last price over open positions.");
+    net_exposure_ = &metrics_.gauge("zerodha_net_exposure_rupees", "Sum of signed quantity x last price over open positions.");
+    realized_pnl_ = &metrics_.gauge("zerodha_realized_pnl_rupees", "P&L booked on closed positions this session.");
+    unrealized_pnl_ = &metrics_.gauge("zerodha_unrealized_pnl_rupees", "Mark-to-market P&L of open positions.");
+    live_orders_ = &metrics_.gauge("zerodha_live_orders", "Orders sent this session that are not yet filled, cancelled or rejected.");
+    
+    metrics_.addCollector([this](std::string& out) {
+        resident_memory_->set(static_cast<double>(MetricsRegistry::residentMemoryBytes()));
+        live_orders_->set(static_cast<double>(order_manager_.live()));
+        PortfolioTotals totals = portfolio_.snapshot();
+        gross_exposure_->set(totals.gross_exposure_paise / 100.0);
+        net_exposure_->set(totals.net_exposure_paise / 100.0);
+        realized_pnl_->set(totals.realized_pnl_paise / 100.0);
+        unrealized_pnl_->set(totals.unrealized_pnl_paise / 100.0);
+        bool header = true;
+        for (size_t i = 0; i < LatencyRecorder::kStageCount; ++i) {
+            LatencyStage stage = static_cast<LatencyStage>(i);
+            std::string labels = std::string("stage=\"") + LatencyRecorder::stageName(stage) + "\"";
+            MetricsRegistry::appendSummary(out, "zerodha_stage_latency_seconds", "Trading loop stage latency.",
+                                           labels, latency_.histogram(stage), header);
+            header = false;
+        }
+    });
+}
+
+ZerodhaClient::ApiEndpoint ZerodhaClient::apiEndpointFor(const std::string& url) const {
+    std::string path = url.compare(0, base_url_.size(), base_url_) == 0 ? url.substr(base_url_.size()) : url;
+    if (path.compare(0, std::strlen(LTP_PATH), LTP_PATH) == 0) return ApiEndpoint::Quote;
+    if (path.compare(0, std::strlen(HISTORICAL_PATH), HISTORICAL_PATH) == 0) return ApiEndpoint::Historical;
+    if (path.compare(0, std::strlen(TOKEN_PATH), TOKEN_PATH) == 0) return ApiEndpoint::Session;
+    if (path.compare(0, 7, "/orders") == 0) return ApiEndpoint::Orders;
+    if (path.compare(0, 12, "/instruments") == 0) return ApiEndpoint::Instruments;
+    return ApiEndpoint::Other;
+}
+
+void ZerodhaClient::countResponse(const std::string& url, const cpr::Response& response) {
+    size_t endpoint = static_cast<size_t>(apiEndpointFor(url));
+    api_requests_[endpoint]->inc();
+    if (response.status_code != 200) {
+        api_errors_[endpoint]->inc();
+        if (response.status_code == 429) {
+            api_rate_limited_->inc();
+        }
+    }
+}
+
+void ZerodhaClient::rateLimitWait(Clock::duration wait) {
+    rate_limit_waits_->inc();
+    rate_limit_wait_ms_->inc(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(wait).count()));
+    clock_->sleepFor(wait);
+}
+
+void ZerodhaClient::setBaseUrl(const std::string& url) {
+    base_url_ = url;
+    while (!base_url_.empty() && base_url_.back() == '/') {
+        base_url_.pop_back();
+    }
 }
 
 bool ZerodhaClient::loadCredentials(const std::string& filename) {
@@ -30,12 +167,27 @@ bool ZerodhaClient::loadCredentials(const std::string& filename) {
         return false;
     }
     
+    // Optional: point the client at a local simulator instead of api.kite.trade
+    if (credentials.find("BASE_URL") != credentials.end() && !credentials["BASE_URL"].empty()) {
+        setBaseUrl(credentials["BASE_URL"]);
+        std::cout << "Using API base URL: " << base_url_ << std::endl;
+    }
+    
     std::cout << "Credentials loaded successfully" << std::endl;
     std::cout << "API Key: " << api_key_ << std::endl;
     return true;
 }
 
 bool ZerodhaClient::loadTradeSettings(const std::string& filename) {
+    if (!parseTradeSettings(filename, trade_settings_)) {
+        return false;
+    }
+    
+    std::cout << "Loaded " << trade_settings_.size() << " trade settings" << std::endl;
+    return true;
+}
+
+bool ZerodhaClient::parseTradeSettings(const std::string& filename, std::vector<TradeSetting>& settings) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open trade settings file: " << filename << std::endl;
@@ -46,7 +198,7 @@ bool ZerodhaClient::loadTradeSettings(const std::string& filename) {
     // Skip header line
     std::getline(file, line);
     
-    trade_settings_.clear();
+    settings.clear();
     
     while (std::getline(file, line)) {
         if (line.empty()) continue;
@@ -61,15 +213,34 @@ bool ZerodhaClient::loadTradeSettings(const std::string& filename) {
             
             TradeSetting setting;
             setting.symbol = symbol;
-            setting.quantity = std::stoi(quantity_str);
             setting.timeframe = timeframe;
-            setting.ema_period = std::stoi(ema_period_str);
+            try {
+                setting.quantity = std::stoi(quantity_str);
+                setting.ema_period = std::stoi(ema_period_str);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid quantity or EMA period for " << symbol << " in " << filename << std::endl;
+                return false;
+            }
+            
+            // Optional Target_Multiple and Stop_Rule columns; blank keeps the 2:1 / two-candle defaults
+            std::string target_str, stop_rule;
+            if (std::getline(ss, target_str, ',') && !target_str.empty()) {
+                setting.target_multiple = std::atof(target_str.c_str());
+            }
+            if (std::getline(ss, stop_rule, ',')) {
+                stop_rule.erase(std::remove_if(stop_rule.begin(), stop_rule.end(), ::isspace), stop_rule.end());
+                StopRule parsed;
+                if (!parseStopRule(stop_rule, parsed)) {
+                    std::cerr << "Warning: Unknown stop rule '" << stop_rule << "' for " << symbol << ", using extreme" << std::endl;
+                    stop_rule.clear();
+                }
+                setting.stop_rule = stop_rule;
+            }
             
-            trade_settings_.push_back(setting);
+            settings.push_back(setting);
         }
     }
     
-    std::cout << "Loaded " << trade_settings_.size() << " trade settings" << std::endl;
     return true;
 }
 
@@ -82,10 +253,11 @@ bool ZerodhaClient::fetchInstruments() {
     std::cout << "Fetching instruments from Zerodha..." << std::endl;
     
     // Try different approaches for fetching instruments
+    // Full dump first (all exchanges and segments), per-exchange dumps as fallback
     std::vector<std::string> urls_to_try = {
-        "https://api.kite.trade/instruments/NSE",
-        "https://api.kite.trade/instruments",
-        "https://api.kite.trade/instruments/NFO"
+        apiUrl("/instruments"),
+        apiUrl("/instruments/NSE"),
+        apiUrl("/instruments/NFO")
     };
     
     for (const auto& url : urls_to_try) {
@@ -150,7 +322,7 @@ bool ZerodhaClient::fetchInstruments() {
     
     // Only create fallback if ALL HTTP requests failed (not just parsing failures)
     std::cout << "Creating fallback instrument data for common symbols..." << std::endl;
-    instruments_cache_.clear();
+    instruments_.clear();
     
     // Add some common NSE symbols with dummy tokens
     std::vector<std::string> common_symbols = {
@@ -165,10 +337,11 @@ bool ZerodhaClient::fetchInstruments() {
         inst.exchange = "NSE";
         inst.instrument_type = "EQ";
         
-        instruments_cache_[inst.tradingsymbol] = inst;
+        instruments_.append(inst);
     }
+    instruments_.buildIndexes();
     
-    std::cout << "Created " << instruments_cache_.size() << " fallback instruments" << std::endl;
+    std::cout << "Created " << instruments_.size() << " fallback instruments" << std::endl;
     std::cout << "Note: Historical data fetching may not work properly with fallback instruments" << std::endl;
     
     return true;
@@ -179,19 +352,44 @@ std::vector<CandleData> ZerodhaClient::getHistoricalData(const std::string& symb
                                                         const std::string& from_date,
                                                         const std::string& to_date,
                                                         bool include_oi) {
-    if (!isLoggedIn()) {
-        std::cerr << "Error: Not logged in. Please login first." << std::endl;
-        return {};
-    }
+    std::vector<CandleData> candles;
+    fetchHistoricalData(symbol, timeframe, from_date, to_date, candles, include_oi);
+    return candles;
+}
+
+bool ZerodhaClient::fetchHistoricalData(const std::string& symbol,
+                                        const std::string& timeframe,
+                                        const std::string& from_date,
+                                        const std::string& to_date,
+                                        std::vector<CandleData>& candles,
+                                        bool include_oi) {
+    candles.clear();
     
     std::string instrument_token = getInstrumentToken(symbol);
     if (instrument_token.empty()) {
         std::cerr << "Error: Could not find instrument token for symbol: " << symbol << std::endl;
-        return {};
+        return false;
+    }
+    
+    return fetchHistoricalCandles(symbol, instrument_token, timeframe, from_date, to_date, candles, include_oi);
+}
+
+bool ZerodhaClient::fetchHistoricalCandles(const std::string& symbol,
+                                           const std::string& instrument_token,
+                                           const std::string& timeframe,
+                                           const std::string& from_date,
+                                           const std::string& to_date,
+                                           std::vector<CandleData>& candles,
+                                           bool include_oi) {
+    candles.clear();
+    
+    if (!isLoggedIn()) {
+        std::cerr << "Error: Not logged in. Please login first." << std::endl;
+        return false;
     }
     
     // Build URL with parameters
-    std::string url = std::string(HISTORICAL_URL) + "/" + instrument_token + "/" + timeframe;
+    std::string url = apiUrl(HISTORICAL_PATH) + "/" + instrument_token + "/" + timeframe;
     
     std::map<std::string, std::string> params;
     params["from"] = from_date;
@@ -202,16 +400,16 @@ std::vector<CandleData> ZerodhaClient::getHistoricalData(const std::string& symb
     
     std::map<std::string, std::string> headers = getAuthHeaders();
     
-    std::cout << "Fetching historical data for " << symbol << " (" << timeframe << ")..." << std::endl;
+    LOG_DEBUG("Fetching historical data for {} ({})...", symbol, timeframe);
     
     cpr::Response response = makeRequest(url, params, headers);
     
     if (response.status_code == 200) {
-        return parseHistoricalDataResponse(response);
+        return parseHistoricalDataResponse(response, candles);
     } else {
-        std::cerr << "Error: Failed to fetch historical data for " << symbol << ". Status: " << response.status_code << std::endl;
-        std::cerr << "Response: " << response.text << std::endl;
-        return {};
+        LOG_ERROR("Failed to fetch historical data for {}. Status: {} Response: {}", symbol, response.status_code,
+                  response.text);
+        return false;
     }
 }
 
@@ -245,6 +443,77 @@ bool ZerodhaClient::fetchHistoricalDataForAllSymbols(const std::string& from_dat
     return true;
 }
 
+CandleStore* ZerodhaClient::getCandleStore(const std::string& symbol, const std::string& timeframe) {
+    if (candle_store_dir_.empty()) {
+        return nullptr;
+    }
+    
+    std::string key = symbol + "_" + timeframe;
+    auto it = candle_stores_.find(key);
+    if (it != candle_stores_.end()) {
+        return it->second.get();
+    }
+    
+    auto store = std::make_unique<CandleStore>(candle_store_dir_);
+    if (!store->open(symbol, timeframe)) {
+        return nullptr;
+    }
+    // The loop completes about one candle per pass; write them a block at a
+    // time (and at each day change) instead of a block per pass
+    store->setAppendBatch(CandleStore::kBlockSize);
+    
+    CandleStore* result = store.get();
+    candle_stores_[key] = std::move(store);
+    return result;
+}
+
+std::vector<CandleData> ZerodhaClient::getCandlesWithHistory(const std::string& symbol,
+                                                            const std::string& timeframe,
+                                                            const std::chrono::system_clock::time_point& from,
+                                                            const std::chrono::system_clock::time_point& to,
+                                                            const std::string& instrument_token) {
+    auto fetch = [&](const std::chrono::system_clock::time_point& fetch_from) {
+        if (instrument_token.empty()) {
+            return getHistoricalData(symbol, timeframe, formatDate(fetch_from), formatDate(to));
+        }
+        std::vector<CandleData> fetched;
+        fetchHistoricalCandles(symbol, instrument_token, timeframe, formatDate(fetch_from), formatDate(to), fetched, false);
+        return fetched;
+    };
+    
+    CandleStore* store = getCandleStore(symbol, timeframe);
+    if (!store) {
+        return fetch(from);
+    }
+    
+    int64_t from_ts = std::chrono::system_clock::to_time_t(from);
+    int64_t to_ts = std::chrono::system_clock::to_time_t(to);
+    
+    // Only download what the store does not have yet; the last stored candle is re-fetched as overlap
+    auto fetch_from = from;
+    if (!store->empty() && store->lastTimestamp() >= from_ts) {
+        fetch_from = std::chrono::system_clock::from_time_t(static_cast<std::time_t>(store->lastTimestamp()));
+    }
+    
+    std::vector<CandleData> fresh = fetch(fetch_from);
+    
+    // The newest candle may still be forming, so it is used but not persisted
+    if (fresh.size() > 1) {
+        store->append(std::vector<CandleData>(fresh.begin(), fresh.end() - 1));
+    }
+    
+    std::vector<CandleData> candles = store->read(from_ts, to_ts);
+    int64_t last_stored = candles.empty() ? std::numeric_limits<int64_t>::min()
+                                          : CandleStore::parseTimestamp(candles.back().timestamp);
+    for (const auto& candle : fresh) {
+        if (CandleStore::parseTimestamp(candle.timestamp) > last_stored) {
+            candles.push_back(candle);
+        }
+    }
+    
+    return candles;
+}
+
 bool ZerodhaClient::login() {
     if (api_key_.empty() || api_secret_.empty()) {
         std::cerr << "Error: Credentials not loaded. Call loadCredentials() first." << std::endl;
@@ -292,10 +561,10 @@ bool ZerodhaClient::generateSessionToken(const std::string& requestToken) {
     
     std::map<std::string, std::string> headers = getDefaultHeaders();
     
-    std::cout << "Debug: Making POST request to: " << TOKEN_URL << std::endl;
+    std::cout << "Debug: Making POST request to: " << apiUrl(TOKEN_PATH) << std::endl;
     
     // Use POST request as per Zerodha documentation
-    cpr::Response response = makePostRequest(TOKEN_URL, data, headers);
+    cpr::Response response = makePostRequest(apiUrl(TOKEN_PATH), data, headers);
     
     std::cout << "Debug: Response Status: " << response.status_code << std::endl;
     std::cout << "Debug: Response Text: " << response.text << std::endl;
@@ -321,6 +590,12 @@ bool ZerodhaClient::generateSessionToken() {
 cpr::Response ZerodhaClient::makeRequest(const std::string& url, 
                                         const std::map<std::string, std::string>& params,
                                         const std::map<std::string, std::string>& headers) {
+    if (traffic_replayer_) {
+        cpr::Response response = replayResponse("GET", url, params);
+        countResponse(url, response);
+        return response;
+    }
+    
     cpr::Parameters cprParams;
     for (const auto& param : params) {
         cprParams.Add({param.first, param.second});
@@ -331,17 +606,29 @@ cpr::Response ZerodhaClient::makeRequest(const std::string& url,
         cprHeaders[header.first] = header.second;
     }
     
+    int64_t sent_ms = clockMillis(*clock_);
     // Disable SSL verification to fix certificate issues
-    return cpr::Get(cpr::Url{url}, 
-                   cprParams, 
-                   cprHeaders,
-                   cpr::VerifySsl{false},
-                   cpr::Timeout{30000}); // 30 second timeout
+    cpr::Response response = cpr::Get(cpr::Url{url}, 
+                                      cprParams, 
+                                      cprHeaders,
+                                      cpr::VerifySsl{false},
+                                      cpr::Timeout{30000}); // 30 second timeout
+    countResponse(url, response);
+    if (traffic_recorder_) {
+        recordTraffic("GET", url, params, response, sent_ms);
+    }
+    return response;
 }
 
 cpr::Response ZerodhaClient::makePostRequest(const std::string& url,
                                             const std::map<std::string, std::string>& data,
                                             const std::map<std::string, std::string>& headers) {
+    if (traffic_replayer_) {
+        cpr::Response response = replayResponse("POST", url, data);
+        countResponse(url, response);
+        return response;
+    }
+    
     cpr::Payload payload{};
     for (const auto& item : data) {
         payload.Add({item.first, item.second});
@@ -352,12 +639,59 @@ cpr::Response ZerodhaClient::makePostRequest(const std::string& url,
         cprHeaders[header.first] = header.second;
     }
     
+    int64_t sent_ms = clockMillis(*clock_);
     // Disable SSL verification to fix certificate issues
-    return cpr::Post(cpr::Url{url}, 
-                    payload, 
-                    cprHeaders,
-                    cpr::VerifySsl{false},
-                    cpr::Timeout{30000}); // 30 second timeout
+    cpr::Response response = cpr::Post(cpr::Url{url}, 
+                                       payload, 
+                                       cprHeaders,
+                                       cpr::VerifySsl{false},
+                                       cpr::Timeout{30000}); // 30 second timeout
+    countResponse(url, response);
+    if (traffic_recorder_) {
+        recordTraffic("POST", url, data, response, sent_ms);
+    }
+    return response;
+}
+
+cpr::Response ZerodhaClient::replayResponse(const std::string& method, const std::string& url,
+                                            const std::map<std::string, std::string>& params) {
+    cpr::Response response;
+    response.url = cpr::Url{url};
+    
+    TrafficEntry entry;
+    if (!traffic_replayer_->serve(method, url, params, entry)) {
+        response.status_code = 0;
+        response.error.message = "No recorded response for " + method + " " + url;
+        // Entries for other requests may be left over (a session that diverged
+        // from the recording), but this request will never be answered again
+        if ((traffic_replayer_->exhausted() || traffic_replayer_->exhausted(method, url)) && !stop_requested_) {
+            std::cout << "Traffic recording exhausted (" << traffic_replayer_->size() - traffic_replayer_->served()
+                      << " unmatched entries left); stopping." << std::endl;
+            requestStop();
+        }
+        return response;
+    }
+    
+    response.status_code = entry.status;
+    response.text = std::move(entry.body);
+    response.elapsed = entry.elapsed;
+    return response;
+}
+
+void ZerodhaClient::recordTraffic(const std::string& method, const std::string& url,
+                                  const std::map<std::string, std::string>& params, const cpr::Response& response,
+                                  int64_t sent_ms) {
+    TrafficEntry entry;
+    entry.ts_ms = sent_ms;
+    entry.method = method;
+    entry.url = url;
+    entry.params = params;
+    entry.status = response.status_code;
+    entry.elapsed = response.elapsed;
+    entry.body = response.text;
+    // The checksum is derived from the API secret; keep it out of the capture
+    entry.params.erase("checksum");
+    traffic_recorder_->record(entry);
 }
 
 std::string ZerodhaClient::generateChecksum(const std::map<std::string, std::string>& params) {
@@ -396,6 +730,10 @@ std::map<std::string, std::string> ZerodhaClient::getDefaultHeaders() {
     std::map<std::string, std::string> headers;
     headers["X-Kite-Version"] = "3";
     headers["Content-Type"] = "application/x-www-form-urlencoded";
+    // Lets a simulator follow a virtual clock (epoch seconds)
+    if (clock_->isVirtual()) {
+        headers["X-Sim-Time"] = std::to_string(clock_->nowSeconds());
+    }
     return headers;
 }
 
@@ -443,47 +781,29 @@ std::map<std::string, std::string> ZerodhaClient::getAuthHeaders() {
     std::map<std::string, std::string> headers = getDefaultHeaders();
     if (!access_token_.empty()) {
         headers["Authorization"] = "token " + api_key_ + ":" + access_token_;
-        std::cout << "Debug: Authorization header set: token " << api_key_ << ":" << access_token_.substr(0, 10) << "..." << std::endl;
+        LOG_TRACE("Authorization header set: token {}:{}...", api_key_, access_token_.substr(0, 10));
     } else {
-        std::cout << "Debug: No access token available for authorization" << std::endl;
+        LOG_DEBUG("No access token available for authorization");
     }
     return headers;
 }
 
 bool ZerodhaClient::parseInstrumentsResponse(const cpr::Response& response) {
     try {
-        // Parse CSV from response.text
-        auto rows = CSVParser::parseCSVString(response.text);
-        if (rows.empty()) {
+        // Single pass over the CSV text straight into the columnar store
+        if (!instruments_.loadFromCSVString(response.text)) {
             std::cerr << "Instrument CSV response is empty or invalid" << std::endl;
             return false;
         }
         
-        instruments_cache_.clear();
-        int valid_instruments = 0;
-        
-        for (const auto& row : rows) {
-            // Required fields: instrument_token, tradingsymbol
-            if (row.count("instrument_token") && row.count("tradingsymbol")) {
-                Instrument inst;
-                inst.instrument_token = row.at("instrument_token");
-                inst.tradingsymbol = row.at("tradingsymbol");
-                inst.name = row.count("name") ? row.at("name") : "";
-                inst.exchange = row.count("exchange") ? row.at("exchange") : "";
-                inst.instrument_type = row.count("instrument_type") ? row.at("instrument_type") : "";
-                
-                // Only add equity instruments (EQ) from NSE for now
-                if (inst.exchange == "NSE" && inst.instrument_type == "EQ") {
-                    instruments_cache_[inst.tradingsymbol] = inst;
-                    valid_instruments++;
-                }
-            }
-        }
-        
-        std::cout << "Loaded " << valid_instruments << " NSE equity instruments from CSV" << std::endl;
-        std::cout << "Total instruments in response: " << rows.size() << std::endl;
+        std::cout << "Loaded " << instruments_.size() << " instruments"
+                  << " (NSE: " << instruments_.countByExchange("NSE")
+                  << ", BSE: " << instruments_.countByExchange("BSE")
+                  << ", NFO: " << instruments_.countByExchange("NFO")
+                  << ", MCX: " << instruments_.countByExchange("MCX") << ")" << std::endl;
         
-        return !instruments_cache_.empty();
+        refreshOptionsChain(true);
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Error parsing instruments CSV response: " << e.what() << std::endl;
         std::cerr << "Response preview: " << response.text.substr(0, 300) << std::endl;
@@ -493,20 +813,25 @@ bool ZerodhaClient::parseInstrumentsResponse(const cpr::Response& response) {
 
 std::vector<CandleData> ZerodhaClient::parseHistoricalDataResponse(const cpr::Response& response) {
     std::vector<CandleData> candles;
-    
+    parseHistoricalDataResponse(response, candles);
+    return candles;
+}
+
+bool ZerodhaClient::parseHistoricalDataResponse(const cpr::Response& response, std::vector<CandleData>& candles) {
     try {
         nlohmann::json json = nlohmann::json::parse(response.text);
         
         if (json["status"] == "success") {
+            candles.reserve(json["data"]["candles"].size());
             for (const auto& candle_array : json["data"]["candles"]) {
                 CandleData candle;
                 
                 // Parse candle data: [timestamp, open, high, low, close, volume, oi]
                 candle.timestamp = candle_array[0];
-                candle.open = candle_array[1];
-                candle.high = candle_array[2];
-                candle.low = candle_array[3];
-                candle.close = candle_array[4];
+                candle.open = Price::fromDouble(candle_array[1].get<double>());
+                candle.high = Price::fromDouble(candle_array[2].get<double>());
+                candle.low = Price::fromDouble(candle_array[3].get<double>());
+                candle.close = Price::fromDouble(candle_array[4].get<double>());
                 candle.volume = candle_array[5];
                 
                 // OI is optional (7th element)
@@ -516,6 +841,7 @@ std::vector<CandleData> ZerodhaClient::parseHistoricalDataResponse(const cpr::Re
                 
                 candles.push_back(candle);
             }
+            return true;
         } else {
             std::cerr << "Failed to parse historical data: " << json["message"] << std::endl;
         }
@@ -523,24 +849,36 @@ std::vector<CandleData> ZerodhaClient::parseHistoricalDataResponse(const cpr::Re
         std::cerr << "Error parsing historical data response: " << e.what() << std::endl;
     }
     
-    return candles;
+    return false;
 }
 
 std::string ZerodhaClient::getInstrumentToken(const std::string& symbol) {
-    auto it = instruments_cache_.find(symbol);
-    if (it != instruments_cache_.end()) {
-        return it->second.instrument_token;
+    // Accepts a bare symbol (NSE/BSE equity first) or an "EXCHANGE:SYMBOL" key
+    InstrumentStore::Row row = instruments_.findAny(symbol);
+    if (row != InstrumentStore::npos) {
+        return std::to_string(instruments_.instrumentToken(row));
     }
     
-    // If not found, try to find by partial match (for NSE symbols)
-    std::string nse_symbol = "NSE:" + symbol;
-    it = instruments_cache_.find(nse_symbol);
-    if (it != instruments_cache_.end()) {
-        return it->second.instrument_token;
+    return "";
+}
+
+std::string ZerodhaClient::getInstrumentExchange(const std::string& symbol) const {
+    InstrumentStore::Row row = instruments_.findAny(symbol);
+    if (row != InstrumentStore::npos) {
+        return std::string(instruments_.exchange(row));
     }
     
-    return "";
-} 
+    return "NSE";
+}
+
+Price ZerodhaClient::getTickSize(const std::string& symbol) const {
+    InstrumentStore::Row row = instruments_.findAny(symbol);
+    if (row != InstrumentStore::npos) {
+        return instruments_.tickSize(row);
+    }
+    
+    return Price::fromPaise(5); // NSE equity default
+}
 
 std::vector<double> ZerodhaClient::calculateEMA(const std::vector<double>& prices, int period) {
     std::vector<double> ema_values;
@@ -549,7 +887,7 @@ std::vector<double> ZerodhaClient::calculateEMA(const std::vector<double>& price
     }
     
     // Calculate multiplier
-    double multiplier = 2.0 / (period + 1.0);
+    double multiplier = emaMultiplier(period);
     
     // Initialize EMA with first price
     ema_values.push_back(prices[0]);
@@ -585,10 +923,10 @@ bool ZerodhaClient::saveInstrumentDataToCSV(const std::string& symbol, const std
         double ema = (i < ema_values.size()) ? ema_values[i] : 0.0;
         
         file << candle.timestamp << ","
-             << std::fixed << std::setprecision(2) << candle.open << ","
-             << std::fixed << std::setprecision(2) << candle.high << ","
-             << std::fixed << std::setprecision(2) << candle.low << ","
-             << std::fixed << std::setprecision(2) << candle.close << ","
+             << candle.open << ","
+             << candle.high << ","
+             << candle.low << ","
+             << candle.close << ","
              << candle.volume << ","
              << std::fixed << std::setprecision(2) << ema << "\n";
     }
@@ -599,87 +937,248 @@ bool ZerodhaClient::saveInstrumentDataToCSV(const std::string& symbol, const std
 }
 
 bool ZerodhaClient::saveInstrumentsToCSV(const std::string& filename) {
-    if (instruments_cache_.empty()) {
+    if (instruments_.empty()) {
         std::cerr << "Error: No instruments loaded. Call fetchInstruments() first." << std::endl;
         return false;
     }
     
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not create file: " << filename << std::endl;
+    if (!instruments_.saveToCSVFile(filename)) {
         return false;
     }
     
-    // Write header
-    file << "instrument_token,tradingsymbol,name,exchange,instrument_type,segment,lot_size,tick_size\n";
-    
-    // Write data
-    for (const auto& pair : instruments_cache_) {
-        const Instrument& inst = pair.second;
-        file << inst.instrument_token << ","
-             << inst.tradingsymbol << ","
-             << "\"" << inst.name << "\","
-             << inst.exchange << ","
-             << inst.instrument_type << ","
-             << "NSE" << ","  // Default segment
-             << "1" << ","   // Default lot_size
-             << "0.05\n";    // Default tick_size
-    }
-    
-    file.close();
-    std::cout << "Saved " << instruments_cache_.size() << " instruments to " << filename << std::endl;
+    std::cout << "Saved " << instruments_.size() << " instruments to " << filename << std::endl;
     return true;
 }
 
 bool ZerodhaClient::loadInstrumentsFromCSV(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open instruments file: " << filename << std::endl;
+    if (!instruments_.loadFromCSVFile(filename)) {
         return false;
     }
     
-    instruments_cache_.clear();
-    std::string line;
-    
-    // Skip header
-    std::getline(file, line);
+    std::cout << "Loaded " << instruments_.size() << " instruments from " << filename << std::endl;
+    refreshOptionsChain(true);
+    return true;
+}
+
+bool ZerodhaClient::refreshOptionsChain(bool force) {
+    int today = currentDateYmd();
+    if (!force && options_chain_.builtOn() == today) {
+        return !options_chain_.empty();
+    }
     
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        
-        std::vector<std::string> parts = CSVParser::splitCSVLine(line);
-        if (parts.size() >= 5) {
-            Instrument inst;
-            inst.instrument_token = parts[0];
-            inst.tradingsymbol = parts[1];
-            inst.name = parts[2];
-            inst.exchange = parts[3];
-            inst.instrument_type = parts[4];
-            
-            instruments_cache_[inst.tradingsymbol] = inst;
-        }
+    // On a new day the dump is downloaded again so contracts listed since are
+    // found; expiries before today drop out of the index
+    if (!force && options_chain_.builtOn() != 0) {
+        reloadInstruments();
     }
+    options_chain_.build(instruments_, today);
+    std::cout << "Options chain built for " << options_chain_.underlyingCount() << " underlyings" << std::endl;
+    return !options_chain_.empty();
+}
+
+bool ZerodhaClient::reloadInstruments() {
+    cpr::Response response = makeRequest(apiUrl("/instruments"), {}, getAuthHeaders());
+    if (response.status_code != 200 || response.text.compare(0, 17, "instrument_token,") != 0) {
+        LOG_WARN("Instrument refresh failed (HTTP {}); keeping the loaded dump", response.status_code);
+        return false;
+    }
+    // Parsed on the side so a bad payload leaves the live dump untouched
+    InstrumentStore refreshed;
+    if (!refreshed.loadFromCSVString(response.text)) {
+        LOG_WARN("Instrument refresh did not parse; keeping the loaded dump");
+        return false;
+    }
+    instruments_ = std::move(refreshed);
     
-    file.close();
-    std::cout << "Loaded " << instruments_cache_.size() << " instruments from " << filename << std::endl;
+    LOG_INFO("Instruments refreshed: {} rows ({} NFO)", instruments_.size(), instruments_.countByExchange("NFO"));
+    instruments_.saveToCSVFile("instruments.csv");
     return true;
 }
 
+std::string ZerodhaClient::selectOption(const std::string& underlying, Price ltp, OptionType type, int strike_offset) {
+    InstrumentStore::Row row = options_chain_.select(underlying, ltp, type, strike_offset, currentDateYmd());
+    if (row == InstrumentStore::npos) {
+        std::cerr << "Error: No " << (type == OptionType::CE ? "CE" : "PE") << " option found for "
+                  << underlying << " near " << ltp << std::endl;
+        return "";
+    }
+    
+    return std::string(instruments_.tradingsymbol(row));
+}
+
 std::vector<std::string> ZerodhaClient::getMatchedSymbols() {
     std::vector<std::string> matched_symbols;
     
     for (const auto& setting : trade_settings_) {
-        if (instruments_cache_.find(setting.symbol) != instruments_cache_.end()) {
+        if (instruments_.findAny(setting.symbol) != InstrumentStore::npos) {
             matched_symbols.push_back(setting.symbol);
         }
     }
     
-    std::cout << "Found " << matched_symbols.size() << " symbols in instruments out of " 
-              << trade_settings_.size() << " trade settings" << std::endl;
+    LOG_DEBUG("Found {} symbols in instruments out of {} trade settings", matched_symbols.size(),
+              trade_settings_.size());
     
     return matched_symbols;
 } 
 
+size_t ZerodhaClient::buildSymbolContexts() {
+    symbol_contexts_.clear();
+    symbol_ids_.clear();
+    rebuildSymbolContexts(trade_settings_);
+    
+    LOG_DEBUG("Built {} symbol contexts from {} trade settings", symbol_contexts_.size(), trade_settings_.size());
+    return symbol_contexts_.size();
+}
+
+ZerodhaClient::ContextChanges ZerodhaClient::rebuildSymbolContexts(const std::vector<TradeSetting>& settings) {
+    ContextChanges changes;
+    std::vector<SymbolContext> contexts;
+    std::unordered_map<std::string, uint32_t> ids;
+    contexts.reserve(settings.size());
+    
+    for (const auto& setting : settings) {
+        // A repeated row keeps the first setting, as the old scans did
+        if (ids.count(setting.symbol)) {
+            continue;
+        }
+        
+        SymbolContext context;
+        auto existing = symbol_ids_.find(setting.symbol);
+        if (existing != symbol_ids_.end()) {
+            // Keep the warmed-up state; a new timeframe needs new candles, a new period a new EMA
+            context = std::move(symbol_contexts_[existing->second]);
+            if (context.setting.timeframe != setting.timeframe) {
+                context.candles.clear();
+                context.ema_values.clear();
+                ++changes.rewarmed;
+            } else if (context.setting.ema_period != setting.ema_period) {
+                context.ema_values.clear();
+                ++changes.rewarmed;
+            }
+        } else {
+            InstrumentStore::Row row = instruments_.findAny(setting.symbol);
+            if (row == InstrumentStore::npos) {
+                continue; // not tradable with the loaded instruments
+            }
+            context.quote_key = std::string(instruments_.exchange(row)) + ":" + setting.symbol;
+            context.instrument_token = std::to_string(instruments_.instrumentToken(row));
+            context.tick_size = instruments_.tickSize(row);
+            portfolio_.registerSymbol(setting.symbol);
+            auto position = active_positions_.find(setting.symbol);
+            context.position = position == active_positions_.end() ? nullptr : &position->second;
+            ++changes.added;
+        }
+        
+        context.id = static_cast<uint32_t>(contexts.size());
+        context.setting = setting;
+        context.params = strategyParamsFor(setting);
+        ids[setting.symbol] = context.id;
+        contexts.push_back(std::move(context));
+    }
+    
+    // Symbols that left the file drop out of the scan; their open positions stay
+    // in active_positions_ and are still watched by checkPositionStatus()
+    changes.removed = symbol_contexts_.size() + changes.added - contexts.size();
+    symbol_contexts_.swap(contexts);
+    symbol_ids_.swap(ids);
+    
+    // Ids may have moved; bars are re-sent in each symbol's next turn of the loop
+    strategy_.reset(symbol_contexts_.size());
+    for (const SymbolContext& context : symbol_contexts_) {
+        strategy_.configure(context.id, context.params, context.tick_size);
+    }
+    if (rule_strategy_) {
+        configureRuleStrategy();
+    }
+    return changes;
+}
+
+bool ZerodhaClient::loadStrategyRules(const std::string& filename) {
+    StrategyRules rules;
+    if (!rules.load(filename)) {
+        return false;
+    }
+    rule_strategy_.reset(new RuleStrategy(rules));
+    configureRuleStrategy();
+    LOG_INFO("Strategy rules loaded from {}", filename);
+    return true;
+}
+
+void ZerodhaClient::configureRuleStrategy() {
+    rule_strategy_->reset(symbol_contexts_.size());
+    for (const SymbolContext& context : symbol_contexts_) {
+        rule_strategy_->configure(context.id, context.params, context.tick_size);
+    }
+}
+
+bool ZerodhaClient::watchTradeSettings(const std::string& filename, std::chrono::milliseconds interval) {
+    settings_watcher_.reset(new SettingsWatcher(filename, &ZerodhaClient::parseTradeSettings, interval));
+    settings_watcher_->publish(trade_settings_);
+    applied_settings_version_ = settings_watcher_->version();
+    return settings_watcher_->start();
+}
+
+void ZerodhaClient::applySettingsUpdate() {
+    if (!settings_watcher_ || settings_watcher_->version() == applied_settings_version_) {
+        return;
+    }
+    
+    // Only pointer and vector moves happen here; parsing was done on the watcher
+    // thread and any warm-up happens in the symbol's own turn of the loop
+    std::shared_ptr<const SettingsSnapshot> snapshot = settings_watcher_->current();
+    ContextChanges changes = rebuildSymbolContexts(snapshot->settings);
+    trade_settings_ = snapshot->settings;
+    applied_settings_version_ = snapshot->version;
+    settings_reloads_->inc();
+    
+    LOG_INFO("Trade settings version {} applied: {} symbols, {} added, {} removed, {} to re-warm",
+             snapshot->version, symbol_contexts_.size(), changes.added, changes.removed, changes.rewarmed);
+}
+
+SymbolContext* ZerodhaClient::findSymbolContext(const std::string& symbol) {
+    auto it = symbol_ids_.find(symbol);
+    return it == symbol_ids_.end() ? nullptr : &symbol_contexts_[it->second];
+}
+
+void ZerodhaClient::refreshCandles(SymbolContext& context,
+                                   const std::chrono::system_clock::time_point& from,
+                                   const std::chrono::system_clock::time_point& to) {
+    std::vector<CandleData> candles = getCandlesWithHistory(context.setting.symbol, context.setting.timeframe, from, to,
+                                                            context.instrument_token);
+    
+    // The first candle seeds the EMA, so values carry over only while the window
+    // starts at the same candle, and only up to the last candle that is unchanged
+    // (the newest one may have been still forming)
+    const std::vector<CandleData>& previous = context.candles;
+    size_t keep = 0;
+    if (!previous.empty() && !candles.empty() && previous.front().timestamp == candles.front().timestamp) {
+        keep = (std::min)(previous.size(), candles.size()) - 1;
+        while (keep > 0 && (previous[keep - 1].timestamp != candles[keep - 1].timestamp ||
+                            previous[keep - 1].close != candles[keep - 1].close)) {
+            --keep;
+        }
+    }
+    context.ema_values.resize((std::min)(keep, context.ema_values.size()));
+    context.candles.swap(candles);
+}
+
+void ZerodhaClient::updateEma(SymbolContext& context) {
+    const std::vector<CandleData>& candles = context.candles;
+    std::vector<double>& ema_values = context.ema_values;
+    if (context.setting.ema_period <= 0) {
+        ema_values.clear();
+        return;
+    }
+    
+    // Same recurrence as calculateEMA, continued from the last kept value
+    double multiplier = emaMultiplier(context.setting.ema_period);
+    ema_values.reserve(candles.size());
+    for (size_t i = ema_values.size(); i < candles.size(); ++i) {
+        double price = candles[i].close.toDouble();
+        ema_values.push_back(i == 0 ? price : (price * multiplier) + (ema_values[i - 1] * (1 - multiplier)));
+    }
+}
+
 std::string ZerodhaClient::formatDate(const std::chrono::system_clock::time_point& time) {
     auto time_t = std::chrono::system_clock::to_time_t(time);
     auto tm = *std::localtime(&time_t);
@@ -689,6 +1188,12 @@ std::string ZerodhaClient::formatDate(const std::chrono::system_clock::time_poin
     return oss.str();
 }
 
+int ZerodhaClient::currentDateYmd() {
+    auto time_t = std::chrono::system_clock::to_time_t(clock_->now());
+    auto tm = *std::localtime(&time_t);
+    return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+
 LastThreeCandles ZerodhaClient::getLastThreeCandles(const std::vector<CandleData>& candles, const std::vector<double>& ema_values) {
     LastThreeCandles data;
     
@@ -697,60 +1202,18 @@ LastThreeCandles ZerodhaClient::getLastThreeCandles(const std::vector<CandleData
         size_t second_idx = candles.size() - 2;
         size_t third_idx = candles.size() - 3;
         
-        // Print timestamps for verification (formatted for 5-minute boundaries)
-        std::cout << "\n=== Last 3 Candles Data ===" << std::endl;
-        std::cout << "Total candles available: " << candles.size() << std::endl;
-        std::cout << "Using candles at indices: " << third_idx << ", " << second_idx << ", " << last_idx << std::endl;
-        
-        // Format timestamp to show only 5-minute boundaries
-        auto format5MinTimestamp = [](const std::string& timestamp) -> std::string {
-            // Extract date and time from timestamp like "2025-07-18T11:58:12+0530"
-            if (timestamp.length() >= 16) {
-                std::string date_part = timestamp.substr(0, 10); // "2025-07-18"
-                std::string time_part = timestamp.substr(11, 5); // "11:58"
-                
-                // Round to nearest 5-minute boundary
-                int hour = std::stoi(time_part.substr(0, 2));
-                int minute = std::stoi(time_part.substr(3, 2));
-                int rounded_minute = (minute / 5) * 5; // Round down to nearest 5
-                
-                std::ostringstream oss;
-                oss << date_part << " " << std::setfill('0') << std::setw(2) << hour 
-                    << ":" << std::setfill('0') << std::setw(2) << rounded_minute;
-                return oss.str();
-            }
-            return timestamp;
-        };
-        
-        // Show raw timestamps first
-        std::cout << "Raw timestamps from API:" << std::endl;
-        std::cout << "Third candle (oldest): " << candles[third_idx].timestamp << std::endl;
-        std::cout << "Second candle: " << candles[second_idx].timestamp << std::endl;
-        std::cout << "Last candle (most recent): " << candles[last_idx].timestamp << std::endl;
-        
-        // Show formatted 5-minute timestamps
-        std::cout << "\nFormatted 5-minute timestamps:" << std::endl;
-        std::cout << "Third candle (oldest): " << format5MinTimestamp(candles[third_idx].timestamp)
-                  << " | O:" << candles[third_idx].open 
-                  << " H:" << candles[third_idx].high 
-                  << " L:" << candles[third_idx].low 
-                  << " C:" << candles[third_idx].close 
-                  << " EMA:" << ema_values[third_idx] << std::endl;
-        
-        std::cout << "Second candle: " << format5MinTimestamp(candles[second_idx].timestamp)
-                  << " | O:" << candles[second_idx].open 
-                  << " H:" << candles[second_idx].high 
-                  << " L:" << candles[second_idx].low 
-                  << " C:" << candles[second_idx].close 
-                  << " EMA:" << ema_values[second_idx] << std::endl;
-        
-        std::cout << "Last candle (most recent): " << format5MinTimestamp(candles[last_idx].timestamp)
-                  << " | O:" << candles[last_idx].open 
-                  << " H:" << candles[last_idx].high 
-                  << " L:" << candles[last_idx].low 
-                  << " C:" << candles[last_idx].close 
-                  << " EMA:" << ema_values[last_idx] << std::endl;
-        std::cout << "=================================" << std::endl;
+        // Candle dump for verification; compiled out below debug level
+        LOG_DEBUG("Last 3 candles: {} available, using indices {}, {}, {}", candles.size(), third_idx, second_idx,
+                  last_idx);
+        LOG_DEBUG("Third candle (oldest): {} ({}) | O:{} H:{} L:{} C:{} EMA:{}", formatFiveMinute(candles[third_idx].timestamp),
+                  candles[third_idx].timestamp, candles[third_idx].open, candles[third_idx].high,
+                  candles[third_idx].low, candles[third_idx].close, ema_values[third_idx]);
+        LOG_DEBUG("Second candle: {} ({}) | O:{} H:{} L:{} C:{} EMA:{}", formatFiveMinute(candles[second_idx].timestamp),
+                  candles[second_idx].timestamp, candles[second_idx].open, candles[second_idx].high,
+                  candles[second_idx].low, candles[second_idx].close, ema_values[second_idx]);
+        LOG_DEBUG("Last candle (most recent): {} ({}) | O:{} H:{} L:{} C:{} EMA:{}",
+                  formatFiveMinute(candles[last_idx].timestamp), candles[last_idx].timestamp, candles[last_idx].open,
+                  candles[last_idx].high, candles[last_idx].low, candles[last_idx].close, ema_values[last_idx]);
         
         // Last candle (most recent)
         data.last_open = candles[last_idx].open;
@@ -777,56 +1240,76 @@ LastThreeCandles ZerodhaClient::getLastThreeCandles(const std::vector<CandleData
     return data;
 }
 
-TradeSignal ZerodhaClient::analyzeStrategy(const std::string& symbol, const LastThreeCandles& data, double ltp) {
+TradeSignal ZerodhaClient::analyzeStrategy(const std::string& symbol, const LastThreeCandles& data, Price ltp) {
+    if (const SymbolContext* context = findSymbolContext(symbol)) {
+        return analyzeStrategy(*context, data, ltp);
+    }
+    
+    // Rule evaluation is shared with the backtester (see strategy.cpp)
+    StrategyParams params;
+    for (const auto& setting : trade_settings_) {
+        if (setting.symbol == symbol) {
+            params = strategyParamsFor(setting);
+            break;
+        }
+    }
+    return makeSignal(symbol, evaluateEmaStrategy(data, ltp, getTickSize(symbol), params));
+}
+
+TradeSignal ZerodhaClient::analyzeStrategy(const SymbolContext& context, const LastThreeCandles& data, Price ltp) {
+    return makeSignal(context.setting.symbol, evaluateEmaStrategy(data, ltp, context.tick_size, context.params));
+}
+
+TradeSignal ZerodhaClient::makeSignal(const std::string& symbol, const SignalDecision& decision) const {
     TradeSignal signal;
     signal.symbol = symbol;
     signal.quantity = 1; // Default quantity
     
-    // Buy Strategy
-    // thirdopen>thirdclose and secondopen>secondclose and secondclose>thirdclose and secondclose>secondema and thirdclose>thirdema and lastclose>lastema
-    if (data.third_open < data.third_close && 
-        data.second_open < data.second_close && 
-       // data.second_close > data.third_close && 
-        data.second_close > data.second_ema && 
-        data.third_close > data.third_ema && 
-        ltp > data.last_ema &&
-        ltp > data.second_high) {
-        
-        signal.action = "BUY";
-        signal.entry_price = ltp; // Use LTP instead of last candle close
-        // Stop loss: lowest of second and third candle lows
-        signal.stop_loss = (std::min)(data.second_low, data.third_low);
-        signal.target = ltp + (2 * (ltp - signal.stop_loss)); // Use LTP for target calculation
-        
-        std::cout << "BUY Signal for " << symbol << " - Entry: " << signal.entry_price 
-                  << ", SL: " << signal.stop_loss << ", Target: " << signal.target << std::endl;
-    }
-    // Sell Strategy
-    // thirdopen<thirdclose and secondopen<secondclose and secondclose<thirdclose and secondclose<secondema and thirdclose<thirdema and lastclose<lastema
-    else if (data.third_open > data.third_close && 
-             data.second_open > data.second_close && 
-            // data.second_close < data.third_close && 
-             data.second_close < data.second_ema && 
-             data.third_close < data.third_ema && 
-             ltp < data.last_ema &&
-             ltp < data.second_low) {
-        
-        signal.action = "SELL";
-        signal.entry_price = ltp; // Use LTP instead of last candle close
-        // Stop loss: highest of second and third candle highs
-        signal.stop_loss = (std::max)(data.second_high, data.third_high);
-        signal.target = ltp - (2 * (signal.stop_loss - ltp)); // Use LTP for target calculation
-        
-        std::cout << "SELL Signal for " << symbol << " - Entry: " << signal.entry_price 
-                  << ", SL: " << signal.stop_loss << ", Target: " << signal.target << std::endl;
+    if (decision.side == SignalSide::None) {
+        return signal;
     }
     
+    signal.action = decision.side == SignalSide::Buy ? "BUY" : "SELL";
+    signal.entry_price = decision.entry_price; // Use LTP instead of last candle close
+    signal.stop_loss = decision.stop_loss;
+    signal.target = decision.target;
+    
+    LOG_INFO("{} Signal for {} - Entry: {}, SL: {}, Target: {}", signal.action, symbol, signal.entry_price,
+             signal.stop_loss, signal.target);
+    
     return signal;
 }
 
-bool ZerodhaClient::placeOrder(const TradeSignal& signal) {
+std::map<std::string, std::string> ZerodhaClient::buildOrderPayload(const std::string& symbol,
+                                                                   const std::string& transaction_type,
+                                                                   const std::string& order_type,
+                                                                   int quantity,
+                                                                   const std::string& tag,
+                                                                   Price price,
+                                                                   Price trigger_price) const {
+    std::map<std::string, std::string> order_data;
+    order_data["tradingsymbol"] = symbol;
+    order_data["exchange"] = getInstrumentExchange(symbol);
+    order_data["transaction_type"] = transaction_type;
+    order_data["order_type"] = order_type;
+    order_data["quantity"] = std::to_string(quantity);
+    order_data["product"] = "MIS"; // Intraday
+    order_data["validity"] = "DAY";
+    if (!price.isZero()) {
+        order_data["price"] = price.toString();
+    }
+    if (!trigger_price.isZero()) {
+        order_data["trigger_price"] = trigger_price.toString();
+    }
+    
+    // Add tag for identification
+    order_data["tag"] = tag;
+    return order_data;
+}
+
+bool ZerodhaClient::placeOrder(const TradeSignal& signal, LatencyTrace* trace) {
     if (!isLoggedIn()) {
-        std::cerr << "Error: Not logged in. Cannot place order." << std::endl;
+        LOG_ERROR("Not logged in. Cannot place order.");
         return false;
     }
     
@@ -834,81 +1317,146 @@ bool ZerodhaClient::placeOrder(const TradeSignal& signal) {
         return false; // No signal
     }
     
-    std::cout << "Placing " << signal.action << " order for " << signal.symbol << std::endl;
+    LOG_INFO("Placing {} order for {}", signal.action, signal.symbol);
     
     // Prepare order data
-    std::map<std::string, std::string> order_data;
-    order_data["tradingsymbol"] = signal.symbol;
-    order_data["exchange"] = "NSE";
-    order_data["transaction_type"] = (signal.action == "BUY" || signal.action == "BUY_STOPLOSS" || signal.action == "SELL_TARGET") ? "BUY" : "SELL";
-    order_data["order_type"] = "MARKET";
-    order_data["quantity"] = std::to_string(signal.quantity);
-    order_data["product"] = "MIS"; // Intraday
-    order_data["validity"] = "DAY";
-    
-    // Add tag for identification
-    order_data["tag"] = "TradingBot_" + signal.action;
+    bool buy = signal.action == "BUY" || signal.action == "BUY_STOPLOSS" || signal.action == "SELL_TARGET";
+    
+    // Pre-trade limits (see risk_gate.h); constant time, no allocation
+    RiskVerdict verdict = risk_.check(portfolio_.find(signal.symbol), buy, signal.quantity, signal.entry_price,
+                                      clockMillis(*clock_));
+    if (verdict != RiskVerdict::Accept) {
+        risk_rejections_[static_cast<size_t>(verdict)]->inc();
+        LOG_WARN("Risk gate blocked {} {} x{}: {}", signal.action, signal.symbol, signal.quantity,
+                 RiskGate::verdictName(verdict));
+        return false;
+    }
+    std::map<std::string, std::string> order_data =
+        buildOrderPayload(signal.symbol, buy ? "BUY" : "SELL", "MARKET", signal.quantity, "TradingBot_" + signal.action);
     
     std::map<std::string, std::string> headers = getAuthHeaders();
     
     // Place order
-    cpr::Response response = makePostRequest("https://api.kite.trade/orders/regular", order_data, headers);
+    uint32_t ref = order_manager_.create(signal.symbol, OrderLeg::Entry, buy, signal.quantity, signal.entry_price);
+    risk_.onOrderSent(clockMillis(*clock_));
+    cpr::Response response = makePostRequest(apiUrl(ORDERS_PATH), order_data, headers);
+    if (trace) trace->stamp(LatencyStage::OrderSend);
     
-    std::cout << "Order Response Status: " << response.status_code << std::endl;
-    std::cout << "Order Response: " << response.text << std::endl;
+    LOG_DEBUG("Order Response Status: {} Response: {}", response.status_code, response.text);
     
     if (response.status_code == 200) {
         try {
             nlohmann::json json = nlohmann::json::parse(response.text);
             if (json["status"] == "success") {
                 std::string order_id = json["data"]["order_id"];
-                std::cout << "Order placed successfully! Order ID: " << order_id << std::endl;
+                LOG_INFO("Order placed successfully! Order ID: {}", order_id);
+                orders_entry_->inc();
+                orderAccepted(ref, order_id);
                 
                 // Log the entry order
                 logOrder(signal.symbol, signal.action, order_id, signal.entry_price, signal.quantity, "ENTRY");
+                if (trace) {
+                    trace->stamp(LatencyStage::OrderParse);
+                    trace->total(LatencyStage::TickToOrder);
+                }
                 
                 // Add to active positions and place SL/Target orders
                 addActivePosition(signal.symbol, order_id, signal);
                 
                 // Place Stop Loss order
-                std::cout << "Placing Stop Loss order..." << std::endl;
-                if (placeStopLossOrder(signal.symbol, signal.action, signal.stop_loss, signal.quantity)) {
-                    active_positions_[signal.symbol].stop_loss_placed = true;
-                    std::cout << "Stop Loss order placed successfully!" << std::endl;
-                } else {
-                    std::cerr << "Failed to place Stop Loss order!" << std::endl;
+                if (!placeStopLossOrder(signal.symbol, signal.action, signal.stop_loss, signal.quantity)) {
+                    LOG_ERROR("Failed to place Stop Loss order for {}", signal.symbol);
                 }
                 
                 // Place Target order
-                std::cout << "Placing Target order..." << std::endl;
-                if (placeTargetOrder(signal.symbol, signal.action, signal.target, signal.quantity)) {
-                    active_positions_[signal.symbol].target_placed = true;
-                    std::cout << "Target order placed successfully!" << std::endl;
-                } else {
-                    std::cerr << "Failed to place Target order!" << std::endl;
+                if (!placeTargetOrder(signal.symbol, signal.action, signal.target, signal.quantity)) {
+                    LOG_ERROR("Failed to place Target order for {}", signal.symbol);
+                }
+                if (trace) {
+                    trace->stamp(LatencyStage::ProtectiveLegs);
+                    trace->total(LatencyStage::TickToLegs);
                 }
                 
                 return true;
             } else {
-                std::cerr << "Order placement failed: " << json["message"] << std::endl;
+                LOG_ERROR("Order placement failed: {}", json.value("message", std::string()));
+                order_manager_.reject(ref);
                 return false;
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error parsing order response: " << e.what() << std::endl;
+            LOG_ERROR("Error parsing order response: {}", e.what());
+            order_manager_.reject(ref);
             return false;
         }
     } else {
-        std::cerr << "Order placement failed with status: " << response.status_code << std::endl;
+        LOG_ERROR("Order placement failed with status: {}", response.status_code);
+        order_manager_.reject(ref);
         return false;
     }
 }
 
+// Resets day-scoped state when the date changes (and on the first pass)
+void ZerodhaClient::startTradingDay() {
+    int today = currentDateYmd();
+    if (today == trading_day_) {
+        return;
+    }
+    bool first = trading_day_ == 0;
+    trading_day_ = today;
+    
+    // After a restart, losses booked earlier today still count; OrderLog.txt
+    // only holds live trades, so replays start from zero
+    int64_t booked = first && !clock_->isVirtual() && !traffic_replayer_ ? bookedTodayPaise() : 0;
+    risk_.startDay(booked);
+    LOG_INFO("Trading day {} started; P&L booked earlier today: {}", today, Price::fromPaise(booked));
+    
+    if (first) {
+        return;
+    }
+    
+    // The previous session's candles go to disk as one block per store
+    for (auto& store : candle_stores_) {
+        store.second->flush();
+    }
+    
+    // Yesterday's intraday orders are all closed; free the table for today's
+    std::lock_guard<std::mutex> lock(order_reset_mutex_);
+    LOG_INFO("Order table reset: {} orders yesterday, {} still live", order_manager_.size(), order_manager_.live());
+    order_manager_.reset();
+}
+
+// Realized P&L of today's closed trades in OrderLog.txt
+int64_t ZerodhaClient::bookedTodayPaise() {
+    std::error_code ec;
+    if (!std::filesystem::exists("OrderLog.txt", ec)) {
+        return 0;
+    }
+    OrderLogIndex index;
+    if (!index.add("OrderLog.txt")) {
+        return 0;
+    }
+    auto time_t = std::chrono::system_clock::to_time_t(clock_->now());
+    int64_t day = orderLogTimestamp(*std::localtime(&time_t)) / 86400;
+    return analyzeOrderLog(index, day, day).total.pnl_paise;
+}
+
 void ZerodhaClient::runTradingLoop() {
     std::cout << "Starting continuous trading loop..." << std::endl;
+    if (symbol_contexts_.empty()) {
+        buildSymbolContexts();
+    }
     
-    while (true) {
+    while (!stop_requested_ && clock_->now() < stop_at_) {
+        applySettingsUpdate();
+        applyReconcileReport();
+        publishPositions();
+        if (latency_report_requested_.exchange(false)) {
+            latency_.report(std::cout);
+        }
+        startTradingDay();
+        
         // Get current time
-        auto now = std::chrono::system_clock::now();
+        auto now = clock_->now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
         auto tm = *std::localtime(&time_t);
         
@@ -918,74 +1466,73 @@ void ZerodhaClient::runTradingLoop() {
         
         if (current_hour < 9 || (current_hour == 9 && current_minute < 25) ||     
             current_hour > 23 || (current_hour == 23 && current_minute > 30)) {
-            std::cout << "Market is closed. Waiting..." << std::endl;
-            std::this_thread::sleep_for(std::chrono::minutes(5));
+            LOG_INFO("Market is closed. Waiting...");
+            clock_->sleepFor(std::chrono::minutes(5));
             continue;
         }
         
-        std::cout << "\n=== Continuous Trading Loop ===" << std::endl;
+        LOG_DEBUG("=== Continuous Trading Loop ===");
+        auto pass_start = std::chrono::steady_clock::now();
+        
+        // Daily options chain refresh (date check only; rebuilds when the day changes)
+        refreshOptionsChain();
         
         // Check position status (SL/Target hits)
         checkPositionStatus();
         
         // Process each symbol continuously
-        for (const auto& symbol : getMatchedSymbols()) {
+        for (SymbolContext& context : symbol_contexts_) {
+            const std::string& symbol = context.setting.symbol;
             // Skip if already have active position (Rule 1: Wait for target/SL before new trade)
-            if (hasActivePosition(symbol)) {
-                std::cout << "Skipping " << symbol << " - Already has active position" << std::endl;
+            if (context.position) {
+                LOG_DEBUG("Skipping {} - Already has active position", symbol);
                 continue;
             }
             
-            std::cout << "Analyzing " << symbol << "..." << std::endl;
+            LOG_DEBUG("Analyzing {}...", symbol);
+            symbols_scanned_->inc();
             
             // Get current LTP for the symbol
-            double ltp = getLTP(symbol);
+            LatencyTrace trace(latency_);
+            Price ltp = getLTP(context);
+            trace.stamp(LatencyStage::Quote);
             
-            // Get timeframe and EMA period from trade settings
-            std::string timeframe = "5minute";
-            int ema_period = 20;
-            for (const auto& setting : getTradeSettings()) {
-                if (setting.symbol == symbol) {
-                    timeframe = setting.timeframe;
-                    ema_period = setting.ema_period;
-                    break;
-                }
-            }
-            
-            // Get historical data for EMA calculation (fetch 10 days of data)
-            // 10 days = 240 hours = 2880 candles for 5-minute timeframe
+            // Get historical data for EMA calculation (10 days of data)
+            // 10 days = 240 hours = 2880 candles for 5-minute timeframe; only the
+            // candles newer than the local store are downloaded
             auto data_start_time = now - std::chrono::hours(240); // 10 days of data
-            std::string from_date = formatDate(data_start_time);
-            std::string to_date = formatDate(now);
             
-            std::vector<CandleData> candles = getHistoricalData(symbol, timeframe, from_date, to_date);
+            refreshCandles(context, data_start_time, now);
+            trace.stamp(LatencyStage::Candles);
             
             // Add 1-second delay after fetching historical data to avoid API rate limits
-            std::this_thread::sleep_for(std::chrono::seconds(2));
+            rateLimitWait(std::chrono::seconds(2));
+            trace.skip();
             
-            // Debug: Print raw timestamp data from API
-            std::cout << "Fetched " << candles.size() << " candles for " << symbol << " (expected ~2880 candles for 10 days of 5-min data)" << std::endl;
+            const std::vector<CandleData>& candles = context.candles;
+            LOG_DEBUG("Fetched {} candles for {} (expected ~2880 candles for 10 days of 5-min data)", candles.size(), symbol);
             if (!candles.empty()) {
-                std::cout << "First candle timestamp: " << candles[0].timestamp << std::endl;
-                std::cout << "Last candle timestamp: " << candles[candles.size()-1].timestamp << std::endl;
+                LOG_DEBUG("First candle timestamp: {}, last: {}", candles.front().timestamp, candles.back().timestamp);
             }
             
             // Save raw data to CSV for verification (exactly as received from API)
             // saveInstrumentDataToCSV(symbol + "_raw", candles, ema_values);
             
             if (candles.size() >= 3) {
-                std::vector<double> close_prices;
-                for (const auto& candle : candles) {
-                    close_prices.push_back(candle.close);
-                }
-                std::vector<double> ema_values = calculateEMA(close_prices, ema_period);
-                // Get last 3 candles
-                LastThreeCandles last_three = getLastThreeCandles(candles, ema_values);
-                // Analyze strategy
-                TradeSignal signal = analyzeStrategy(symbol, last_three, ltp);
+                updateEma(context);
+                trace.stamp(LatencyStage::Ema);
+                LOG_DEBUG("Last candle: {} | O:{} H:{} L:{} C:{} EMA:{}", formatFiveMinute(candles.back().timestamp),
+                          candles.back().open, candles.back().high, candles.back().low, candles.back().close,
+                          context.ema());
+                // Bar and tick events, then the rule over the column state (no window copy)
+                TradeSignal signal = makeSignal(symbol, rule_strategy_ ? decideWith(*rule_strategy_, context, ltp)
+                                                                      : decideWith(strategy_, context, ltp));
+                trace.stamp(LatencyStage::Signal);
+                trace.total(LatencyStage::TickToSignal);
                 // Place order if signal exists
                 if (!signal.action.empty()) {
-                    placeOrder(signal);
+                    (signal.action == "BUY" ? signals_buy_ : signals_sell_)->inc();
+                    placeOrder(signal, &trace);
                 }
             }
             
@@ -993,116 +1540,122 @@ void ZerodhaClient::runTradingLoop() {
             checkPositionStatusWithLTP(symbol, ltp);
             
             // Small delay between symbols (continuous monitoring)
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            rateLimitWait(std::chrono::milliseconds(100));
         }
         
+        loop_passes_->inc();
+        loop_pass_seconds_->set(std::chrono::duration<double>(std::chrono::steady_clock::now() - pass_start).count());
+        
         // Continuous monitoring - no 5-minute wait
-        std::this_thread::sleep_for(std::chrono::seconds(10)); // Check every 10 seconds
+        clock_->sleepFor(std::chrono::seconds(10)); // Check every 10 seconds
     }
+    
+    if (reconciler_) {
+        reconciler_->stop();
+    }
+    std::cout << "Trading loop stopped." << std::endl;
+    PortfolioTotals totals = portfolio_.snapshot();
+    std::cout << "Session P&L: realized " << Price::fromPaise(totals.realized_pnl_paise) << ", unrealized "
+              << Price::fromPaise(totals.unrealized_pnl_paise) << " over " << totals.open_positions
+              << " open positions" << std::endl;
+    latency_.report(std::cout);
 }
 
 // Position management methods
-bool ZerodhaClient::placeStopLossOrder(const std::string& symbol, const std::string& action, double stop_loss, int quantity) {
+bool ZerodhaClient::placeStopLossOrder(const std::string& symbol, const std::string& action, Price stop_loss, int quantity) {
     if (!isLoggedIn()) {
-        std::cerr << "Error: Not logged in. Cannot place stop loss order." << std::endl;
+        LOG_ERROR("Not logged in. Cannot place stop loss order.");
         return false;
     }
     
-    std::cout << "Placing Stop Loss order for " << symbol << " at " << stop_loss << std::endl;
-    
-    // Prepare order data
-    std::map<std::string, std::string> order_data;
-    order_data["tradingsymbol"] = symbol;
-    order_data["exchange"] = "NSE";
-    order_data["transaction_type"] = (action == "BUY") ? "SELL" : "BUY"; // Opposite of entry
-    order_data["order_type"] = "SL"; // Stop Loss order type
-    order_data["quantity"] = std::to_string(quantity);
-    order_data["product"] = "MIS"; // Intraday
-    order_data["validity"] = "DAY";
-    order_data["trigger_price"] = std::to_string(stop_loss);
-    order_data["price"] = std::to_string(stop_loss);
+    LOG_INFO("Placing Stop Loss order for {} at {}", symbol, stop_loss);
     
-    // Add tag for identification
-    order_data["tag"] = "TradingBot_SL";
+    // Stop Loss order on the opposite side of the entry
+    std::map<std::string, std::string> order_data =
+        buildOrderPayload(symbol, (action == "BUY") ? "SELL" : "BUY", "SL", quantity, "TradingBot_SL", stop_loss, stop_loss);
     
     std::map<std::string, std::string> headers = getAuthHeaders();
     
     // Place order
-    cpr::Response response = makePostRequest("https://api.kite.trade/orders/regular", order_data, headers);
+    uint32_t ref = order_manager_.create(symbol, OrderLeg::StopLoss, action != "BUY", quantity, stop_loss);
+    risk_.onOrderSent(clockMillis(*clock_));
+    cpr::Response response = makePostRequest(apiUrl(ORDERS_PATH), order_data, headers);
     
-    std::cout << "Stop Loss Order Response Status: " << response.status_code << std::endl;
-    std::cout << "Stop Loss Order Response: " << response.text << std::endl;
+    LOG_DEBUG("Stop Loss Order Response Status: {} Response: {}", response.status_code, response.text);
     
     if (response.status_code == 200) {
         try {
             nlohmann::json json = nlohmann::json::parse(response.text);
             if (json["status"] == "success") {
                 std::string order_id = json["data"]["order_id"];
-                std::cout << "Stop Loss order placed successfully! Order ID: " << order_id << std::endl;
+                LOG_INFO("Stop Loss order placed successfully! Order ID: {}", order_id);
+                orders_stoploss_->inc();
+                orderAccepted(ref, order_id);
+                recordLegPlaced(symbol, true, order_id);
                 logOrder(symbol, (action == "BUY") ? "SELL" : "BUY", order_id, stop_loss, quantity, "STOPLOSS");
                 return true;
             } else {
-                std::cerr << "Stop Loss order placement failed: " << json["message"] << std::endl;
+                LOG_ERROR("Stop Loss order placement failed: {}", json.value("message", std::string()));
+                order_manager_.reject(ref);
                 return false;
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error parsing stop loss order response: " << e.what() << std::endl;
+            LOG_ERROR("Error parsing stop loss order response: {}", e.what());
+            order_manager_.reject(ref);
             return false;
         }
     } else {
-        std::cerr << "Stop Loss order placement failed with status: " << response.status_code << std::endl;
+        LOG_ERROR("Stop Loss order placement failed with status: {}", response.status_code);
+        order_manager_.reject(ref);
         return false;
     }
 }
 
-bool ZerodhaClient::placeTargetOrder(const std::string& symbol, const std::string& action, double target, int quantity) {
+bool ZerodhaClient::placeTargetOrder(const std::string& symbol, const std::string& action, Price target, int quantity) {
     if (!isLoggedIn()) {
-        std::cerr << "Error: Not logged in. Cannot place target order." << std::endl;
+        LOG_ERROR("Not logged in. Cannot place target order.");
         return false;
     }
     
-    std::cout << "Placing Target order for " << symbol << " at " << target << std::endl;
+    LOG_INFO("Placing Target order for {} at {}", symbol, target);
     
-    // Prepare order data
-    std::map<std::string, std::string> order_data;
-    order_data["tradingsymbol"] = symbol;
-    order_data["exchange"] = "NSE";
-    order_data["transaction_type"] = (action == "BUY") ? "SELL" : "BUY"; // Opposite of entry
-    order_data["order_type"] = "LIMIT"; // Limit order for target
-    order_data["quantity"] = std::to_string(quantity);
-    order_data["product"] = "MIS"; // Intraday
-    order_data["validity"] = "DAY";
-    order_data["price"] = std::to_string(target);
-    
-    // Add tag for identification
-    order_data["tag"] = "TradingBot_TARGET";
+    // Limit order for the target on the opposite side of the entry
+    std::map<std::string, std::string> order_data =
+        buildOrderPayload(symbol, (action == "BUY") ? "SELL" : "BUY", "LIMIT", quantity, "TradingBot_TARGET", target);
     
     std::map<std::string, std::string> headers = getAuthHeaders();
     
     // Place order
-    cpr::Response response = makePostRequest("https://api.kite.trade/orders/regular", order_data, headers);
+    uint32_t ref = order_manager_.create(symbol, OrderLeg::Target, action != "BUY", quantity, target);
+    risk_.onOrderSent(clockMillis(*clock_));
+    cpr::Response response = makePostRequest(apiUrl(ORDERS_PATH), order_data, headers);
     
-    std::cout << "Target Order Response Status: " << response.status_code << std::endl;
-    std::cout << "Target Order Response: " << response.text << std::endl;
+    LOG_DEBUG("Target Order Response Status: {} Response: {}", response.status_code, response.text);
     
     if (response.status_code == 200) {
         try {
             nlohmann::json json = nlohmann::json::parse(response.text);
             if (json["status"] == "success") {
                 std::string order_id = json["data"]["order_id"];
-                std::cout << "Target order placed successfully! Order ID: " << order_id << std::endl;
+                LOG_INFO("Target order placed successfully! Order ID: {}", order_id);
+                orders_target_->inc();
+                orderAccepted(ref, order_id);
+                recordLegPlaced(symbol, false, order_id);
                 logOrder(symbol, (action == "BUY") ? "SELL" : "BUY", order_id, target, quantity, "TARGET");
                 return true;
             } else {
-                std::cerr << "Target order placement failed: " << json["message"] << std::endl;
+                LOG_ERROR("Target order placement failed: {}", json.value("message", std::string()));
+                order_manager_.reject(ref);
                 return false;
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error parsing target order response: " << e.what() << std::endl;
+            LOG_ERROR("Error parsing target order response: {}", e.what());
+            order_manager_.reject(ref);
             return false;
         }
     } else {
-        std::cerr << "Target order placement failed with status: " << response.status_code << std::endl;
+        LOG_ERROR("Target order placement failed with status: {}", response.status_code);
+        order_manager_.reject(ref);
         return false;
     }
 }
@@ -1119,76 +1672,344 @@ void ZerodhaClient::addActivePosition(const std::string& symbol, const std::stri
     position.stop_loss_placed = false;
     position.target_placed = false;
     
-    active_positions_[symbol] = position;
-    std::cout << "Added active position for " << symbol << " - Entry Order ID: " << entry_order_id << std::endl;
+    ActivePosition& slot = active_positions_[symbol];
+    slot = position;
+    // Market entry: booked as filled at the signal price, as the rest of the bot assumes
+    portfolio_.onFill(portfolio_.registerSymbol(symbol), signal.action == "BUY", signal.quantity, signal.entry_price);
+    if (SymbolContext* context = findSymbolContext(symbol)) {
+        context->position = &slot;
+    }
+    active_positions_gauge_->set(static_cast<double>(active_positions_.size()));
+    ++positions_version_;
+    if (journal_) {
+        journal_->opened(position, clockMillis(*clock_));
+    }
+    LOG_INFO("Added active position for {} - Entry Order ID: {}", symbol, entry_order_id);
+}
+
+void ZerodhaClient::orderAccepted(uint32_t ref, const std::string& order_id) {
+    if (!order_manager_.bindBrokerId(ref, order_id) || !order_manager_.acknowledge(ref)) {
+        LOG_WARN("Order {} is not tracked by the order manager", order_id);
+    }
+}
+
+void ZerodhaClient::recordLegPlaced(const std::string& symbol, bool stop_loss, const std::string& order_id) {
+    auto it = active_positions_.find(symbol);
+    if (it == active_positions_.end()) {
+        return;
+    }
+    ActivePosition& position = it->second;
+    ++positions_version_;
+    if (stop_loss) {
+        position.stop_loss_placed = true;
+        position.stop_loss_order_id = order_id;
+        if (journal_) journal_->stopLossPlaced(symbol, order_id, clockMillis(*clock_));
+    } else {
+        position.target_placed = true;
+        position.target_order_id = order_id;
+        if (journal_) journal_->targetPlaced(symbol, order_id, clockMillis(*clock_));
+    }
+}
+
+bool ZerodhaClient::openPositionJournal(const std::string& path) {
+    auto started = std::chrono::steady_clock::now();
+    std::unique_ptr<PositionJournal> journal(new PositionJournal());
+    if (!journal->open(path, active_positions_)) {
+        return false;
+    }
+    journal_ = std::move(journal);
+    for (const auto& entry : active_positions_) {
+        const ActivePosition& position = entry.second;
+        portfolio_.onFill(portfolio_.registerSymbol(position.symbol), position.action == "BUY", position.quantity,
+                          position.entry_price);
+    }
+    
+    for (auto& context : symbol_contexts_) {
+        auto it = active_positions_.find(context.setting.symbol);
+        context.position = it == active_positions_.end() ? nullptr : &it->second;
+    }
+    active_positions_gauge_->set(static_cast<double>(active_positions_.size()));
+    ++positions_version_;
+    
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    LOG_INFO("Position journal {}: {} records, {} open positions recovered in {} ms", path,
+             journal_->replayedRecords(), active_positions_.size(), millis);
+    
+    if (!active_positions_.empty() && isLoggedIn()) {
+        reconcileRecoveredPositions();
+    }
+    return true;
+}
+
+bool ZerodhaClient::fetchOrders(std::vector<BrokerOrder>& orders) {
+    orders.clear();
+    if (!isLoggedIn()) {
+        LOG_ERROR("Not logged in. Cannot fetch orders.");
+        return false;
+    }
+    
+    cpr::Response response = makeRequest(apiUrl(ORDER_BOOK_PATH), {}, getAuthHeaders());
+    if (response.status_code != 200) {
+        LOG_ERROR("Failed to fetch the order book. Status: {}", response.status_code);
+        return false;
+    }
+    
+    try {
+        nlohmann::json json = nlohmann::json::parse(response.text);
+        if (json["status"] != "success" || !json["data"].is_array()) {
+            LOG_ERROR("Order book request failed: {}", json.value("message", std::string()));
+            return false;
+        }
+        orders.reserve(json["data"].size());
+        for (const auto& item : json["data"]) {
+            BrokerOrder order;
+            order.order_id = item.value("order_id", std::string());
+            order.status = item.value("status", std::string());
+            order.symbol = item.value("tradingsymbol", std::string());
+            order.transaction_type = item.value("transaction_type", std::string());
+            order.order_type = item.value("order_type", std::string());
+            order.tag = item["tag"].is_string() ? item["tag"].get<std::string>() : std::string();
+            order.quantity = item.value("quantity", 0);
+            order.filled_quantity = item.value("filled_quantity", 0);
+            order.average_price = Price::fromDouble(item.value("average_price", 0.0));
+            orders.push_back(std::move(order));
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error parsing order book: {}", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool ZerodhaClient::fetchPositions(std::vector<BrokerPosition>& positions) {
+    positions.clear();
+    if (!isLoggedIn()) {
+        LOG_ERROR("Not logged in. Cannot fetch positions.");
+        return false;
+    }
+    
+    cpr::Response response = makeRequest(apiUrl(POSITIONS_PATH), {}, getAuthHeaders());
+    if (response.status_code != 200) {
+        LOG_ERROR("Failed to fetch positions. Status: {}", response.status_code);
+        return false;
+    }
+    
+    try {
+        nlohmann::json json = nlohmann::json::parse(response.text);
+        if (json["status"] != "success" || !json["data"]["net"].is_array()) {
+            LOG_ERROR("Positions request failed: {}", json.value("message", std::string()));
+            return false;
+        }
+        const nlohmann::json& net = json["data"]["net"];
+        positions.reserve(net.size());
+        for (const auto& item : net) {
+            BrokerPosition position;
+            position.symbol = item.value("tradingsymbol", std::string());
+            position.exchange = item.value("exchange", std::string());
+            position.product = item.value("product", std::string());
+            position.quantity = item.value("quantity", 0);
+            position.average_price = Price::fromDouble(item.value("average_price", 0.0));
+            positions.push_back(std::move(position));
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Error parsing positions: {}", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool ZerodhaClient::startReconciler(std::chrono::milliseconds interval) {
+    if (traffic_replayer_) {
+        // Recorded traffic is served in order; extra requests from another thread would desync it
+        LOG_WARN("Broker reconciliation is off while replaying recorded traffic");
+        return false;
+    }
+    reconciler_.reset(new Reconciler(
+        [this](std::vector<BrokerOrder>& orders, std::vector<BrokerPosition>& positions) {
+            if (!fetchOrders(orders)) {
+                return false;
+            }
+            // The order book doubles as the order-update feed for the lifecycle table
+            std::lock_guard<std::mutex> lock(order_reset_mutex_);
+            for (const auto& order : orders) {
+                order_manager_.applyBrokerStatus(order.order_id, order.status, order.filled_quantity);
+            }
+            return fetchPositions(positions);
+        },
+        interval));
+    publishPositions();
+    return reconciler_->start();
+}
+
+void ZerodhaClient::publishPositions() {
+    if (!reconciler_ || published_positions_version_ == positions_version_) {
+        return;
+    }
+    std::vector<ActivePosition> positions;
+    positions.reserve(active_positions_.size());
+    for (const auto& entry : active_positions_) {
+        positions.push_back(entry.second);
+    }
+    reconciler_->publishLocal(positions_version_, std::move(positions));
+    published_positions_version_ = positions_version_;
+}
+
+void ZerodhaClient::applyReconcileReport() {
+    if (!reconciler_ || reconciler_->sequence() == applied_reconcile_sequence_) {
+        return;
+    }
+    std::shared_ptr<const ReconcileReport> report = reconciler_->latest();
+    applied_reconcile_sequence_ = report->sequence;
+    if (report->local_version != positions_version_) {
+        // Positions changed while the books were being fetched; the next pass will catch up
+        LOG_DEBUG("Discarding reconciliation report {} (positions version {} now {})",
+                  report->sequence, report->local_version, positions_version_);
+        return;
+    }
+    reconcile_passes_->inc();
+    
+    for (const auto& discrepancy : report->discrepancies) {
+        reconcile_discrepancies_[static_cast<size_t>(discrepancy.kind)]->inc();
+        LOG_WARN("Reconciliation: {} {} leg={} order={} expected_qty={} broker_qty={}",
+                 Discrepancy::kindName(discrepancy.kind), discrepancy.symbol, Discrepancy::legName(discrepancy.leg),
+                 discrepancy.order_id, discrepancy.expected_quantity, discrepancy.broker_quantity);
+        
+        auto it = active_positions_.find(discrepancy.symbol);
+        if (it == active_positions_.end()) {
+            continue;
+        }
+        // Only unambiguous cases are repaired; the rest needs a human
+        if (discrepancy.kind == Discrepancy::Kind::MissedFill && discrepancy.leg == Discrepancy::Leg::StopLoss) {
+            logStopLossHit(discrepancy.symbol, it->second.stop_loss);
+            removeActivePosition(discrepancy.symbol, it->second.stop_loss);
+        } else if (discrepancy.kind == Discrepancy::Kind::MissedFill && discrepancy.leg == Discrepancy::Leg::Target) {
+            logTargetHit(discrepancy.symbol, it->second.target);
+            removeActivePosition(discrepancy.symbol, it->second.target);
+        } else if (discrepancy.kind == Discrepancy::Kind::UntrackedLeg) {
+            recordLegPlaced(discrepancy.symbol, discrepancy.leg == Discrepancy::Leg::StopLoss, discrepancy.order_id);
+        }
+    }
+    if (!report->discrepancies.empty()) {
+        LOG_INFO("Reconciled {} orders and {} positions: {} discrepancies", report->orders, report->positions,
+                 report->discrepancies.size());
+    }
+}
+
+void ZerodhaClient::reconcileRecoveredPositions() {
+    // One order book request covers every recovered position
+    std::vector<BrokerOrder> orders;
+    if (!fetchOrders(orders)) {
+        LOG_WARN("Could not reconcile recovered positions; keeping the journal's view");
+        return;
+    }
+    std::unordered_map<std::string, const BrokerOrder*> by_id;
+    by_id.reserve(orders.size());
+    for (const auto& order : orders) {
+        by_id[order.order_id] = &order;
+    }
+    auto status = [&by_id](const std::string& order_id) -> std::string {
+        auto it = by_id.find(order_id);
+        return it == by_id.end() ? std::string() : it->second->status;
+    };
+    
+    std::vector<std::pair<std::string, Price>> closed; // symbol, exit price (none if never filled)
+    for (const auto& entry : active_positions_) {
+        const ActivePosition& position = entry.second;
+        std::string entry_status = status(position.entry_order_id);
+        if (entry_status.empty() || entry_status == "REJECTED" || entry_status == "CANCELLED") {
+            // Not in today's book (intraday positions do not carry over) or never filled
+            LOG_WARN("Dropping recovered {}: entry order {} is {}", position.symbol, position.entry_order_id,
+                     entry_status.empty() ? std::string("not in today's order book") : entry_status);
+            closed.emplace_back(position.symbol, Price());
+        } else if (position.stop_loss_placed && status(position.stop_loss_order_id) == "COMPLETE") {
+            LOG_INFO("Recovered {} was stopped out while the bot was down", position.symbol);
+            logStopLossHit(position.symbol, position.stop_loss);
+            closed.emplace_back(position.symbol, position.stop_loss);
+        } else if (position.target_placed && status(position.target_order_id) == "COMPLETE") {
+            LOG_INFO("Recovered {} reached its target while the bot was down", position.symbol);
+            logTargetHit(position.symbol, position.target);
+            closed.emplace_back(position.symbol, position.target);
+        }
+    }
+    for (const auto& position : closed) {
+        removeActivePosition(position.first, position.second);
+    }
+    LOG_INFO("Reconciled {} recovered positions against {} orders; {} still open",
+             active_positions_.size() + closed.size(), orders.size(), active_positions_.size());
 }
 
 bool ZerodhaClient::hasActivePosition(const std::string& symbol) {
     return active_positions_.find(symbol) != active_positions_.end();
 }
 
-void ZerodhaClient::removeActivePosition(const std::string& symbol) {
-    if (active_positions_.find(symbol) != active_positions_.end()) {
-        active_positions_.erase(symbol);
-        std::cout << "Removed active position for " << symbol << std::endl;
+void ZerodhaClient::removeActivePosition(const std::string& symbol, Price exit_price) {
+    auto it = active_positions_.find(symbol);
+    if (it != active_positions_.end()) {
+        if (SymbolContext* context = findSymbolContext(symbol)) {
+            context->position = nullptr;
+        }
+        // Without an exit price the entry never filled; unwinding at the entry books nothing
+        const ActivePosition& position = it->second;
+        int64_t realized = portfolio_.onFill(portfolio_.find(symbol), position.action != "BUY", position.quantity,
+                                             exit_price > Price() ? exit_price : position.entry_price);
+        if (exit_price > Price()) {
+            LOG_INFO("{} closed at {}: P&L {}", symbol, exit_price, Price::fromPaise(realized));
+        }
+        active_positions_.erase(it);
+        active_positions_gauge_->set(static_cast<double>(active_positions_.size()));
+        ++positions_version_;
+        if (journal_) {
+            journal_->closed(symbol, clockMillis(*clock_));
+        }
+        LOG_INFO("Removed active position for {}", symbol);
     }
 }
 
 // Order logging methods
 void ZerodhaClient::logOrder(const std::string& symbol, const std::string& action, const std::string& order_id, 
-                            double price, int quantity, const std::string& order_type) {
-    std::ofstream log_file("OrderLog.txt", std::ios::app);
-    if (log_file.is_open()) {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto tm = *std::localtime(&time_t);
-        
-        log_file << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " | "
-                 << order_type << " | " << action << " | " << symbol << " | "
-                 << "Price: " << std::fixed << std::setprecision(2) << price << " | "
-                 << "Qty: " << quantity << " | "
-                 << "Order ID: " << order_id << std::endl;
-        
-        log_file.close();
-        std::cout << "Order logged to OrderLog.txt" << std::endl;
-    } else {
-        std::cerr << "Error: Could not open OrderLog.txt for writing" << std::endl;
-    }
+                            Price price, int quantity, const std::string& order_type) {
+    OrderLogRecord record;
+    record.event = order_type == "STOPLOSS" ? OrderLogEvent::StopLoss
+                 : order_type == "TARGET" ? OrderLogEvent::Target : OrderLogEvent::Entry;
+    record.buy = action == "BUY";
+    record.symbol = symbol;
+    record.price = price;
+    record.quantity = quantity;
+    record.order_id = order_id;
+    appendOrderLogRecord(record);
 }
 
-void ZerodhaClient::logStopLossHit(const std::string& symbol, double price) {
-    std::ofstream log_file("OrderLog.txt", std::ios::app);
-    if (log_file.is_open()) {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto tm = *std::localtime(&time_t);
-        
-        log_file << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " | "
-                 << "STOPLOSS_HIT" << " | " << symbol << " | "
-                 << "Price: " << std::fixed << std::setprecision(2) << price << std::endl;
-        
-        log_file.close();
-        std::cout << "Stop Loss hit logged to OrderLog.txt" << std::endl;
-    } else {
-        std::cerr << "Error: Could not open OrderLog.txt for writing" << std::endl;
+void ZerodhaClient::logStopLossHit(const std::string& symbol, Price price) {
+    logExit(symbol, price, true);
+}
+
+void ZerodhaClient::logTargetHit(const std::string& symbol, Price price) {
+    logExit(symbol, price, false);
+}
+
+void ZerodhaClient::logExit(const std::string& symbol, Price price, bool stop_loss) {
+    OrderLogRecord record;
+    record.event = stop_loss ? OrderLogEvent::StopLossHit : OrderLogEvent::TargetHit;
+    record.symbol = symbol;
+    record.price = price;
+    // Name the closing leg and its entry so the analytics can pair them exactly
+    auto it = active_positions_.find(symbol);
+    if (it != active_positions_.end()) {
+        record.buy = it->second.action != "BUY";
+        record.quantity = it->second.quantity;
+        record.order_id = stop_loss ? it->second.stop_loss_order_id : it->second.target_order_id;
+        record.entry_id = it->second.entry_order_id;
     }
+    appendOrderLogRecord(record);
 }
 
-void ZerodhaClient::logTargetHit(const std::string& symbol, double price) {
-    std::ofstream log_file("OrderLog.txt", std::ios::app);
-    if (log_file.is_open()) {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto tm = *std::localtime(&time_t);
-        
-        log_file << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " | "
-                 << "TARGET_HIT" << " | " << symbol << " | "
-                 << "Price: " << std::fixed << std::setprecision(2) << price << std::endl;
-        
-        log_file.close();
-        std::cout << "Target hit logged to OrderLog.txt" << std::endl;
+void ZerodhaClient::appendOrderLogRecord(OrderLogRecord& record) {
+    auto time_t = std::chrono::system_clock::to_time_t(clock_->now());
+    record.timestamp = orderLogTimestamp(*std::localtime(&time_t));
+    if (appendOrderLog("OrderLog.txt", record)) {
+        LOG_DEBUG("{} logged to OrderLog.txt", orderLogEventName(record.event));
     } else {
-        std::cerr << "Error: Could not open OrderLog.txt for writing" << std::endl;
+        LOG_ERROR("Could not open OrderLog.txt for writing");
     }
 }
 
@@ -1197,8 +2018,10 @@ void ZerodhaClient::checkPositionStatus() {
     // This method checks if stop loss or target orders have been executed
     // For symbols that weren't processed in the main loop (no LTP available)
     
-    std::vector<std::string> positions_to_remove;
+    std::vector<std::pair<std::string, Price>> positions_to_remove; // symbol, exit price
     
+    // Totals are published once for the whole sweep
+    portfolio_.beginBatch();
     for (const auto& pair : active_positions_) {
         const std::string& symbol = pair.first;
         const ActivePosition& position = pair.second;
@@ -1207,167 +2030,145 @@ void ZerodhaClient::checkPositionStatus() {
         // (This function is called less frequently now)
         if (symbol != "PROCESSED_IN_MAIN_LOOP") {
             // Get current LTP for real-time monitoring
-            double current_ltp = getLTP(symbol);
+            Price current_ltp = getLTP(symbol);
             
-            if (current_ltp > 0.0) {
+            if (current_ltp > Price()) {
+                portfolio_.onMark(portfolio_.find(symbol), current_ltp);
                 // Check if stop loss hit
                 if (position.action == "BUY" && current_ltp <= position.stop_loss) {
                     logStopLossHit(symbol, current_ltp);
-                    positions_to_remove.push_back(symbol);
-                    std::cout << "Stop Loss hit for " << symbol << " at LTP: " << current_ltp << " (SL: " << position.stop_loss << ")" << std::endl;
+                    positions_to_remove.emplace_back(symbol, current_ltp);
+                    LOG_INFO("Stop Loss hit for {} at LTP: {} (SL: {})", symbol, current_ltp, position.stop_loss);
                 }
                 else if (position.action == "SELL" && current_ltp >= position.stop_loss) {
                     logStopLossHit(symbol, current_ltp);
-                    positions_to_remove.push_back(symbol);
-                    std::cout << "Stop Loss hit for " << symbol << " at LTP: " << current_ltp << " (SL: " << position.stop_loss << ")" << std::endl;
+                    positions_to_remove.emplace_back(symbol, current_ltp);
+                    LOG_INFO("Stop Loss hit for {} at LTP: {} (SL: {})", symbol, current_ltp, position.stop_loss);
                 }
                 // Check if target hit
                 else if (position.action == "BUY" && current_ltp >= position.target) {
                     logTargetHit(symbol, current_ltp);
-                    positions_to_remove.push_back(symbol);
-                    std::cout << "Target hit for " << symbol << " at LTP: " << current_ltp << " (Target: " << position.target << ")" << std::endl;
+                    positions_to_remove.emplace_back(symbol, current_ltp);
+                    LOG_INFO("Target hit for {} at LTP: {} (Target: {})", symbol, current_ltp, position.target);
                 }
                 else if (position.action == "SELL" && current_ltp <= position.target) {
                     logTargetHit(symbol, current_ltp);
-                    positions_to_remove.push_back(symbol);
-                    std::cout << "Target hit for " << symbol << " at LTP: " << current_ltp << " (Target: " << position.target << ")" << std::endl;
+                    positions_to_remove.emplace_back(symbol, current_ltp);
+                    LOG_INFO("Target hit for {} at LTP: {} (Target: {})", symbol, current_ltp, position.target);
                 }
             }
         }
     }
     
+    portfolio_.endBatch();
+    
     // Remove closed positions
-    for (const auto& symbol : positions_to_remove) {
-        removeActivePosition(symbol);
+    for (const auto& position : positions_to_remove) {
+        removeActivePosition(position.first, position.second);
     }
 }
 
-void ZerodhaClient::checkPositionStatusWithLTP(const std::string& symbol, double ltp) {
+void ZerodhaClient::checkPositionStatusWithLTP(const std::string& symbol, Price ltp) {
     // This method checks if stop loss or target orders have been executed
     // Using the provided LTP (no need to fetch again)
     
-    if (ltp <= 0.0) return; // Invalid LTP
+    if (ltp <= Price()) return; // Invalid LTP
     
     auto it = active_positions_.find(symbol);
     if (it == active_positions_.end()) return; // No active position for this symbol
     
     const ActivePosition& position = it->second;
     std::vector<std::string> positions_to_remove;
-    
-    // Get recent historical data to show previous 2 candle information
-    auto now = std::chrono::system_clock::now();
-    auto data_start_time = now - std::chrono::hours(2); // Get last 2 hours of data
-    std::string from_date = formatDate(data_start_time);
-    std::string to_date = formatDate(now);
-    
-    std::vector<CandleData> candles = getHistoricalData(symbol, "5minute", from_date, to_date);
-    
-    // Show previous 2 candle information for monitoring
-    if (candles.size() >= 2) {
-        std::cout << "\n=== Previous 2 Candles for " << symbol << " ===" << std::endl;
+    portfolio_.onMark(portfolio_.find(symbol), ltp);
+    
+    // The previous two candles are fetched only to be logged; skip the API call otherwise
+    if (LOG_ENABLED(LogLevel::Debug)) {
+        auto now = clock_->now();
+        std::string from_date = formatDate(now - std::chrono::hours(2));
+        std::string to_date = formatDate(now);
+        std::vector<CandleData> candles = getHistoricalData(symbol, "5minute", from_date, to_date);
         
-        // Format timestamp function (reuse from getLastThreeCandles)
-        auto format5MinTimestamp = [](const std::string& timestamp) -> std::string {
-            if (timestamp.length() >= 16) {
-                std::string date_part = timestamp.substr(0, 10);
-                std::string time_part = timestamp.substr(11, 5);
-                int hour = std::stoi(time_part.substr(0, 2));
-                int minute = std::stoi(time_part.substr(3, 2));
-                int rounded_minute = (minute / 5) * 5;
-                
-                std::ostringstream oss;
-                oss << date_part << " " << std::setfill('0') << std::setw(2) << hour 
-                    << ":" << std::setfill('0') << std::setw(2) << rounded_minute;
-                return oss.str();
-            }
-            return timestamp;
-        };
-        
-        // Show second-to-last candle
-        size_t second_last_idx = candles.size() - 2;
-        std::cout << "Second-to-last candle: " << format5MinTimestamp(candles[second_last_idx].timestamp)
-                  << " | O:" << candles[second_last_idx].open 
-                  << " H:" << candles[second_last_idx].high 
-                  << " L:" << candles[second_last_idx].low 
-                  << " C:" << candles[second_last_idx].close << std::endl;
-        
-        // Show last candle
-        size_t last_idx = candles.size() - 1;
-        std::cout << "Last candle: " << format5MinTimestamp(candles[last_idx].timestamp)
-                  << " | O:" << candles[last_idx].open 
-                  << " H:" << candles[last_idx].high 
-                  << " L:" << candles[last_idx].low 
-                  << " C:" << candles[last_idx].close << std::endl;
-        
-        std::cout << "Current LTP: " << ltp << std::endl;
-        std::cout << "Position: " << position.action << " | Entry: " << position.entry_price 
-                  << " | SL: " << position.stop_loss << " | Target: " << position.target << std::endl;
-        std::cout << "=================================" << std::endl;
+        if (candles.size() >= 2) {
+            const CandleData& second_last = candles[candles.size() - 2];
+            const CandleData& last = candles[candles.size() - 1];
+            LOG_DEBUG("Previous 2 candles for {}: {} | O:{} H:{} L:{} C:{} ; {} | O:{} H:{} L:{} C:{}", symbol,
+                      formatFiveMinute(second_last.timestamp), second_last.open, second_last.high, second_last.low,
+                      second_last.close, formatFiveMinute(last.timestamp), last.open, last.high, last.low, last.close);
+            LOG_DEBUG("Current LTP: {} | Position: {} | Entry: {} | SL: {} | Target: {}", ltp, position.action,
+                      position.entry_price, position.stop_loss, position.target);
+        }
     }
     
     // Check if stop loss hit
     if (position.action == "BUY" && ltp <= position.stop_loss) {
         logStopLossHit(symbol, ltp);
         positions_to_remove.push_back(symbol);
-        std::cout << "Stop Loss hit for " << symbol << " at LTP: " << ltp << " (SL: " << position.stop_loss << ")" << std::endl;
+        LOG_INFO("Stop Loss hit for {} at LTP: {} (SL: {})", symbol, ltp, position.stop_loss);
     }
     else if (position.action == "SELL" && ltp >= position.stop_loss) {
         logStopLossHit(symbol, ltp);
         positions_to_remove.push_back(symbol);
-        std::cout << "Stop Loss hit for " << symbol << " at LTP: " << ltp << " (SL: " << position.stop_loss << ")" << std::endl;
+        LOG_INFO("Stop Loss hit for {} at LTP: {} (SL: {})", symbol, ltp, position.stop_loss);
     }
     // Check if target hit
     else if (position.action == "BUY" && ltp >= position.target) {
         logTargetHit(symbol, ltp);
         positions_to_remove.push_back(symbol);
-        std::cout << "Target hit for " << symbol << " at LTP: " << ltp << " (Target: " << position.target << ")" << std::endl;
+        LOG_INFO("Target hit for {} at LTP: {} (Target: {})", symbol, ltp, position.target);
     }
     else if (position.action == "SELL" && ltp <= position.target) {
         logTargetHit(symbol, ltp);
         positions_to_remove.push_back(symbol);
-        std::cout << "Target hit for " << symbol << " at LTP: " << ltp << " (Target: " << position.target << ")" << std::endl;
+        LOG_INFO("Target hit for {} at LTP: {} (Target: {})", symbol, ltp, position.target);
     }
     
     // Remove closed positions
     for (const auto& sym : positions_to_remove) {
-        removeActivePosition(sym);
+        removeActivePosition(sym, ltp);
     }
 } 
 
-double ZerodhaClient::getLTP(const std::string& symbol) {
+Price ZerodhaClient::getLTP(const std::string& symbol) {
+    return fetchLTP(symbol, getInstrumentExchange(symbol) + ":" + symbol); // Format: EXCHANGE:SYMBOL
+}
+
+Price ZerodhaClient::getLTP(const SymbolContext& context) {
+    return fetchLTP(context.setting.symbol, context.quote_key);
+}
+
+Price ZerodhaClient::fetchLTP(const std::string& symbol, const std::string& quote_key) {
     if (!isLoggedIn()) {
-        std::cerr << "Error: Not logged in. Cannot get LTP." << std::endl;
-        return 0.0;
+        LOG_ERROR("Not logged in. Cannot get LTP.");
+        return Price();
     }
     
     // Prepare the API request
-    std::string url = "https://api.kite.trade/quote/ltp";
+    std::string url = apiUrl(LTP_PATH);
     std::map<std::string, std::string> params;
-    params["i"] = "NSE:" + symbol; // Format: NSE:SYMBOL
+    params["i"] = quote_key;
     
     std::map<std::string, std::string> headers = getAuthHeaders();
     
     // Make the API request
     cpr::Response response = makeRequest(url, params, headers);
     
-    double ltp = 0.0;
+    Price ltp;
     
     if (response.status_code == 200) {
         try {
             nlohmann::json json = nlohmann::json::parse(response.text);
             
-            if (json["status"] == "success" && json["data"].contains("NSE:" + symbol)) {
-                ltp = json["data"]["NSE:" + symbol]["last_price"];
-                std::cout << "LTP for " << symbol << ": " << ltp << std::endl;
+            if (json["status"] == "success" && json["data"].contains(quote_key)) {
+                ltp = Price::fromDouble(json["data"][quote_key]["last_price"].get<double>());
+                LOG_DEBUG("LTP for {}: {}", symbol, ltp);
             } else {
-                std::cerr << "Error: No LTP data available for " << symbol << std::endl;
+                LOG_ERROR("No LTP data available for {}", symbol);
             }
         } catch (const std::exception& e) {
-            std::cerr << "Error parsing LTP response: " << e.what() << std::endl;
+            LOG_ERROR("Error parsing LTP response: {}", e.what());
         }
     } else {
-        std::cerr << "Error getting LTP for " << symbol << ". Status: " << response.status_code << std::endl;
-        std::cerr << "Response: " << response.text << std::endl;
+        LOG_ERROR("Error getting LTP for {}. Status: {} Response: {}", symbol, response.status_code, response.text);
     }
     
     return ltp;